@@ -19,7 +19,7 @@ our @EXPORT_OK = qw(trim read_config_file get_config validate_config
     get_dbh get_ref_dbh make_refseq_db load_refprofiles_db
     run_redund write_sqlite set_statistics get_statistics set_datetime
     print_config trim sqlite_install_RC_function
-    gen_exec_array_cb vs_db_insert);
+    gen_exec_array_cb vs_db_insert flankmap_reader);
 
 # vutil.pm
 # author: Yevgeniy Gelfand, Yozen Hernandez
@@ -1187,6 +1187,57 @@ sub gen_exec_array_cb {
     }
 }
 
+#-------------------------------------------------------------------------------
+## @brief      flankmap_reader
+##
+## @param      $mapfile The map file written by flankalign.exe
+##
+## @return     A callback which returns the next cluster of the file
+##             on each call, as its name ("a1_a2") and an arrayref of
+##             its read lines, and an empty list after the last one.
+##             The file is read sequentially, one cluster at a time,
+##             and the index block at its end is skipped.
+##
+sub flankmap_reader {
+    my $mapfile = shift
+        or croak "Error: Must specify a map file.\n";
+
+    open my $mfh, "<", $mapfile
+        or croak "Error opening for reading '$mapfile': $!\n";
+
+    my $header;
+    return sub {
+        my ( $cluster, @lines );
+
+        while ( defined $header or defined( $header = <$mfh> ) ) {
+            chomp $header;
+            last if $header =~ /^#index\t/;
+
+            if ( $header =~ /^@(\d+_\d+)/ ) {
+                $cluster = $1;
+                undef $header;
+                last;
+            }
+
+            undef $header;
+        }
+
+        return () unless defined $cluster;
+
+        while ( my $line = <$mfh> ) {
+            if ( $line =~ /^[@#]/ ) {
+                $header = $line;
+                last;
+            }
+
+            chomp $line;
+            push @lines, $line;
+        }
+
+        return ( $cluster, \@lines );
+    }
+}
+
 #-------------------------------------------------------------------------------
 ## @brief      vs_db_insert
 ##
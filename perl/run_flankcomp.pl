@@ -15,15 +15,15 @@ use vutil
     qw(get_config get_dbh set_statistics gen_exec_array_cb vs_db_insert);
 
 
+# flankalign.exe reads the cluster flanks straight from the databases,
+# this only links the clusters and records their sizes
 my $argc = @ARGV;
-die "Usage: run_flankcomp.pl expects 4 arguments.\n"
-    unless $argc >= 4;
+die "Usage: run_flankcomp.pl expects 2 arguments.\n"
+    unless $argc >= 2;
 
 my $curdir    = getcwd();
 my $inputfile = $ARGV[0];
 my $cnf       = $ARGV[1];
-my $TEMPDIR   = $ARGV[2];
-my $outfile   = $ARGV[3];
 
 # get run config
 my %run_conf = get_config("CONFIG", $cnf);
@@ -43,8 +43,6 @@ my $mostReps    = 0;
 my $mostRefReps = 0;
 my $maxRange    = 0;
 
-my $BREAK_SIZE = 4000;
-
 $write_dbh->do("PRAGMA foreign_keys = OFF");
 $write_dbh->do("PRAGMA synchronous = OFF");
 
@@ -109,17 +107,17 @@ $sth->finish();
 $write_dbh->do("PRAGMA synchronous = FULL"); # KA: i'm confident this doesnt matter
 $write_dbh->do("PRAGMA synchronous = OFF");
 
-print "Printing DNA and inserting into cluster table.\n";
+print "Inserting into cluster table.\n";
 
-# now print dna and quals (also insert into cluster table)
+# pattern sizes of the refs and reads (also insert into cluster table)
 $sth = $read_dbh->prepare(
-    q{SELECT rid, flankleft, sequence, flankright, pattern, copynum, direction
+    q{SELECT MIN(LENGTH(pattern)), MAX(LENGTH(pattern)), COUNT(*)
     FROM refdb.fasta_ref_reps
     INNER JOIN clusterlnk ON rid=-repeatid
     WHERE clusterid = ?})
     or die "Couldn't prepare statement: " . $read_dbh->errstr;
 $sth1 = $read_dbh->prepare(
-    q{SELECT rid, dna, first, last, pattern, copynum, direction
+    q{SELECT MIN(LENGTH(pattern)), MAX(LENGTH(pattern)), COUNT(*)
     FROM fasta_reads
     INNER JOIN replnk ON fasta_reads.sid=replnk.sid
     INNER JOIN clusterlnk ON rid=repeatid
@@ -130,7 +128,6 @@ $sth2 = $write_dbh->prepare(
     VALUES(?,?,?,?,?)})
     or die "Couldn't prepare statement: " . $write_dbh->errstr;
 
-my $i;
 seek( $fh, 0, 0 );
 $clusters_processed = 0;
 my @clusters;
@@ -167,64 +164,20 @@ while (<$fh>) {
     # execute ref and read pulls
     $sth->execute($clusters_processed)
         or die "Couldn't execute statement: " . $sth->errstr;
+    my ( $refminpat, $refmaxpat, $numrefs ) = $sth->fetchrow_array();
+    $sth->finish();
+
     $sth1->execute($clusters_processed)
         or die "Couldn't execute statement: " . $sth1->errstr;
+    my ( $readminpat, $readmaxpat, $numreads ) = $sth1->fetchrow_array();
+    $sth1->finish();
 
-    # store refs for later use
-    open( my $RFILE, ">$TEMPDIR/refs.txt" ) or die $!;
-    while ( my @data = $sth->fetchrow_array() ) {
-        print $RFILE "-"
-            . $data[0]
-            . $data[6] . ","
-            . $data[1] . ","
-            . $data[2] . ","
-            . $data[3] . ","
-            . $data[4] . "\n";
-
-        $minpat = min( $minpat, length( $data[4] ) );
-        $maxpat = max( $maxpat, length( $data[4] ) );
-
-        $i++;
-    }
-    close($RFILE);
-
-    # print reads in blocks of BREAK_SIZE
-    $i = 0;
-    my $hcount = 0;
-
-    open( my $outfh, ">>$outfile" ) or die $!;
-    while ( my @data = $sth1->fetchrow_array() ) {
-        if ( ( $i % $BREAK_SIZE ) == 0 ) {
-            $hcount++;
-
-            print $outfh "@($clusters_processed\_$hcount):";
-            print $outfh
-                "\n**********************************************************************\n";
-
-            # print refs each time
-            open( my $RFILE, "<$TEMPDIR/refs.txt" ) or die $!;
-            while (<$RFILE>) { print $outfh $_; }
-            close($RFILE);
-        }
-        my $dna = nowhitespace( $data[1] );
-        print $outfh $data[0]
-            . $data[6] . ","
-            . $data[2] . ","
-            . $data[3] . ","
-            . $dna . ","
-            . $data[4] . "\n";
-
-        $minpat = min( $minpat, length( $data[4] ) );
-        $maxpat = max( $maxpat, length( $data[4] ) );
-
-        $i++;
-    }
-    close($outfh);
+    # MIN and MAX are NULL without refs or reads
+    $minpat = min( grep {defined} $minpat, $refminpat, $readminpat );
+    $maxpat = max( grep {defined} $maxpat, $refmaxpat, $readmaxpat );
 
     # insert database records (cluster table)
     if ( $ENV{DEBUG} ) {
-        my $numrefs  = $sth->rows;
-        my $numreads = $sth1->rows;
         warn "Cluster $clusters_processed, numrefs: $numrefs, numreads: $numreads\n";
     }
     push @clusters,
@@ -280,9 +233,3 @@ set_statistics({
 print "Processing complete -- processed $clusters_processed cluster(s).";
 
 1;
-
-sub nowhitespace {
-    my $string = shift;
-    $string =~ s/\s+//g;
-    return $string;
-}
@@ -10,7 +10,8 @@ use List::Util qw[min max];
 
 use FindBin;
 use lib "$FindBin::RealBin/lib";
-use vutil qw(get_config get_dbh set_statistics gen_exec_array_cb vs_db_insert);
+use vutil qw(get_config get_dbh set_statistics gen_exec_array_cb vs_db_insert
+    flankmap_reader);
 
 # Arguments
 my $argc = @ARGV;
@@ -19,7 +20,7 @@ die "Usage: run_rankflankmap.pl expects 3 arguments.\n"
 
 my $curdir    = getcwd();
 my $inputfile = $ARGV[0];
-my $mapdir    = $ARGV[1];
+my $mapfile   = $ARGV[1];
 my $cnf       = $ARGV[2];
 
 # Database connection and variables
@@ -61,9 +62,7 @@ $rankflank_insert_sth
 
 open FILE, "<$inputfile" or die "error opening for reading '$inputfile': $!";
 
-opendir( DIR, $mapdir );
-my @allfiles = readdir(DIR);
-closedir(DIR);
+my $next_cluster = flankmap_reader($mapfile);
 
 my $j = 0;
 my $k = 0;
@@ -72,93 +71,86 @@ my $uploadedrank = 0;
 my $uploadedmap  = 0;
 my ( @map_rows, @rankflank_rows );
 
-foreach my $file (@allfiles) {
+while ( my ( $cluster, $lines ) = $next_cluster->() ) {
 
-    if ( index( $file, "_map" ) ) {
+    $clusters_processed++;
 
-        $clusters_processed++;
+    my %READVECTOR = ();
+    foreach (@$lines) {
+        my @mfields = split( '\t', $_ );
+        my $msize   = scalar @mfields;
+        if ( $msize >= 8 ) {
+            my $readid = $mfields[0];
+            my @rfields = split( ',', $mfields[7] );
+            my $bestscore = 0;
+            my $bestref   = "";
 
-        my $mfile = "$mapdir/$file";
-        open my $MFH, "<$mfile" or die $!;
+            foreach my $refstr (@rfields) {
+                if ( $refstr =~ /^-?(\d+):(\d+):(\d+)/ ) {
 
-        my %READVECTOR = ();
-        while (<$MFH>) {
-            chomp;
-            my @mfields = split( '\t', $_ );
-            my $msize   = scalar @mfields;
-            if ( $msize >= 8 ) {
-                my $readid = $mfields[0];
-                my @rfields = split( ',', $mfields[7] );
-                my $bestscore = 0;
-                my $bestref   = "";
+                    # calculate score
+                    my $score;
 
-                foreach my $refstr (@rfields) {
-                    if ( $refstr =~ /^-?(\d+):(\d+):(\d+)/ ) {
+                    # if no flanks, it will only be marked best if nothing else is available
+                    if ( ( $mfields[2] + $mfields[3] ) == 0 ) {
+                        $score = 0;
+                    }
+                    else {
+                        ## asked to add by Dr. Benson to balance out small flanks
+                        #my $A = ($2 + $3) / ( $mfields[2] + $mfields[3] );
+                        #my $B = 1 / ( $mfields[2] + $mfields[3]);
+                        #$score = 1 - max($A,$B);
+                        $score = 1 - (
+                            ( $2 + $3 ) / ( $mfields[2] + $mfields[3] ) );
+                    }
 
-                        # calculate score
-                        my $score;
+                    # filter to remove all flank scores below .9, added Nov 5, 2012
+                    if ( $score >= 0.90 ) {
 
-                        # if no flanks, it will only be marked best if nothing else is available
-                        if ( ( $mfields[2] + $mfields[3] ) == 0 ) {
-                            $score = 0;
+                        if ( $score > $bestscore ) {
+                            $bestref   = $1;
+                            $bestscore = $score;
                         }
-                        else {
-                            ## asked to add by Dr. Benson to balance out small flanks
-                            #my $A = ($2 + $3) / ( $mfields[2] + $mfields[3] );
-                            #my $B = 1 / ( $mfields[2] + $mfields[3]);
-                            #$score = 1 - max($A,$B);
-                            $score = 1 - (
-                                ( $2 + $3 ) / ( $mfields[2] + $mfields[3] ) );
-                        }
-
-                        # filter to remove all flank scores below .9, added Nov 5, 2012
-                        if ( $score >= 0.90 ) {
-
-                            if ( $score > $bestscore ) {
-                                $bestref   = $1;
-                                $bestscore = $score;
-                            }
-                            elsif ( $score == $bestscore ) {
-                                if ( $bestref eq "" ) { $bestref = $1; }
-                                else { $bestref .= ( "," . $1 ); }
-                            }
+                        elsif ( $score == $bestscore ) {
+                            if ( $bestref eq "" ) { $bestref = $1; }
+                            else { $bestref .= ( "," . $1 ); }
                         }
+                    }
 
-                        $k++;
-                        push @map_rows, [ $1, $readid ];
-                        if ( @map_rows % $RECORDS_PER_INFILE_INSERT == 0 ) {
-                            my $cb = gen_exec_array_cb( \@map_rows );
-                            my $rows = vs_db_insert( $dbh, $map_insert_sth, $cb,
-                                "Error inserting into map table." );
-                            $uploadedmap += $rows;
-                            @map_rows = ();
-                        }
+                    $k++;
+                    push @map_rows, [ $1, $readid ];
+                    if ( @map_rows % $RECORDS_PER_INFILE_INSERT == 0 ) {
+                        my $cb = gen_exec_array_cb( \@map_rows );
+                        my $rows = vs_db_insert( $dbh, $map_insert_sth, $cb,
+                            "Error inserting into map table." );
+                        $uploadedmap += $rows;
+                        @map_rows = ();
                     }
                 }
+            }
 
-                # insert the rankflank
-                if ( $bestref ne "" ) {
-                    my @ranks = split( ',', $bestref );
-                    my $ties  = scalar(@ranks) - 1;
-                    foreach my $rstr (@ranks) {
-                        $j++;
-
-                        push @rankflank_rows, [ $rstr, $readid, $bestscore, $ties ];
-                        if ( @rankflank_rows % $RECORDS_PER_INFILE_INSERT == 0 ) {
-                            my $cb = gen_exec_array_cb( \@rankflank_rows );
-                            my $rows = vs_db_insert( $dbh, $rankflank_insert_sth, $cb,
-                                "Error inserting into rankflank table." );
-                            $uploadedrank += $rows;
-                            @rankflank_rows = ();
-                        }
+            # insert the rankflank
+            if ( $bestref ne "" ) {
+                my @ranks = split( ',', $bestref );
+                my $ties  = scalar(@ranks) - 1;
+                foreach my $rstr (@ranks) {
+                    $j++;
+
+                    push @rankflank_rows, [ $rstr, $readid, $bestscore, $ties ];
+                    if ( @rankflank_rows % $RECORDS_PER_INFILE_INSERT == 0 ) {
+                        my $cb = gen_exec_array_cb( \@rankflank_rows );
+                        my $rows = vs_db_insert( $dbh, $rankflank_insert_sth, $cb,
+                            "Error inserting into rankflank table." );
+                        $uploadedrank += $rows;
+                        @rankflank_rows = ();
                     }
                 }
             }
         }
+    }
 
-        ( $ENV{DEBUG} ) && warn "processed: $clusters_processed\n";
-    }    # end of if (index($file,"_map")) {
-}    # end of foreach @files
+    ( $ENV{DEBUG} ) && warn "processed: $clusters_processed\n";
+}    # end of while clusters
 close(FILE);
 
 if (@map_rows) {
@@ -429,7 +429,8 @@ if ( $STEP == 3 ) {
     system("./redund.exe",
         $trff,
         "$processedf/allreads.leb36",
-        "-i");
+        "-i",
+        "-t", $opts{'NPROCESSES'});
     FlagError('calling redund.exe on read profiles folder');
 
     print "Setting additional statistics...\n";
@@ -493,9 +494,22 @@ if ( $STEP == 4 ) {
     print $tmp_rotindex $rotindex_str;
     close $tmp_rotindex;
 
+    # The reference file above is rewritten into a new temp dir every
+    # run, so psearch keeps its seed index next to the reference db
+    # instead. The index is stamped and named by the content of the
+    # reference profiles, it is reused as long as the refdb is unchanged.
+    my $index_folder = "$opts{REFERENCE}.psidx";
+    if ( -d $index_folder or mkdir $index_folder ) {
+        unlink glob("$index_folder/*.psidx") if ( $opts{REDO_REFDB} );
+        $ENV{PSEARCH_INDEX_DIR} = $index_folder;
+    }
+    else {
+        warn "Could not create $index_folder ($!), "
+            . "the reference index will not be kept.\n";
+    }
+
     print "Running proclu.\n";
     system("./run_proclu.pl",
-        1,
         $processedf,
         $reference_folder,
         $CLUST_PARAMS,
@@ -566,18 +580,14 @@ if ( $STEP == 8 ) {
 }
 
 if ( $STEP == 9 ) {
-    print "Executing step #$STEP (outputting flanks inside each cluster).\n";
+    print "Executing step #$STEP (linking repeats to their clusters).\n";
     Stamp('Start');
     $timestart = time();
 
-    unlink "$processedf/allwithdups.flanks";
-
     system("./run_flankcomp.pl",
         "$processedf/allwithdups.clusters",
-        $config_file,
-        File::Temp->newdir(),
-        "$processedf/allwithdups.flanks");
-    FlagError('outputting flanks inside each cluster');
+        $config_file);
+    FlagError('linking repeats to their clusters');
 
     FinishStep('WRITE_FLANKS');
 }
@@ -587,20 +597,19 @@ if ( $STEP == 10 ) {
     Stamp('Start');
     $timestart = time();
 
-    my $outf = "$processedf/out";
-    die "Failed to create output directory $outf.\n"
-        unless -r -w -e $outf or mkdir $outf;
-    unlink glob "$outf/*";
+    unlink "$processedf/allwithdups.map";
 
     # 0 for maxerror, means flankalign will pick maxerror based on individual flanklength
+    # flanks are read from the run and reference databases
     system("./flankalign.exe",
-        $outf,
+        "$processedf/allwithdups.map",
         "$processedf/result",
-        "$processedf/allwithdups.flanks",
+        "$output_folder/$opts{RUN_NAME}.db",
         0,
         $opts{'MAX_FLANK_CONSIDERED'},
         $opts{'NPROCESSES'},
-        15);
+        15,
+        $opts{'REFERENCE'} . ".db");
     FlagError('aligning ref-read flanks');
 
     FinishStep('MAP_FLANKS');
@@ -617,7 +626,7 @@ if ( $STEP == 12 ) {
 
     system("./run_rankflankmap.pl",
         "$processedf/allwithdups.clusters",
-        "$processedf/out",
+        "$processedf/allwithdups.map",
         $config_file);
     FlagError('inserting map and rankflank information into database');
 
@@ -744,7 +753,7 @@ if ( $STEP == 20 ) {
 
     # Cleanup
     print "File Cleanup Time!\n";
-    remove_tree("$processedf/out", {safe => 1});
+    unlink "$processedf/allwithdups.map";
     if ($opts{'CLEANUP'}) {
         remove_tree($trff, {safe => 1});
         remove_tree($processedf, {safe => 1});
@@ -0,0 +1,824 @@
+/*
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/***************************************************************
+    bench_kernels.c :   Times the sequence and profile comparison
+                        kernels on inputs sampled from real reads.
+
+                Usage:
+
+            bench_kernels.exe FASTA DISTANCE_TABLE [-s SECONDS]
+                              [-o OUTPUT.json] [-b BASELINE.json]
+
+            FASTA (plain or gzip, e.g. test/fasta_Watson_selected.gz)
+            is scanned for the best tandem repeat of every read and
+            of its reverse complement. The repeats give the consensus
+            (LCS), the flanks as trf2proclu-ngs cuts them (edit
+            distance, narrowband) and a profile built from the copies
+            (profile alignment), so lengths follow the reads. Half of
+            the pairs compare a repeat with a mutated copy of itself,
+            the rest with another repeat.
+
+            DISTANCE_TABLE is eucledian.dst, as given to psearch.
+
+            Every kernel is run over its pairs for at least SECONDS
+            (default 1). Reported are calls and matrix cells (the
+            lengths multiplied, also for the narrowband kernels) per
+            second and malloc/calloc/realloc calls per kernel call.
+            The checksum adds up the results and only changes if a
+            kernel does. -o writes the results as JSON, -b prints the
+            speed relative to a file written by an earlier -o.
+
+            Samples are drawn from a fixed seed, runs on the same
+            machine and input compare the same work.
+*/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "../libs/easylife/easylife.h"
+#include "../libs/vntr_kernels/vntr_kernels.h"
+
+char *GetReverse( char *original );
+char *GetComplement( char *original );
+char *GetReverseComplement( char *original );
+
+int  REFLEN             = 50;
+int  MAXFLANKCONSIDERED = 1000000;
+char OPTION             = 0;
+
+#include "../psearch1.91/profile.h"
+
+#define MAXFLANK 60        // ref flank as trf2proclu-ngs cuts it
+#define MAXREADFLANK 50    // read flank considered by psearch
+#define MINARRAY 20        // shortest repeat array taken from a read
+#define MAXPERIOD 250      // largest consensus searched
+#define MAXERR 8           // flank errors allowed, as psearch with -1
+#define HOMOLOGY 70        // narrowband profile alignment, psearch default
+#define NPAIRS 2000        // pairs per kernel
+#define MAXREADLENGTH 100000
+
+/*******************************************************************************************/
+/* allocation counting, the libc functions are reached through their
+ * glibc aliases */
+extern void *__libc_malloc( size_t size );
+extern void *__libc_calloc( size_t n, size_t size );
+extern void *__libc_realloc( void *ptr, size_t size );
+
+static unsigned long long Allocations = 0;
+
+void *malloc( size_t size ) {
+    Allocations++;
+    return __libc_malloc( size );
+}
+
+void *calloc( size_t n, size_t size ) {
+    Allocations++;
+    return __libc_calloc( n, size );
+}
+
+void *realloc( void *ptr, size_t size ) {
+    Allocations++;
+    return __libc_realloc( ptr, size );
+}
+
+/*******************************************************************************************/
+typedef struct {
+    char *   consensus; // one copy of the pattern
+    char *   left;      // reversed, as psearch keeps it
+    char *   right;
+    int      patlen, leftlen, rightlen;
+    PROFILE *prof;
+} BENCH_REPEAT;
+
+typedef struct {
+    char *   a, *b;
+    int      alen, blen;
+    PROFILE *pa, *pb;
+} BENCH_PAIR;
+
+typedef struct {
+    const char *name;
+    double      seconds;
+    double      calls, cells, allocations;
+    long long   checksum;
+} BENCH_RESULT;
+
+typedef int ( *BENCH_KERNEL )( BENCH_PAIR *pair );
+
+static BENCH_REPEAT *Repeats    = NULL;
+static int           NRepeats   = 0;
+static int           MaxRepeats = 0;
+
+static unsigned long long Seed = 0x9E3779B97F4A7C15ULL;
+
+/* workspace and distance table of the profile kernels */
+static PA_CONTEXT *   Pac = NULL;
+static unsigned char *Dt  = NULL;
+
+/*******************************************************************************************/
+void doCriticalErrorAndQuit( const char *format, ... ) {
+
+    va_list argp;
+
+    fprintf( stderr, "\nERROR: " );
+
+    va_start( argp, format );
+    vfprintf( stderr, format, argp );
+    va_end( argp );
+
+    fprintf( stderr, "\n\n" );
+    exit( 1 );
+}
+
+/*******************************************************************************************/
+static unsigned int Random( unsigned int n ) {
+    Seed ^= Seed << 13;
+    Seed ^= Seed >> 7;
+    Seed ^= Seed << 17;
+    return (unsigned int) ( ( Seed >> 16 ) % n );
+}
+
+/*******************************************************************************************/
+static double Now( void ) {
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*******************************************************************************************/
+char *GetReverse( char *original ) {
+    int   i, length = strlen( original );
+    char *buffer = (char *) smalloc( length + 1 );
+
+    for ( i = 0; i < length; i++ )
+        buffer[i] = original[length - 1 - i];
+
+    buffer[length] = '\0';
+    return buffer;
+}
+
+/*******************************************************************************************/
+char *GetComplement( char *original ) {
+    int   i, length = strlen( original );
+    char *buffer = (char *) smalloc( length + 1 );
+
+    for ( i = 0; i < length; i++ ) {
+        switch ( original[i] ) {
+        case 'A':
+            buffer[i] = 'T';
+            break;
+        case 'C':
+            buffer[i] = 'G';
+            break;
+        case 'G':
+            buffer[i] = 'C';
+            break;
+        case 'T':
+            buffer[i] = 'A';
+            break;
+        default:
+            buffer[i] = 'N';
+            break;
+        }
+    }
+
+    buffer[length] = '\0';
+    return buffer;
+}
+
+/*******************************************************************************************/
+static char *Substring( const char *s, int start, int length ) {
+    char *copy = (char *) smalloc( length + 1 );
+
+    memcpy( copy, s + start, length );
+    copy[length] = '\0';
+    return copy;
+}
+
+/*******************************************************************************************/
+/* profile of the copies of the array, one composition per pattern column */
+static PROFILE *BuildProfile( const char *array, int arraylen, int patlen,
+  int key ) {
+
+    PROFILE *prof;
+    int      i, col, counts[5];
+
+    prof          = (PROFILE *) scalloc( 1, sizeof( PROFILE ) );
+    prof->key     = key;
+    prof->patlen  = patlen;
+    prof->copynum = arraylen / (float) patlen;
+    prof->proflen = patlen;
+    prof->indices = (int *) smalloc( patlen * sizeof( int ) );
+
+    for ( col = 0; col < patlen; col++ ) {
+        memset( counts, 0, sizeof( counts ) );
+
+        for ( i = col; i < arraylen; i += patlen ) {
+            switch ( array[i] ) {
+            case 'A':
+                counts[0]++;
+                prof->a++;
+                break;
+            case 'C':
+                counts[1]++;
+                prof->c++;
+                break;
+            case 'G':
+                counts[2]++;
+                prof->g++;
+                break;
+            case 'T':
+                counts[3]++;
+                prof->t++;
+                break;
+            default:
+                counts[4]++;
+                break;
+            }
+        }
+
+        prof->indices[col] = GetCompositionId( counts );
+    }
+
+    return prof;
+}
+
+/*******************************************************************************************/
+/* best scoring tandem repeat of the read: for every period the run of
+ * s[i] == s[i + period] scored +1 per match and -3 per mismatch, the
+ * array is the run and one more copy */
+static void FindRepeat( const char *s, int len ) {
+
+    int           period, i, score, start, best, beststart, bestend;
+    int           tperiod = 0, tstart = 0, tend = 0, tscore = 0;
+    int           arraylen, leftstart;
+    BENCH_REPEAT *tr;
+    char *        left;
+
+    for ( period = 1; period <= MAXPERIOD && 2 * period <= len; period++ ) {
+        score = best = beststart = bestend = 0;
+        start = 0;
+
+        for ( i = 0; i + period < len; i++ ) {
+            if ( score <= 0 ) {
+                score = 0;
+                start = i;
+            }
+
+            score += ( s[i] == s[i + period] ) ? 1 : -3;
+
+            if ( score > best ) {
+                best      = score;
+                beststart = start;
+                bestend   = i + 1;
+            }
+        }
+
+        // shorter periods win ties, multiples of them score the same
+        if ( bestend - beststart >= period && best > tscore ) {
+            tscore  = best;
+            tperiod = period;
+            tstart  = beststart;
+            tend    = bestend + period;
+        }
+    }
+
+    arraylen = tend - tstart;
+
+    if ( 0 == tperiod || arraylen < MINARRAY )
+        return;
+
+    if ( NRepeats >= MaxRepeats ) {
+        MaxRepeats = ( MaxRepeats ) ? 2 * MaxRepeats : 64;
+        Repeats    = (BENCH_REPEAT *) realloc(
+          Repeats, MaxRepeats * sizeof( BENCH_REPEAT ) );
+
+        if ( NULL == Repeats ) {
+            fprintf( stderr, "\nERROR: out of memory\n\n" );
+            exit( 1 );
+        }
+    }
+
+    tr            = &Repeats[NRepeats];
+    tr->patlen    = tperiod;
+    tr->consensus = Substring( s, tstart, tperiod );
+    leftstart     = max( 0, tstart - MAXFLANK );
+    tr->leftlen   = tstart - leftstart;
+    tr->rightlen  = min( MAXFLANK, len - tend );
+    left          = Substring( s, leftstart, tr->leftlen );
+    tr->left      = GetReverse( left );
+    tr->right     = Substring( s, tend, tr->rightlen );
+    tr->prof      = BuildProfile( s + tstart, arraylen, tperiod, NRepeats + 1 );
+    free( left );
+
+    // flankless repeats can't be used for the flank kernels
+    if ( tr->leftlen > 0 && tr->rightlen > 0 )
+        NRepeats++;
+    else {
+        free( tr->consensus );
+        free( tr->left );
+        free( tr->right );
+        FreeProfile( tr->prof );
+    }
+}
+
+/*******************************************************************************************/
+static int LoadRepeats( const char *filename ) {
+
+    gzFile fp;
+    char * line, *seq, *rc;
+    int    len = 0, n;
+
+    fp = gzopen( filename, "r" );
+
+    if ( NULL == fp )
+        return -1;
+
+    line = (char *) smalloc( MAXREADLENGTH + 2 );
+    seq  = (char *) smalloc( MAXREADLENGTH + 1 );
+
+    while ( 1 ) {
+        char *got = gzgets( fp, line, MAXREADLENGTH + 2 );
+
+        if ( NULL == got || '>' == line[0] ) {
+            if ( len > 0 ) {
+                seq[len] = '\0';
+                FindRepeat( seq, len );
+                rc = GetReverseComplement( seq );
+                FindRepeat( rc, len );
+                free( rc );
+            }
+
+            len = 0;
+
+            if ( NULL == got )
+                break;
+
+            continue;
+        }
+
+        for ( n = 0; line[n] && len < MAXREADLENGTH; n++ ) {
+            char c = toupper( line[n] );
+
+            if ( c == 'A' || c == 'C' || c == 'G' || c == 'T' || c == 'N' )
+                seq[len++] = c;
+        }
+    }
+
+    gzclose( fp );
+    free( line );
+    free( seq );
+
+    return NRepeats;
+}
+
+/*******************************************************************************************/
+/* copy with about 3% substitutions and 1% insertions and deletions each,
+ * cut to maxlen */
+static char *Mutate( const char *s, int len, int maxlen, int *outlen ) {
+
+    char *copy = (char *) smalloc( 2 * len + 2 );
+    int   i, n = 0;
+
+    for ( i = 0; i < len && n < maxlen; i++ ) {
+        unsigned int r = Random( 100 );
+
+        if ( r < 3 )
+            copy[n++] = "ACGT"[Random( 4 )];
+        else if ( r < 4 ) {
+            copy[n++] = "ACGT"[Random( 4 )];
+            i--;
+        } else if ( r >= 5 )
+            copy[n++] = s[i];
+    }
+
+    copy[n] = '\0';
+    *outlen = n;
+    return copy;
+}
+
+/*******************************************************************************************/
+char *GetReverseComplement( char *original ) {
+    char *c = GetComplement( original ), *rc = GetReverse( c );
+
+    free( c );
+    return rc;
+}
+
+/*******************************************************************************************/
+static BENCH_PAIR *MakeSequencePairs( int flanks, int *count ) {
+
+    BENCH_PAIR *  pairs;
+    BENCH_REPEAT *ri, *rj;
+    int           k, right;
+
+    pairs = (BENCH_PAIR *) scalloc( NPAIRS, sizeof( BENCH_PAIR ) );
+
+    for ( k = 0; k < NPAIRS; k++ ) {
+        ri    = &Repeats[Random( NRepeats )];
+        rj    = ( k & 1 ) ? &Repeats[Random( NRepeats )] : ri;
+        right = Random( 2 );
+
+        if ( flanks ) {
+            // ref flank against a read flank, which is shorter
+            pairs[k].a    = right ? ri->right : ri->left;
+            pairs[k].alen = right ? ri->rightlen : ri->leftlen;
+            pairs[k].b    = Mutate( right ? rj->right : rj->left,
+              right ? rj->rightlen : rj->leftlen, MAXREADFLANK,
+              &pairs[k].blen );
+        } else {
+            pairs[k].a    = ri->consensus;
+            pairs[k].alen = ri->patlen;
+            pairs[k].b    = Mutate(
+              rj->consensus, rj->patlen, rj->patlen + 10, &pairs[k].blen );
+        }
+
+        // an all deleted copy aligns as an empty string
+        if ( 0 == pairs[k].blen ) {
+            free( pairs[k].b );
+            pairs[k].b    = Substring( pairs[k].a, 0, pairs[k].alen );
+            pairs[k].blen = pairs[k].alen;
+        }
+    }
+
+    *count = NPAIRS;
+    return pairs;
+}
+
+/*******************************************************************************************/
+/* profiles within the size error psearch sends to the narrowband */
+static BENCH_PAIR *MakeProfilePairs( int *count ) {
+
+    BENCH_PAIR *  pairs;
+    BENCH_REPEAT *ri, *rj;
+    int           k, tries;
+
+    pairs = (BENCH_PAIR *) scalloc( NPAIRS, sizeof( BENCH_PAIR ) );
+
+    for ( k = 0; k < NPAIRS; k++ ) {
+        ri = &Repeats[Random( NRepeats )];
+        rj = ri;
+
+        for ( tries = 0; ( k & 1 ) && tries < 100; tries++ ) {
+            rj = &Repeats[Random( NRepeats )];
+
+            if ( max( ri->patlen, rj->patlen ) <=
+                 2 * min( ri->patlen, rj->patlen ) )
+                break;
+        }
+
+        if ( max( ri->patlen, rj->patlen ) > 2 * min( ri->patlen, rj->patlen ) )
+            rj = ri;
+
+        pairs[k].pa   = ri->prof;
+        pairs[k].pb   = rj->prof;
+        pairs[k].alen = ri->prof->proflen;
+        pairs[k].blen = rj->prof->proflen;
+    }
+
+    *count = NPAIRS;
+    return pairs;
+}
+
+/*******************************************************************************************/
+/* the narrowband no end penalty kernels need seq1 no longer than seq2 */
+#define SHORTER_FIRST( p )                                              \
+    ( ( p )->blen <= ( p )->alen ) ? ( p )->b : ( p )->a,               \
+      ( ( p )->blen <= ( p )->alen ) ? ( p )->a : ( p )->b,             \
+      min( ( p )->alen, ( p )->blen ), max( ( p )->alen, ( p )->blen )
+
+static int BenchLCS( BENCH_PAIR *p ) {
+    return LCS_multiple_word( p->a, p->b, p->alen, p->blen );
+}
+
+static int BenchEditDistance( BENCH_PAIR *p ) {
+    return Edit_Distance_multiple_word_NoEndPenaltySeq1(
+      p->a, p->b, p->alen, p->blen );
+}
+
+static int BenchEditDistanceBounded( BENCH_PAIR *p ) {
+    return Edit_Distance_multiple_word_NoEndPenaltySeq1_Bounded(
+      p->a, p->b, p->alen, p->blen, MAXERR );
+}
+
+static int BenchNarrowbandNoEndPenalty( BENCH_PAIR *p ) {
+    return narrowbandUnitCostDistanceNoEndPenaltySeq2(
+      SHORTER_FIRST( p ), MAXERR );
+}
+
+static int BenchNarrowbandNoEndPenaltyLowMem( BENCH_PAIR *p ) {
+    return narrowbandUnitCostDistanceNoEndPenaltySeq2LowMem(
+      SHORTER_FIRST( p ), MAXERR );
+}
+
+static int BenchNarrowbandNoEndPenaltyPointers( BENCH_PAIR *p ) {
+    return narrowbandUnitCostDistanceNoEndPenaltySeq2LowMemUsesPointers(
+      SHORTER_FIRST( p ), MAXERR );
+}
+
+static int BenchNarrowbandSameLength( BENCH_PAIR *p ) {
+    int len = min( p->alen, p->blen );
+
+    return narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
+      p->b, p->a, len, len, MAXERR );
+}
+
+static int BenchFixedProfileAP( BENCH_PAIR *p ) {
+    PAP *ap = GetFixedProfileAP( Pac, p->pa, p->pb, Dt );
+    int  distance;
+
+    if ( NULL == ap )
+        return -1;
+
+    distance = ap->distance;
+    FreePAP( ap );
+    return distance;
+}
+
+static int BenchFixedProfileAPNarrowband( BENCH_PAIR *p ) {
+    PAP *ap = GetFixedProfileAPNarrowband( Pac, p->pa, p->pb, Dt, HOMOLOGY );
+    int  distance;
+
+    if ( NULL == ap )
+        return -1;
+
+    distance = ap->distance;
+    FreePAP( ap );
+    return distance;
+}
+
+static int BenchFixedProfileScore( BENCH_PAIR *p ) {
+    PAP ap;
+
+    if ( GetFixedProfileScore( Pac, p->pa, p->pb, Dt, &ap ) < 0 )
+        return -1;
+
+    return ap.distance;
+}
+
+static int BenchFixedProfileScoreNarrowband( BENCH_PAIR *p ) {
+    PAP ap;
+
+    if ( GetFixedProfileScoreNarrowband( Pac, p->pa, p->pb, Dt, HOMOLOGY,
+           &ap ) < 0 )
+        return -1;
+
+    return ap.distance;
+}
+
+/*******************************************************************************************/
+static int CompareInt( const void *a, const void *b ) {
+    return *(const int *) a - *(const int *) b;
+}
+
+/* quartiles of one length of the repeats */
+static void PrintLengths( const char *what, size_t offset ) {
+
+    int *lengths = (int *) smalloc( NRepeats * sizeof( int ) );
+    int  i;
+
+    for ( i = 0; i < NRepeats; i++ )
+        lengths[i] = *(int *) ( (char *) &Repeats[i] + offset );
+
+    qsort( lengths, NRepeats, sizeof( int ), CompareInt );
+    printf( "  %-12s min %d, 25%% %d, median %d, 75%% %d, max %d\n", what,
+      lengths[0], lengths[NRepeats / 4], lengths[NRepeats / 2],
+      lengths[3 * NRepeats / 4], lengths[NRepeats - 1] );
+    free( lengths );
+}
+
+/*******************************************************************************************/
+/* runs the kernel over all pairs until the time is up, the first round
+ * is not timed so workspaces are grown */
+static void Run( BENCH_RESULT *r, const char *name, BENCH_KERNEL kernel,
+  BENCH_PAIR *pairs, int npairs, double seconds ) {
+
+    double             start, cells = 0;
+    unsigned long long allocations;
+    long long          checksum = 0, rounds = 0;
+    int                k;
+
+    for ( k = 0; k < npairs; k++ ) {
+        checksum += kernel( &pairs[k] );
+        cells += (double) pairs[k].alen * pairs[k].blen;
+    }
+
+    allocations = Allocations;
+    start       = Now();
+
+    do {
+        for ( k = 0; k < npairs; k++ )
+            kernel( &pairs[k] );
+
+        rounds++;
+        r->seconds = Now() - start;
+    } while ( r->seconds < seconds );
+
+    r->name        = name;
+    r->calls       = (double) rounds * npairs;
+    r->cells       = cells * rounds;
+    r->allocations = ( Allocations - allocations ) / r->calls;
+    r->checksum    = checksum;
+
+    printf( "%s\n    %12.0f calls/s %14.0f cells/s %8.2f allocs/call, "
+            "checksum %lld\n",
+      name, r->calls / r->seconds, r->cells / r->seconds, r->allocations,
+      checksum );
+}
+
+/*******************************************************************************************/
+static int WriteJSON( const char *filename, const char *input,
+  BENCH_RESULT *results, int nresults ) {
+
+    FILE *fp = fopen( filename, "w" );
+    int   i;
+
+    if ( NULL == fp )
+        return -1;
+
+    // one kernel per line, ReadBaseline relies on it
+    fprintf( fp, "{\n  \"input\": \"%s\",\n  \"repeats\": %d,\n", input,
+      NRepeats );
+    fprintf( fp, "  \"pairs\": %d,\n  \"kernels\": [\n", NPAIRS );
+
+    for ( i = 0; i < nresults; i++ ) {
+        fprintf( fp,
+          "    {\"name\": \"%s\", \"calls\": %.0f, \"seconds\": %.6f, "
+          "\"calls_per_second\": %.1f, \"cells_per_second\": %.1f, "
+          "\"allocations_per_call\": %.3f, \"checksum\": %lld}%s\n",
+          results[i].name, results[i].calls, results[i].seconds,
+          results[i].calls / results[i].seconds,
+          results[i].cells / results[i].seconds, results[i].allocations,
+          results[i].checksum, ( i + 1 < nresults ) ? "," : "" );
+    }
+
+    fprintf( fp, "  ]\n}\n" );
+    fclose( fp );
+
+    return 0;
+}
+
+/*******************************************************************************************/
+static int CompareBaseline( const char *filename, BENCH_RESULT *results,
+  int nresults ) {
+
+    FILE *    fp = fopen( filename, "r" );
+    char      line[1024], name[256];
+    double    callspersecond, cellspersecond, allocations;
+    long long checksum;
+    int       i;
+
+    if ( NULL == fp )
+        return -1;
+
+    printf( "\nAgainst %s:\n", filename );
+
+    while ( fgets( line, sizeof( line ), fp ) ) {
+        if ( 5 != sscanf( line,
+                    " {\"name\": \"%255[^\"]\", \"calls\": %*f, \"seconds\": "
+                    "%*f, \"calls_per_second\": %lf, \"cells_per_second\": "
+                    "%lf, \"allocations_per_call\": %lf, \"checksum\": %lld",
+                    name, &callspersecond, &cellspersecond, &allocations,
+                    &checksum ) )
+            continue;
+
+        for ( i = 0; i < nresults; i++ ) {
+            if ( strcmp( name, results[i].name ) )
+                continue;
+
+            printf( "%s\n    %6.2fx speed, allocs/call %.2f -> %.2f%s\n",
+              name, results[i].calls / results[i].seconds / callspersecond,
+              allocations, results[i].allocations,
+              ( checksum != results[i].checksum ) ? ", RESULTS DIFFER" : "" );
+        }
+    }
+
+    fclose( fp );
+    return 0;
+}
+
+/*******************************************************************************************/
+int main( int argc, char **argv ) {
+
+    BENCH_RESULT   results[16];
+    BENCH_PAIR *   lcspairs, *flankpairs, *profpairs;
+    double         seconds  = 1.0;
+    char *         output   = NULL;
+    char *         baseline = NULL;
+    int            i, n = 0, nlcs, nflank, nprof;
+
+    if ( argc < 3 ) {
+        printf( "\nbench_kernels.exe FASTA DISTANCE_TABLE [-s SECONDS] "
+                "[-o OUTPUT.json] [-b BASELINE.json]\n\n" );
+        exit( 1 );
+    }
+
+    for ( i = 3; i + 1 < argc; i += 2 ) {
+        if ( 0 == strcmp( argv[i], "-s" ) )
+            seconds = atof( argv[i + 1] );
+        else if ( 0 == strcmp( argv[i], "-o" ) )
+            output = argv[i + 1];
+        else if ( 0 == strcmp( argv[i], "-b" ) )
+            baseline = argv[i + 1];
+        else {
+            fprintf( stderr, "\nERROR: unknown option %s\n\n", argv[i] );
+            exit( 1 );
+        }
+    }
+
+    if ( i < argc ) {
+        fprintf( stderr, "\nERROR: option %s needs a value\n\n", argv[i] );
+        exit( 1 );
+    }
+
+    if ( LoadRepeats( argv[1] ) <= 0 ) {
+        fprintf( stderr, "\nERROR: no repeats found in %s\n\n", argv[1] );
+        exit( 1 );
+    }
+
+    Dt = LoadDistanceTable( argv[2] );
+
+    if ( NULL == Dt ) {
+        fprintf( stderr, "\nERROR: unable to load distance table %s\n\n",
+          argv[2] );
+        exit( 1 );
+    }
+
+    Pac = CreatePAContext();
+
+    if ( NULL == Pac ) {
+        fprintf( stderr, "\nERROR: unable to allocate alignment workspace\n\n" );
+        exit( 1 );
+    }
+
+    lcspairs   = MakeSequencePairs( 0, &nlcs );
+    flankpairs = MakeSequencePairs( 1, &nflank );
+    profpairs  = MakeProfilePairs( &nprof );
+
+    printf( "%d repeats from %s, %d pairs per kernel\n", NRepeats, argv[1],
+      NPAIRS );
+    PrintLengths( "consensus", offsetof( BENCH_REPEAT, patlen ) );
+    PrintLengths( "left flank", offsetof( BENCH_REPEAT, leftlen ) );
+    PrintLengths( "right flank", offsetof( BENCH_REPEAT, rightlen ) );
+    printf( "\n" );
+
+    Run( &results[n++], "LCS_multiple_word", BenchLCS, lcspairs, nlcs, seconds );
+    Run( &results[n++], "Edit_Distance_multiple_word_NoEndPenaltySeq1",
+      BenchEditDistance, flankpairs, nflank, seconds );
+    Run( &results[n++], "Edit_Distance_multiple_word_NoEndPenaltySeq1_Bounded",
+      BenchEditDistanceBounded, flankpairs, nflank, seconds );
+    Run( &results[n++], "narrowbandUnitCostDistanceNoEndPenaltySeq2",
+      BenchNarrowbandNoEndPenalty, flankpairs, nflank, seconds );
+    Run( &results[n++], "narrowbandUnitCostDistanceNoEndPenaltySeq2LowMem",
+      BenchNarrowbandNoEndPenaltyLowMem, flankpairs, nflank, seconds );
+    Run( &results[n++],
+      "narrowbandUnitCostDistanceNoEndPenaltySeq2LowMemUsesPointers",
+      BenchNarrowbandNoEndPenaltyPointers, flankpairs, nflank, seconds );
+    Run( &results[n++],
+      "narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPoi"
+      "nters",
+      BenchNarrowbandSameLength, flankpairs, nflank, seconds );
+    Run( &results[n++], "GetFixedProfileAP", BenchFixedProfileAP, profpairs,
+      nprof, seconds );
+    Run( &results[n++], "GetFixedProfileAPNarrowband",
+      BenchFixedProfileAPNarrowband, profpairs, nprof, seconds );
+    Run( &results[n++], "GetFixedProfileScore", BenchFixedProfileScore,
+      profpairs, nprof, seconds );
+    Run( &results[n++], "GetFixedProfileScoreNarrowband",
+      BenchFixedProfileScoreNarrowband, profpairs, nprof, seconds );
+
+    if ( output && WriteJSON( output, argv[1], results, n ) < 0 ) {
+        fprintf( stderr, "\nERROR: unable to write %s\n\n", output );
+        exit( 1 );
+    }
+
+    if ( baseline && CompareBaseline( baseline, results, n ) < 0 ) {
+        fprintf( stderr, "\nERROR: unable to read %s\n\n", baseline );
+        exit( 1 );
+    }
+
+    FreePAContext( Pac );
+    FreeDistanceTable( Dt );
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/***************************************************************
+    leb36conv.c :   Converts profile files between LEB36 text and
+                    the binary profile format (profbin.h).
+
+                Usage:
+
+            leb36conv.exe INPUTFILE OUTPUTFILE
+
+            A binary input is written out as LEB36 text, a text
+            input as binary. Text written back from a binary file
+            converted from text is the same as the original, so
+            reference sets and debugging can stay with the text.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../libs/profbin/profbin.h"
+
+/*******************************************************************************************/
+int ToText( FILE *in, FILE *out ) {
+    PROFBIN_FILE *pf;
+    uint64_t      i;
+
+    pf = ProfbinMap( in );
+
+    if ( NULL == pf ) {
+        fprintf( stderr, "\nERROR: unfinished binary profile file or version "
+                         "other than %d\n\n",
+          PROFBIN_VERSION );
+        return 1;
+    }
+
+    for ( i = 0; i < pf->nrecords; i++ ) {
+        if ( 0 != ProfbinWriteText( out, ProfbinRecord( pf, i ) ) ) {
+            fprintf( stderr, "\nERROR: unable to write record %lu\n\n",
+              (unsigned long) i );
+            ProfbinUnmap( pf );
+            return 1;
+        }
+    }
+
+    printf( "%lu profiles converted to LEB36.\n", (unsigned long) i );
+    ProfbinUnmap( pf );
+
+    return 0;
+}
+
+/*******************************************************************************************/
+int ToBinary( FILE *in, FILE *out ) {
+    PROFBIN_WRITER *pw;
+    PROFBIN_TEXT    pt = {0};
+    PROFBIN_ENTRY   pe;
+    int             rc;
+    long            n = 0;
+
+    pw = ProfbinCreate( out );
+
+    if ( NULL == pw ) {
+        fprintf( stderr, "\nERROR: unable to write the header\n\n" );
+        return 1;
+    }
+
+    while ( 1 == ( rc = ProfbinReadText( in, &pt, &pe ) ) ) {
+        if ( 0 != ProfbinWrite( pw, &pe ) ) {
+            rc = -2;
+            break;
+        }
+
+        n++;
+    }
+
+    if ( -1 == rc )
+        fprintf( stderr, "\nERROR: malformed profile on line %ld\n\n",
+          pt.line );
+    else if ( -2 == rc )
+        fprintf( stderr, "\nERROR: unable to write profile on line %ld\n\n",
+          pt.line );
+
+    ProfbinFreeText( &pt );
+
+    if ( 0 != ProfbinClose( pw ) ) {
+        fprintf( stderr, "\nERROR: unable to write the record table\n\n" );
+        return 1;
+    }
+
+    if ( 0 != rc )
+        return 1;
+
+    printf( "%ld profiles converted to binary.\n", n );
+
+    return 0;
+}
+
+/*******************************************************************************************/
+int main( int argc, char **argv ) {
+    FILE *in, *out;
+    int   rc;
+
+    if ( argc != 3 ) {
+        printf( "\nLEB36CONV - converts profiles between LEB36 text and "
+                "binary (%s)\n",
+          PROFBIN_EXT );
+        printf( "\n\nUsage:\n\n%s INPUTFILE OUTPUTFILE\n\n", argv[0] );
+        printf( "   binary input is written as text, text input as binary\n\n" );
+        exit( 1 );
+    }
+
+    in = fopen( argv[1], "r" );
+
+    if ( NULL == in ) {
+        printf( "\nERROR: Unable to open input file '%s'\n\n", argv[1] );
+        exit( 1 );
+    }
+
+    out = fopen( argv[2], "w" );
+
+    if ( NULL == out ) {
+        printf( "\nERROR: Unable to open output file '%s'\n\n", argv[2] );
+        exit( 1 );
+    }
+
+    if ( ProfbinIsBinary( in ) )
+        rc = ToText( in, out );
+    else
+        rc = ToBinary( in, out );
+
+    fclose( in );
+
+    if ( 0 != fclose( out ) )
+        rc = 1;
+
+    return rc;
+}
@@ -0,0 +1,514 @@
+/****************************************************************
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ ****************************************************************/
+
+/***************************************************************
+    profbin.c : Binary profile file, see profbin.h.
+
+                Errors are returned to the caller, each tool
+                reports them its own way.
+****************************************************************/
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "profbin.h"
+
+#define PROFBIN_ALIGN( X ) ( ( ( X ) + 7 ) & ~( (uint64_t) 7 ) )
+
+/* concensus symbol of every composition id, as getConcensusFromProfile
+   picks it (first largest count, '-' columns are left out) */
+static char profbin_symbol[1001];
+static int  profbin_symbol_init = 0;
+
+/***************************************************************/
+static void profbin_init_symbols( void ) {
+    int a, c, g, t, dash, id = 0, i, sel, counts[5];
+
+    for ( a = 0; a <= 10; a++ )
+        for ( c = 0; c <= 10; c++ )
+            for ( g = 0; g <= 10; g++ )
+                for ( t = 0; t <= 10; t++ ) {
+                    dash = 10 - a - c - g - t;
+
+                    if ( dash < 0 )
+                        continue;
+
+                    counts[0] = a;
+                    counts[1] = c;
+                    counts[2] = g;
+                    counts[3] = t;
+                    counts[4] = dash;
+
+                    for ( sel = 0, i = 1; i < 5; i++ )
+                        if ( counts[i] > counts[sel] )
+                            sel = i;
+
+                    profbin_symbol[id++] = "ACGT-"[sel];
+                }
+
+    profbin_symbol_init = 1;
+}
+
+/***************************************************************/
+static int profbin_concensus( const int *indices, int proflen, char *dest ) {
+    int  i, n = 0;
+    char s;
+
+    for ( i = 0; i < proflen; i++ ) {
+
+        // ids outside the table are a perfect mixture
+        s = ( indices[i] < 0 || indices[i] > 1000 )
+              ? 'A'
+              : profbin_symbol[indices[i]];
+
+        if ( '-' != s ) {
+            if ( dest )
+                dest[n] = s;
+
+            n++;
+        }
+    }
+
+    if ( dest )
+        dest[n] = '\0';
+
+    return n;
+}
+
+/***************************************************************/
+static int profbin_pindcmp( const int *p1, const int *p2, int len1, int len2 ) {
+    int i;
+
+    if ( len1 != len2 )
+        return ( len1 > len2 ) ? 1 : -1;
+
+    for ( i = 0; i < len1; i++ ) {
+        if ( p1[i] != p2[i] )
+            return ( p1[i] > p2[i] ) ? 1 : -1;
+    }
+
+    return 0;
+}
+
+/***************************************************************/
+int ProfbinIsBinary( FILE *fp ) {
+    char magic[sizeof( PROFBIN_MAGIC ) - 1];
+
+    return ( sizeof( magic ) ==
+               pread( fileno( fp ), magic, sizeof( magic ), 0 ) &&
+             0 == memcmp( magic, PROFBIN_MAGIC, sizeof( magic ) ) );
+}
+
+/***************************************************************/
+PROFBIN_FILE *ProfbinMap( FILE *fp ) {
+    PROFBIN_FILE *        pf;
+    const PROFBIN_HEADER *h;
+    struct stat           st;
+    void *                base;
+
+    if ( 0 != fstat( fileno( fp ), &st ) ||
+         st.st_size < (off_t) sizeof( PROFBIN_HEADER ) )
+        return NULL;
+
+    base = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fileno( fp ), 0 );
+
+    if ( MAP_FAILED == base )
+        return NULL;
+
+    h = (const PROFBIN_HEADER *) base;
+
+    if ( 0 != memcmp( h->magic, PROFBIN_MAGIC, sizeof( h->magic ) ) ||
+         PROFBIN_VERSION != h->version ||
+         sizeof( PROFBIN_RECORD ) != h->recordsize || 0 == h->table ||
+         h->table > (uint64_t) st.st_size ||
+         h->nrecords > ( st.st_size - h->table ) / sizeof( uint64_t ) ) {
+        munmap( base, st.st_size );
+        return NULL;
+    }
+
+    pf = (PROFBIN_FILE *) calloc( 1, sizeof( PROFBIN_FILE ) );
+
+    if ( NULL == pf ) {
+        munmap( base, st.st_size );
+        return NULL;
+    }
+
+    pf->base     = (const char *) base;
+    pf->size     = st.st_size;
+    pf->header   = h;
+    pf->table    = (const uint64_t *) ( pf->base + h->table );
+    pf->nrecords = h->nrecords;
+
+    return pf;
+}
+
+/***************************************************************/
+void ProfbinUnmap( PROFBIN_FILE *pf ) {
+    if ( NULL == pf )
+        return;
+
+    munmap( (void *) pf->base, pf->size );
+    free( pf );
+}
+
+/***************************************************************/
+const PROFBIN_RECORD *ProfbinRecord( const PROFBIN_FILE *pf, uint64_t i ) {
+    if ( i >= pf->nrecords )
+        return NULL;
+
+    return (const PROFBIN_RECORD *) ( pf->base + pf->table[i] );
+}
+
+const int32_t *ProfbinIndices( const PROFBIN_RECORD *rec ) {
+    return (const int32_t *) ( rec + 1 );
+}
+
+const int32_t *ProfbinRCIndices( const PROFBIN_RECORD *rec ) {
+    return ProfbinIndices( rec ) + rec->proflen;
+}
+
+const char *ProfbinConcensus( const PROFBIN_RECORD *rec ) {
+    return (const char *) ( ProfbinRCIndices( rec ) +
+                            ( ( rec->proflenrc > 0 ) ? rec->proflenrc : 0 ) );
+}
+
+const char *ProfbinRCConcensus( const PROFBIN_RECORD *rec ) {
+    return ProfbinConcensus( rec ) + rec->conclen + 1;
+}
+
+const char *ProfbinLeft( const PROFBIN_RECORD *rec ) {
+    return ProfbinRCConcensus( rec ) + rec->conclenrc + 1;
+}
+
+const char *ProfbinRight( const PROFBIN_RECORD *rec ) {
+    return ProfbinLeft( rec ) + ( ( rec->leftlen > 0 ) ? rec->leftlen : 0 ) +
+           1;
+}
+
+/***************************************************************/
+PROFBIN_WRITER *ProfbinCreate( FILE *fp ) {
+    PROFBIN_WRITER *pw;
+    PROFBIN_HEADER  h;
+
+    if ( !profbin_symbol_init )
+        profbin_init_symbols();
+
+    pw = (PROFBIN_WRITER *) calloc( 1, sizeof( PROFBIN_WRITER ) );
+
+    if ( NULL == pw )
+        return NULL;
+
+    // unfinished until ProfbinClose sets the table
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, PROFBIN_MAGIC, sizeof( h.magic ) );
+    h.version    = PROFBIN_VERSION;
+    h.recordsize = sizeof( PROFBIN_RECORD );
+
+    if ( 1 != fwrite( &h, sizeof( h ), 1, fp ) ) {
+        free( pw );
+        return NULL;
+    }
+
+    pw->fp     = fp;
+    pw->offset = sizeof( h );
+
+    return pw;
+}
+
+/***************************************************************/
+int ProfbinWrite( PROFBIN_WRITER *pw, const PROFBIN_ENTRY *pe ) {
+    PROFBIN_RECORD *rec;
+    char *          p, copynum[32];
+    int             proflenrc, leftlen, rightlen, conclen, conclenrc;
+    size_t          size;
+
+    proflenrc = ( pe->rcindices && pe->proflenrc > 0 ) ? pe->proflenrc : 0;
+    leftlen   = ( pe->left && pe->right ) ? (int) strlen( pe->left ) : -1;
+    rightlen  = ( pe->left && pe->right ) ? (int) strlen( pe->right ) : -1;
+    conclen   = profbin_concensus( pe->indices, pe->proflen, NULL );
+    conclenrc = profbin_concensus( pe->rcindices, proflenrc, NULL );
+
+    size = sizeof( PROFBIN_RECORD ) +
+           sizeof( int32_t ) * ( pe->proflen + proflenrc ) + conclen + 1 +
+           conclenrc + 1 + ( ( leftlen > 0 ) ? leftlen : 0 ) + 1 +
+           ( ( rightlen > 0 ) ? rightlen : 0 ) + 1;
+    size = PROFBIN_ALIGN( size );
+
+    if ( size > pw->maxbuffer ) {
+        p = (char *) realloc( pw->buffer, 2 * size );
+
+        if ( NULL == p )
+            return -1;
+
+        pw->buffer    = p;
+        pw->maxbuffer = 2 * size;
+    }
+
+    if ( pw->nrecords == pw->maxtable ) {
+        uint64_t *table = (uint64_t *) realloc(
+          pw->table, ( 2 * pw->maxtable + 1024 ) * sizeof( uint64_t ) );
+
+        if ( NULL == table )
+            return -1;
+
+        pw->table    = table;
+        pw->maxtable = 2 * pw->maxtable + 1024;
+    }
+
+    memset( pw->buffer, 0, size );
+    rec = (PROFBIN_RECORD *) pw->buffer;
+
+    // the copy number a LEB36 line would give back
+    snprintf( copynum, sizeof( copynum ), "%.2f", pe->copynum );
+
+    rec->size      = size;
+    rec->key       = pe->key;
+    rec->patlen    = pe->patlen;
+    rec->copynum   = strtof( copynum, NULL );
+    rec->proflen   = pe->proflen;
+    rec->proflenrc = ( proflenrc > 0 ) ? proflenrc : -1;
+    rec->a         = pe->a;
+    rec->c         = pe->c;
+    rec->g         = pe->g;
+    rec->t         = pe->t;
+    rec->conclen   = conclen;
+    rec->conclenrc = conclenrc;
+    rec->leftlen   = leftlen;
+    rec->rightlen  = rightlen;
+    rec->minrep    = ( proflenrc > 0 &&
+                    profbin_pindcmp( pe->rcindices, pe->indices, proflenrc,
+                      pe->proflen ) < 0 )
+                    ? PROFBIN_MINREP_RC
+                    : PROFBIN_MINREP_FORWARD;
+
+    p = (char *) ( rec + 1 );
+    memcpy( p, pe->indices, sizeof( int32_t ) * pe->proflen );
+    p += sizeof( int32_t ) * pe->proflen;
+    memcpy( p, pe->rcindices, sizeof( int32_t ) * proflenrc );
+    p += sizeof( int32_t ) * proflenrc;
+    p += profbin_concensus( pe->indices, pe->proflen, p ) + 1;
+    p += profbin_concensus( pe->rcindices, proflenrc, p ) + 1;
+
+    if ( leftlen >= 0 ) {
+        memcpy( p, pe->left, leftlen + 1 );
+        p += leftlen + 1;
+        memcpy( p, pe->right, rightlen + 1 );
+    }
+
+    if ( 1 != fwrite( pw->buffer, size, 1, pw->fp ) )
+        return -1;
+
+    pw->table[pw->nrecords++] = pw->offset;
+    pw->offset += size;
+
+    return 0;
+}
+
+/***************************************************************/
+int ProfbinClose( PROFBIN_WRITER *pw ) {
+    PROFBIN_HEADER h;
+    int            rc = 0;
+
+    memset( &h, 0, sizeof( h ) );
+    memcpy( h.magic, PROFBIN_MAGIC, sizeof( h.magic ) );
+    h.version    = PROFBIN_VERSION;
+    h.recordsize = sizeof( PROFBIN_RECORD );
+    h.nrecords   = pw->nrecords;
+    h.table      = pw->offset;
+
+    if ( pw->nrecords != fwrite( pw->table, sizeof( uint64_t ), pw->nrecords,
+                           pw->fp ) ||
+         0 != fseeko( pw->fp, 0, SEEK_SET ) ||
+         1 != fwrite( &h, sizeof( h ), 1, pw->fp ) ||
+         0 != fseeko( pw->fp, 0, SEEK_END ) || 0 != fflush( pw->fp ) )
+        rc = -1;
+
+    free( pw->table );
+    free( pw->buffer );
+    free( pw );
+
+    return rc;
+}
+
+/***************************************************************/
+static int profbin_from_leb36( const char *digits, int n ) {
+    int i, v, num = 0, mult = 1;
+
+    // same as LEB36ToInt
+    for ( i = 0; i < n; i++ ) {
+        if ( digits[i] < 65 )
+            v = digits[i] & 0xF;
+        else
+            v = ( digits[i] & 0x1F ) + 9;
+
+        num += v * mult;
+        mult *= 36;
+    }
+
+    return num;
+}
+
+/* indices of one profile, two LEB36 digits each */
+static int profbin_read_digits( char **p, int *dest, int n ) {
+    int   i;
+    char *s = *p;
+
+    while ( ' ' == *s || '\t' == *s )
+        s++;
+
+    for ( i = 0; i < n; i++, s += 2 ) {
+        if ( '\0' == s[0] || ' ' == s[0] || '\n' == s[0] || '\0' == s[1] ||
+             ' ' == s[1] || '\n' == s[1] )
+            return -1;
+
+        dest[i] = profbin_from_leb36( s, 2 );
+    }
+
+    *p = s;
+    return 0;
+}
+
+/***************************************************************/
+int ProfbinReadText( FILE *fp, PROFBIN_TEXT *pt, PROFBIN_ENTRY *pe ) {
+    int     key, patlen, proflen, proflenrc, n;
+    float   copynum;
+    char *  p, *bar;
+    ssize_t len;
+
+    do {
+        len = getline( &pt->flanks, &pt->maxflanks, fp );
+
+        if ( len < 0 )
+            return 0;
+
+        pt->line++;
+        p = pt->flanks;
+
+        while ( ' ' == *p || '\t' == *p || '\r' == *p || '\n' == *p )
+            p++;
+    } while ( '\0' == *p );
+
+    memset( pe, 0, sizeof( *pe ) );
+
+    if ( 5 != sscanf( p, "%d %d %f %d %d%n", &key, &patlen, &copynum,
+                &proflen, &proflenrc, &n ) ||
+         proflen < 0 )
+        return -1;
+
+    p += n;
+
+    n = proflen + ( ( proflenrc > 0 ) ? proflenrc : 0 );
+
+    if ( (size_t) n > pt->maxindices ) {
+        pt->maxindices = 2 * n;
+        pt->indices    = (int *) realloc(
+          pt->indices, pt->maxindices * sizeof( int ) );
+
+        if ( NULL == pt->indices )
+            return -1;
+    }
+
+    pe->key       = key;
+    pe->patlen    = patlen;
+    pe->copynum   = copynum;
+    pe->proflen   = proflen;
+    pe->indices   = pt->indices;
+    pe->proflenrc = -1;
+
+    if ( 0 != profbin_read_digits( &p, pt->indices, proflen ) )
+        return -1;
+
+    if ( proflenrc <= 0 )
+        return 1;
+
+    pe->proflenrc = proflenrc;
+    pe->rcindices = pt->indices + proflen;
+
+    if ( 0 != profbin_read_digits( &p, pt->indices + proflen, proflenrc ) ||
+         4 != sscanf( p, " %d %d %d %d%n", &pe->a, &pe->c, &pe->g, &pe->t,
+                &n ) )
+        return -1;
+
+    p += n;
+
+    // optional flanks, left|right, split in place
+    while ( ' ' == *p || '\t' == *p )
+        p++;
+
+    p[strcspn( p, " \t\r\n" )] = '\0';
+    bar                         = strchr( p, '|' );
+
+    if ( NULL != bar ) {
+        *bar      = '\0';
+        pe->left  = p;
+        pe->right = bar + 1;
+    }
+
+    return 1;
+}
+
+/***************************************************************/
+void ProfbinFreeText( PROFBIN_TEXT *pt ) {
+    free( pt->indices );
+    free( pt->flanks );
+    memset( pt, 0, sizeof( *pt ) );
+}
+
+/***************************************************************/
+static void profbin_write_digits( FILE *fp, const int32_t *indices, int n ) {
+    int  i, v;
+    char digits[2];
+
+    // IntToLEB36 with the second digit padded, as WriteProfileWithRC
+    for ( i = 0; i < n; i++ ) {
+        v         = ( indices[i] > 0 ) ? indices[i] : 0;
+        digits[0] = ( v % 36 < 10 ) ? v % 36 + 48 : v % 36 + 55;
+        v /= 36;
+        digits[1] = ( v % 36 < 10 ) ? v % 36 + 48 : v % 36 + 55;
+        fwrite( digits, 1, 2, fp );
+    }
+}
+
+/***************************************************************/
+int ProfbinWriteText( FILE *fp, const PROFBIN_RECORD *rec ) {
+
+    fprintf( fp, "%d %d %.2f %d %d ", rec->key, rec->patlen, rec->copynum,
+      rec->proflen, rec->proflenrc );
+    profbin_write_digits( fp, ProfbinIndices( rec ), rec->proflen );
+
+    if ( rec->proflenrc <= 0 ) {
+        fprintf( fp, "\n" );
+        return ferror( fp ) ? -1 : 0;
+    }
+
+    fprintf( fp, " " );
+    profbin_write_digits( fp, ProfbinRCIndices( rec ), rec->proflenrc );
+    fprintf( fp, " %d %d %d %d", rec->a, rec->c, rec->g, rec->t );
+
+    if ( rec->leftlen >= 0 )
+        fprintf( fp, " %s|%s", ProfbinLeft( rec ), ProfbinRight( rec ) );
+
+    fprintf( fp, "\n" );
+
+    return ferror( fp ) ? -1 : 0;
+}
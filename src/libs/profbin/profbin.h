@@ -0,0 +1,145 @@
+/****************************************************************
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ ****************************************************************/
+
+/***************************************************************
+    profbin.h : Binary profile file, shared by trf2proclu-ngs,
+                redund and psearch in place of LEB36 text.
+
+                One record per profile pair, 8 byte aligned:
+                the repeat data, the profile and its reverse
+                complement as 4 byte indices, the minimum
+                representation key, the concensus of both
+                profiles and the flanks, all ready to use from
+                a read-only mapping of the file. A table of
+                record offsets follows the records so a file
+                can be split or searched without reading it.
+
+                Records keep what a LEB36 line has (copy number
+                rounded as "%.2f" writes it) so files convert
+                both ways without changing a tool's results,
+                see leb36conv.
+****************************************************************/
+
+#ifndef _PROFBIN_H
+#define _PROFBIN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROFBIN_EXT ".pbin"
+#define PROFBIN_MAGIC "PROFBIN\032"
+#define PROFBIN_VERSION 1
+
+/* minimum representation key, as MinimumRepresentation of redund with
+   identical profiles only */
+#define PROFBIN_MINREP_FORWARD 0
+#define PROFBIN_MINREP_RC 1
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t recordsize; // sizeof( PROFBIN_RECORD ) of the writer
+    uint64_t nrecords;
+    uint64_t table;      // uint64_t offset of every record, 0 if unfinished
+    uint64_t reserved[4];
+} PROFBIN_HEADER;
+
+/* followed by int32_t indices[proflen], int32_t rcindices[proflenrc],
+   the concensus, the rc concensus, the left and the right flank, each
+   terminated by 0, and padding to 8 bytes */
+typedef struct {
+    uint32_t size; // of the whole record
+    int32_t  key;
+    int32_t  patlen;
+    float    copynum;
+    int32_t  proflen;
+    int32_t  proflenrc; // -1 without reverse complement
+    int32_t  a, c, g, t;
+    int32_t  minrep; // PROFBIN_MINREP_*, of the indices as written
+    int32_t  conclen, conclenrc;
+    int32_t  leftlen, rightlen; // -1 without flanks
+    int32_t  reserved;
+} PROFBIN_RECORD;
+
+/* a profile pair to be written, rc and flanks may be NULL */
+typedef struct {
+    int         key, patlen;
+    float       copynum;
+    const int * indices, *rcindices;
+    int         proflen, proflenrc;
+    int         a, c, g, t;
+    const char *left, *right;
+} PROFBIN_ENTRY;
+
+typedef struct {
+    FILE *    fp;
+    uint64_t  offset, nrecords;
+    uint64_t *table;
+    size_t    maxtable;
+    char *    buffer;
+    size_t    maxbuffer;
+} PROFBIN_WRITER;
+
+typedef struct {
+    const char *          base;
+    size_t                size;
+    const PROFBIN_HEADER *header;
+    const uint64_t *      table;
+    uint64_t              nrecords;
+} PROFBIN_FILE;
+
+// 1 if the open file starts with a binary profile header, the file
+// position is kept
+int ProfbinIsBinary( FILE *fp );
+
+// Maps a binary profile file read-only. Returns NULL if it is not one,
+// has another version or is unfinished.
+PROFBIN_FILE *ProfbinMap( FILE *fp );
+void          ProfbinUnmap( PROFBIN_FILE *pf );
+
+const PROFBIN_RECORD *ProfbinRecord( const PROFBIN_FILE *pf, uint64_t i );
+const int32_t *       ProfbinIndices( const PROFBIN_RECORD *rec );
+const int32_t *       ProfbinRCIndices( const PROFBIN_RECORD *rec );
+const char *          ProfbinConcensus( const PROFBIN_RECORD *rec );
+const char *          ProfbinRCConcensus( const PROFBIN_RECORD *rec );
+const char *          ProfbinLeft( const PROFBIN_RECORD *rec );
+const char *          ProfbinRight( const PROFBIN_RECORD *rec );
+
+// Starts a binary profile file at the current position of fp (which
+// must be seekable, records are counted into the header on close).
+PROFBIN_WRITER *ProfbinCreate( FILE *fp );
+int             ProfbinWrite( PROFBIN_WRITER *pw, const PROFBIN_ENTRY *pe );
+// Writes the offset table and the header, fp is not closed.
+int ProfbinClose( PROFBIN_WRITER *pw );
+
+// LEB36 text, one line as WriteProfileWithRC writes it. The entry
+// points into buffers owned by the caller's PROFBIN_TEXT, valid until
+// the next call. Returns 1 for a record, 0 at the end, -1 on a
+// malformed line.
+typedef struct {
+    int *  indices;
+    size_t maxindices;
+    char * flanks;
+    size_t maxflanks;
+    long   line;
+} PROFBIN_TEXT;
+
+int  ProfbinReadText( FILE *fp, PROFBIN_TEXT *pt, PROFBIN_ENTRY *pe );
+void ProfbinFreeText( PROFBIN_TEXT *pt );
+int  ProfbinWriteText( FILE *fp, const PROFBIN_RECORD *rec );
+
+#endif
@@ -1,5 +1,5 @@
 /*
- *  convert to bitstring.c
+ *  bitstring64.c
  *  bitwise edit distance alignment
  *
  *  Created by Gary Benson on 7/17/12.
@@ -7,7 +7,7 @@
  *
  */
 
-#include "convert to bitstring64.h"
+#include "bitstring64.h"
 #define wordSize64 64
 
 char *convertToBitString64( unsigned long long int number ) {
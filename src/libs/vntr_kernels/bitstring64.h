@@ -1,5 +1,5 @@
 /*
- *  convert to bitstring.h
+ *  bitstring64.h
  *  bitwise edit distance alignment
  *
  *  Created by Gary Benson on 7/17/12.
@@ -7,4 +7,9 @@
  *
  */
 
-char *convertToBitString64( unsigned long long int number );
\ No newline at end of file
+#ifndef BITSTRING64_H
+#define BITSTRING64_H
+
+char *convertToBitString64( unsigned long long int number );
+
+#endif
@@ -0,0 +1,812 @@
+/*
+ *  bitwise_edit_distance.c
+ *  bitwise edit distance alignment
+ *
+ *  Created by Gary Benson on 7/20/12.
+ *  Copyright 2012 Boston University. All rights reserved.
+ *
+ */
+
+#include "bitwise_edit_distance.h"
+#include "vntr_kernels.h"
+#include "bitstring64.h"
+#include "packed_sequence.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define wordSize 64
+#define wordSizeMinusOne 63
+
+// rows of stringN up to this many words (4095 characters) are kept on the
+// stack, longer ones are allocated for the alignment
+#define stackRowWords 64
+
+#define freeRows         \
+    if ( heapRows )      \
+        free( heapRows );
+
+// number of wordSize-bit words needed for a stringN of length N
+static int NumberOfWords( int N ) {
+
+    int integerPart;
+
+    // First bit word can only hold wordSize-1 string positions
+    // so there is space for the zero column
+
+    if ( N > wordSize - 1 ) {
+        integerPart = ( N - wordSize + 1 ) / wordSize;
+        return ( N - wordSize + 1 - wordSize * integerPart ) > 0
+                 ? integerPart + 2
+                 : integerPart + 1;
+    }
+
+    return ( 1 ); // does not call Edit_Distance_single_word
+}
+
+// change of the score across 4 columns and the lowest it gets on the way,
+// indexed by the P_D bits << 4 | the P_I bits of the columns
+static const struct {
+    signed char sum, min;
+} NibbleWalk[256] = {
+    { 0, 0 }, { 1, 1 }, { 1, 0 }, { 2, 1 }, { 1, 0 }, { 2, 1 }, { 2, 0 },
+    { 3, 1 }, { 1, 0 }, { 2, 1 }, { 2, 0 }, { 3, 1 }, { 2, 0 }, { 3, 1 },
+    { 3, 0 }, { 4, 1 }, { -1, -1 }, { 0, 0 }, { 0, -1 }, { 1, 0 }, { 0, -1 },
+    { 1, 0 }, { 1, -1 }, { 2, 0 }, { 0, -1 }, { 1, 0 }, { 1, -1 }, { 2, 0 },
+    { 1, -1 }, { 2, 0 }, { 2, -1 }, { 3, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 },
+    { 1, 1 }, { 0, -1 }, { 1, 0 }, { 1, 0 }, { 2, 1 }, { 0, -1 }, { 1, 0 },
+    { 1, 0 }, { 2, 1 }, { 1, -1 }, { 2, 0 }, { 2, 0 }, { 3, 1 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -2 }, { 0, -1 }, { 0, -1 },
+    { 1, 0 }, { -1, -2 }, { 0, -1 }, { 0, -1 }, { 1, 0 }, { 0, -2 }, { 1, -1 },
+    { 1, -1 }, { 2, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { 0, 0 },
+    { 1, 1 }, { 1, 0 }, { 2, 1 }, { 0, -1 }, { 1, 0 }, { 1, 0 }, { 2, 1 },
+    { 1, 0 }, { 2, 1 }, { 2, 0 }, { 3, 1 }, { -2, -2 }, { -1, -1 }, { -1, -1 },
+    { 0, 0 }, { -1, -1 }, { 0, 0 }, { 0, -1 }, { 1, 0 }, { -1, -2 }, { 0, -1 },
+    { 0, -1 }, { 1, 0 }, { 0, -1 }, { 1, 0 }, { 1, -1 }, { 2, 0 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 },
+    { -1, -2 }, { 0, -1 }, { 0, -1 }, { 1, 0 }, { 0, -1 }, { 1, 0 }, { 1, 0 },
+    { 2, 1 }, { -3, -3 }, { -2, -2 }, { -2, -2 }, { -1, -1 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }, { -2, -3 }, { -1, -2 }, { -1, -2 },
+    { 0, -1 }, { -1, -2 }, { 0, -1 }, { 0, -1 }, { 1, 0 }, { -1, -1 }, { 0, 0 },
+    { 0, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 1, 0 }, { 2, 1 }, { 0, 0 },
+    { 1, 1 }, { 1, 0 }, { 2, 1 }, { 1, 0 }, { 2, 1 }, { 2, 0 }, { 3, 1 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 },
+    { 0, -1 }, { 1, 0 }, { -1, -1 }, { 0, 0 }, { 0, -1 }, { 1, 0 }, { 0, -1 },
+    { 1, 0 }, { 1, -1 }, { 2, 0 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { -1, -1 }, { 0, 0 }, { 0, 0 },
+    { 1, 1 }, { 0, -1 }, { 1, 0 }, { 1, 0 }, { 2, 1 }, { -3, -3 }, { -2, -2 },
+    { -2, -2 }, { -1, -1 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -2 }, { 0, -1 },
+    { 0, -1 }, { 1, 0 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { -1, -1 }, { 0, 0 }, { 0, 0 },
+    { 1, 1 }, { 0, 0 }, { 1, 1 }, { 1, 0 }, { 2, 1 }, { -3, -3 }, { -2, -2 },
+    { -2, -2 }, { -1, -1 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 },
+    { 0, -1 }, { 1, 0 }, { -3, -3 }, { -2, -2 }, { -2, -2 }, { -1, -1 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -2, -2 }, { -1, -1 },
+    { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { -4, -4 },
+    { -3, -3 }, { -3, -3 }, { -2, -2 }, { -3, -3 }, { -2, -2 }, { -2, -2 },
+    { -1, -1 }, { -3, -3 }, { -2, -2 }, { -2, -2 }, { -1, -1 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }
+};
+
+// smallest score in the row at column zero and at the columns of the
+// P_D and P_I = ~P_S_or_P_D words, scored as the final row is
+static int RowMinimum( unsigned long long int *P_D,
+  unsigned long long int *P_S_or_P_D, int NWords,
+  unsigned long long int junkBitsMask, int rowScore ) {
+
+    unsigned long long int P_DErase;
+    unsigned long long int P_IErase;
+    int                    i, j, walk;
+    int                    Score = rowScore;
+    int                    best  = rowScore;
+
+    for ( j = 0; j < NWords; j++ ) {
+        P_DErase = P_D[j];
+        P_IErase = ~P_S_or_P_D[j];
+
+        // first bit of the first word is the zero column
+        if ( j == 0 ) {
+            P_DErase &= ~0x0000000000000001ULL;
+            P_IErase &= ~0x0000000000000001ULL;
+        }
+
+        if ( j == NWords - 1 ) {
+            P_DErase &= junkBitsMask;
+            P_IErase &= junkBitsMask;
+        }
+
+        for ( i = 0; i < wordSize; i += 4 ) {
+            walk = (int) ( ( ( P_DErase >> i ) & 0xF ) << 4 |
+                           ( ( P_IErase >> i ) & 0xF ) );
+
+            if ( Score + NibbleWalk[walk].min < best )
+                best = Score + NibbleWalk[walk].min;
+
+            Score += NibbleWalk[walk].sum;
+        }
+    }
+
+    return ( best );
+}
+
+// 1 if stringM has only ACGTN from position i to M, as the row loop
+// would find
+static int ValidRemainder( char *stringM, int i, int M ) {
+
+    for ( ; i < M; i++ ) {
+        switch ( stringM[i] ) {
+        case 'A':
+        case 'C':
+        case 'G':
+        case 'T':
+        case 'N':
+            break;
+        default:
+            printf(
+              "\nError, non-ACGTN character read in string:%c", stringM[i] );
+            return ( 0 );
+        }
+    }
+
+    return ( 1 );
+}
+
+// storage of the match vectors for a stringN of length N, one block
+static int PatternStorage( EDIT_DISTANCE_PATTERN *pattern, int N ) {
+
+    int                     NWords;
+    unsigned long long int *words;
+
+    NWords = NumberOfWords( N );
+
+    if ( NWords > pattern->maxWords ) {
+        words = (unsigned long long int *) realloc(
+          pattern->matchA, 5 * NWords * sizeof( unsigned long long int ) );
+
+        if ( words == NULL )
+            return ( -1 );
+
+        pattern->maxWords   = NWords;
+        pattern->matchA     = words;
+        pattern->matchC     = words + NWords;
+        pattern->matchG     = words + 2 * NWords;
+        pattern->matchT     = words + 3 * NWords;
+        pattern->matchN     = words + 4 * NWords;
+    }
+
+    pattern->N           = N;
+    pattern->badPosition = N + 1;
+    pattern->badChar     = '\0';
+
+    return ( NWords );
+}
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare(
+  EDIT_DISTANCE_PATTERN *pattern, char *stringN, int N ) {
+
+    // encodes stringN into the match vectors of pattern, growing its
+    // storage when needed, so that stringN (or any prefix of it) can be
+    // aligned against many stringM without encoding it again.
+    // A non-ACGTN character is remembered and reported by
+    // Edit_Distance_multiple_word_NoEndPenaltySeq1_Run once a prefix
+    // reaching it is aligned, as the unprepared call does.
+
+    // returns -1 if out of memory
+
+    int                     i, j;
+    int                     NWords;
+    unsigned long long int  bitmask;
+    unsigned long long int *matchA;
+    unsigned long long int *matchC;
+    unsigned long long int *matchG;
+    unsigned long long int *matchT;
+    unsigned long long int *matchN;
+
+    NWords = PatternStorage( pattern, N );
+
+    if ( NWords < 0 )
+        return ( -1 );
+
+    matchA = pattern->matchA;
+    matchC = pattern->matchC;
+    matchG = pattern->matchG;
+    matchT = pattern->matchT;
+    matchN = pattern->matchN;
+
+    //*************************encode match strings A C G T N for string1
+    // loop through stringN and store bits in matchA, matchC, etc.
+    // column zero in the score matrix is ignored
+    // so we start with i = 0 and bitmask = 1 in the first nWord only
+
+    for ( j = 0; j < NWords; j++ ) {
+        bitmask = 0x0000000000000001;
+
+        matchA[j] = 0x0000000000000000;
+        matchC[j] = 0x0000000000000000;
+        matchG[j] = 0x0000000000000000;
+        matchT[j] = 0x0000000000000000;
+        matchN[j] = 0x0000000000000000;
+        for ( i = j * wordSize; i < ( j + 1 ) * wordSize; i++ ) {
+            if ( i <= N ) {
+                if ( i || j ) {
+                    // if both i and j are zero, it means we are at the zero
+                    // position in the row don't process because it doesn't
+                    // correspond to a character in the string
+
+                    switch ( stringN[i - 1] ) {
+                    case 'A':
+                        matchA[j] |= bitmask;
+                        break;
+                    case 'C':
+                        matchC[j] |= bitmask;
+                        break;
+                    case 'G':
+                        matchG[j] |= bitmask;
+                        break;
+                    case 'T':
+                        matchT[j] |= bitmask;
+                        break;
+                    case 'N':
+                        matchN[j] |= bitmask;
+                        break;
+                    default:
+                        // only the first one is reported
+                        if ( i < pattern->badPosition ) {
+                            pattern->badPosition = i;
+                            pattern->badChar     = stringN[i];
+                        }
+                        break;
+                    }
+                }
+                bitmask <<=
+                  1; // bitmask = bitmask<<1, moves set bit one position higher
+            }
+        }
+    }
+
+    // debug
+    /*
+     printf("\nmatchA:  ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(matchA[j]));} printf("\nmatchC:
+     ");for(j=0;j<NWords;j++){printf("%s ",convertToBitString64(matchC[j]));}
+     printf("\nmatchG:  ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(matchG[j]));} printf("\nmatchT:
+     ");for(j=0;j<NWords;j++){printf("%s ",convertToBitString64(matchT[j]));}
+     printf("\nmatchN:  ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(matchN[j]));}
+     */
+
+    return ( 0 );
+}
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_PrepareView(
+  EDIT_DISTANCE_PATTERN *pattern, const PACKEDSEQ_VIEW *viewN ) {
+
+    // as Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare, stringN
+    // is the whole view
+
+    // returns -1 if out of memory
+
+    unsigned long long int *matchVectors[5];
+    int                     i, N, NWords, bad;
+
+    N      = viewN->length;
+    NWords = PatternStorage( pattern, N );
+
+    if ( NWords < 0 )
+        return ( -1 );
+
+    memset( pattern->matchA, 0,
+      5 * NWords * sizeof( unsigned long long int ) );
+
+    matchVectors[0] = pattern->matchA;
+    matchVectors[1] = pattern->matchC;
+    matchVectors[2] = pattern->matchG;
+    matchVectors[3] = pattern->matchT;
+    matchVectors[4] = pattern->matchN;
+
+    bad = PackedSeqViewBad( viewN, 0, N );
+    if ( bad >= 0 ) {
+        pattern->badPosition = bad + 1;
+        pattern->badChar     = PackedSeqViewChar( viewN, bad );
+        N                    = bad;
+    }
+
+    // column zero is bit 0 of the first word, character i is column i + 1
+    for ( i = 0; i < N; i++ ) {
+        matchVectors[PackedSeqViewCode( viewN, i )][( i + 1 ) / wordSize] |=
+          1ULL << ( ( i + 1 ) % wordSize );
+    }
+
+    return ( 0 );
+}
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Run(
+  EDIT_DISTANCE_PATTERN *pattern, int N, char *stringM, int M ) {
+
+    // aligns stringM against the first N characters of the prepared
+    // stringN, N can not be more than the prepared length.
+    // Gives the same result as Edit_Distance_multiple_word_NoEndPenaltySeq1
+    // on those N characters: bits past N never reach the ones below
+    // them and are masked out of the final row.
+
+    // returns zero if M is zero
+
+    // returns -1 if error
+
+    // the score is never more than M, so no row is cut short
+    return ( Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded(
+      pattern, N, stringM, M, M ) );
+}
+
+// rows of Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded, stringM
+// is read from viewM when that is given, inlined in each kernel clone
+static inline __attribute__( ( always_inline ) ) int RunBounded(
+  EDIT_DISTANCE_PATTERN *pattern, int N, char *stringM,
+  const PACKEDSEQ_VIEW *viewM, int M, int maxScore ) {
+
+    int                     i, j, bad;
+    unsigned long long int *matchA;
+    unsigned long long int *matchC;
+    unsigned long long int *matchG;
+    unsigned long long int *matchT;
+    unsigned long long int *matchN;
+    unsigned long long int *matchVectors[5];
+    unsigned long long int
+      *                     matchVector; // to hold one of matchA, matchC, etc.  no memory allocated
+    unsigned long long int  matchString;
+    unsigned long long int *P_D;
+    unsigned long long int *P_S_or_P_D;
+    unsigned long long int  stackRows[2 * stackRowWords];
+    unsigned long long int *heapRows = NULL;
+    unsigned long long int  M_m;
+    unsigned long long int  R_IS;
+    unsigned long long int  not_M_I;
+    unsigned long long int  not_M_I_xor_P_D;
+    unsigned long long int  VC_0;
+    unsigned long long int  VC_plus_1;
+    unsigned long long int  VC_0_shift;
+    unsigned long long int  VC_plus_1_shift;
+    unsigned long long int  sum;
+    unsigned long long int  sum_and_R_IS;
+    unsigned long long int  highBitMask64 = 0x8000000000000000;
+    unsigned long long int  carryBitSum;
+    unsigned long long int  carryBitVC_plus_1_shift;
+    unsigned long long int  carryBitVC_0_shift;
+    unsigned long long int  oldCarryBitVC_plus_1_shift;
+    unsigned long long int  oldCarryBitVC_0_shift;
+
+    unsigned long long int P_DErase;
+    unsigned long long int P_IErase;
+    unsigned long long int mask;
+    int                    Score;
+    int                    bestFinalRowScore;
+
+    int                    NWords;
+    int                    junkBits;
+    unsigned long long int junkBitsMask;
+    int                    bestFinalColumn;
+
+    if ( M == 0 )
+        return ( 0 );
+
+    if ( N > pattern->N )
+        return ( -1 );
+
+    if ( N >= pattern->badPosition ) {
+        printf( "\nError, non-ACGTN character read at position "
+                "%d in string:%c",
+          pattern->badPosition, pattern->badChar );
+        return ( -1 );
+    }
+
+    // a view is checked whole, the character rows below only on the way
+    if ( viewM ) {
+        bad = PackedSeqViewBad( viewM, 0, M );
+        if ( bad >= 0 ) {
+            printf( "\nError, non-ACGTN character read in string:%c",
+              PackedSeqViewChar( viewM, bad ) );
+            return ( -1 );
+        }
+    }
+
+    NWords       = NumberOfWords( N );
+    junkBits     = wordSize - 1 + ( NWords - 1 ) * wordSize - N;
+    junkBitsMask = 0xFFFFFFFFFFFFFFFF >> junkBits;
+    // printf("\n>>>%s",convertToBitString64(junkBitsMask));
+
+    matchA     = pattern->matchA;
+    matchC     = pattern->matchC;
+    matchG     = pattern->matchG;
+    matchT     = pattern->matchT;
+    matchN     = pattern->matchN;
+    P_D        = stackRows;
+
+    matchVectors[0] = matchA;
+    matchVectors[1] = matchC;
+    matchVectors[2] = matchG;
+    matchVectors[3] = matchT;
+    matchVectors[4] = matchN;
+
+    if ( NWords > stackRowWords ) {
+        heapRows = (unsigned long long int *) malloc(
+          2 * NWords * sizeof( unsigned long long int ) );
+
+        if ( heapRows == NULL ) {
+            printf( "\nError, unable to allocate rows for a string of %d "
+                    "characters",
+              N );
+            return ( -1 );
+        }
+
+        P_D = heapRows;
+    }
+
+    P_S_or_P_D = P_D + NWords;
+
+    for ( j = 0; j < NWords; j++ ) {
+        P_D[j]        = 0x0000000000000000;
+        P_S_or_P_D[j] = 0x0000000000000000;
+    }
+
+    // initialize PD and PS||PD for row zero
+    // all of row zero is increase, except zero position
+    // which must be S or D so that an initial first R_IS run is computed
+    // correctly here it is set to D for global alignment so that the vertical
+    // class value below it will be set to +1 (first column increasing)
+    // otherwise, set to S for semi-global alignment so no penalty
+    // for starting row (first column all zeros)
+
+    P_D[0] =
+      1; // puts 1 in zero position, as required above for global alignment
+    P_S_or_P_D[0] = 1; // required for consistency
+
+    // debug
+    /*
+     printf("\n\nRow 0");
+     printf("\nP_D:         ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(P_D[j]));} printf("\nP_S_or_P_D:
+     ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(P_S_or_P_D[j]));}
+     */
+
+    // loop for each letter in string2
+    // row zero in the score matrix corresponds to the initial value of
+    // complement
+    for ( i = 0; i < M; i++ ) {
+        carryBitSum = 0x0000000000000000;
+        carryBitVC_plus_1_shift =
+          0x0000000000000001; // set up for adding 1 to first position after
+                              // shift
+        carryBitVC_0_shift = 0x0000000000000000;
+
+        if ( viewM )
+            matchVector = matchVectors[PackedSeqViewCode( viewM, i )];
+        else
+            switch ( stringM[i] ) {
+            case 'A':
+                matchVector = matchA;
+                break;
+            case 'C':
+                matchVector = matchC;
+                break;
+            case 'G':
+                matchVector = matchG;
+                break;
+            case 'T':
+                matchVector = matchT;
+                break;
+            case 'N':
+                matchVector = matchN;
+                break;
+            default:
+                printf( "\nError, non-ACGTN character read in string:%c",
+                  stringM[i] );
+                freeRows;
+                return ( -1 );
+                break;
+            }
+
+        for ( j = 0; j < NWords; j++ ) {
+            oldCarryBitVC_plus_1_shift = carryBitVC_plus_1_shift;
+            oldCarryBitVC_0_shift      = carryBitVC_0_shift;
+
+            matchString = matchVector[j];
+
+            // compute bitstrings
+            // match subsets
+            M_m             = matchString | P_D[j];
+            R_IS            = ~M_m;
+            not_M_I         = R_IS | P_S_or_P_D[j];
+            not_M_I_xor_P_D = not_M_I ^ P_D[j];
+
+            // the add (with carry)
+            // and get carryBitSum for next round
+            // saw this online. if a+b causes overflow (carry), a+b<a, a+b<b.
+            // bug fix Beth Becker 4/30/14
+            // old: sum = not_M_I+P_S_or_P_D[j]+carryBitSum;
+            // old: if(sum<not_M_I) carryBitSum = 1;
+            sum         = not_M_I + carryBitSum;
+            carryBitSum = ( sum < not_M_I ) ? 1 : 0;
+            sum += P_S_or_P_D[j];
+            carryBitSum |= ( sum < P_S_or_P_D[j] ) ? 1 : 0;
+
+            sum_and_R_IS = sum & R_IS;
+
+            // the new vertical classes
+            VC_0      = sum_and_R_IS ^ not_M_I_xor_P_D;
+            VC_plus_1 = P_D[j] | ( sum_and_R_IS & P_S_or_P_D[j] );
+
+            // get shift carry bits
+            // mask and shift
+            carryBitVC_0_shift = ( VC_0 & highBitMask64 ) >> wordSizeMinusOne;
+            carryBitVC_plus_1_shift =
+              ( VC_plus_1 & highBitMask64 ) >> wordSizeMinusOne;
+
+            // the vertical class shifts (with carry)
+            VC_0_shift      = ( VC_0 << 1 ) + oldCarryBitVC_0_shift;
+            VC_plus_1_shift = ( VC_plus_1 << 1 ) + oldCarryBitVC_plus_1_shift;
+
+            // reset first position in VC_plus_1_shift for boundary condition
+            // this is done with oldCarryBitVC__plus_1_shift above
+            // VC_plus_1_shift+=1;
+
+            // debug
+            /*
+             printf("\n\nRow %d, Column %d",i+1,j);
+             printf("\nP_D: %s",convertToBitString64(P_D[j]));
+             printf("\nP_S_or_P_D: %s",convertToBitString64(P_S_or_P_D[j]));
+             printf("\nmatchString: %s",convertToBitString64(matchString));
+             printf("\nM_m:                    %s",convertToBitString64(M_m));
+             printf("\nR_IS                    %s",convertToBitString64(R_IS));
+             printf("\nnot_M_I %s",convertToBitString64(not_M_I));
+             printf("\nnot_M_I_xor_P_D
+             %s",convertToBitString64(not_M_I_xor_P_D)); printf("\nsum
+             %s",convertToBitString64(sum)); printf("\nsum_and_R_IS
+             %s",convertToBitString64(sum_and_R_IS)); printf("\nVC_0
+             %s",convertToBitString64(VC_0)); printf("\nVC_0_shift
+             %s",convertToBitString64(VC_0_shift)); printf("\nVC_plus_1
+             %s",convertToBitString64(VC_plus_1)); printf("\nVC_plus_1_shift
+             %s",convertToBitString64(VC_plus_1_shift));
+
+             printf("\n\ncarryBitSum %s",convertToBitString64(carryBitSum));
+             printf("\ncarryBitVC_0_shift
+             %s",convertToBitString64(carryBitVC_0_shift));
+             printf("\ncarryBitVC_plus_1_shift
+             %s",convertToBitString64(carryBitVC_plus_1_shift));
+             */
+
+            // new pair classes
+            P_D[j]        = M_m & VC_plus_1_shift;
+            P_S_or_P_D[j] = VC_plus_1_shift | ( M_m & VC_0_shift );
+
+            // debug
+            /*
+             printf("\n\nNew P_D: %s",convertToBitString64(P_D[j]));
+             printf("\nNew P_S_or_P_D: %s",convertToBitString64(P_S_or_P_D[j]));
+             */
+        }
+
+        // stop once no column of this row is within maxScore, a row
+        // scores at most its number (column zero) so rows up to
+        // maxScore are never tested
+        if ( i + 1 > maxScore &&
+             RowMinimum( P_D, P_S_or_P_D, NWords, junkBitsMask, i + 1 ) >
+               maxScore ) {
+            freeRows;
+
+            if ( !viewM && !ValidRemainder( stringM, i + 1, M ) )
+                return ( -1 );
+
+            return ( maxScore + 1 );
+        }
+    }
+
+    // debug
+    /*
+     printf("\n\nFinal:");
+     printf("\nP_D:         ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(P_D[j]));} printf("\nP_S_or_P_D:
+     ");for(j=0;j<NWords;j++){printf("%s
+     ",convertToBitString64(P_S_or_P_D[j]));}
+     */
+
+    //***end of identical code to Edit_Distance_multiple_word
+
+    // printf("\n\nFinal:");
+    // printf("\nP_D:         ");
+    // for(j=0;j<NWords;j++){
+    //     if (j==NWords-1) printf("\n%s
+    //     ",convertToBitString64(P_D[j]&junkBitsMask)); else printf("\n%s
+    //     ",convertToBitString64(P_D[j]));
+    // }
+    // printf("\n");
+    // for (i=0; i<wordSize-junkBits; i++) {
+    //     printf(" ");
+    // }
+    // printf("^");
+
+    // printf("\nP_I = ~P_S_or_P_D:  ");
+    // for(j=0;j<NWords;j++){
+    //     if (j==NWords-1) printf("\n%s
+    //     ",convertToBitString64(~P_S_or_P_D[j]&junkBitsMask)); else
+    //     printf("\n%s ",convertToBitString64(~P_S_or_P_D[j]));
+    // }
+    // printf("\n");
+    // for (i=0; i<wordSize-junkBits; i++) {
+    //     printf(" ");
+    // }
+    // printf("^");
+
+    // find best edit distance score in final row
+    mask              = 0x0000000000000001;
+    bestFinalRowScore = M;
+    bestFinalColumn   = 0;
+    Score             = M;
+    for ( j = 0; j < NWords; j++ ) {
+        P_DErase = P_D[j];
+        // P_IErase=~(P_S_or_P_D[j]);
+        P_IErase = ~P_S_or_P_D[j];
+
+        // mask bits past N in final word using JunkBitsMask
+        if ( j == NWords - 1 ) {
+            P_DErase &= junkBitsMask;
+            P_IErase &= junkBitsMask;
+        }
+
+        for ( i = 0; i < wordSize; i++ ) {
+            // do nothing if first NWord, first bit.
+            // This was set to 1 artifically in both PD and PSorPD
+            if ( i | j ) {
+                Score -= (int) P_DErase & mask;
+                Score += (int) P_IErase & mask;
+                if ( Score < bestFinalRowScore ) {
+                    bestFinalRowScore = Score;
+                    bestFinalColumn   = j * wordSize + i;
+                }
+            }
+            P_DErase >>= 1;
+            P_IErase >>= 1;
+
+            // debug
+            /*
+             printf("\n\nP_DErase: %s",convertToBitString64(P_DErase));
+             printf("\nP_IErase: %s",convertToBitString64(P_IErase));
+             */
+        }
+    }
+
+    // debug
+
+    // printf("\n");
+    // for (i=0; i<bestFinalColumn-1; i++) {
+    //     printf(" ");
+    // }
+    //    printf("^%d, %d",bestFinalColumn,NWords*wordSize-junkBits);
+    //    printf("\nGlobal Score: %d",Score);
+    // printf("\nBest Final Row Score is %d",bestFinalRowScore);
+
+    freeRows;
+
+    if ( bestFinalRowScore > maxScore )
+        return ( maxScore + 1 );
+
+    return ( bestFinalRowScore );
+}
+
+VNTR_KERNEL int Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded(
+  EDIT_DISTANCE_PATTERN *pattern, int N, char *stringM, int M,
+  int maxScore ) {
+
+    // as Edit_Distance_multiple_word_NoEndPenaltySeq1_Run, for callers
+    // that only test the score against maxScore: the score is exact up to
+    // maxScore, anything higher is returned as maxScore + 1.
+    // The smallest score of a row (column zero included) never goes down
+    // in the rows below it, so the alignment stops at the first row whose
+    // smallest score is past maxScore.
+    // The pattern is only read, threads can share it.
+
+    // returns zero if M is zero
+
+    // returns -1 if error
+
+    return ( RunBounded( pattern, N, stringM, NULL, M, maxScore ) );
+}
+
+VNTR_KERNEL int Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded_View(
+  EDIT_DISTANCE_PATTERN *pattern, int N, const PACKEDSEQ_VIEW *viewM,
+  int maxScore ) {
+
+    // as Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded, stringM
+    // is the whole view
+
+    return ( RunBounded( pattern, N, NULL, viewM, viewM->length, maxScore ) );
+}
+
+void Edit_Distance_multiple_word_NoEndPenaltySeq1_Free(
+  EDIT_DISTANCE_PATTERN *pattern ) {
+
+    free( pattern->matchA );
+    memset( pattern, 0, sizeof( EDIT_DISTANCE_PATTERN ) );
+}
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1(
+  char *stringN, char *stringM, int N, int M ) {
+
+    // the procedure computes fast bitwise edit distance
+    //***longer string is stringN
+    //***no end penalty on the right end of stringN
+    // n is the length of stringN
+    // m is the length of stringM
+    // n and m are *not* determined by strlen because they
+    // may be part of longer strings
+    // does not call Edit_Distance_single_word even when N<wordsize
+
+    // to align many stringM against the same stringN, prepare it once
+    // with Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare
+
+    // returns zero if M is zero
+
+    // returns -1 if error
+
+    EDIT_DISTANCE_PATTERN pattern;
+    int                   bestFinalRowScore;
+
+    if ( M == 0 )
+        return ( 0 );
+
+    memset( &pattern, 0, sizeof( EDIT_DISTANCE_PATTERN ) );
+
+    if ( Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare(
+           &pattern, stringN, N ) < 0 )
+        return ( -1 );
+
+    bestFinalRowScore =
+      Edit_Distance_multiple_word_NoEndPenaltySeq1_Run( &pattern, N, stringM, M );
+
+    Edit_Distance_multiple_word_NoEndPenaltySeq1_Free( &pattern );
+
+    return ( bestFinalRowScore );
+}
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Bounded(
+  char *stringN, char *stringM, int N, int M, int maxScore ) {
+
+    // the procedure computes fast bitwise edit distance
+    //***longer string is stringN
+    //***no end penalty on the right end of stringN
+    // n is the length of stringN
+    // m is the length of stringM
+    // n and m are *not* determined by strlen because they
+    // may be part of longer strings
+    // does not call Edit_Distance_single_word even when N<wordsize
+
+    // the score is exact up to maxScore, anything higher is returned as
+    // maxScore + 1, see Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded
+
+    // returns zero if M is zero
+
+    // returns -1 if error
+
+    EDIT_DISTANCE_PATTERN pattern;
+    int                   bestFinalRowScore;
+
+    if ( M == 0 )
+        return ( 0 );
+
+    memset( &pattern, 0, sizeof( EDIT_DISTANCE_PATTERN ) );
+
+    if ( Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare(
+           &pattern, stringN, N ) < 0 )
+        return ( -1 );
+
+    bestFinalRowScore = Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded(
+      &pattern, N, stringM, M, maxScore );
+
+    Edit_Distance_multiple_word_NoEndPenaltySeq1_Free( &pattern );
+
+    return ( bestFinalRowScore );
+}
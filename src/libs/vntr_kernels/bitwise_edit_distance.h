@@ -0,0 +1,49 @@
+/*
+ *  bitwise_edit_distance.h
+ *  bitwise edit distance alignment
+ *
+ *  Created by Gary Benson on 7/20/12.
+ *  Copyright 2012 Boston University. All rights reserved.
+ *
+ */
+
+#ifndef BITWISE_EDIT_DISTANCE_NO_END_PENALTY_H
+#define BITWISE_EDIT_DISTANCE_NO_END_PENALTY_H
+
+#include "packed_sequence.h"
+
+#define maxStringLengthForEditDistanceRegister 64
+
+/* stringN encoded once for many alignments, zero fill before the first
+ * prepare. Alignments only read it, so threads can share one. */
+typedef struct {
+    int  N;           // length prepared
+    int  maxWords;    // words allocated for each vector
+    int  badPosition; // of the first non-ACGTN character, N + 1 if none
+    char badChar;
+    unsigned long long int *matchA, *matchC, *matchG, *matchT, *matchN;
+} EDIT_DISTANCE_PATTERN;
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1(
+  char *stringN, char *stringM, int N, int M );
+// exact up to maxScore, maxScore + 1 for anything higher
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Bounded(
+  char *stringN, char *stringM, int N, int M, int maxScore );
+
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare(
+  EDIT_DISTANCE_PATTERN *pattern, char *stringN, int N );
+// the same from a packed view, stringN is the whole view
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_PrepareView(
+  EDIT_DISTANCE_PATTERN *pattern, const PACKEDSEQ_VIEW *viewN );
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Run(
+  EDIT_DISTANCE_PATTERN *pattern, int N, char *stringM, int M );
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded(
+  EDIT_DISTANCE_PATTERN *pattern, int N, char *stringM, int M, int maxScore );
+// stringM is the whole view
+int Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded_View(
+  EDIT_DISTANCE_PATTERN *pattern, int N, const PACKEDSEQ_VIEW *viewM,
+  int maxScore );
+void Edit_Distance_multiple_word_NoEndPenaltySeq1_Free(
+  EDIT_DISTANCE_PATTERN *pattern );
+
+#endif
@@ -0,0 +1,315 @@
+/*
+ *  bitwise_edit_distance_batch.c
+ *  bitwise no end penalty edit distance of many independent pairs
+ *
+ *  Each lane runs the single word case of
+ *  Edit_Distance_multiple_word_NoEndPenaltySeq1 on its own pair:
+ *  its own match words, its own stringM, one character per row.
+ *  Lanes whose stringM is done keep their last row until the longest
+ *  one in the group is finished, the queue is sorted by length so
+ *  groups are of similar lengths.
+ *
+ */
+
+#include "bitwise_edit_distance_batch.h"
+#include "packed_sequence.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define wordSize 64
+
+typedef unsigned long long int ED_V2 __attribute__( ( vector_size( 16 ) ) );
+typedef unsigned long long int ED_V4 __attribute__( ( vector_size( 32 ) ) );
+typedef unsigned long long int ED_V8 __attribute__( ( vector_size( 64 ) ) );
+
+// A C G T N -> 0 - 4, everything else is rejected by ED_batch_add
+static const unsigned char ED_batch_code[256] = {
+    ['A'] = 0, ['C'] = 1, ['G'] = 2, ['T'] = 3, ['N'] = 4
+};
+
+// change of the score across 4 columns and the lowest it gets on the way,
+// indexed by the P_D bits << 4 | the P_I bits of the columns
+static const struct {
+    signed char sum, min;
+} NibbleWalk[256] = {
+    { 0, 0 }, { 1, 1 }, { 1, 0 }, { 2, 1 }, { 1, 0 }, { 2, 1 }, { 2, 0 },
+    { 3, 1 }, { 1, 0 }, { 2, 1 }, { 2, 0 }, { 3, 1 }, { 2, 0 }, { 3, 1 },
+    { 3, 0 }, { 4, 1 }, { -1, -1 }, { 0, 0 }, { 0, -1 }, { 1, 0 }, { 0, -1 },
+    { 1, 0 }, { 1, -1 }, { 2, 0 }, { 0, -1 }, { 1, 0 }, { 1, -1 }, { 2, 0 },
+    { 1, -1 }, { 2, 0 }, { 2, -1 }, { 3, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 },
+    { 1, 1 }, { 0, -1 }, { 1, 0 }, { 1, 0 }, { 2, 1 }, { 0, -1 }, { 1, 0 },
+    { 1, 0 }, { 2, 1 }, { 1, -1 }, { 2, 0 }, { 2, 0 }, { 3, 1 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -2 }, { 0, -1 }, { 0, -1 },
+    { 1, 0 }, { -1, -2 }, { 0, -1 }, { 0, -1 }, { 1, 0 }, { 0, -2 }, { 1, -1 },
+    { 1, -1 }, { 2, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { 0, 0 },
+    { 1, 1 }, { 1, 0 }, { 2, 1 }, { 0, -1 }, { 1, 0 }, { 1, 0 }, { 2, 1 },
+    { 1, 0 }, { 2, 1 }, { 2, 0 }, { 3, 1 }, { -2, -2 }, { -1, -1 }, { -1, -1 },
+    { 0, 0 }, { -1, -1 }, { 0, 0 }, { 0, -1 }, { 1, 0 }, { -1, -2 }, { 0, -1 },
+    { 0, -1 }, { 1, 0 }, { 0, -1 }, { 1, 0 }, { 1, -1 }, { 2, 0 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 },
+    { -1, -2 }, { 0, -1 }, { 0, -1 }, { 1, 0 }, { 0, -1 }, { 1, 0 }, { 1, 0 },
+    { 2, 1 }, { -3, -3 }, { -2, -2 }, { -2, -2 }, { -1, -1 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }, { -2, -3 }, { -1, -2 }, { -1, -2 },
+    { 0, -1 }, { -1, -2 }, { 0, -1 }, { 0, -1 }, { 1, 0 }, { -1, -1 }, { 0, 0 },
+    { 0, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 1, 0 }, { 2, 1 }, { 0, 0 },
+    { 1, 1 }, { 1, 0 }, { 2, 1 }, { 1, 0 }, { 2, 1 }, { 2, 0 }, { 3, 1 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 },
+    { 0, -1 }, { 1, 0 }, { -1, -1 }, { 0, 0 }, { 0, -1 }, { 1, 0 }, { 0, -1 },
+    { 1, 0 }, { 1, -1 }, { 2, 0 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { -1, -1 }, { 0, 0 }, { 0, 0 },
+    { 1, 1 }, { 0, -1 }, { 1, 0 }, { 1, 0 }, { 2, 1 }, { -3, -3 }, { -2, -2 },
+    { -2, -2 }, { -1, -1 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -2 }, { 0, -1 },
+    { 0, -1 }, { 1, 0 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { -1, -1 }, { 0, 0 }, { 0, 0 },
+    { 1, 1 }, { 0, 0 }, { 1, 1 }, { 1, 0 }, { 2, 1 }, { -3, -3 }, { -2, -2 },
+    { -2, -2 }, { -1, -1 }, { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 },
+    { 0, -1 }, { 1, 0 }, { -3, -3 }, { -2, -2 }, { -2, -2 }, { -1, -1 },
+    { -2, -2 }, { -1, -1 }, { -1, -1 }, { 0, 0 }, { -2, -2 }, { -1, -1 },
+    { -1, -1 }, { 0, 0 }, { -1, -1 }, { 0, 0 }, { 0, 0 }, { 1, 1 }, { -4, -4 },
+    { -3, -3 }, { -3, -3 }, { -2, -2 }, { -3, -3 }, { -2, -2 }, { -2, -2 },
+    { -1, -1 }, { -3, -3 }, { -2, -2 }, { -2, -2 }, { -1, -1 }, { -2, -2 },
+    { -1, -1 }, { -1, -1 }, { 0, 0 }
+};
+
+// best score of the final row of a pair, column zero (M) included
+static int ED_batch_best( ED_BATCH_PAIR *pair, unsigned long long int P_D,
+  unsigned long long int P_S_or_P_D ) {
+
+    unsigned long long int P_DErase = P_D & pair->scored;
+    unsigned long long int P_IErase = ~P_S_or_P_D & pair->scored;
+    int                    i, walk;
+    int                    Score = pair->M;
+    int                    best  = pair->M;
+
+    for ( i = 0; i < wordSize; i += 4 ) {
+        walk = (int) ( ( ( P_DErase >> i ) & 0xF ) << 4 |
+                       ( ( P_IErase >> i ) & 0xF ) );
+
+        if ( Score + NibbleWalk[walk].min < best )
+            best = Score + NibbleWalk[walk].min;
+
+        Score += NibbleWalk[walk].sum;
+    }
+
+    return ( best );
+}
+
+// aligns up to LANES pairs, one per lane of VTYPE, the row update is the
+// one of Edit_Distance_multiple_word_NoEndPenaltySeq1 for the first word
+#define ED_BATCH_ALIGN( VTYPE, LANES )                                        \
+    VTYPE P_D, P_S_or_P_D, rows, active, matchString, M_m, R_IS, not_M_I,     \
+      not_M_I_xor_P_D, sum, sum_and_R_IS, VC_0, VC_plus_1, VC_0_shift,        \
+      VC_plus_1_shift;                                                        \
+    int l, i, maxM = 0;                                                       \
+                                                                              \
+    for ( l = 0; l < LANES; l++ ) {                                           \
+        rows[l] = ( l < count ) ? (unsigned long long int) pairs[l].M : 0;    \
+        if ( l < count && pairs[l].M > maxM )                                 \
+            maxM = pairs[l].M;                                                \
+    }                                                                         \
+                                                                              \
+    /* row zero, D in the zero position */                                    \
+    P_D        = ( VTYPE ){ 0 } + 1;                                          \
+    P_S_or_P_D = P_D;                                                         \
+                                                                              \
+    for ( i = 0; i < maxM; i++ ) {                                            \
+        for ( l = 0; l < LANES; l++ ) {                                       \
+            matchString[l] =                                                  \
+              ( i >= (int) rows[l] )                                          \
+                ? 0                                                           \
+                : ( pairs[l].stringM )                                        \
+                    ? pairs[l].match[ED_batch_code[(unsigned char) pairs[l]   \
+                                                     .stringM[i]]]            \
+                    : pairs[l].match[PackedSeqViewCode(                       \
+                        &pairs[l].viewM, i )];                                \
+        }                                                                     \
+                                                                              \
+        active = (VTYPE) ( rows > (unsigned long long int) i );               \
+                                                                              \
+        M_m             = matchString | P_D;                                  \
+        R_IS            = ~M_m;                                               \
+        not_M_I         = R_IS | P_S_or_P_D;                                  \
+        not_M_I_xor_P_D = not_M_I ^ P_D;                                      \
+        sum             = not_M_I + P_S_or_P_D;                               \
+        sum_and_R_IS    = sum & R_IS;                                         \
+        VC_0            = sum_and_R_IS ^ not_M_I_xor_P_D;                     \
+        VC_plus_1       = P_D | ( sum_and_R_IS & P_S_or_P_D );                \
+        VC_0_shift      = VC_0 << 1;                                          \
+        VC_plus_1_shift = ( VC_plus_1 << 1 ) + 1;                             \
+                                                                              \
+        /* finished lanes keep their final row */                             \
+        P_S_or_P_D = ( ( VC_plus_1_shift | ( M_m & VC_0_shift ) ) & active ) | \
+                     ( P_S_or_P_D & ~active );                                \
+        P_D = ( ( M_m & VC_plus_1_shift ) & active ) | ( P_D & ~active );     \
+    }                                                                         \
+                                                                              \
+    for ( l = 0; l < count; l++ ) {                                           \
+        *pairs[l].result = ED_batch_best( &pairs[l], P_D[l], P_S_or_P_D[l] ); \
+    }
+
+static void ED_batch_align2( ED_BATCH_PAIR *pairs, int count ) {
+    ED_BATCH_ALIGN( ED_V2, 2 )
+}
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+
+__attribute__( ( target( "avx2" ) ) ) static void ED_batch_align4(
+  ED_BATCH_PAIR *pairs, int count ) {
+    ED_BATCH_ALIGN( ED_V4, 4 )
+}
+
+__attribute__( ( target( "avx512f" ) ) ) static void ED_batch_align8(
+  ED_BATCH_PAIR *pairs, int count ) {
+    ED_BATCH_ALIGN( ED_V8, 8 )
+}
+
+#endif
+
+void ED_batch_init( ED_BATCH *eb ) {
+
+    memset( eb, 0, sizeof( ED_BATCH ) );
+
+    eb->lanes = 2;
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+    __builtin_cpu_init();
+
+    if ( __builtin_cpu_supports( "avx512f" ) )
+        eb->lanes = 8;
+    else if ( __builtin_cpu_supports( "avx2" ) )
+        eb->lanes = 4;
+#endif
+}
+
+// queues a checked pair
+static ED_BATCH_PAIR *ED_batch_pair( ED_BATCH *eb,
+  EDIT_DISTANCE_PATTERN *pattern, int N, int M, int *result ) {
+
+    ED_BATCH_PAIR *pair;
+
+    if ( eb->npairs >= eb->maxpairs ) {
+        eb->maxpairs = ( eb->maxpairs ) ? 2 * eb->maxpairs : 256;
+        eb->pairs    = (ED_BATCH_PAIR *) realloc(
+          eb->pairs, eb->maxpairs * sizeof( ED_BATCH_PAIR ) );
+
+        if ( eb->pairs == NULL ) {
+            fprintf( stderr, "\nERROR: Unable to grow edit distance batch" );
+            exit( 1 );
+        }
+    }
+
+    pair           = &eb->pairs[eb->npairs++];
+    pair->match[0] = pattern->matchA[0];
+    pair->match[1] = pattern->matchC[0];
+    pair->match[2] = pattern->matchG[0];
+    pair->match[3] = pattern->matchT[0];
+    pair->match[4] = pattern->matchN[0];
+    pair->M        = M;
+    pair->result   = result;
+
+    // columns 1 to N
+    pair->scored = ( 0xFFFFFFFFFFFFFFFF >> ( wordSize - 1 - N ) ) &
+                   ~0x0000000000000001ULL;
+
+    return ( pair );
+}
+
+int ED_batch_add( ED_BATCH *eb, EDIT_DISTANCE_PATTERN *pattern, int N,
+  char *stringM, int M, int *result ) {
+
+    ED_BATCH_PAIR *pair;
+    int            i;
+
+    if ( M == 0 ) {
+        *result = 0;
+        return ( 1 );
+    }
+
+    // one word holds the zero column and wordSize - 1 characters
+    if ( N > wordSize - 1 || N > pattern->N || N >= pattern->badPosition )
+        return ( 0 );
+
+    // the single pair kernel reports these
+    for ( i = 0; i < M; i++ ) {
+        switch ( stringM[i] ) {
+        case 'A':
+        case 'C':
+        case 'G':
+        case 'T':
+        case 'N':
+            break;
+        default:
+            return ( 0 );
+        }
+    }
+
+    pair          = ED_batch_pair( eb, pattern, N, M, result );
+    pair->stringM = stringM;
+
+    return ( 1 );
+}
+
+int ED_batch_add_view( ED_BATCH *eb, EDIT_DISTANCE_PATTERN *pattern, int N,
+  const PACKEDSEQ_VIEW *viewM, int *result ) {
+
+    ED_BATCH_PAIR *pair;
+
+    if ( viewM->length == 0 ) {
+        *result = 0;
+        return ( 1 );
+    }
+
+    if ( N > wordSize - 1 || N > pattern->N || N >= pattern->badPosition ||
+         PackedSeqViewBad( viewM, 0, viewM->length ) >= 0 )
+        return ( 0 );
+
+    pair          = ED_batch_pair( eb, pattern, N, viewM->length, result );
+    pair->stringM = NULL;
+    pair->viewM   = *viewM;
+
+    return ( 1 );
+}
+
+static int ED_batch_longer( const void *a, const void *b ) {
+    return ( (const ED_BATCH_PAIR *) b )->M - ( (const ED_BATCH_PAIR *) a )->M;
+}
+
+void ED_batch_run( ED_BATCH *eb ) {
+
+    int first, count;
+
+    qsort( eb->pairs, eb->npairs, sizeof( ED_BATCH_PAIR ), ED_batch_longer );
+
+    for ( first = 0; first < eb->npairs; first += eb->lanes ) {
+        count = eb->npairs - first;
+
+        if ( count > eb->lanes )
+            count = eb->lanes;
+
+        switch ( eb->lanes ) {
+#if defined( __x86_64__ ) || defined( __i386__ )
+        case 8:
+            ED_batch_align8( eb->pairs + first, count );
+            break;
+
+        case 4:
+            ED_batch_align4( eb->pairs + first, count );
+            break;
+#endif
+        default:
+            ED_batch_align2( eb->pairs + first, count );
+            break;
+        }
+    }
+
+    eb->npairs = 0;
+}
+
+void ED_batch_free( ED_BATCH *eb ) {
+
+    free( eb->pairs );
+    memset( eb, 0, sizeof( ED_BATCH ) );
+}
@@ -0,0 +1,46 @@
+/*
+ *  bitwise_edit_distance_batch.h
+ *  bitwise no end penalty edit distance of many independent pairs
+ *
+ *  Pairs whose stringN fits one 64 bit word are aligned side by
+ *  side, one pair per vector lane: 8 with AVX-512, 4 with AVX2 and
+ *  2 otherwise, picked at run time. Results are the same as
+ *  Edit_Distance_multiple_word_NoEndPenaltySeq1 for the pair.
+ *
+ */
+
+#ifndef BITWISE_EDIT_DISTANCE_BATCH_H
+#define BITWISE_EDIT_DISTANCE_BATCH_H
+
+#include "bitwise_edit_distance.h"
+
+typedef struct {
+    unsigned long long int match[5]; // A, C, G, T, N word of stringN
+    unsigned long long int scored;   // columns of the final row scored
+    char *                 stringM;  // not copied, NULL for a view
+    PACKEDSEQ_VIEW         viewM;
+    int                    M;
+    int *                  result;
+} ED_BATCH_PAIR;
+
+typedef struct {
+    int            lanes; // pairs aligned at once
+    ED_BATCH_PAIR *pairs;
+    int            npairs, maxpairs;
+} ED_BATCH;
+
+// picks the lanes for the CPU
+void ED_batch_init( ED_BATCH *eb );
+// Queues stringM against the first N characters of a prepared stringN,
+// *result is set by ED_batch_run. Returns 0 if the pair can not be
+// batched (stringN longer than a word, bad characters), the caller then
+// aligns it with the single pair kernel.
+int ED_batch_add( ED_BATCH *eb, EDIT_DISTANCE_PATTERN *pattern, int N,
+  char *stringM, int M, int *result );
+// the same with stringM the whole view
+int ED_batch_add_view( ED_BATCH *eb, EDIT_DISTANCE_PATTERN *pattern, int N,
+  const PACKEDSEQ_VIEW *viewM, int *result );
+void ED_batch_run( ED_BATCH *eb );
+void ED_batch_free( ED_BATCH *eb );
+
+#endif
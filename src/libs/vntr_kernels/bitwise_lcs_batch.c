@@ -0,0 +1,276 @@
+/*
+ *  bitwise_lcs_batch.c
+ *  bitwise LCS of one prepared string against many strings
+ *
+ *  The prepared string is laid out horizontally (character i at
+ *  bit i), each compared string is processed one character per
+ *  row. The LCS is symmetric, so this gives the same length as
+ *  LCS_multiple_word whichever string is longer. Strings with
+ *  characters other than ACGTN are handed to LCS_multiple_word.
+ *
+ */
+
+#include "bitwise_lcs_batch.h"
+#include "bitwise_lcs_multiple_word.h"
+#include "packed_sequence.h"
+#include "vntr_kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define wordSize 64
+
+// A C G T N -> 0 - 4, anything else -> -1
+static signed char LCS_batch_code( char c ) {
+    switch ( c ) {
+    case 'A':
+        return 0;
+
+    case 'C':
+        return 1;
+
+    case 'G':
+        return 2;
+
+    case 'T':
+        return 3;
+
+    case 'N':
+        return 4;
+
+    default:
+        return -1;
+    }
+}
+
+// match vectors for a string of length characters
+static void LCS_batch_storage( LCS_BATCH *lb, int length ) {
+
+    lb->length = length;
+    lb->valid  = 1;
+    lb->nwords = length / wordSize + 1;
+
+    if ( lb->nwords > lb->maxwords ) {
+        lb->maxwords = 2 * lb->nwords;
+        lb->match    = (unsigned long long int *) realloc(
+          lb->match, 5 * lb->maxwords * sizeof( unsigned long long int ) );
+        lb->complement = (unsigned long long int *) realloc(
+          lb->complement, lb->maxwords * sizeof( unsigned long long int ) );
+
+        if ( NULL == lb->match || NULL == lb->complement ) {
+            printf( "\nError, unable to allocate LCS match vectors for a "
+                    "string of %d characters",
+              length );
+            exit( 1 );
+        }
+    }
+
+    memset(
+      lb->match, 0, 5 * lb->nwords * sizeof( unsigned long long int ) );
+}
+
+void LCS_batch_prepare( LCS_BATCH *lb, char *string, int length ) {
+
+    int i, code;
+
+    LCS_batch_storage( lb, length );
+    lb->string = string;
+
+    for ( i = 0; i < length; i++ ) {
+        code = LCS_batch_code( string[i] );
+
+        if ( code < 0 ) {
+            lb->valid = 0;
+            return;
+        }
+
+        lb->match[code * lb->nwords + i / wordSize] |= 1ULL
+                                                       << ( i % wordSize );
+    }
+}
+
+void LCS_batch_prepare_view( LCS_BATCH *lb, const PACKEDSEQ_VIEW *view ) {
+
+    int i;
+
+    // characters other than ACGTN go to LCS_multiple_word, which needs them
+    free( lb->unpacked );
+    lb->unpacked = NULL;
+
+    if ( PackedSeqViewBad( view, 0, view->length ) >= 0 ) {
+        lb->unpacked = PackedSeqViewString( view );
+
+        if ( NULL == lb->unpacked ) {
+            printf( "\nError, unable to unpack a string of %d characters",
+              view->length );
+            exit( 1 );
+        }
+
+        LCS_batch_prepare( lb, lb->unpacked, view->length );
+        return;
+    }
+
+    LCS_batch_storage( lb, view->length );
+    lb->string = NULL;
+    lb->view   = *view;
+
+    for ( i = 0; i < view->length; i++ ) {
+        lb->match[PackedSeqViewCode( view, i ) * lb->nwords + i / wordSize] |=
+          1ULL << ( i % wordSize );
+    }
+}
+
+// characters of the prepared string, a view is unpacked the first time
+static char *LCS_batch_string( LCS_BATCH *lb ) {
+
+    if ( NULL == lb->string ) {
+        lb->unpacked = PackedSeqViewString( &lb->view );
+
+        if ( NULL == lb->unpacked ) {
+            printf( "\nError, unable to unpack a string of %d characters",
+              lb->length );
+            exit( 1 );
+        }
+
+        lb->string = lb->unpacked;
+    }
+
+    return lb->string;
+}
+
+// rows of LCS_batch_one for a valid prepared string, string is read from
+// view when that is given. Returns -1 at a character other than ACGTN.
+static inline __attribute__( ( always_inline ) ) int LCS_batch_rows(
+  LCS_BATCH *lb, char *string, const PACKEDSEQ_VIEW *view, int length ) {
+
+    unsigned long long int complement, onlyOnesNotInOriginal, addResult;
+    unsigned long long int carryBit, *matchVector, *Complement;
+    int                    i, j, code, countOneBits;
+
+    // prepared string fits one word, keep the row in a register
+    if ( 1 == lb->nwords ) {
+        complement = ~0ULL;
+
+        for ( i = 0; i < length; i++ ) {
+            code = ( view ) ? PackedSeqViewCode( view, i )
+                            : LCS_batch_code( string[i] );
+
+            if ( code < 0 )
+                return ( -1 );
+
+            onlyOnesNotInOriginal = complement & lb->match[code];
+            complement = ( complement + onlyOnesNotInOriginal ) |
+                         ( complement ^ onlyOnesNotInOriginal );
+        }
+
+        return __builtin_popcountll( ~complement );
+    }
+
+    Complement = lb->complement;
+
+    for ( j = 0; j < lb->nwords; j++ )
+        Complement[j] = ~0ULL;
+
+    for ( i = 0; i < length; i++ ) {
+        code = ( view ) ? PackedSeqViewCode( view, i )
+                        : LCS_batch_code( string[i] );
+
+        if ( code < 0 )
+            return ( -1 );
+
+        matchVector = lb->match + code * lb->nwords;
+        carryBit    = 0;
+
+        for ( j = 0; j < lb->nwords; j++ ) {
+            complement            = Complement[j];
+            onlyOnesNotInOriginal = complement & matchVector[j];
+
+            // add with the carry of the previous word
+            addResult = complement + carryBit;
+            carryBit  = ( addResult < carryBit );
+            addResult += onlyOnesNotInOriginal;
+            carryBit |= ( addResult < onlyOnesNotInOriginal );
+
+            Complement[j] =
+              addResult | ( complement ^ onlyOnesNotInOriginal );
+        }
+    }
+
+    countOneBits = 0;
+
+    for ( j = 0; j < lb->nwords; j++ )
+        countOneBits += __builtin_popcountll( ~Complement[j] );
+
+    return countOneBits;
+}
+
+VNTR_KERNEL int LCS_batch_one( LCS_BATCH *lb, char *string, int length ) {
+
+    int lcs = -1;
+
+    if ( lb->valid )
+        lcs = LCS_batch_rows( lb, string, NULL, length );
+
+    // same call as before, for the pairs this can't reproduce
+    if ( lcs < 0 )
+        return LCS_multiple_word(
+          string, LCS_batch_string( lb ), length, lb->length );
+
+    return lcs;
+}
+
+VNTR_KERNEL int LCS_batch_one_view(
+  LCS_BATCH *lb, const PACKEDSEQ_VIEW *view ) {
+
+    char *string;
+    int   lcs;
+
+    if ( lb->valid && PackedSeqViewBad( view, 0, view->length ) < 0 )
+        return LCS_batch_rows( lb, NULL, view, view->length );
+
+    string = PackedSeqViewString( view );
+
+    if ( NULL == string ) {
+        printf( "\nError, unable to unpack a string of %d characters",
+          view->length );
+        exit( 1 );
+    }
+
+    lcs = LCS_batch_one( lb, string, view->length );
+    free( string );
+
+    return lcs;
+}
+
+int LCS_batch_filter( LCS_BATCH *lb, char **strings, int *lengths, int count,
+  double cutoff, int *keep ) {
+    // keeps (in order) the indices of the strings whose LCS with the prepared
+    // string is at least cutoff of the shorter one, rounded, but never the
+    // whole shorter string
+    // returns the number of indices in keep
+
+    int i, shortest, minlen, nkeep = 0;
+
+    for ( i = 0; i < count; i++ ) {
+        shortest = ( lengths[i] < lb->length ) ? lengths[i] : lb->length;
+        minlen   = (int) ( shortest * cutoff + .5 );
+
+        if ( minlen > shortest - 1 )
+            minlen = shortest - 1;
+
+        if ( LCS_batch_one( lb, strings[i], lengths[i] ) >= minlen )
+            keep[nkeep++] = i;
+    }
+
+    return nkeep;
+}
+
+void LCS_batch_free( LCS_BATCH *lb ) {
+    free( lb->match );
+    free( lb->complement );
+    free( lb->unpacked );
+    lb->match      = NULL;
+    lb->complement = NULL;
+    lb->unpacked   = NULL;
+    lb->maxwords   = 0;
+}
@@ -0,0 +1,37 @@
+/*
+ *  bitwise_lcs_batch.h
+ *  bitwise LCS of one prepared string against many strings
+ *
+ *  The match vectors of the prepared string are built once and
+ *  reused for every string it is compared with, results are the
+ *  same as LCS_multiple_word for the same pair.
+ *
+ */
+
+#ifndef BITWISE_LCS_BATCH_H
+#define BITWISE_LCS_BATCH_H
+
+#include "packed_sequence.h"
+
+typedef struct {
+    char *                  string; // prepared string (not copied)
+    PACKEDSEQ_VIEW          view;   // prepared view, when string is NULL
+    int                     length;
+    int                     valid;  // 0 if it has characters other than ACGTN
+    int                     nwords; // 64 bit words per match vector
+    int                     maxwords;
+    unsigned long long int *match;      // 5 vectors (A, C, G, T, N) of nwords
+    unsigned long long int *complement; // workspace of nwords
+    char *                  unpacked;   // view with characters other than ACGTN
+} LCS_BATCH;
+
+void LCS_batch_prepare( LCS_BATCH *lb, char *string, int length );
+int  LCS_batch_one( LCS_BATCH *lb, char *string, int length );
+// the same with packed views, zero fill lb before the first prepare
+void LCS_batch_prepare_view( LCS_BATCH *lb, const PACKEDSEQ_VIEW *view );
+int  LCS_batch_one_view( LCS_BATCH *lb, const PACKEDSEQ_VIEW *view );
+int  LCS_batch_filter( LCS_BATCH *lb, char **strings, int *lengths, int count,
+   double cutoff, int *keep );
+void LCS_batch_free( LCS_BATCH *lb );
+
+#endif
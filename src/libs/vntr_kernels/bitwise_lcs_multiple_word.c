@@ -1,5 +1,5 @@
 /*
- *  bitwise LCS multiple word.c
+ *  bitwise_lcs_multiple_word.c
  *  linear time bitwise LCS
  *
  *  Created by Gary Benson on 8/15/11.
@@ -8,9 +8,10 @@
  *
  */
 
-#include "bitwise LCS multiple word.h"
-#include "bitwise LCS single word.h"
-#include "convert to bitstring64.h"
+#include "bitwise_lcs_multiple_word.h"
+#include "vntr_kernels.h"
+#include "bitwise_lcs_single_word.h"
+#include "bitstring64.h"
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,7 +27,7 @@
     free( matchN );       \
     free( Complement );
 
-int LCS_multiple_word( char *string1, char *string2, int n, int m ) {
+VNTR_KERNEL int LCS_multiple_word( char *string1, char *string2, int n, int m ) {
     // the procedure computes fast bitwise LCS
     // n is the length of string1
     // m is the length of string2
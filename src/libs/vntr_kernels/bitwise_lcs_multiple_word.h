@@ -1,5 +1,5 @@
 /*
- *  bitwise LCS.h
+ *  bitwise_lcs_multiple_word.h
  *  linear time bitwise LCS
  *
  *  Created by Gary Benson on 8/15/11.
@@ -7,6 +7,11 @@
  *
  */
 
+#ifndef BITWISE_LCS_MULTIPLE_WORD_H
+#define BITWISE_LCS_MULTIPLE_WORD_H
+
 #define maxStringLengthForRegister 63
 
-int LCS_multiple_word( char *string1, char *string2, int n, int m );
\ No newline at end of file
+int LCS_multiple_word( char *string1, char *string2, int n, int m );
+
+#endif
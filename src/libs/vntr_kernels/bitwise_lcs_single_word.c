@@ -1,5 +1,5 @@
 /*
- *  bitwise LCS.c
+ *  bitwise_lcs_single_word.c
  *  linear time bitwise LCS
  *
  *  Created by Gary Benson on 8/15/11.
@@ -8,8 +8,9 @@
  *
  */
 
-#include "bitwise LCS single word.h"
-#include "convert to bitstring64.h"
+#include "bitwise_lcs_single_word.h"
+#include "bitstring64.h"
+#include "vntr_kernels.h"
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,7 +18,7 @@
 
 #define wordSize 64
 
-int LCS_single_word( char *string1, char *string2, int n, int m ) {
+VNTR_KERNEL int LCS_single_word( char *string1, char *string2, int n, int m ) {
     // the procedure computes fast bitwise LCS
     // n is the length of string1
     // m is the length of string2
@@ -0,0 +1,99 @@
+/*
+ *  min_representation.c
+ *  minimum representation of a profile and its reverse complement
+ *
+ */
+
+#include "min_representation.h"
+#include <stddef.h>
+#include <string.h>
+
+int LeastRotation( const int *indices, int length ) {
+
+    int i = 0, j, k, least = 0;
+
+    // Duval: the least rotation starts the last Lyndon word that begins
+    // before length in the factorization of the indices written twice
+    while ( i < length ) {
+        least = i;
+        j     = i + 1;
+        k     = i;
+
+        while ( j < 2 * length ) {
+            int a = indices[( k < length ) ? k : k - length];
+            int b = indices[( j < length ) ? j : j - length];
+
+            if ( a > b )
+                break;
+
+            k = ( a < b ) ? i : k + 1;
+            j++;
+        }
+
+        while ( i <= k )
+            i += j - k;
+    }
+
+    return ( least );
+}
+
+int RotationCmp( const int *indices1, int length1, int offset1,
+  const int *indices2, int length2, int offset2 ) {
+
+    int i;
+
+    if ( length1 != length2 )
+        return ( ( length1 > length2 ) ? 1 : -1 );
+
+    for ( i = 0; i < length1; i++ ) {
+        if ( indices1[offset1] != indices2[offset2] )
+            return ( ( indices1[offset1] > indices2[offset2] ) ? 1 : -1 );
+
+        if ( ++offset1 == length1 )
+            offset1 = 0;
+
+        if ( ++offset2 == length2 )
+            offset2 = 0;
+    }
+
+    return ( 0 );
+}
+
+int MinRepresentation( const int *indices, int length, const int *rcindices,
+  int lengthrc, int rotate, MINREP *mr ) {
+
+    int offset = 0, offsetrc = 0;
+
+    if ( NULL == indices || NULL == rcindices )
+        return ( -1 );
+
+    if ( rotate ) {
+        offset   = LeastRotation( indices, length );
+        offsetrc = LeastRotation( rcindices, lengthrc );
+    }
+
+    if ( RotationCmp( rcindices, lengthrc, offsetrc, indices, length, offset ) <
+         0 ) {
+        mr->indices = rcindices;
+        mr->length  = lengthrc;
+        mr->offset  = offsetrc;
+        mr->rc      = 1;
+    } else {
+        mr->indices = indices;
+        mr->length  = length;
+        mr->offset  = offset;
+        mr->rc      = 0;
+    }
+
+    return ( 0 );
+}
+
+int *MinRepresentationCopy( const MINREP *mr, int *dest ) {
+
+    memcpy( dest, mr->indices + mr->offset,
+      sizeof( int ) * ( mr->length - mr->offset ) );
+    memcpy( dest + mr->length - mr->offset, mr->indices,
+      sizeof( int ) * mr->offset );
+
+    return ( dest );
+}
@@ -0,0 +1,40 @@
+/*
+ *  min_representation.h
+ *  minimum representation of a profile and its reverse complement
+ *
+ *  The key redund and trf2proclu-ngs sort profiles by: the smaller of
+ *  the profile and its reverse complement (shorter first, then index
+ *  by index as pindcmp compares) or, with rotations, the smallest
+ *  rotation of either. The least rotation of a strand is found in
+ *  linear time without copying it (Duval's algorithm), the key is
+ *  given as the strand and the rotation it starts at. Only a caller
+ *  that needs it in one piece copies it, into a buffer of its own.
+ *
+ */
+
+#ifndef MIN_REPRESENTATION_H
+#define MIN_REPRESENTATION_H
+
+typedef struct {
+    const int *indices; // of the strand the key comes from
+    int        length;
+    int        offset;  // the key starts at indices[offset] and wraps around
+    int        rc;      // 1 if it is the reverse complement
+} MINREP;
+
+// first index of the smallest rotation of the indices
+int LeastRotation( const int *indices, int length );
+
+// compares two rotated index arrays as pindcmp compares their copies
+int RotationCmp( const int *indices1, int length1, int offset1,
+  const int *indices2, int length2, int offset2 );
+
+// key of a profile, rotated when rotate is set, the forward strand
+// wins a tie, returns -1 without a reverse complement
+int MinRepresentation( const int *indices, int length, const int *rcindices,
+  int lengthrc, int rotate, MINREP *mr );
+
+// the key in one piece, in dest (mr->length ints), returns dest
+int *MinRepresentationCopy( const MINREP *mr, int *dest );
+
+#endif
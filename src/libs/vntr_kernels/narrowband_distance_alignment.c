@@ -1,5 +1,5 @@
 /*
- *  narrowbandDistanceAlignment.c
+ *  narrowband_distance_alignment.c
  *  NarrowbandDistanceAlignment
  *
  *  Created by Gary Benson on 1/20/12.
@@ -9,14 +9,16 @@
 
 //#define debug
 
-#include "narrowbandDistanceAlignment.h"
+#include "narrowband_distance_alignment.h"
+#include "vntr_kernels.h"
+#include "packed_sequence.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 #define min3( a, b, c ) \
     ( ( a <= b ) ? ( ( a <= c ) ? a : c ) : ( ( b <= c ) ? b : c ) )
 
-int narrowbandUnitCostDistanceNoEndPenaltySeq2(
+VNTR_KERNEL int narrowbandUnitCostDistanceNoEndPenaltySeq2(
   char *seq1, char *seq2, int len1, int len2, int maxerr ) {
     // seq 1 is on left side
     // seq 2 is across top
@@ -139,7 +141,7 @@ int narrowbandUnitCostDistanceNoEndPenaltySeq2(
     return ( score );
 }
 
-int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMem(
+VNTR_KERNEL int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMem(
   char *seq1, char *seq2, int len1, int len2, int maxerr ) {
     // seq 1 is on left side
     // seq 2 is across top
@@ -325,7 +327,7 @@ int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMem(
     return ( score );
 }
 
-int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMemUsesPointers(
+VNTR_KERNEL int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMemUsesPointers(
   char *seq1, char *seq2, int len1, int len2, int maxerr ) {
     // seq 1 is on left side
     // seq 2 is across top
@@ -530,8 +532,25 @@ int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMemUsesPointers(
     return ( score );
 }
 
-int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
-  char *seq1, char *seq2, int len1, int len2, int maxerr ) {
+// 1 if the characters differ, codes are compared unless both are N or
+// another non ACGT character
+static inline int NarrowbandViewMismatch( const PACKEDSEQ_VIEW *view1,
+  int i, const PACKEDSEQ_VIEW *view2, int j ) {
+
+    int code1 = PackedSeqViewCode( view1, i );
+    int code2 = PackedSeqViewCode( view2, j );
+
+    if ( code1 < 4 || code2 < 4 )
+        return ( code1 != code2 );
+
+    return ( PackedSeqViewChar( view1, i ) != PackedSeqViewChar( view2, j ) );
+}
+
+// narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers,
+// the sequences are read from the views when those are given
+static inline __attribute__( ( always_inline ) ) int SameLengthBestScore(
+  char *seq1, char *seq2, const PACKEDSEQ_VIEW *view1,
+  const PACKEDSEQ_VIEW *view2, int len1, int len2, int maxerr ) {
     // seq 1 is on left side
     // seq 2 is across top
     // assumes sequences are same length
@@ -638,9 +657,14 @@ int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers
             if ( col == 0 )
                 ( *Sp ) = row; // column zero fill
             else {
-                match = ( seq1[row - 1] == seq2[from + col - leftboundary - 1] )
-                          ? 0
-                          : 1;
+                if ( view1 )
+                    match = NarrowbandViewMismatch(
+                      view1, row - 1, view2, from + col - leftboundary - 1 );
+                else
+                    match =
+                      ( seq1[row - 1] == seq2[from + col - leftboundary - 1] )
+                        ? 0
+                        : 1;
                 up       = ( *Spu ) + 1;
                 left     = ( *Spl ) + 1;
                 diagonal = ( *Spd ) + match;
@@ -774,3 +798,19 @@ int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers
     // minimum score from last row and column
     return ( score );
 }
+
+VNTR_KERNEL int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
+  char *seq1, char *seq2, int len1, int len2, int maxerr ) {
+
+    return ( SameLengthBestScore(
+      seq1, seq2, NULL, NULL, len1, len2, maxerr ) );
+}
+
+VNTR_KERNEL int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnView(
+  const PACKEDSEQ_VIEW *view1, const PACKEDSEQ_VIEW *view2, int maxerr ) {
+
+    // the same on packed views, len1 and len2 are their lengths
+
+    return ( SameLengthBestScore(
+      NULL, NULL, view1, view2, view1->length, view2->length, maxerr ) );
+}
@@ -1,11 +1,17 @@
 /*
- * narrowbandDistanceAlignment.h
+ * narrowband_distance_alignment.h
  * NarrowbandDistanceAlignment
  *
  * Created by Gary Benson on 1/20/12.
  * Copyright 2012 Boston University. All rights reserved.
  *
  */
+
+#ifndef NARROWBAND_DISTANCE_ALIGNMENT_H
+#define NARROWBAND_DISTANCE_ALIGNMENT_H
+
+#include "packed_sequence.h"
+
 int narrowbandUnitCostDistanceNoEndPenaltySeq2(
   char *seq1, char *seq2, int len1, int len2, int maxerr );
 int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMem(
@@ -14,3 +20,7 @@ int narrowbandUnitCostDistanceNoEndPenaltySeq2LowMemUsesPointers(
   char *seq1, char *seq2, int len1, int len2, int maxerr );
 int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
   char *seq1, char *seq2, int len1, int len2, int maxerr );
+int narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnView(
+  const PACKEDSEQ_VIEW *view1, const PACKEDSEQ_VIEW *view2, int maxerr );
+
+#endif
@@ -0,0 +1,200 @@
+/*
+ *  packed_sequence.c
+ *  2 bit packed nucleotide sequences and views of them
+ *
+ */
+
+#include "packed_sequence.h"
+#include <stdlib.h>
+#include <string.h>
+
+// code + 1 of each character, 0 for anything but A, C, G, T
+static const unsigned char PackedSeqCode[256] = {
+    ['A'] = 1, ['C'] = 2, ['G'] = 3, ['T'] = 4
+};
+
+static const char PackedSeqChar[] = "ACGTN";
+
+int PackSequence( PACKEDSEQ *ps, const char *sequence, int length ) {
+
+    size_t                  nwords = ( length + 31 ) / 32 + 1;
+    size_t                  maxwords;
+    unsigned long long int  word, nword;
+    unsigned long long int *words;
+    int                     i, code, bad = 0;
+
+    // the first sequence gets what it needs, later ones grow it twice over
+    if ( nwords > ps->maxwords ) {
+        maxwords = ( ps->maxwords ) ? 2 * nwords : nwords;
+        words    = (unsigned long long int *) realloc( ps->bases,
+          ( maxwords + maxwords / 2 + 1 ) * sizeof( unsigned long long int ) );
+
+        if ( words == NULL )
+            return ( -1 );
+
+        ps->maxwords = maxwords;
+        ps->bases    = words;
+        ps->nmask    = words + maxwords;
+    }
+
+    ps->length = length;
+    word = nword = 0;
+
+    for ( i = 0; i < length; i++ ) {
+        code = PackedSeqCode[(unsigned char) sequence[i]];
+
+        if ( code )
+            word |= (unsigned long long int) ( code - 1 ) << ( ( i & 31 ) << 1 );
+        else {
+            nword |= 1ULL << ( i & 63 );
+
+            if ( sequence[i] != 'N' )
+                bad = 1;
+        }
+
+        if ( 31 == ( i & 31 ) ) {
+            ps->bases[i >> 5] = word;
+            word              = 0;
+        }
+
+        if ( 63 == ( i & 63 ) ) {
+            ps->nmask[i >> 6] = nword;
+            nword             = 0;
+        }
+    }
+
+    ps->bases[length >> 5] = word;
+    ps->nmask[length >> 6] = nword;
+
+    free( ps->text );
+    ps->text = NULL;
+
+    if ( bad ) {
+        ps->text = (char *) malloc( length + 1 );
+
+        if ( ps->text == NULL )
+            return ( -1 );
+
+        memcpy( ps->text, sequence, length );
+        ps->text[length] = '\0';
+    }
+
+    return ( 0 );
+}
+
+void FreePackedSequence( PACKEDSEQ *ps ) {
+
+    free( ps->bases );
+    free( ps->text );
+    memset( ps, 0, sizeof( PACKEDSEQ ) );
+}
+
+PACKEDSEQ_VIEW PackedSeqView( const PACKEDSEQ *ps, int start, int length ) {
+
+    PACKEDSEQ_VIEW view;
+
+    view.seq    = ps;
+    view.origin = start;
+    view.step   = 1;
+    view.flip   = 0;
+    view.length = length;
+
+    return ( view );
+}
+
+PACKEDSEQ_VIEW PackedSeqViewReverse( PACKEDSEQ_VIEW view ) {
+
+    view.origin += view.step * ( view.length - 1 );
+    view.step = -view.step;
+
+    return ( view );
+}
+
+PACKEDSEQ_VIEW PackedSeqViewComplement( PACKEDSEQ_VIEW view ) {
+
+    view.flip ^= 3;
+
+    return ( view );
+}
+
+PACKEDSEQ_VIEW PackedSeqViewPrefix( PACKEDSEQ_VIEW view, int length ) {
+
+    if ( length < view.length )
+        view.length = length;
+
+    return ( view );
+}
+
+char PackedSeqViewChar( const PACKEDSEQ_VIEW *view, int i ) {
+
+    char c;
+
+    if ( view->seq->text == NULL )
+        return ( PackedSeqChar[PackedSeqViewCode( view, i )] );
+
+    c = view->seq->text[view->origin + view->step * i];
+
+    if ( view->flip ) {
+        switch ( c ) {
+        case 'A':
+            return ( 'T' );
+        case 'C':
+            return ( 'G' );
+        case 'G':
+            return ( 'C' );
+        case 'T':
+            return ( 'A' );
+        case 'a':
+            return ( 't' );
+        case 'c':
+            return ( 'g' );
+        case 'g':
+            return ( 'c' );
+        case 't':
+            return ( 'a' );
+        }
+    }
+
+    return ( c );
+}
+
+int PackedSeqViewBad( const PACKEDSEQ_VIEW *view, int from, int to ) {
+
+    int i;
+
+    if ( view->seq->text == NULL )
+        return ( -1 );
+
+    for ( i = from; i < to; i++ ) {
+        switch ( view->seq->text[view->origin + view->step * i] ) {
+        case 'A':
+        case 'C':
+        case 'G':
+        case 'T':
+        case 'N':
+            break;
+        default:
+            return ( i );
+        }
+    }
+
+    return ( -1 );
+}
+
+char *PackedSeqViewString( const PACKEDSEQ_VIEW *view ) {
+
+    char *string;
+    int   i;
+
+    string = (char *) malloc( view->length + 1 );
+
+    if ( string == NULL )
+        return ( NULL );
+
+    for ( i = 0; i < view->length; i++ )
+        string[i] = PackedSeqViewChar( view, i );
+
+    string[view->length] = '\0';
+
+    return ( string );
+}
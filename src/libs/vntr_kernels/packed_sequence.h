@@ -0,0 +1,73 @@
+/*
+ *  packed_sequence.h
+ *  2 bit packed nucleotide sequences and views of them
+ *
+ *  A, C, G and T are stored as 0-3, 32 bases per word (base i at
+ *  bits 2*(i%32) of word i/32). Any other character is stored as 0
+ *  and flagged in a separate mask, one bit per base. A sequence with
+ *  characters other than ACGTN also keeps a copy of its text, so the
+ *  kernels report them as they do for character strings.
+ *
+ *  A view is a range of a packed sequence read forward or backward,
+ *  complemented or not. Reversing or complementing a view only
+ *  changes how its bases are indexed, nothing is copied.
+ *
+ */
+
+#ifndef PACKED_SEQUENCE_H
+#define PACKED_SEQUENCE_H
+
+#include <stddef.h>
+
+typedef struct {
+    int                     length;
+    size_t                  maxwords;
+    unsigned long long int *bases; // 2 bits per base
+    unsigned long long int *nmask; // 1 bit per base, set for non ACGT
+    char *                  text;  // only with characters other than ACGTN
+} PACKEDSEQ;
+
+typedef struct {
+    const PACKEDSEQ *seq;
+    int              origin; // base of seq at position 0 of the view
+    int              step;   // 1, -1 for a reversed view
+    int              flip;   // 3 for a complemented view, 0 otherwise
+    int              length;
+} PACKEDSEQ_VIEW;
+
+// buffers grow and are reused, zero fill before the first call,
+// returns -1 if out of memory
+int  PackSequence( PACKEDSEQ *ps, const char *sequence, int length );
+void FreePackedSequence( PACKEDSEQ *ps );
+
+#define PACKEDSEQ_BASE( PS, I ) \
+    ( (int) ( ( ( PS )->bases[( I ) >> 5] >> ( ( ( I ) &31 ) << 1 ) ) & 3 ) )
+#define PACKEDSEQ_ISN( PS, I ) \
+    ( (int) ( ( ( PS )->nmask[( I ) >> 6] >> ( ( I ) &63 ) ) & 1 ) )
+
+// length bases of ps from start, forward
+PACKEDSEQ_VIEW PackedSeqView( const PACKEDSEQ *ps, int start, int length );
+PACKEDSEQ_VIEW PackedSeqViewReverse( PACKEDSEQ_VIEW view );
+PACKEDSEQ_VIEW PackedSeqViewComplement( PACKEDSEQ_VIEW view );
+PACKEDSEQ_VIEW PackedSeqViewPrefix( PACKEDSEQ_VIEW view, int length );
+
+// character at position i, complemented as GetComplement does
+char PackedSeqViewChar( const PACKEDSEQ_VIEW *view, int i );
+// first position from..to-1 holding a character other than ACGTN, -1 if
+// there is none
+int PackedSeqViewBad( const PACKEDSEQ_VIEW *view, int from, int to );
+// the characters of the view as a new string, NULL if out of memory
+char *PackedSeqViewString( const PACKEDSEQ_VIEW *view );
+
+// A C G T -> 0 - 3, anything else -> 4, at position i of the view
+static inline int PackedSeqViewCode( const PACKEDSEQ_VIEW *view, int i ) {
+
+    int p = view->origin + view->step * i;
+
+    if ( PACKEDSEQ_ISN( view->seq, p ) )
+        return ( 4 );
+
+    return ( PACKEDSEQ_BASE( view->seq, p ) ^ view->flip );
+}
+
+#endif
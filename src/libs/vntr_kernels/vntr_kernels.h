@@ -0,0 +1,59 @@
+/****************************************************************
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ ****************************************************************/
+
+/***************************************************************
+    vntr_kernels.h : The sequence comparison kernels of the
+                     pipeline (bitwise LCS, bitwise no end
+                     penalty edit distance, narrowband alignment),
+                     one copy linked by every tool. The flank
+                     kernels also take 2 bit packed sequences,
+                     read through reversed or complemented views
+                     instead of copies. The minimum representation
+                     key of redund and trf2proclu-ngs is here too.
+
+                     Binaries are built for the baseline x86-64
+                     and pick faster code for the CPU they run
+                     on: the scalar kernels marked VNTR_KERNEL
+                     are cloned for x86-64-v2 (SSE4.2, POPCNT),
+                     v3 (AVX2) and v4 (AVX-512) and resolved by
+                     the loader, the batch kernels choose their
+                     vector width at init.
+****************************************************************/
+
+#ifndef _VNTR_KERNELS_H
+#define _VNTR_KERNELS_H
+
+#if defined( __x86_64__ ) && defined( __linux__ ) && defined( __GNUC__ ) && \
+  !defined( __clang__ ) && __GNUC__ >= 12
+#define VNTR_KERNEL                                                        \
+    __attribute__( ( target_clones( "default", "arch=x86-64-v2",           \
+      "arch=x86-64-v3", "arch=x86-64-v4" ) ) )
+#else
+#define VNTR_KERNEL
+#endif
+
+#include "bitstring64.h"
+#include "bitwise_edit_distance.h"
+#include "bitwise_edit_distance_batch.h"
+#include "bitwise_lcs_batch.h"
+#include "bitwise_lcs_multiple_word.h"
+#include "bitwise_lcs_single_word.h"
+#include "min_representation.h"
+#include "narrowband_distance_alignment.h"
+#include "packed_sequence.h"
+
+#endif
@@ -1,10 +0,0 @@
-/*
- *  convert to bitstring.h
- *  bitwise edit distance alignment
- *
- *  Created by Gary Benson on 7/17/12.
- *  Copyright 2012 Boston University. All rights reserved.
- *
- */
-
-char *convertToBitString64( unsigned long long int number );
\ No newline at end of file
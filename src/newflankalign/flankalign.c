@@ -1,17 +1,41 @@
 /****************************************************************************************************
 
-   flankalign.c - creates .MAP files (using narrowband alignment)
+   flankalign.c - creates the .MAP file (using narrowband alignment)
 
-   Usage: ./flankalign outdir xmldir inputfile MAXERRORS MAXTHREADS
-PATLEN_SIZE_ERR
+   Usage: ./flankalign outfile xmldir inputfile MAXERRORS
+MAX_FLANK_CONSIDERED MAXTHREADS PATLEN_SIZE_ERR [refdb]
+
+   With refdb, inputfile is the run database: clusters are read from its
+   clusterlnk, replnk and fasta_reads tables and from fasta_ref_reps of
+   the reference database, with no flanks file in between.
+
+   All clusters go to one map file, a block per cluster in the order the
+   alignments finish:
+
+     @a1_a2<TAB>1<TAB>1<TAB>1<TAB>1<TAB>1
+     readid<TAB>'<TAB>leftlen<TAB>rightlen<TAB>1<TAB>1<TAB>1<TAB>refid:lerr:rerr,...
+     ...
+
+   Read lines of a block are in pattern size order, reads of the same
+   pattern size in their order in the cluster (this used to be left to
+   the random quicksort pivots). run_rankflankmap.pl ranks the refs of
+   each read from its own line and a read is in one cluster only, so
+   the line order does not change the map or rankflank tables.
+
+   followed by the index block, the offset and length in bytes of every
+   cluster block:
+
+     #index<TAB>clusters
+     a1_a2<TAB>offset<TAB>length
+     ...
 
 ****************************************************************************************************/
 
 #include <stdio.h>
 
-#include <sys/stat.h>
+#include <pthread.h>
+#include <sqlite3.h>
 #include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 
 #include <ctype.h>
@@ -29,18 +53,13 @@ PATLEN_SIZE_ERR
 #include "../libs/easylife/easylife.h"
 
 //#include "narrowbandDistanceAlignment.h"
-#include "bitwise edit distance alignment multiple word no end penalty.h"
+#include "../libs/vntr_kernels/vntr_kernels.h"
 
 //#include "aln.h"
 //#include "aln_nb.h"
 
 //#define PER_READ_STATS
 //#define PRINT_ALIGNMENTS
-int LARGESERRORALLOWED = 0;
-int MAXEL1             = 0;
-int MAXER1             = 0;
-int MAXEL2             = 0;
-int MAXER2             = 0;
 
 #define MATCH_SCORE ( 1 )
 #define MISM_PEN ( -3 )
@@ -55,143 +74,286 @@ int MAXTHREADS = ( 1 );
 int PATLEN_SIZE_ERR      = 0;
 int MAX_FLANK_CONSIDERED = 1000;
 
-char *Complementascii =
-  NULL; /* precomputed array used for the reverse complement function */
-int ThreadCounter = 0;
+/*******************************************************************************************/
+void doCriticalErrorAndQuit( const char *format, ... ) {
+
+    va_list argp;
+
+    printf( "\n\nERROR!!!!:\n" );
+    if ( format == NULL )
+        exit( 0 );
+    ;
+
+    va_start( argp, format );
+    vprintf( format, argp );
+    fflush( stdout );
+    va_end( argp );
+
+    exit( 1 );
+}
+
+/* reference flanks prepared for edit distance, once per cluster */
+typedef struct {
+    EDIT_DISTANCE_PATTERN leftpat, rightpat;
+    unsigned short *      leftgrams, *rightgrams; // q-gram at each position
+} FLANK_PREPARED;
+
+typedef struct {
+    long long int   id;
+    int             patsize, leftlen, rightlen;
+    int             order;    // in its cluster list, breaks patsize ties
+    PACKEDSEQ       seq;      // left flank then right flank, as in the read
+    FLANK_PREPARED *prepared; // references only
+} FLANK;
+
+/*******************************************************************************************/
+void flankDestroy( void *in ) {
 
-/********************************       init_complement_ascii
- * ****************************/
-char *init_complement_ascii( void )
+    FLANK *g = (FLANK *) in;
 
-{
-    /* complement has 256 entries so that finding the entries for A, C, G and T
-     * which are complement ascii values */
-    /* require no calculation */
-    int   i;
-    char *ca = (char *) calloc( 256, sizeof( int ) );
+    FreePackedSequence( &g->seq );
 
-    if ( ca == NULL ) {
-        return NULL;
+    if ( g->prepared ) {
+        Edit_Distance_multiple_word_NoEndPenaltySeq1_Free(
+          &g->prepared->leftpat );
+        Edit_Distance_multiple_word_NoEndPenaltySeq1_Free(
+          &g->prepared->rightpat );
+        free( g->prepared->leftgrams );
+        free( g->prepared->rightgrams );
+        sfree( g->prepared );
     }
 
-    for ( i = 0; i < 256; i++ )
-        ca[i] = i;
+    free( g );
+}
+
+/*******************************************************************************************/
+/* the flanks read outward from the repeat, the left one backwards */
+PACKEDSEQ_VIEW flankLeft( FLANK *f ) {
+
+    return PackedSeqViewReverse( PackedSeqView( &f->seq, 0, f->leftlen ) );
+}
 
-    ca['A'] = 'T';
-    ca['C'] = 'G';
-    ca['G'] = 'C';
-    ca['T'] = 'A';
-    ca['a'] = 't';
-    ca['c'] = 'g';
-    ca['g'] = 'c';
-    ca['t'] = 'a';
+PACKEDSEQ_VIEW flankRight( FLANK *f ) {
 
-    return ca;
+    return PackedSeqView( &f->seq, f->leftlen, f->rightlen );
 }
 
 /*******************************************************************************************/
-char *GetReverse( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-    if ( buffer == NULL ) {
-        return NULL;
-    }
+/* packs the two flanks of f into one sequence, only called by the thread
+ * reading the clusters */
+void packFlanks(
+  FLANK *f, const char *left, int leftlen, const char *right, int rightlen ) {
+
+    static char *joined    = NULL;
+    static int   maxjoined = 0;
+
+    if ( leftlen + rightlen > maxjoined ) {
+        maxjoined = 2 * ( leftlen + rightlen );
+        joined    = (char *) realloc( joined, maxjoined );
 
-    /* reverse pattern */
-    sourceptr  = original;
-    destinptr  = buffer + length; /* position at termination */
-    *destinptr = '\0';            /* terminate string */
-    destinptr--;
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = *sourceptr;
-        destinptr--;
-        sourceptr++;
+        if ( !joined )
+            doCriticalErrorAndQuit(
+              "\n\nFlankAlign - memory error 1. Aborting!\n\n" );
     }
 
-    /* return buffer containg reverse complement */
-    return buffer;
+    memcpy( joined, left, leftlen );
+    memcpy( joined + leftlen, right, rightlen );
+
+    if ( PackSequence( &f->seq, joined, leftlen + rightlen ) < 0 )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - memory error 1. Aborting!\n\n" );
+
+    f->leftlen  = leftlen;
+    f->rightlen = rightlen;
 }
 
-/***********************************************************************/
-char *GetComplement( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* safety check */
-    if ( Complementascii == NULL ) {
-        Complementascii = init_complement_ascii();
-        if ( NULL == Complementascii )
-            return NULL;
-    }
+/*******************************************************************************************/
+/* reference flanks as they are stored */
+FLANK *refFlank( long long int rid, char *flankleft, char *flankright,
+  int patsize ) {
 
-    /* find out how long the string is */
-    length = strlen( original );
+    FLANK *templ_flank_ptr = (FLANK *) scalloc( 1, sizeof( FLANK ) );
 
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-    if ( buffer == NULL ) {
-        return NULL;
-    }
+    packFlanks( templ_flank_ptr, flankleft, strlen( flankleft ), flankright,
+      strlen( flankright ) );
 
-    /* complement pattern */
-    sourceptr = original;
-    destinptr = buffer;
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = Complementascii[( *sourceptr )];
-        destinptr++;
-        sourceptr++;
-    }
-    *destinptr = '\0'; /* terminate string */
+    templ_flank_ptr->patsize = patsize;
+    templ_flank_ptr->id      = rid;
 
-    /* return buffer containg reverse complement */
-    return buffer;
+    return templ_flank_ptr;
 }
 
 /*******************************************************************************************/
-void doCriticalErrorAndQuit( const char *format, ... ) {
+/* read flanks around the repeat at first..last (1 based) of dna, at most
+ * MAX_FLANK_CONSIDERED long next to the repeat */
+FLANK *readFlank(
+  long long int rid, int start, int end, char *dna, int patsize ) {
 
-    va_list argp;
+    FLANK *templ_flank_ptr = (FLANK *) scalloc( 1, sizeof( FLANK ) );
+    int    length, repeatstart, leftlen, rightlen;
 
-    printf( "\n\nERROR!!!!:\n" );
-    if ( format == NULL )
-        exit( 0 );
-    ;
+    length      = strlen( dna );
+    repeatstart = max( 0, min( start - 1, length ) );
 
-    va_start( argp, format );
-    vprintf( format, argp );
-    fflush( stdout );
-    va_end( argp );
+    /* FOR FLANKSHORT */
+    leftlen  = repeatstart;
+    rightlen = max( 0, length - end );
 
-    exit( 1 );
+    if ( leftlen > MAX_FLANK_CONSIDERED )
+        leftlen = MAX_FLANK_CONSIDERED;
+    if ( rightlen > MAX_FLANK_CONSIDERED )
+        rightlen = MAX_FLANK_CONSIDERED;
+    /* ENDO OF FLANKSHORT */
+
+    packFlanks( templ_flank_ptr, dna + repeatstart - leftlen, leftlen,
+      ( rightlen ) ? dna + end : dna, rightlen );
+
+    templ_flank_ptr->patsize = patsize;
+    templ_flank_ptr->id      = rid;
+
+    return templ_flank_ptr;
 }
 
+/*******************************************************************************************/
+/* q-gram filter. A read flank of M characters aligned to a prefix of a
+ * reference flank with k errors keeps at least (its q-grams) - k * QGRAM
+ * of them unedited, each found at its own position of the prefix. When
+ * the reference flank (the N characters given to the alignment) shares
+ * fewer q-grams with the read flank the alignment has more than k errors
+ * and is skipped. q-grams with a non-ACGT character are left out on both
+ * sides. */
+#define QGRAM ( 4 )
+#define QGRAM_CODES ( 1 << ( 2 * QGRAM ) )
+#define QGRAM_NONE ( QGRAM_CODES ) // q-gram with a non-ACGT character
+
+/* q-grams of a read flank, counted once per read */
 typedef struct {
-    long long int id;
-    int           patsize, leftlen, rightlen;
-    char *        left;
-    char *        right;
-    char *        leftcp;
-    char *        rightcp;
-} FLANK;
+    unsigned short counts[QGRAM_CODES];
+    int            len;   // of the flank
+    int            grams; // counted, non-ACGT ones left out
+    int            clean; // only ACGTN, the alignment accepts it
+} QGRAM_COUNTS;
 
 /*******************************************************************************************/
-void flankDestroy( void *in ) {
+/* code of the q-gram starting at each position of a flank, the last
+ * QGRAM - 1 positions have none. Bases are coded A C G T -> 0 - 3, so the
+ * complement of a code is code ^ 3. */
+unsigned short *qgramCodes( const PACKEDSEQ_VIEW *view ) {
 
-    FLANK *g = (FLANK *) in;
+    unsigned short *codes;
+    int             i, b, code = 0, valid = 0, len = view->length;
 
-    free( g->left );
-    free( g->right );
-    free( g->leftcp );
-    free( g->rightcp );
-    free( g );
+    codes = (unsigned short *) malloc(
+      ( ( len > QGRAM ) ? len : QGRAM ) * sizeof( unsigned short ) );
+
+    if ( !codes )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - memory error 8. Aborting!\n\n" );
+
+    for ( i = 0; i < len; i++ ) {
+
+        b = PackedSeqViewCode( view, i );
+        if ( b > 3 ) {
+            valid = 0;
+            b     = 0;
+        } else {
+            valid++;
+        }
+
+        code = ( ( code << 2 ) | b ) & ( QGRAM_CODES - 1 );
+
+        if ( i >= QGRAM - 1 )
+            codes[i - QGRAM + 1] = ( valid >= QGRAM ) ? code : QGRAM_NONE;
+    }
+
+    return codes;
+}
+
+/*******************************************************************************************/
+void qgramCount( QGRAM_COUNTS *qc, const PACKEDSEQ_VIEW *view ) {
+
+    int i, b, code = 0, valid = 0;
+
+    memset( qc->counts, 0, sizeof( qc->counts ) );
+    qc->len   = view->length;
+    qc->grams = 0;
+    qc->clean = ( PackedSeqViewBad( view, 0, view->length ) < 0 );
+
+    for ( i = 0; i < view->length; i++ ) {
+
+        b = PackedSeqViewCode( view, i );
+        if ( b > 3 ) {
+            valid = 0;
+            b     = 0;
+        } else {
+            valid++;
+        }
+
+        code = ( ( code << 2 ) | b ) & ( QGRAM_CODES - 1 );
+
+        if ( valid >= QGRAM ) {
+            qc->counts[code]++;
+            qc->grams++;
+        }
+    }
+}
+
+/*******************************************************************************************/
+/* 1 if the first N characters of a prepared reference flank share too few
+ * q-grams with the read flank (its complement when flip is
+ * QGRAM_CODES - 1) for an alignment within maxerrors */
+int qgramSkip( QGRAM_COUNTS *qc, int flip, int M, unsigned short *refgrams,
+  EDIT_DISTANCE_PATTERN *pattern, int N, int maxerrors ) {
+
+    unsigned short left[QGRAM_CODES];
+    int            needed, shared, i, code;
+
+    // shortened reads and characters the alignment reports as errors
+    // go through it
+    if ( M != qc->len || !qc->clean || N >= pattern->badPosition )
+        return 0;
+
+    needed = qc->grams - maxerrors * QGRAM;
+    if ( needed <= 0 )
+        return 0;
+
+    memcpy( left, qc->counts, sizeof( left ) );
+    shared = 0;
+    for ( i = 0; i + QGRAM <= N; i++ ) {
+
+        code = refgrams[i];
+        if ( code != QGRAM_NONE && left[code ^ flip] ) {
+            left[code ^ flip]--;
+
+            if ( ++shared >= needed )
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+/* a reference in the size window of a read, with the flank errors of
+ * both directions */
+typedef struct {
+    FLANK *ref;
+    int    lerr1, rerr1, lerr2, rerr2;
+} FLANK_PAIR;
+
+/*******************************************************************************************/
+/* queues a flank alignment, those that do not fit the batch are aligned
+ * right away, counting errors up to maxerrors. Alignments the q-gram
+ * filter rules out get maxerrors + 1. */
+void flankQueue( ED_BATCH *batch, EDIT_DISTANCE_PATTERN *pattern,
+  unsigned short *refgrams, int N, PACKEDSEQ_VIEW read, QGRAM_COUNTS *qc,
+  int flip, int maxerrors, int *result ) {
+
+    if ( qgramSkip(
+           qc, flip, read.length, refgrams, pattern, N, maxerrors ) )
+        *result = maxerrors + 1;
+    else if ( !ED_batch_add_view( batch, pattern, N, &read, result ) )
+        *result = Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded_View(
+          pattern, N, &read, maxerrors );
 }
 
 /*******************************************************************************************/
@@ -207,85 +369,608 @@ int __patsizeCmp( const void *item1, const void *item2 ) {
     else if ( d1 < d2 )
         return -1;
 
-    return 0;
+    /* equal patsize stays in list order, whatever the pivots */
+    d1 = ( (FLANK *) item1 )->order;
+    d2 = ( (FLANK *) item2 )->order;
+
+    return ( d1 > d2 ) - ( d1 < d2 );
+}
+
+/* numbers the flanks of a list in their order, for __patsizeCmp */
+void numberFlanks( EASY_LIST *list ) {
+
+    EASY_NODE *nd;
+    int        i = 0;
+
+    for ( nd = list->head; nd != NULL; nd = nd->next )
+        ( (FLANK *) EasyListItem( nd ) )->order = i++;
 }
 
 /*******************************************************************************************/
-int main( int argc, char *argv[] ) {
+/* Clusters are aligned by a pool of MAXTHREADS threads. The main thread
+ * reads the clusters and deals their tasks to the least loaded thread
+ * queue. A thread takes the costliest task of its own queue and, when
+ * that is empty, steals the costliest task of the most loaded queue.
+ * The cost of a task is the number of reference-read pairs it may align,
+ * clusters costing more than SPLIT_COST are split into read ranges. Every
+ * range writes its map lines to memory, the last one to finish writes the
+ * cluster block to the map file. */
+#define SPLIT_COST ( 250000 )
+#define TASKS_PER_THREAD ( 4 ) // tasks waiting in the queues, per thread
 
-    char *outdir, *xmldir, *filename, *buffer, *src1, *src2, *src3, *src4,
-      *src5, *dst, tempbuf[2000];
-    FILE *        rd_fp;
-    long long int rid;
-    long long int processed = 0;
-    char *        hasdata   = NULL;
-    int           a1, a2, status, i, *PARR;
+typedef struct {
+    int        a1, a2;
+    EASY_LIST *ref_list, *read_list;
+    FLANK **   reads; // of read_list, sorted by patsize
+    int        nparts, partsleft;
+    char **    text; // map lines of every part
+    size_t *   textlen;
+} FLANK_CLUSTER;
 
-    /* cmd arguments */
-    if ( argc < 8 )
-        doCriticalErrorAndQuit(
-          "\n\nFlankAlign - Please use ./flankalign  outdir xmldir inputfile "
-          "MAXERRORS MAX_FLANK_CONSIDERED MAXTHREADS PATLEN_SIZE_ERR\n\n" );
+typedef struct {
+    FLANK_CLUSTER *cl;
+    int            part;
+    int            first, last; // reads of the part, last not included
+    long long int  cost;
+} FLANK_TASK;
 
-    outdir   = argv[1];
-    xmldir   = argv[2]; // never used
-    filename = argv[3];
+typedef struct {
+    FLANK_TASK **   tasks;
+    int             ntasks, maxtasks;
+    long long int   load; // cost of the tasks queued
+    pthread_mutex_t lock;
+} FLANK_QUEUE;
 
-    if ( argc >= 5 ) {
-        MAXERRORS = atoi( argv[4] );
-    }
+typedef struct {
+    int           a1, a2;
+    long long int offset, length; // of the cluster block
+} MAP_INDEX;
 
-    if ( argc >= 6 ) {
-        MAX_FLANK_CONSIDERED = atoi( argv[5] );
+typedef struct {
+    FLANK_QUEUE *   queues; // one for each thread
+    int             nqueues;
+    int             pending; // tasks queued, not taken yet
+    int             quit;    // all clusters read
+    pthread_mutex_t lock;
+    pthread_cond_t  more, room;
+
+    FILE *          map; // output, one writer at a time
+    MAP_INDEX *     index;
+    size_t          nindex, maxindex;
+    pthread_mutex_t maplock;
+} FLANK_POOL;
+
+typedef struct {
+    FLANK_POOL *pool;
+    int         id; // of its queue
+    ED_BATCH    batch;
+    FLANK_PAIR *window;
+    int         maxwindow;
+    pthread_t   thread;
+} FLANK_WORKER;
+
+/*******************************************************************************************/
+void queuePush( FLANK_QUEUE *q, FLANK_TASK *task ) {
+
+    pthread_mutex_lock( &q->lock );
+
+    if ( q->ntasks >= q->maxtasks ) {
+        q->maxtasks = ( q->maxtasks ) ? 2 * q->maxtasks : 16;
+        q->tasks    = (FLANK_TASK **) realloc(
+          q->tasks, q->maxtasks * sizeof( FLANK_TASK * ) );
+
+        if ( !q->tasks )
+            doCriticalErrorAndQuit(
+              "\n\nFlankAlign - memory error 5. Aborting!\n\n" );
     }
 
-    if ( MAX_FLANK_CONSIDERED < 1 ) {
-        doCriticalErrorAndQuit(
-          "\n\nFlankAlign - ? should be more than or equal to one!\n\n" );
+    q->tasks[q->ntasks++] = task;
+    q->load += task->cost;
+
+    pthread_mutex_unlock( &q->lock );
+}
+
+/*******************************************************************************************/
+/* removes the costliest task of a queue, NULL if it is empty */
+FLANK_TASK *queuePopCostliest( FLANK_QUEUE *q ) {
+
+    FLANK_TASK *task = NULL;
+    int         i, best;
+
+    pthread_mutex_lock( &q->lock );
+
+    if ( q->ntasks > 0 ) {
+
+        best = 0;
+        for ( i = 1; i < q->ntasks; i++ ) {
+            if ( q->tasks[i]->cost > q->tasks[best]->cost )
+                best = i;
+        }
+
+        task            = q->tasks[best];
+        q->tasks[best]  = q->tasks[--q->ntasks];
+        q->load        -= task->cost;
     }
 
-    if ( argc >= 7 ) {
-        MAXTHREADS = atoi( argv[6] );
+    pthread_mutex_unlock( &q->lock );
+
+    return task;
+}
+
+/*******************************************************************************************/
+/* hands a task to the least loaded queue, waits while too many are queued */
+void poolPush( FLANK_POOL *pool, FLANK_TASK *task ) {
+
+    FLANK_QUEUE * q;
+    long long int load, best = 0;
+    int           i, target = 0;
+
+    pthread_mutex_lock( &pool->lock );
+
+    while ( pool->pending >= TASKS_PER_THREAD * pool->nqueues )
+        pthread_cond_wait( &pool->room, &pool->lock );
+
+    for ( i = 0; i < pool->nqueues; i++ ) {
+
+        q = &pool->queues[i];
+        pthread_mutex_lock( &q->lock );
+        load = q->load;
+        pthread_mutex_unlock( &q->lock );
+
+        if ( i == 0 || load < best ) {
+            best   = load;
+            target = i;
+        }
     }
 
-    if ( MAXTHREADS < 1 ) {
-        doCriticalErrorAndQuit( "\n\nFlankAlign - maxthreads should be more "
-                                "than or equal to one!\n\n" );
+    queuePush( &pool->queues[target], task );
+    pool->pending++;
+    pthread_cond_broadcast( &pool->more );
+
+    pthread_mutex_unlock( &pool->lock );
+}
+
+/*******************************************************************************************/
+/* next task of a thread, NULL once all clusters are read and taken */
+FLANK_TASK *poolTake( FLANK_WORKER *w ) {
+
+    FLANK_POOL *  pool = w->pool;
+    FLANK_QUEUE * q;
+    FLANK_TASK *  task;
+    long long int load, best;
+    int           i, ntasks, victim;
+
+    while ( 1 ) {
+
+        task = queuePopCostliest( &pool->queues[w->id] );
+
+        /* own queue is empty, steal from the most loaded one */
+        if ( !task ) {
+
+            victim = -1;
+            best   = 0;
+            for ( i = 0; i < pool->nqueues; i++ ) {
+
+                q = &pool->queues[i];
+                pthread_mutex_lock( &q->lock );
+                ntasks = q->ntasks;
+                load   = q->load;
+                pthread_mutex_unlock( &q->lock );
+
+                if ( ntasks > 0 && ( victim < 0 || load > best ) ) {
+                    best   = load;
+                    victim = i;
+                }
+            }
+
+            if ( victim >= 0 )
+                task = queuePopCostliest( &pool->queues[victim] );
+        }
+
+        pthread_mutex_lock( &pool->lock );
+
+        if ( task ) {
+            pool->pending--;
+            pthread_cond_signal( &pool->room );
+            pthread_mutex_unlock( &pool->lock );
+            return task;
+        }
+
+        if ( 0 == pool->pending ) {
+
+            if ( pool->quit ) {
+                pthread_mutex_unlock( &pool->lock );
+                return NULL;
+            }
+
+            pthread_cond_wait( &pool->more, &pool->lock );
+        }
+
+        pthread_mutex_unlock( &pool->lock );
     }
+}
 
-    if ( argc >= 8 ) {
-        PATLEN_SIZE_ERR = atoi( argv[7] );
+/*******************************************************************************************/
+/* appends the block of a cluster from the lines of its parts */
+void writeCluster( FLANK_POOL *pool, FLANK_CLUSTER *cl ) {
+
+    MAP_INDEX *   entry;
+    long long int offset;
+    int           i;
+
+    pthread_mutex_lock( &pool->maplock );
+
+    offset = ftello( pool->map );
+    fprintf( pool->map, "@%d_%d\t1\t1\t1\t1\t1", cl->a1, cl->a2 );
+
+    for ( i = 0; i < cl->nparts; i++ )
+        fwrite( cl->text[i], 1, cl->textlen[i], pool->map );
+
+    fputc( '\n', pool->map );
+
+    if ( pool->nindex >= pool->maxindex ) {
+        pool->maxindex = ( pool->maxindex ) ? 2 * pool->maxindex : 1024;
+        pool->index    = (MAP_INDEX *) realloc(
+          pool->index, pool->maxindex * sizeof( MAP_INDEX ) );
+
+        if ( !pool->index )
+            doCriticalErrorAndQuit(
+              "\n\nFlankAlign - memory error 7. Aborting!\n\n" );
     }
 
-    if ( PATLEN_SIZE_ERR < 1 ) {
+    entry         = &pool->index[pool->nindex++];
+    entry->a1     = cl->a1;
+    entry->a2     = cl->a2;
+    entry->offset = offset;
+    entry->length = ftello( pool->map ) - offset;
+
+    if ( ferror( pool->map ) )
         doCriticalErrorAndQuit(
-          "\n\nFlankAlign - PATLEN_SIZE_ERR must be at least 1%%!\n\n" );
-    }
+          "\n\nFlankAlign - can't write output file. Aborting!\n\n" );
 
-    PARR = (int *) smalloc( sizeof( int ) * MAXTHREADS );
+    pthread_mutex_unlock( &pool->maplock );
 
-    /* alignment options */
-    // if (NULL==(sm=init_sm(MATCH_SCORE,MISM_PEN)))
-    //   doCriticalErrorAndQuit("Memory error. Aborting!\n\n");
+    for ( i = 0; i < cl->nparts; i++ )
+        free( cl->text[i] );
+
+    EasyListDestroy( cl->ref_list );
+    EasyListDestroy( cl->read_list );
+    sfree( cl->reads );
+    sfree( cl->text );
+    sfree( cl->textlen );
+    sfree( cl );
+}
+
+/*******************************************************************************************/
+/* aligns the reads of a task to the references within their size window */
+void alignPart( FLANK_WORKER *w, FLANK_TASK *task ) {
+
+    FLANK_CLUSTER *cl = task->cl;
+    FILE *         fp;
+    EASY_NODE *    nd2, *windowstart;
+    FLANK *        read_ptr, *ref_ptr;
+    FLANK_PAIR *   pair;
+    int            comma, nwindow, k, r;
+    int            maxel1, maxer1, maxel2, maxer2, largesterrorallowed;
+    QGRAM_COUNTS   leftqc, rightqc;
+    PACKEDSEQ_VIEW left, right, leftcp, rightcp;
+
+    fp = open_memstream( &cl->text[task->part], &cl->textlen[task->part] );
+
+    if ( !fp )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - memory error 6. Aborting!\n\n" );
+
+    /* the references skipped by the window only grow with the read
+     * patsize, so a part can start from the head */
+    windowstart = cl->ref_list->head;
+    for ( r = task->first; r < task->last; r++ ) {
+
+        read_ptr = cl->reads[r];
+        fprintf( fp, "\n%lld\t'\t%d\t%d\t1\t1\t1\t", read_ptr->id,
+          read_ptr->leftlen, read_ptr->rightlen );
+
+        /* references within the size window of the read */
+        nwindow = 0;
+        for ( nd2 = windowstart; nd2 != NULL; nd2 = nd2->next ) {
+
+            double sizeerror;
+
+            ref_ptr = (FLANK *) EasyListItem( nd2 );
+
+            /* if sizes are too different, stop */
+            if ( ref_ptr->patsize > read_ptr->patsize ) {
+                sizeerror =
+                  ( ref_ptr->patsize / (double) read_ptr->patsize - 1.0 ) *
+                  100;
+            } else {
+                sizeerror =
+                  ( read_ptr->patsize / (double) ref_ptr->patsize - 1.0 ) *
+                  100;
+            }
+
+            if ( sizeerror > PATLEN_SIZE_ERR ) {
+
+                if ( ref_ptr->patsize < read_ptr->patsize ) {
+                    windowstart = nd2;
+                    continue;
+                } else {
+                    break;
+                }
+            }
+
+            if ( nwindow >= w->maxwindow ) {
+                w->maxwindow = ( w->maxwindow ) ? 2 * w->maxwindow : 256;
+                w->window    = (FLANK_PAIR *) realloc(
+                  w->window, w->maxwindow * sizeof( FLANK_PAIR ) );
+
+                if ( !w->window )
+                    doCriticalErrorAndQuit(
+                      "\n\nFlankAlign - memory error 4. Aborting!\n\n" );
+            }
+
+            w->window[nwindow++].ref = ref_ptr;
+        }
+
+        /*****************************************************************************************************************/
+
+        /* if 0 passed for maxerror, calculate based on flank length */
+        if ( 0 != MAXERRORS ) {
+            maxel1 = MAXERRORS;
+            maxer1 = MAXERRORS;
+            maxel2 = MAXERRORS;
+            maxer2 = MAXERRORS;
+        } else {
+            maxel1 = min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
+            maxer1 = min( 8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
+            maxel2 = min( 8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
+            maxer2 = min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
+        }
+
+        left    = flankLeft( read_ptr );
+        right   = flankRight( read_ptr );
+        leftcp  = PackedSeqViewComplement( left );
+        rightcp = PackedSeqViewComplement( right );
+
+        qgramCount( &leftqc, &left );
+        qgramCount( &rightqc, &right );
+
+        /* queue the flanks of every pair, both directions, to be aligned
+         * side by side */
+        for ( k = 0; k < nwindow; k++ ) {
+
+            FLANK_PREPARED *prep;
+            int             refleft, refright;
+
+            pair    = &w->window[k];
+            ref_ptr = pair->ref;
+            prep    = ref_ptr->prepared;
+
+            /* shorten reference from 1000 to slightly more than readlen */
+            largesterrorallowed =
+              ( 0 != MAXERRORS ) ? MAXERRORS : max( maxel1, maxer1 );
+            refleft  = min( ref_ptr->leftlen,
+              read_ptr->leftlen + largesterrorallowed + 2 );
+            refright = min( ref_ptr->rightlen,
+              read_ptr->rightlen + largesterrorallowed + 2 );
+
+            /* If ref is from ends of chromosome it could be shorter. Thats
+             * why readlen will be shortened to reflen */
+            flankQueue( &w->batch, &prep->leftpat, prep->leftgrams, refleft,
+              PackedSeqViewPrefix( left, refleft ), &leftqc, 0, maxel1,
+              &pair->lerr1 );
+            flankQueue( &w->batch, &prep->rightpat, prep->rightgrams,
+              refright, PackedSeqViewPrefix( right, refright ), &rightqc, 0,
+              maxer1, &pair->rerr1 );
+
+            /* try aligning to the compliment of the other flank instead */
+            largesterrorallowed =
+              ( 0 != MAXERRORS ) ? MAXERRORS : max( maxel2, maxer2 );
+            refleft  = min( ref_ptr->leftlen,
+              read_ptr->rightlen + largesterrorallowed + 2 );
+            refright = min( ref_ptr->rightlen,
+              read_ptr->leftlen + largesterrorallowed + 2 );
+
+            flankQueue( &w->batch, &prep->leftpat, prep->leftgrams, refleft,
+              PackedSeqViewPrefix( rightcp, refleft ), &rightqc,
+              QGRAM_CODES - 1, maxel2, &pair->lerr2 );
+            flankQueue( &w->batch, &prep->rightpat, prep->rightgrams,
+              refright, PackedSeqViewPrefix( leftcp, refright ), &leftqc,
+              QGRAM_CODES - 1, maxer2, &pair->rerr2 );
+        }
+
+        ED_batch_run( &w->batch );
+
+        comma = 0;
+        for ( k = 0; k < nwindow; k++ ) {
+
+            int lerr, rerr;
+            int lerr1, rerr1;
+            int lerr2, rerr2;
+            int sumerr1, sumerr2;
+
+            pair    = &w->window[k];
+            ref_ptr = pair->ref;
+            lerr1   = pair->lerr1;
+            rerr1   = pair->rerr1;
+            lerr2   = pair->lerr2;
+            rerr2   = pair->rerr2;
+
+            if ( lerr1 < 0 || rerr1 < 0 || lerr2 < 0 || rerr2 < 0 )
+                doCriticalErrorAndQuit(
+                  "\n\nFlankAlign - wrong sizes for narrowband alignment, "
+                  "seq1 must be larger. Aborting!\n\n" );
+
+            /*****************************************************************************************************************/
+
+            /* if passes criteria in EITHER direction */
+            if ( ( lerr1 <= maxel1 && rerr1 <= maxer1 ) ||
+                 ( lerr2 <= maxel2 && rerr2 <= maxer2 ) ) {
+
+                /* if passes criteria in BOTH direction */
+                if ( ( lerr1 <= maxel1 && rerr1 <= maxer1 ) &&
+                     ( lerr2 <= maxel2 && rerr2 <= maxer2 ) ) {
+
+                    /* print #errors with smallest sum */
+                    sumerr1 = lerr1 + rerr1;
+                    sumerr2 = lerr2 + rerr2;
+
+                    if ( sumerr1 <= sumerr2 ) {
+                        lerr = lerr1;
+                        rerr = rerr1;
+                    } else {
+                        lerr = lerr2;
+                        rerr = rerr2;
+                    }
+
+                    /* if passes criteria in FORWARD direction */
+                } else if ( lerr1 <= maxel1 && rerr1 <= maxer1 ) {
+
+                    lerr = lerr1;
+                    rerr = rerr1;
+
+                    /* if passes criteria in REVERSE direction */
+                } else {
 
-    if ( Complementascii == NULL ) {
-        Complementascii = init_complement_ascii();
-        if ( NULL == Complementascii )
-            return 1;
+                    lerr = lerr2;
+                    rerr = rerr2;
+                }
+
+                /* print comma separated refs with errors */
+                if ( 1 == comma ) {
+                    fprintf( fp, "," );
+                }
+                fprintf( fp, "%lld:%d:%d", ref_ptr->id, lerr, rerr );
+                comma = 1;
+            }
+        }
     }
 
-    /* enter out dir */
-    if ( chdir( outdir ) ) { // should this be negated?
-        mkdir( outdir, 0755 );
+    fclose( fp );
+}
+
+/*******************************************************************************************/
+void *alignThread( void *arg ) {
+
+    FLANK_WORKER * w = (FLANK_WORKER *) arg;
+    FLANK_TASK *   task;
+    FLANK_CLUSTER *cl;
+    int            last;
+
+    while ( ( task = poolTake( w ) ) != NULL ) {
+
+        cl = task->cl;
+        alignPart( w, task );
+        sfree( task );
 
-        if ( chdir( outdir ) ) {
+        pthread_mutex_lock( &w->pool->lock );
+        last = ( 0 == --cl->partsleft );
+        pthread_mutex_unlock( &w->pool->lock );
 
+        if ( last )
+            writeCluster( w->pool, cl );
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************************/
+/* splits a cluster into tasks and hands them to the pool */
+void scheduleCluster( FLANK_POOL *pool, FLANK_CLUSTER *cl ) {
+
+    EASY_NODE *   nd;
+    FLANK *       ref_ptr;
+    FLANK_TASK *  task;
+    long long int nrefs, nreads, cost;
+    int           i, nparts;
+
+    numberFlanks( cl->read_list );
+    numberFlanks( cl->ref_list );
+    EasyListQuickSort( cl->read_list, __patsizeCmp );
+    EasyListQuickSort( cl->ref_list, __patsizeCmp );
+
+    /* every read of the window is aligned against the same reference
+     * flanks, encode them once */
+    for ( nd = cl->ref_list->head; nd != NULL; nd = nd->next ) {
+
+        FLANK_PREPARED *prep;
+        PACKEDSEQ_VIEW  left, right;
+
+        ref_ptr = (FLANK *) EasyListItem( nd );
+        left    = flankLeft( ref_ptr );
+        right   = flankRight( ref_ptr );
+
+        prep = ref_ptr->prepared =
+          (FLANK_PREPARED *) scalloc( 1, sizeof( FLANK_PREPARED ) );
+
+        if ( Edit_Distance_multiple_word_NoEndPenaltySeq1_PrepareView(
+               &prep->leftpat, &left ) < 0 ||
+             Edit_Distance_multiple_word_NoEndPenaltySeq1_PrepareView(
+               &prep->rightpat, &right ) < 0 )
             doCriticalErrorAndQuit(
-              "\n\nFlankAlign - could not enter or create output dir!\n\n" );
-        }
+              "\n\nFlankAlign - memory error 3. Aborting!\n\n" );
+
+        prep->leftgrams  = qgramCodes( &left );
+        prep->rightgrams = qgramCodes( &right );
     }
 
-    /* parse file one cluster at a time */
+    nrefs  = EasyListSize( cl->ref_list );
+    nreads = EasyListSize( cl->read_list );
+
+    cl->reads = (FLANK **) smalloc( ( nreads + 1 ) * sizeof( FLANK * ) );
+    i         = 0;
+    for ( nd = cl->read_list->head; nd != NULL; nd = nd->next )
+        cl->reads[i++] = (FLANK *) EasyListItem( nd );
+
+    cost   = nrefs * nreads;
+    nparts = 1;
+    if ( cost > SPLIT_COST )
+        nparts = (int) min( nreads, ( cost + SPLIT_COST - 1 ) / SPLIT_COST );
+
+    cl->nparts    = nparts;
+    cl->partsleft = nparts;
+    cl->text      = (char **) scalloc( nparts, sizeof( char * ) );
+    cl->textlen   = (size_t *) scalloc( nparts, sizeof( size_t ) );
+
+    /* the cluster belongs to the pool once its last task is pushed */
+    for ( i = 0; i < nparts; i++ ) {
+
+        task        = (FLANK_TASK *) smalloc( sizeof( FLANK_TASK ) );
+        task->cl    = cl;
+        task->part  = i;
+        task->first = (int) ( nreads * i / nparts );
+        task->last  = (int) ( nreads * ( i + 1 ) / nparts );
+        task->cost  = nrefs * ( task->last - task->first );
+
+        poolPush( pool, task );
+    }
+}
+
+/*******************************************************************************************/
+void submitCluster( FLANK_POOL *pool, int a1, int a2, EASY_LIST *ref_list,
+  EASY_LIST *read_list ) {
+
+    FLANK_CLUSTER *cl = (FLANK_CLUSTER *) scalloc( 1, sizeof( FLANK_CLUSTER ) );
+
+    cl->a1        = a1;
+    cl->a2        = a2;
+    cl->ref_list  = ref_list;
+    cl->read_list = read_list;
+    scheduleCluster( pool, cl );
+}
+
+/*******************************************************************************************/
+/* clusters written by run_flankcomp.pl, one line per reference or read,
+ * returns the number read */
+long long int readClustersText( FLANK_POOL *pool, char *filename ) {
+
+    char *buffer, *src1, *src2, *src3, *src4, *src5;
+    FILE *        rd_fp;
+    long long int rid;
+    long long int processed = 0;
+    char *        hasdata   = NULL;
+    int           a1, a2;
+
     buffer = smalloc( sizeof( char ) * ( MAXLINESIZE + 1 ) );
 
     if ( filename[0] == '-' )
@@ -315,9 +1000,7 @@ int main( int argc, char *argv[] ) {
         while ( 1 ) {
 
             EASY_LIST *ref_list, *read_list;
-            EASY_NODE *nd1, *nd2, *windowstart;
-            int        start, end, length, i;
-            FLANK *    templ_flank_ptr;
+            int        start, end;
 
             ref_list  = EasyListCreate( NULL, flankDestroy );
             read_list = EasyListCreate( NULL, flankDestroy );
@@ -381,23 +1064,8 @@ int main( int argc, char *argv[] ) {
                         src5--;
                     }
 
-                    templ_flank_ptr = (FLANK *) smalloc( sizeof( FLANK ) );
-
-                    templ_flank_ptr->left     = GetReverse( src1 );
-                    templ_flank_ptr->right    = strdup( src3 );
-                    templ_flank_ptr->leftlen  = strlen( src1 );
-                    templ_flank_ptr->rightlen = strlen( src3 );
-                    templ_flank_ptr->leftcp   = NULL;
-                    templ_flank_ptr->rightcp  = NULL;
-
-                    if ( !templ_flank_ptr->left || !templ_flank_ptr->right )
-                        doCriticalErrorAndQuit(
-                          "\n\nFlankAlign - memory error 1. Aborting!\n\n" );
-
-                    templ_flank_ptr->patsize = strlen( src4 );
-                    templ_flank_ptr->id      = rid;
-
-                    EasyListInsertTail( ref_list, templ_flank_ptr );
+                    EasyListInsertTail(
+                      ref_list, refFlank( rid, src1, src3, strlen( src4 ) ) );
 
                 } else if ( rid > 0 ) {
 
@@ -447,8 +1115,6 @@ int main( int argc, char *argv[] ) {
                         src5--;
                     }
 
-                    templ_flank_ptr = (FLANK *) smalloc( sizeof( FLANK ) );
-
                     start = strtol( src1, NULL, 10 );
                     if ( ( errno == ERANGE ) || ( errno != 0 && start == 0 ) ) {
                         perror( "strtol" );
@@ -461,71 +1127,8 @@ int main( int argc, char *argv[] ) {
                         exit( EXIT_FAILURE );
                     }
 
-                    length = strlen( src3 );
-
-                    // fprintf(stderr, "start: %d end: %d length: %d\n\n",start,
-                    // end, length);
-                    // exit(1);
-
-                    templ_flank_ptr->left =
-                      calloc( start + 2, sizeof( *templ_flank_ptr->left ) );
-                    templ_flank_ptr->right = calloc(
-                      ( length - end ) + 2, sizeof( *templ_flank_ptr->right ) );
-
-                    if ( !templ_flank_ptr->left )
-                        doCriticalErrorAndQuit(
-                          "\n\nFlankAlign - memory error 2 in left flank. rid: "
-                          "%d, start: %d end: %d length: %d, start+2: %d, "
-                          "length-end+2: %d. Aborting!\n\n",
-                          rid, start, end, length, start + 2,
-                          length - end + 2 );
-
-                    if ( !templ_flank_ptr->right )
-                        doCriticalErrorAndQuit(
-                          "\n\nFlankAlign - memory error 2 in right flank. "
-                          "rid: %d, start: %d end: %d length: %d, start+2: %d, "
-                          "length-end+2: %d. Aborting!\n\n",
-                          rid, start, end, length, start + 2,
-                          length - end + 2 );
-
-                    dst = templ_flank_ptr->left;
-                    for ( i = start - 2; i >= 0; i-- ) {
-                        *dst = src3[i];
-                        dst++;
-                    }
-                    *dst = 0;
-
-                    dst = templ_flank_ptr->right;
-                    for ( i = end; i < length; i++ ) {
-                        *dst = src3[i];
-                        dst++;
-                    }
-                    *dst = 0;
-
-                    templ_flank_ptr->patsize = strlen( src4 );
-                    templ_flank_ptr->id      = rid;
-
-                    /* FOR FLANKSHORT */
-                    templ_flank_ptr->leftlen = strlen( templ_flank_ptr->left );
-                    templ_flank_ptr->rightlen =
-                      strlen( templ_flank_ptr->right );
-
-                    if ( templ_flank_ptr->leftlen > MAX_FLANK_CONSIDERED )
-                        templ_flank_ptr->left[MAX_FLANK_CONSIDERED] = '\0';
-                    if ( templ_flank_ptr->rightlen > MAX_FLANK_CONSIDERED )
-                        templ_flank_ptr->right[MAX_FLANK_CONSIDERED] = '\0';
-                    /* ENDO OF FLANKSHORT */
-
-                    templ_flank_ptr->leftlen = strlen( templ_flank_ptr->left );
-                    templ_flank_ptr->rightlen =
-                      strlen( templ_flank_ptr->right );
-
-                    templ_flank_ptr->leftcp =
-                      GetComplement( templ_flank_ptr->left );
-                    templ_flank_ptr->rightcp =
-                      GetComplement( templ_flank_ptr->right );
-
-                    EasyListInsertTail( read_list, templ_flank_ptr );
+                    EasyListInsertTail( read_list,
+                      readFlank( rid, start, end, src3, strlen( src4 ) ) );
                 }
 
                 if ( ( hasdata = fgets( buffer, MAXLINESIZE, rd_fp ) ) ==
@@ -536,286 +1139,375 @@ int main( int argc, char *argv[] ) {
 
             /* process cluster*/
             processed++;
-            ThreadCounter++;
-
-            // if (processed>=10) exit(0);
+            submitCluster( pool, a1, a2, ref_list, read_list );
 
-            pid_t pID = fork();
-
-            if ( pID == 0 ) { // child
-                // Code only executed by child process
+            /* end of file? */
+            if ( !hasdata )
+                break;
 
-                // BASICALIGNPAIR     *ba;
-                FILE * fp;
-                FLANK *read_ptr, *ref_ptr;
-                char   tempname[100];
-                int    comma;
+            /* read cluster info */
+            a1 = a2 = 0;
+            sscanf( buffer, "@(%d_%d)", &a1, &a2 );
+            if ( a1 <= 0 || a2 <= 0 ) {
+                printf( "Can't read cluster number. \n%s\n", buffer );
+                exit( 1 );
+            }
+        }
 
-                /* Redirect standard files to /dev/null */
-                // freopen( "/dev/null", "r", stdin);
-                // freopen( "/dev/null", "w", stdout);
-                // freopen( "/dev/null", "w", stderr);
+    fclose( rd_fp );
+    sfree( buffer );
 
-                EasyListQuickSort( read_list, __patsizeCmp );
-                EasyListQuickSort( ref_list, __patsizeCmp );
+    return processed;
+}
 
-                sprintf( tempname, "%d_%d.map", a1, a2 );
-                fp = fopen( tempname, "w" );
+/*******************************************************************************************/
+/* Clusters straight from the run database (clusterlnk, replnk,
+ * fasta_reads) and the reference database attached to it
+ * (fasta_ref_reps), blocked the way the flanks file is: reads in blocks
+ * of READS_PER_BLOCK, each block with every reference of its cluster,
+ * clusters without reads left out. Returns the number of blocks read. */
+#define READS_PER_BLOCK ( 4000 )
 
-                if ( !fp )
-                    doCriticalErrorAndQuit( "\n\nFlankAlign - can't open "
-                                            "output file. Aborting!\n\n" );
+typedef struct {
+    long long int rid;
+    char *        left, *right;
+    int           patsize;
+} REF_ROW;
 
-                fprintf(
-                  fp, "@%d_%d	1	1	1	1	1", a1, a2 );
+/* column text, NULL read as an empty string */
+static char *columnText( sqlite3_stmt *stmt, int col ) {
 
-                windowstart = ref_list->head;
-                for ( nd1 = read_list->head; nd1 != NULL; nd1 = nd1->next ) {
+    const unsigned char *text = sqlite3_column_text( stmt, col );
 
-                    read_ptr = (FLANK *) EasyListItem( nd1 );
-                    fprintf( fp,
-                      "\n%lld	'	%d	%d	1	1	"
-                      "1	",
-                      read_ptr->id, read_ptr->leftlen, read_ptr->rightlen );
+    return ( text ) ? (char *) text : "";
+}
 
-                    comma = 0;
-                    for ( nd2 = windowstart; nd2 != NULL; nd2 = nd2->next ) {
+static sqlite3_stmt *prepareOrQuit( sqlite3 *db, const char *sql ) {
 
-                        int lerr, rerr;
-                        int lerr1, rerr1;
-                        int lerr2, rerr2;
+    sqlite3_stmt *stmt;
 
-                        int errors, errors1, errors2;
-                        int sumerr1, sumerr2, refleft, refright;
+    if ( SQLITE_OK != sqlite3_prepare_v2( db, sql, -1, &stmt, NULL ) )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - cannot prepare statement: %s. Aborting!\n\n",
+          sqlite3_errmsg( db ) );
 
-                        double sizeerror;
+    return stmt;
+}
 
-                        ref_ptr = (FLANK *) EasyListItem( nd2 );
+/* upper case with anything but ACGT as N, the same as the flanks file reader */
+static void normalizeDna( char *dna ) {
 
-                        /* if sizes are too different, stop */
-                        if ( ref_ptr->patsize > read_ptr->patsize ) {
-                            sizeerror =
-                              ( ref_ptr->patsize / (double) read_ptr->patsize -
-                                1.0 ) *
-                              100;
-                        } else {
-                            sizeerror =
-                              ( read_ptr->patsize / (double) ref_ptr->patsize -
-                                1.0 ) *
-                              100;
-                        }
+    for ( ; *dna; dna++ ) {
+        *dna = toupper( (unsigned char) *dna );
+        if ( NULL == strchr( "ACGT", *dna ) ) {
+            *dna = 'N';
+        }
+    }
+}
 
-                        if ( sizeerror > PATLEN_SIZE_ERR ) {
+long long int readClustersDb( FLANK_POOL *pool, char *rundb, char *refdb ) {
 
-                            if ( ref_ptr->patsize < read_ptr->patsize ) {
-                                windowstart = nd2;
-                                continue;
-                            } else {
-                                break;
-                            }
-                        }
+    sqlite3 *     db;
+    sqlite3_stmt *clusters, *refs, *reads;
+    char *        sql, *err_msg = NULL, *dna = NULL, *src, *dst;
+    REF_ROW *     rows = NULL;
+    EASY_LIST *   ref_list = NULL, *read_list = NULL;
+    int           nrows, maxrows = 0, maxdna = 0, cid, block, nreads, i, rc;
+    long long int processed = 0;
 
-                        /*****************************************************************************************************************/
+    if ( SQLITE_OK != sqlite3_open_v2( rundb, &db, SQLITE_OPEN_READONLY, NULL ) )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - cannot open database %s: %s. Aborting!\n\n",
+          rundb, sqlite3_errmsg( db ) );
 
-                        /* if 0 passed for maxerror, calculate based on flank
-                         * length */
-                        if ( 0 != MAXERRORS ) {
-                            MAXEL1             = MAXERRORS;
-                            MAXER1             = MAXERRORS;
-                            MAXEL2             = MAXERRORS;
-                            MAXER2             = MAXERRORS;
-                            LARGESERRORALLOWED = MAXERRORS;
-                        }
+    sql = sqlite3_mprintf( "ATTACH DATABASE %Q AS refdb", refdb );
+    if ( SQLITE_OK != sqlite3_exec( db, sql, NULL, NULL, &err_msg ) )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - cannot attach database %s: %s. Aborting!\n\n",
+          refdb, err_msg );
+    sqlite3_free( sql );
+
+    clusters = prepareOrQuit(
+      db, "SELECT DISTINCT clusterid FROM clusterlnk ORDER BY clusterid" );
+    refs = prepareOrQuit( db,
+      "SELECT rid, flankleft, flankright, LENGTH(pattern)"
+      " FROM refdb.fasta_ref_reps"
+      " INNER JOIN clusterlnk ON rid=-repeatid"
+      " WHERE clusterid = ?" );
+    reads = prepareOrQuit( db,
+      "SELECT rid, dna, first, last, LENGTH(pattern)"
+      " FROM fasta_reads"
+      " INNER JOIN replnk ON fasta_reads.sid=replnk.sid"
+      " INNER JOIN clusterlnk ON rid=repeatid"
+      " WHERE clusterid = ?" );
+
+    while ( SQLITE_ROW == ( rc = sqlite3_step( clusters ) ) ) {
+
+        cid = sqlite3_column_int( clusters, 0 );
+
+        /* references, copied into every block */
+        nrows = 0;
+        sqlite3_bind_int( refs, 1, cid );
+        while ( SQLITE_ROW == ( rc = sqlite3_step( refs ) ) ) {
+
+            if ( nrows >= maxrows ) {
+                maxrows = ( maxrows ) ? 2 * maxrows : 64;
+                rows    = (REF_ROW *) realloc( rows, maxrows * sizeof( REF_ROW ) );
+
+                if ( !rows )
+                    doCriticalErrorAndQuit(
+                      "\n\nFlankAlign - memory error 9. Aborting!\n\n" );
+            }
 
-                        /* shorten reference from 1000 to slightly more than
-                         * readlen */
-                        if ( 0 == MAXERRORS ) {
-                            MAXEL1 =
-                              min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
-                            MAXER1 = min(
-                              8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
-                            LARGESERRORALLOWED = max( MAXEL1, MAXER1 );
-                        }
-                        refleft  = min( ref_ptr->leftlen,
-                          read_ptr->leftlen + LARGESERRORALLOWED + 2 );
-                        refright = min( ref_ptr->rightlen,
-                          read_ptr->rightlen + LARGESERRORALLOWED + 2 );
-
-                        /* If ref is from ends of chromosome it could be
-                         * shorter. Thats why readlen will be shortened to
-                         * reflen */
-                        lerr1 = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->left, read_ptr->left, refleft,
-                          ( refleft > read_ptr->leftlen ) ? read_ptr->leftlen
-                                                          : refleft );
-                        rerr1 = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->right, read_ptr->right, refright,
-                          ( refright > read_ptr->rightlen ) ? read_ptr->rightlen
-                                                            : refright );
-
-                        if ( lerr1 < 0 || rerr1 < 0 )
-                            doCriticalErrorAndQuit(
-                              "\n\nFlankAlign - wrong sizes for narrowband "
-                              "alignment, seq1 must be larger. Aborting!\n\n" );
-
-                        /* try aligning to the compliment of the other flank
-                         * instead */
-                        /*****************************************************************************************************************/
-
-                        /* shorten reference from 1000 to slightly more than
-                         * readlen */
-                        if ( 0 == MAXERRORS ) {
-                            MAXEL2 = min(
-                              8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
-                            MAXER2 =
-                              min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
-                            LARGESERRORALLOWED = max( MAXEL2, MAXER2 );
-                        }
-                        refleft  = min( ref_ptr->leftlen,
-                          read_ptr->rightlen + LARGESERRORALLOWED + 2 );
-                        refright = min( ref_ptr->rightlen,
-                          read_ptr->leftlen + LARGESERRORALLOWED + 2 );
-
-                        /* If ref is from ends of chromosome it could be
-                         * shorter. Thats why readlen will be shortened to
-                         * reflen */
-                        lerr2 = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->left, read_ptr->rightcp, refleft,
-                          ( refleft > read_ptr->rightlen ) ? read_ptr->rightlen
-                                                           : refleft );
-                        rerr2 = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->right, read_ptr->leftcp, refright,
-                          ( refright > read_ptr->leftlen ) ? read_ptr->leftlen
-                                                           : refright );
-
-                        if ( lerr2 < 0 || rerr2 < 0 )
-                            doCriticalErrorAndQuit(
-                              "\n\nFlankAlign - wrong sizes for narrowband "
-                              "alignment, seq1 must be larger. Aborting!\n\n" );
-
-                        // printf("%d - %d - %s - %s - %d\n",ref_ptr->leftlen,
-                        // read_ptr->leftlen,ref_ptr->left, read_ptr->left,
-                        // lerr); printf("%d - %d - %s - %s -
-                        // %d\n",ref_ptr->rightlen,
-                        // read_ptr->rightlen,ref_ptr->right, read_ptr->right,
-                        // rerr);
-
-                        /*****************************************************************************************************************/
-                        /*****************************************************************************************************************/
-                        /*****************************************************************************************************************/
-
-                        /* if passes criteria in EITHER direction */
-                        if ( ( lerr1 <= MAXEL1 && rerr1 <= MAXER1 ) ||
-                             ( lerr2 <= MAXEL2 && rerr2 <= MAXER2 ) ) {
-
-                            /* if passes criteria in BOTH direction */
-                            if ( ( lerr1 <= MAXEL1 && rerr1 <= MAXER1 ) &&
-                                 ( lerr2 <= MAXEL2 && rerr2 <= MAXER2 ) ) {
-
-                                /* print #errors with smallest sum */
-                                sumerr1 = lerr1 + rerr1;
-                                sumerr2 = lerr2 + rerr2;
-
-                                if ( sumerr1 <= sumerr2 ) {
-                                    lerr = lerr1;
-                                    rerr = rerr1;
-                                } else {
-                                    lerr = lerr2;
-                                    rerr = rerr2;
-                                }
-
-                                /* if passes criteria in FORWARD direction */
-                            } else if ( lerr1 <= MAXEL1 && rerr1 <= MAXER1 ) {
-
-                                lerr = lerr1;
-                                rerr = rerr1;
-
-                                /* if passes criteria in REVERSE direction */
-                            } else {
-
-                                lerr = lerr2;
-                                rerr = rerr2;
-                            }
-
-                            /* print comma separated refs with errors */
-                            if ( 1 == comma ) {
-                                fprintf( fp, "," );
-                            }
-                            fprintf(
-                              fp, "%lld:%d:%d", ref_ptr->id, lerr, rerr );
-                            comma = 1;
-                        }
-                    }
-                }
+            rows[nrows].rid     = -sqlite3_column_int64( refs, 0 );
+            rows[nrows].left    = strdup( columnText( refs, 1 ) );
+            rows[nrows].right   = strdup( columnText( refs, 2 ) );
+            rows[nrows].patsize = sqlite3_column_int( refs, 3 );
 
-                fclose( fp );
+            if ( !rows[nrows].left || !rows[nrows].right )
+                doCriticalErrorAndQuit(
+                  "\n\nFlankAlign - memory error 9. Aborting!\n\n" );
 
-                _exit( 0 );
+            normalizeDna( rows[nrows].left );
+            normalizeDna( rows[nrows].right );
+            nrows++;
+        }
 
-            } else if ( pID < 0 ) { // failed to fork
-                doCriticalErrorAndQuit(
-                  "\n\nFlankAlign - failed to fork code=%d (%s). Aborting!\n\n",
-                  errno, strerror( errno ) );
-                exit( 1 );
-            }
+        if ( SQLITE_DONE != rc )
+            doCriticalErrorAndQuit(
+              "\n\nFlankAlign - cannot read references: %s. Aborting!\n\n",
+              sqlite3_errmsg( db ) );
 
-            PARR[ThreadCounter - 1] = pID;
+        sqlite3_reset( refs );
 
-            // Code below only executed by parent process
-            //printf( "processing: %d_%d (pid: %d) threadcounter: %d\n", a1, a2,
-            //  pID, ThreadCounter );
+        /* reads, a block at a time */
+        block  = 0;
+        nreads = 0;
+        sqlite3_bind_int( reads, 1, cid );
+        while ( SQLITE_ROW == ( rc = sqlite3_step( reads ) ) ) {
 
-            /* child has its own copy now, so it's ok to destroy for parent */
-            EasyListDestroy( ref_list );
-            EasyListDestroy( read_list );
+            if ( 0 == nreads ) {
+                ref_list  = EasyListCreate( NULL, flankDestroy );
+                read_list = EasyListCreate( NULL, flankDestroy );
 
-            /* if full batch scheduled, wait for one to finish and schedule
-             * another */
-            if ( ThreadCounter >= MAXTHREADS ) {
+                for ( i = 0; i < nrows; i++ )
+                    EasyListInsertTail( ref_list, refFlank( rows[i].rid,
+                                                    rows[i].left, rows[i].right,
+                                                    rows[i].patsize ) );
+            }
 
-                pid_t retid = waitpid( PARR[0], &status, 0 );
+            /* dna without white space, normalized */
+            src = columnText( reads, 1 );
+            if ( sqlite3_column_bytes( reads, 1 ) >= maxdna ) {
+                maxdna = sqlite3_column_bytes( reads, 1 ) + 1;
+                dna    = (char *) realloc( dna, maxdna );
 
-                if ( -1 == retid )
+                if ( !dna )
                     doCriticalErrorAndQuit(
-                      "\n\nFlankAlign - wait function returned -1. Aborting!" );
-                //else
-                //    printf( "\tterminated: %d\n", retid );
+                      "\n\nFlankAlign - memory error 9. Aborting!\n\n" );
+            }
 
-                for ( i = 1; i < ThreadCounter; i++ ) {
-                    PARR[i - 1] = PARR[i];
+            for ( dst = dna; *src; src++ ) {
+                if ( !isspace( (unsigned char) *src ) ) {
+                    *dst = toupper( (unsigned char) *src );
+                    if ( NULL == strchr( "ACGT", *dst ) ) {
+                        *dst = 'N';
+                    }
+                    dst++;
                 }
-
-                ThreadCounter--;
             }
+            *dst = '\0';
 
-            /* end of file? */
-            if ( !hasdata )
-                break;
+            EasyListInsertTail( read_list,
+              readFlank( sqlite3_column_int64( reads, 0 ),
+                sqlite3_column_int( reads, 2 ), sqlite3_column_int( reads, 3 ),
+                dna, sqlite3_column_int( reads, 4 ) ) );
 
-            /* read cluster info */
-            a1 = a2 = 0;
-            sscanf( buffer, "@(%d_%d)", &a1, &a2 );
-            if ( a1 <= 0 || a2 <= 0 ) {
-                printf( "Can't read cluster number. \n%s\n", buffer );
-                exit( 1 );
+            if ( ++nreads == READS_PER_BLOCK ) {
+                processed++;
+                submitCluster( pool, cid, ++block, ref_list, read_list );
+                nreads = 0;
             }
         }
 
-    /* wait for all child processes to finish */
-    for ( i = 0; i < ThreadCounter; i++ ) {
+        if ( SQLITE_DONE != rc )
+            doCriticalErrorAndQuit(
+              "\n\nFlankAlign - cannot read reads: %s. Aborting!\n\n",
+              sqlite3_errmsg( db ) );
+
+        sqlite3_reset( reads );
+
+        if ( nreads > 0 ) {
+            processed++;
+            submitCluster( pool, cid, ++block, ref_list, read_list );
+        }
+
+        for ( i = 0; i < nrows; i++ ) {
+            free( rows[i].left );
+            free( rows[i].right );
+        }
+    }
+
+    if ( SQLITE_DONE != rc )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - cannot read clusters: %s. Aborting!\n\n",
+          sqlite3_errmsg( db ) );
 
-        pid_t retid = waitpid( PARR[i], &status, 0 );
+    sqlite3_finalize( clusters );
+    sqlite3_finalize( refs );
+    sqlite3_finalize( reads );
+    sqlite3_close( db );
+    free( rows );
+    free( dna );
 
-        if ( -1 == retid )
+    return processed;
+}
+
+/*******************************************************************************************/
+int main( int argc, char *argv[] ) {
+
+    char *outfile, *xmldir, *filename, *refdbname = NULL;
+    long long int processed = 0;
+    int           i;
+    size_t        ui;
+    FLANK_POOL    pool;
+    FLANK_WORKER *workers;
+
+    /* cmd arguments */
+    if ( argc < 8 )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - Please use ./flankalign  outfile xmldir inputfile "
+          "MAXERRORS MAX_FLANK_CONSIDERED MAXTHREADS PATLEN_SIZE_ERR "
+          "[refdb]\n\n" );
+
+    outfile  = argv[1];
+    xmldir   = argv[2]; // never used
+    filename = argv[3];
+
+    if ( argc >= 5 ) {
+        MAXERRORS = atoi( argv[4] );
+    }
+
+    if ( argc >= 6 ) {
+        MAX_FLANK_CONSIDERED = atoi( argv[5] );
+    }
+
+    if ( MAX_FLANK_CONSIDERED < 1 ) {
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - ? should be more than or equal to one!\n\n" );
+    }
+
+    if ( argc >= 7 ) {
+        MAXTHREADS = atoi( argv[6] );
+    }
+
+    if ( MAXTHREADS < 1 ) {
+        doCriticalErrorAndQuit( "\n\nFlankAlign - maxthreads should be more "
+                                "than or equal to one!\n\n" );
+    }
+
+    if ( argc >= 8 ) {
+        PATLEN_SIZE_ERR = atoi( argv[7] );
+    }
+
+    if ( PATLEN_SIZE_ERR < 1 ) {
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - PATLEN_SIZE_ERR must be at least 1%%!\n\n" );
+    }
+
+    /* inputfile is the run database */
+    if ( argc >= 9 ) {
+        refdbname = argv[8];
+    }
+
+    /* alignment options */
+    // if (NULL==(sm=init_sm(MATCH_SCORE,MISM_PEN)))
+    //   doCriticalErrorAndQuit("Memory error. Aborting!\n\n");
+
+    /* open the map file */
+    pool.map = fopen( outfile, "w" );
+
+    if ( !pool.map )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - can't open output file. Aborting!\n\n" );
+
+    setvbuf( pool.map, NULL, _IOFBF, 1 << 20 );
+    pool.index    = NULL;
+    pool.nindex   = 0;
+    pool.maxindex = 0;
+    pthread_mutex_init( &pool.maplock, NULL );
+
+    /* start the alignment threads */
+    pool.nqueues = MAXTHREADS;
+    pool.queues =
+      (FLANK_QUEUE *) scalloc( MAXTHREADS, sizeof( FLANK_QUEUE ) );
+    pool.pending = 0;
+    pool.quit    = 0;
+    pthread_mutex_init( &pool.lock, NULL );
+    pthread_cond_init( &pool.more, NULL );
+    pthread_cond_init( &pool.room, NULL );
+
+    for ( i = 0; i < MAXTHREADS; i++ )
+        pthread_mutex_init( &pool.queues[i].lock, NULL );
+
+    workers = (FLANK_WORKER *) scalloc( MAXTHREADS, sizeof( FLANK_WORKER ) );
+
+    for ( i = 0; i < MAXTHREADS; i++ ) {
+
+        workers[i].pool = &pool;
+        workers[i].id   = i;
+        ED_batch_init( &workers[i].batch );
+
+        if ( 0 != pthread_create( &workers[i].thread, NULL, alignThread,
+                    &workers[i] ) )
             doCriticalErrorAndQuit(
-              "\n\nFlankAlign - wait function returned -1. Aborting!" );
-        //else
-        //    printf( "\tterminated: %d\n", retid );
+              "\n\nFlankAlign - failed to create thread code=%d (%s). "
+              "Aborting!\n\n",
+              errno, strerror( errno ) );
+    }
+
+    /* parse clusters, one at a time */
+    if ( refdbname )
+        processed = readClustersDb( &pool, filename, refdbname );
+    else
+        processed = readClustersText( &pool, filename );
+
+    /* wait for the threads to align the clusters left */
+    pthread_mutex_lock( &pool.lock );
+    pool.quit = 1;
+    pthread_cond_broadcast( &pool.more );
+    pthread_mutex_unlock( &pool.lock );
+
+    for ( i = 0; i < MAXTHREADS; i++ )
+        pthread_join( workers[i].thread, NULL );
+
+    for ( i = 0; i < MAXTHREADS; i++ ) {
+        ED_batch_free( &workers[i].batch );
+        free( workers[i].window );
+        free( pool.queues[i].tasks );
+        pthread_mutex_destroy( &pool.queues[i].lock );
     }
-    ThreadCounter = 0;
+
+    pthread_cond_destroy( &pool.more );
+    pthread_cond_destroy( &pool.room );
+    pthread_mutex_destroy( &pool.lock );
+    sfree( pool.queues );
+    sfree( workers );
+
+    /* index of the cluster blocks */
+    fprintf( pool.map, "#index\t%zu\n", pool.nindex );
+    for ( ui = 0; ui < pool.nindex; ui++ )
+        fprintf( pool.map, "%d_%d\t%lld\t%lld\n", pool.index[ui].a1,
+          pool.index[ui].a2, pool.index[ui].offset, pool.index[ui].length );
+
+    if ( fclose( pool.map ) )
+        doCriticalErrorAndQuit(
+          "\n\nFlankAlign - can't write output file. Aborting!\n\n" );
+
+    free( pool.index );
+    pthread_mutex_destroy( &pool.maplock );
 
     /* done */
-    fclose( rd_fp );
     printf( "Processed: %lld\n", processed);
 
     return 0;
@@ -28,7 +28,7 @@ PATLEN_SIZE_ERR REFLEN
 
 #include "../libs/easylife/easylife.h"
 
-#include "narrowbandDistanceAlignment.h"
+#include "../libs/vntr_kernels/vntr_kernels.h"
 //#include "aln.h"
 //#include "aln_nb.h"
 
@@ -48,155 +48,18 @@ int REFLEN     = ( 1000000 );
 
 int PATLEN_SIZE_ERR = 0;
 
-char *Complementascii =
-  NULL; /* precomputed array used for the reverse complement function */
 int ThreadCounter = 0;
 
-/********************************       init_complement_ascii
- * ****************************/
-char *init_complement_ascii( void )
-
-{
-    /* complement has 256 entries so that finding the entries for A, C, G and T
-     * which are complement ascii values */
-    /* require no calculation */
-    int   i;
-    char *ca = (char *) calloc( 256, sizeof( int ) );
-
-    if ( ca == NULL ) {
-        return NULL;
-    }
-
-    for ( i = 0; i < 256; i++ )
-        ca[i] = i;
-
-    ca['A'] = 'T';
-    ca['C'] = 'G';
-    ca['G'] = 'C';
-    ca['T'] = 'A';
-    ca['a'] = 't';
-    ca['c'] = 'g';
-    ca['g'] = 'c';
-    ca['t'] = 'a';
-
-    return ca;
-}
-
-/*******************************************************************************************/
-char *GetReverse( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-    if ( buffer == NULL ) {
-        return NULL;
-    }
-
-    /* reverse pattern */
-    sourceptr  = original;
-    destinptr  = buffer + length; /* position at termination */
-    *destinptr = '\0';            /* terminate string */
-    destinptr--;
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = *sourceptr;
-        destinptr--;
-        sourceptr++;
-    }
-
-    /* return buffer containg reverse complement */
-    return buffer;
-}
-
-/***********************************************************************/
-char *GetComplement( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* safety check */
-    if ( Complementascii == NULL ) {
-        Complementascii = init_complement_ascii();
-        if ( NULL == Complementascii )
-            return NULL;
-    }
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-    if ( buffer == NULL ) {
-        return NULL;
-    }
-
-    /* complement pattern */
-    sourceptr = original;
-    destinptr = buffer;
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = Complementascii[( *sourceptr )];
-        destinptr++;
-        sourceptr++;
-    }
-    *destinptr = '\0'; /* terminate string */
-
-    /* return buffer containg reverse complement */
-    return buffer;
-}
-
-/***********************************************************************/
-char *GetReverseComplement( char *original ) {
-    static char *Complementascii =
-      NULL; /* precomputed array used for the reverse complement function */
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* safety check */
-    if ( Complementascii == NULL ) {
-        Complementascii = init_complement_ascii();
-        if ( NULL == Complementascii )
-            return NULL;
-    }
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-    if ( buffer == NULL ) {
-        return NULL;
-    }
-
-    /* reverse complement pattern */
-    sourceptr  = original;
-    destinptr  = buffer + length; /* position at termination */
-    *destinptr = '\0';            /* terminate string */
-    destinptr--;
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = Complementascii[( *sourceptr )];
-        destinptr--;
-        sourceptr++;
-    }
-
-    /* return buffer containg reverse complement */
-    return buffer;
-}
-
-/***********************************************************************/
-
 int RC = 0; // this will be set by MinimumRepresentation if the reverse
             // complement is the minimum
 
 /*******************************************************************************************/
 void MinimumRepresentation( char **indptr ) {
 
-    int   i, j, len;
-    char *src, *srcrc, *tar, *sourceptr, *destinptr, tmp, *indices;
+    static PACKEDSEQ packed;
+    PACKEDSEQ_VIEW   rc;
+    int              i, j, len;
+    char *           src, *srcrc, *tar, tmp, *indices;
 
     indices = *indptr;
 
@@ -205,8 +68,14 @@ void MinimumRepresentation( char **indptr ) {
         return;
     len = strlen( src );
 
+    if ( PackSequence( &packed, src, len ) < 0 )
+        return;
+
+    rc = PackedSeqViewComplement(
+      PackedSeqViewReverse( PackedSeqView( &packed, 0, len ) ) );
+
     tar   = strdup( src );
-    srcrc = GetReverseComplement( src );
+    srcrc = PackedSeqViewString( &rc );
     if ( NULL == tar || NULL == srcrc )
         return;
 
@@ -285,10 +154,7 @@ typedef struct {
     long long int id;
     int           patsize, leftlen, rightlen, count, scoresum, comparisons;
     char          leftcon, rightcon;
-    char *        left;
-    char *        right;
-    char *        leftcp;
-    char *        rightcp;
+    PACKEDSEQ     seq; // left flank, then right flank
     char *        pattern;
     char *        sequence;
 } FLANK;
@@ -298,15 +164,51 @@ void flankDestroy( void *in ) {
 
     FLANK *g = (FLANK *) in;
 
-    free( g->left );
-    free( g->right );
-    free( g->leftcp );
-    free( g->rightcp );
+    FreePackedSequence( &g->seq );
     free( g->pattern );
     free( g->sequence );
     free( g );
 }
 
+/*******************************************************************************************/
+PACKEDSEQ_VIEW flankLeft( FLANK *f ) {
+
+    return PackedSeqViewReverse( PackedSeqView( &f->seq, 0, f->leftlen ) );
+}
+
+PACKEDSEQ_VIEW flankRight( FLANK *f ) {
+
+    return PackedSeqView( &f->seq, f->leftlen, f->rightlen );
+}
+
+/*******************************************************************************************/
+/* packs the two flanks of f into one sequence */
+void packFlanks(
+  FLANK *f, const char *left, int leftlen, const char *right, int rightlen ) {
+
+    static char *joined    = NULL;
+    static int   maxjoined = 0;
+
+    if ( leftlen + rightlen > maxjoined ) {
+        maxjoined = 2 * ( leftlen + rightlen );
+        joined    = (char *) realloc( joined, maxjoined );
+
+        if ( !joined )
+            doCriticalErrorAndQuit(
+              "\n\nRefFlankAlign - memory error 1. Aborting!\n\n" );
+    }
+
+    memcpy( joined, left, leftlen );
+    memcpy( joined + leftlen, right, rightlen );
+
+    if ( PackSequence( &f->seq, joined, leftlen + rightlen ) < 0 )
+        doCriticalErrorAndQuit(
+          "\n\nRefFlankAlign - memory error 1. Aborting!\n\n" );
+
+    f->leftlen  = leftlen;
+    f->rightlen = rightlen;
+}
+
 /*******************************************************************************************/
 int __patsizeCmp( const void *item1, const void *item2 ) {
 
@@ -382,12 +284,6 @@ int main( int argc, char *argv[] ) {
     // if (NULL==(sm=init_sm(MATCH_SCORE,MISM_PEN)))
     //   doCriticalErrorAndQuit("Memory error. Aborting!\n\n");
 
-    if ( Complementascii == NULL ) {
-        Complementascii = init_complement_ascii();
-        if ( NULL == Complementascii )
-            return 1;
-    }
-
     /* open representatives file */
     sprintf( tempbuf, "%s/representatives.txt", outdir );
     RFP = fopen( tempbuf, "w" );
@@ -429,6 +325,7 @@ int main( int argc, char *argv[] ) {
             EASY_LIST *ref_list;
             EASY_NODE *nd1, *nd2;
             int start, end, length, i, largestCount, scoresum, comparisons;
+            int leftlen, rightlen;
             long long int totlensum;
             FLANK *       templ_flank_ptr, *largestPtr;
 
@@ -493,28 +390,21 @@ int main( int argc, char *argv[] ) {
                         src5--;
                     }
 
-                    templ_flank_ptr = (FLANK *) smalloc( sizeof( FLANK ) );
-
-                    templ_flank_ptr->left  = GetReverse( src1 );
-                    templ_flank_ptr->right = strdup( src3 );
+                    templ_flank_ptr = (FLANK *) scalloc( 1, sizeof( FLANK ) );
 
-                    templ_flank_ptr->leftlen  = strlen( src1 );
-                    templ_flank_ptr->rightlen = strlen( src3 );
+                    /* only the REFLEN bases next to the repeat are compared */
+                    leftlen  = min( (int) strlen( src1 ), REFLEN );
+                    rightlen = min( (int) strlen( src3 ), REFLEN );
 
-                    templ_flank_ptr->leftlen =
-                      min( templ_flank_ptr->leftlen, REFLEN );
-                    templ_flank_ptr->rightlen =
-                      min( templ_flank_ptr->rightlen, REFLEN );
-
-                    templ_flank_ptr->leftcp =
-                      GetComplement( templ_flank_ptr->left );
-                    templ_flank_ptr->rightcp =
-                      GetComplement( templ_flank_ptr->right );
+                    packFlanks( templ_flank_ptr,
+                      src1 + strlen( src1 ) - leftlen, leftlen, src3,
+                      rightlen );
 
                     templ_flank_ptr->sequence = strdup( src2 );
                     templ_flank_ptr->pattern  = strdup( src4 );
 
-                    if ( !templ_flank_ptr->left || !templ_flank_ptr->right )
+                    if ( !templ_flank_ptr->sequence ||
+                         !templ_flank_ptr->pattern )
                         doCriticalErrorAndQuit(
                           "\n\nFlankAlign - memory error 1. Aborting!\n\n" );
 
@@ -673,6 +563,8 @@ int main( int argc, char *argv[] ) {
 
                         double sizeerror;
 
+                        PACKEDSEQ_VIEW readleft, readright, refleft, refright;
+
                         ref_ptr = (FLANK *) EasyListItem( nd2 );
 
                         // fprintf(fp,"\t%d - %d - %s - %s\n",ref_ptr->leftlen,
@@ -697,20 +589,17 @@ int main( int argc, char *argv[] ) {
                         }
 
                         /* same direction */
+                        readleft  = flankLeft( read_ptr );
+                        readright = flankRight( read_ptr );
+                        refleft   = flankLeft( ref_ptr );
+                        refright  = flankRight( ref_ptr );
+
                         lerr1 =
-                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
-                            read_ptr->left, ref_ptr->left, read_ptr->leftlen,
-                            ( ref_ptr->leftlen > read_ptr->leftlen )
-                              ? ref_ptr->leftlen
-                              : read_ptr->leftlen,
-                            MAXERRORS );
+                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnView(
+                            &readleft, &refleft, MAXERRORS );
                         rerr1 =
-                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
-                            read_ptr->right, ref_ptr->right, read_ptr->rightlen,
-                            ( ref_ptr->rightlen > read_ptr->rightlen )
-                              ? ref_ptr->rightlen
-                              : read_ptr->rightlen,
-                            MAXERRORS );
+                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnView(
+                            &readright, &refright, MAXERRORS );
 
                         // lerr1 = rerr1 = 100;
                         if ( lerr1 < 0 || rerr1 < 0 ) {
@@ -722,21 +611,15 @@ int main( int argc, char *argv[] ) {
 
                         /* try aligning to the compliment of the other flank
                          * instead */
+                        readleft  = PackedSeqViewComplement( readleft );
+                        readright = PackedSeqViewComplement( readright );
+
                         lerr2 =
-                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
-                            read_ptr->rightcp, ref_ptr->left,
-                            read_ptr->rightlen,
-                            ( ref_ptr->leftlen > read_ptr->rightlen )
-                              ? ref_ptr->leftlen
-                              : read_ptr->rightlen,
-                            MAXERRORS );
+                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnView(
+                            &readright, &refleft, MAXERRORS );
                         rerr2 =
-                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnLowMemUsesPointers(
-                            read_ptr->leftcp, ref_ptr->right, read_ptr->leftlen,
-                            ( ref_ptr->rightlen > read_ptr->leftlen )
-                              ? ref_ptr->rightlen
-                              : read_ptr->leftlen,
-                            MAXERRORS );
+                          narrowbandUnitCostDistanceSameLengthBestScoreLastRowColumnView(
+                            &readleft, &refright, MAXERRORS );
 
                         // lerr2 = rerr2 = 100;
                         if ( lerr2 < 0 || rerr2 < 0 ) {
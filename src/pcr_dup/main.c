@@ -3,8 +3,7 @@
 #include <string.h>
 #include <errno.h>
 #include "LinkedList.h"
-#include "bitwise LCS single word.h"
-#include "bitwise LCS multiple word.h"
+#include "../libs/vntr_kernels/vntr_kernels.h"
 
 #define MAXREADLENGTH 5000
 #define FLANKLENGTH 20
@@ -1,12 +0,0 @@
-/*
- *  bitwise LCS.h
- *  linear time bitwise LCS
- *
- *  Created by Gary Benson on 8/15/11.
- *  Copyright 2011 Boston University. All rights reserved.
- *
- */
-
-#define maxStringLengthForRegister 63
-
-int LCS_multiple_word( char *string1, char *string2, int n, int m );
\ No newline at end of file
@@ -1,13 +0,0 @@
-/*
- *  bitwise edit distance alignment multiple word no end penalty.h
- *  bitwise edit distance alignment
- *
- *  Created by Gary Benson on 7/20/12.
- *  Copyright 2012 Boston University. All rights reserved.
- *
- */
-
-#define maxStringLengthForEditDistanceRegister 64
-
-int Edit_Distance_multiple_word_NoEndPenaltySeq1(
-  char *stringN, char *stringM, int N, int M );
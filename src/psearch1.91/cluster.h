@@ -45,54 +45,54 @@ int ClusterBasePrint( CLUSTERBASE *base, FILE *fp );
 int ClusterBaseDestroy( CLUSTERBASE *base );
 int ClusterBaseAskLink( CLUSTERBASE *base, int key1, int key2 );
 int ClusterBaseRestoreDirection( CLUSTERBASE *base, int key, int direction );
+int ClusterBaseSetConnected(
+  CLUSTERBASE *base, int key, int leftcon, int rightcon );
 
 /* IMPLEMENTATION */
 
-#define CLUSTERBASESIZE 1000000
-#define CLUSTERMAGICNUM 15423
+/* Clusters are kept as a union-find forest over an array of nodes, one node
+ * per key, joined by size with path compression. Each node holds the parity
+ * of its direction relative to its parent, a root holds its own direction, so
+ * the direction of a key is the xor of the parities up to its root and
+ * flipping a whole cluster on a merge only changes the parity of one root.
+ * Every root also keeps its members in insertion order (the root first) and
+ * its place in the list of clusters, so clusters print as they always have. */
 
-typedef struct tagCLUSTERITEM {
-    struct tagCLUSTERKEY * key;
-    struct tagCLUSTERITEM *next;
-} CLUSTERITEM;
-
-typedef struct tagCLUSTERHEAD {
-    int                    count;
-    struct tagCLUSTERHEAD *prevcluster;
-    struct tagCLUSTERHEAD *nextcluster;
-    CLUSTERITEM *          first;
-    CLUSTERITEM *          last;
-    char *                 comment;
-} CLUSTERHEAD;
-
-typedef struct tagCLUSTERKEY {
-    int                   key;
-    int                   direction;
-    char                  leftcon, rightcon;
-    PROFILE *             prof, *profrc;
-    struct tagCLUSTERKEY *next;
-    CLUSTERHEAD *         cluster;
-
-} CLUSTERKEY;
+#define CLUSTERMAGICNUM 15423
+#define CLUSTERINITIALSIZE 65536
+
+typedef struct {
+    int      key;
+    int      parent;
+    int      next; // next member of the cluster, -1 at the end
+    char     parity, leftcon, rightcon;
+    PROFILE *prof, *profrc;
+
+    // only used on roots
+    int   count;
+    int   last;
+    int   prevcluster, nextcluster;
+    char *comment;
+} CLUSTERNODE;
 
 struct tagCLUSTERBASE {
     int                    magic; // set to CLUSTERMAGICNUM on valid structures
-    CLUSTERKEY **          keys;
-    CLUSTERHEAD *          firstcluster;
-    CLUSTERHEAD *          lastcluster;
-    int                    size;
+    CLUSTERNODE *          nodes;
+    int                    nnodes, maxnodes;
+    int *                  table; // open addressing, node index + 1, 0 if empty
+    int                    tablesize;
+    int                    firstcluster, lastcluster;
     unsigned long long int trcount;
 };
 
-CLUSTERKEY * cl_findkey( CLUSTERBASE *base, int key );
-CLUSTERHEAD *cl_newcluster( CLUSTERBASE *base );
-int cl_insertkey( CLUSTERBASE *base, CLUSTERHEAD *cluster, int key, int dir );
-int cl_mergeclusters(
-  CLUSTERBASE *base, CLUSTERHEAD *c1, CLUSTERHEAD *c2, int flip );
+int cl_findkey( CLUSTERBASE *base, int key );
+int cl_findroot( CLUSTERBASE *base, int node, int *direction );
+int cl_newcluster( CLUSTERBASE *base, int key );
+int cl_insertkey( CLUSTERBASE *base, int root, int key, int dir );
+int cl_mergeclusters( CLUSTERBASE *base, int r1, int r2, int flip );
 
 CLUSTERBASE *ClusterBaseCreate( void ) {
     CLUSTERBASE *base;
-    CLUSTERKEY **keys;
 
     // allocate a clusterbase structure
     base = (CLUSTERBASE *) malloc( sizeof( CLUSTERBASE ) );
@@ -100,20 +100,25 @@ CLUSTERBASE *ClusterBaseCreate( void ) {
     if ( base == NULL )
         return NULL;
 
-    // allocate the rack with 'zero-out' memory
-    keys = (CLUSTERKEY **) calloc( CLUSTERBASESIZE, sizeof( CLUSTERKEY * ) );
+    // allocate the key table with 'zero-out' memory and the nodes
+    base->table = (int *) calloc( CLUSTERINITIALSIZE, sizeof( int ) );
+    base->nodes = (CLUSTERNODE *) malloc(
+      CLUSTERINITIALSIZE / 2 * sizeof( CLUSTERNODE ) );
 
-    if ( keys == NULL ) {
+    if ( base->table == NULL || base->nodes == NULL ) {
+        free( base->table );
+        free( base->nodes );
         free( base );
         return NULL;
     }
 
     // assemble the parts
     base->magic        = CLUSTERMAGICNUM;
-    base->keys         = keys;
-    base->firstcluster = NULL;
-    base->lastcluster  = NULL;
-    base->size         = CLUSTERBASESIZE;
+    base->nnodes       = 0;
+    base->maxnodes     = CLUSTERINITIALSIZE / 2;
+    base->tablesize    = CLUSTERINITIALSIZE;
+    base->firstcluster = -1;
+    base->lastcluster  = -1;
     base->trcount      = 0;
 
     return base;
@@ -121,7 +126,7 @@ CLUSTERBASE *ClusterBaseCreate( void ) {
 
 int ClusterBaseAddComment( CLUSTERBASE *base, int key1, char *comment ) {
 
-    CLUSTERKEY *pk1;
+    int pk1, root, dir;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -132,12 +137,15 @@ int ClusterBaseAddComment( CLUSTERBASE *base, int key1, char *comment ) {
 
     pk1 = cl_findkey( base, key1 );
 
-    if ( pk1 == NULL )
+    if ( pk1 < 0 )
         return -1;
 
-    pk1->cluster->comment = strdup( comment );
+    root = cl_findroot( base, pk1, &dir );
 
-    if ( pk1->cluster->comment )
+    free( base->nodes[root].comment );
+    base->nodes[root].comment = strdup( comment );
+
+    if ( base->nodes[root].comment )
         return 0;
     else
         return -1;
@@ -146,8 +154,6 @@ int ClusterBaseAddComment( CLUSTERBASE *base, int key1, char *comment ) {
 // this function added to support 1 repeat clusters, Gelfand Jan 5, 2007
 int ClusterBaseAddUnique( CLUSTERBASE *base, int key1 ) {
 
-    CLUSTERHEAD *cluster;
-
     // verify if valid cluster base
     if ( base == NULL )
         return -1;
@@ -155,12 +161,7 @@ int ClusterBaseAddUnique( CLUSTERBASE *base, int key1 ) {
     if ( base->magic != CLUSTERMAGICNUM )
         return -1;
 
-    cluster = cl_newcluster( base );
-
-    if ( cluster == NULL )
-        return -1;
-
-    if ( cl_insertkey( base, cluster, key1, 0 ) )
+    if ( cl_newcluster( base, key1 ) < 0 )
         return -1;
 
     return 0;
@@ -170,7 +171,8 @@ int ClusterBaseAddUnique( CLUSTERBASE *base, int key1 ) {
  * clusterr */
 int ClusterBaseRestoreDirection( CLUSTERBASE *base, int key, int direction ) {
 
-    CLUSTERKEY *pk1;
+    CLUSTERNODE *nodes;
+    int          pk1, root, dir, node, nodedir;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -181,10 +183,24 @@ int ClusterBaseRestoreDirection( CLUSTERBASE *base, int key, int direction ) {
 
     pk1 = cl_findkey( base, key );
 
-    if ( pk1 == NULL )
+    if ( pk1 < 0 )
         return -1;
-    else
-        pk1->direction = direction;
+
+    nodes = base->nodes;
+    root  = cl_findroot( base, pk1, &dir );
+
+    // every other key of the cluster is put directly under the root, so
+    // only the one changed key moves
+    for ( node = nodes[root].next; node >= 0; node = nodes[node].next )
+        cl_findroot( base, node, &nodedir );
+
+    if ( pk1 == root ) {
+        for ( node = nodes[root].next; node >= 0; node = nodes[node].next )
+            nodes[node].parity ^= nodes[root].parity ^ direction;
+
+        nodes[root].parity = direction;
+    } else
+        nodes[pk1].parity = direction ^ nodes[root].parity;
 
     return 0;
 }
@@ -192,9 +208,26 @@ int ClusterBaseRestoreDirection( CLUSTERBASE *base, int key, int direction ) {
 int ClusterBaseAddLinkProfile( CLUSTERBASE *base, int key1, int key2,
   PROFILE *prof1, PROFILE *prof1rc, PROFILE *prof2, PROFILE *prof2rc,
   int dir ) {
-    CLUSTERKEY * pk1, *pk2;
-    CLUSTERHEAD *cluster;
-    int          flip;
+
+    int pk1, pk2;
+
+    if ( ClusterBaseAddLink( base, key1, key2, dir ) )
+        return -1;
+
+    // this is needed for pam
+    pk1                     = cl_findkey( base, key1 );
+    pk2                     = cl_findkey( base, key2 );
+    base->nodes[pk1].prof   = prof1;
+    base->nodes[pk1].profrc = prof1rc;
+    base->nodes[pk2].prof   = prof2;
+    base->nodes[pk2].profrc = prof2rc;
+
+    return 0;
+}
+
+int ClusterBaseAddLink( CLUSTERBASE *base, int key1, int key2, int dir ) {
+    int pk1, pk2, root1, root2, dir1, dir2, root;
+    int flip;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -211,64 +244,51 @@ int ClusterBaseAddLinkProfile( CLUSTERBASE *base, int key1, int key2,
     pk2 = cl_findkey( base, key2 );
 
     // if both keys are new
-    if ( pk1 == NULL && pk2 == NULL ) {
-        cluster = cl_newcluster( base );
-
-        if ( cluster == NULL )
-            return -1;
+    if ( pk1 < 0 && pk2 < 0 ) {
+        root = cl_newcluster( base, key1 );
 
-        if ( cl_insertkey( base, cluster, key1, 0 ) )
+        if ( root < 0 )
             return -1;
 
-        if ( cl_insertkey( base, cluster, key2, dir ) )
+        if ( cl_insertkey( base, root, key2, dir ) )
             return -1;
     }
     // if both keys have been added before
-    else if ( pk1 != NULL && pk2 != NULL ) {
+    else if ( pk1 >= 0 && pk2 >= 0 ) {
+        root1 = cl_findroot( base, pk1, &dir1 );
+        root2 = cl_findroot( base, pk2, &dir2 );
+
         // make sure the clusters are different
-        if ( pk1->cluster != pk2->cluster ) {
-            flip = pk1->direction ^ pk2->direction ^ dir;
+        if ( root1 != root2 ) {
+            flip = dir1 ^ dir2 ^ dir;
 
-            if ( cl_mergeclusters( base, pk1->cluster, pk2->cluster, flip ) )
+            if ( cl_mergeclusters( base, root1, root2, flip ) )
                 return -1;
         }
     }
     // if one has been added but not the other
     else {
-        if ( pk1 != NULL ) {
-            if ( pk1->direction == 0 ) {
-                if ( cl_insertkey( base, pk1->cluster, key2, dir ) )
-                    return -1;
-            } else {
-                if ( cl_insertkey( base, pk1->cluster, key2, !dir ) )
-                    return -1;
-            }
+        if ( pk1 >= 0 ) {
+            root1 = cl_findroot( base, pk1, &dir1 );
+
+            if ( cl_insertkey( base, root1, key2, ( dir1 == 0 ) ? dir : !dir ) )
+                return -1;
         } else {
-            if ( pk2->direction == 0 ) {
-                if ( cl_insertkey( base, pk2->cluster, key1, dir ) )
-                    return -1;
-            } else {
-                if ( cl_insertkey( base, pk2->cluster, key1, !dir ) )
-                    return -1;
-            }
+            root2 = cl_findroot( base, pk2, &dir2 );
+
+            if ( cl_insertkey( base, root2, key1, ( dir2 == 0 ) ? dir : !dir ) )
+                return -1;
         }
     }
 
-    // this is needed for pam
-    pk1         = cl_findkey( base, key1 );
-    pk2         = cl_findkey( base, key2 );
-    pk1->prof   = prof1;
-    pk1->profrc = prof1rc;
-    pk2->prof   = prof2;
-    pk2->profrc = prof2rc;
-
     return 0;
 }
 
-int ClusterBaseAddLink( CLUSTERBASE *base, int key1, int key2, int dir ) {
-    CLUSTERKEY * pk1, *pk2;
-    CLUSTERHEAD *cluster;
-    int          flip;
+/* marks the flanks of key as connected to another reference */
+int ClusterBaseSetConnected(
+  CLUSTERBASE *base, int key, int leftcon, int rightcon ) {
+
+    int pk;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -277,62 +297,22 @@ int ClusterBaseAddLink( CLUSTERBASE *base, int key1, int key2, int dir ) {
     if ( base->magic != CLUSTERMAGICNUM )
         return -1;
 
-    // make sure keys are different
-    if ( key1 == key2 )
-        return -1;
-
-    pk1 = cl_findkey( base, key1 );
-    pk2 = cl_findkey( base, key2 );
-
-    // if both keys are new
-    if ( pk1 == NULL && pk2 == NULL ) {
-        cluster = cl_newcluster( base );
+    pk = cl_findkey( base, key );
 
-        if ( cluster == NULL )
-            return -1;
-
-        if ( cl_insertkey( base, cluster, key1, 0 ) )
-            return -1;
+    if ( pk < 0 )
+        return -1;
 
-        if ( cl_insertkey( base, cluster, key2, dir ) )
-            return -1;
-    }
-    // if both keys have been added before
-    else if ( pk1 != NULL && pk2 != NULL ) {
-        // make sure the clusters are different
-        if ( pk1->cluster != pk2->cluster ) {
-            flip = pk1->direction ^ pk2->direction ^ dir;
+    if ( leftcon )
+        base->nodes[pk].leftcon = 1;
 
-            if ( cl_mergeclusters( base, pk1->cluster, pk2->cluster, flip ) )
-                return -1;
-        }
-    }
-    // if one has been added but not the other
-    else {
-        if ( pk1 != NULL ) {
-            if ( pk1->direction == 0 ) {
-                if ( cl_insertkey( base, pk1->cluster, key2, dir ) )
-                    return -1;
-            } else {
-                if ( cl_insertkey( base, pk1->cluster, key2, !dir ) )
-                    return -1;
-            }
-        } else {
-            if ( pk2->direction == 0 ) {
-                if ( cl_insertkey( base, pk2->cluster, key1, dir ) )
-                    return -1;
-            } else {
-                if ( cl_insertkey( base, pk2->cluster, key1, !dir ) )
-                    return -1;
-            }
-        }
-    }
+    if ( rightcon )
+        base->nodes[pk].rightcon = 1;
 
     return 0;
 }
 
 int ClusterBaseAskLink( CLUSTERBASE *base, int key1, int key2 ) {
-    CLUSTERKEY *pk1, *pk2;
+    int pk1, pk2, dir;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -345,155 +325,210 @@ int ClusterBaseAskLink( CLUSTERBASE *base, int key1, int key2 ) {
     pk2 = cl_findkey( base, key2 );
 
     // if both keys have been added before
-    if ( pk1 != NULL && pk2 != NULL ) {
-        // if both keys point to same cluster return 1
-        if ( pk1->cluster == pk2->cluster )
+    if ( pk1 >= 0 && pk2 >= 0 ) {
+        // if both keys are in the same cluster return 1
+        if ( cl_findroot( base, pk1, &dir ) == cl_findroot( base, pk2, &dir ) )
             return 1;
     }
 
     return 0;
 }
 
-CLUSTERKEY *cl_findkey( CLUSTERBASE *base, int key ) {
-    int         pos;
-    CLUSTERKEY *pk;
+/* position of key in the table, 'zero-out' slots are free */
+static inline unsigned int cl_slot( CLUSTERBASE *base, int key ) {
+
+    return ( ( (unsigned int) key * 2654435769u ) & ( base->tablesize - 1 ) );
+}
 
-    // locate key in hash rack
-    pos = abs( key ) % base->size;
+/* node index of key, -1 if it has not been added */
+int cl_findkey( CLUSTERBASE *base, int key ) {
+    unsigned int pos;
 
-    for ( pk = base->keys[pos]; pk != NULL; pk = pk->next )
-        if ( pk->key == key )
-            break;
+    // locate key in the table, probing linearly
+    for ( pos = cl_slot( base, key ); base->table[pos] != 0;
+          pos = ( pos + 1 ) & ( base->tablesize - 1 ) )
+        if ( base->nodes[base->table[pos] - 1].key == key )
+            return ( base->table[pos] - 1 );
 
-    return pk;
+    return -1;
 }
 
-CLUSTERHEAD *cl_newcluster( CLUSTERBASE *base ) {
-    CLUSTERHEAD *cluster;
+/* root of node's cluster and direction of node, compresses the path */
+int cl_findroot( CLUSTERBASE *base, int node, int *direction ) {
+    CLUSTERNODE *nodes = base->nodes;
+    int          root, parity, next, hold;
+
+    // parity up to, but not including, the root
+    parity = 0;
+    for ( root = node; nodes[root].parent != root; root = nodes[root].parent )
+        parity ^= nodes[root].parity;
+
+    *direction = parity ^ nodes[root].parity;
+
+    // point every node on the path at the root
+    while ( node != root && nodes[node].parent != root ) {
+        next               = nodes[node].parent;
+        hold               = nodes[node].parity;
+        nodes[node].parent = root;
+        nodes[node].parity = parity;
+        parity ^= hold;
+        node = next;
+    }
+
+    return root;
+}
 
-    // allocate cluster structure
-    cluster = (CLUSTERHEAD *) malloc( sizeof( CLUSTERHEAD ) );
+/* adds a node for key, growing the nodes and table as needed */
+int cl_newnode( CLUSTERBASE *base, int key ) {
+    CLUSTERNODE *nodes;
+    int *        table;
+    int          i, oldsize;
+    unsigned int pos;
 
-    if ( cluster == NULL )
-        return NULL;
+    if ( base->nnodes == base->maxnodes ) {
+        nodes = (CLUSTERNODE *) realloc(
+          base->nodes, 2 * base->maxnodes * sizeof( CLUSTERNODE ) );
 
-    // set cluster members
-    cluster->count       = 0;
-    cluster->prevcluster = NULL;
-    cluster->nextcluster = NULL;
-    cluster->first       = NULL;
-    cluster->last        = NULL;
-    cluster->comment     = NULL;
+        if ( nodes == NULL )
+            return -1;
 
-    // place at end of cluster list
-    if ( base->firstcluster == NULL ) {
-        base->firstcluster = cluster;
-        base->lastcluster  = cluster;
-    } else {
-        base->lastcluster->nextcluster = cluster;
-        cluster->prevcluster           = base->lastcluster;
-        base->lastcluster              = cluster;
+        base->nodes = nodes;
+        base->maxnodes *= 2;
     }
 
-    return cluster;
-}
+    // keep the table at most half full
+    if ( 2 * ( base->nnodes + 1 ) > base->tablesize ) {
+        table = (int *) calloc( 2 * base->tablesize, sizeof( int ) );
 
-int cl_insertkey( CLUSTERBASE *base, CLUSTERHEAD *cluster, int key, int dir ) {
-    int          pos;
-    CLUSTERKEY * pk;
-    CLUSTERITEM *pi;
+        if ( table == NULL )
+            return -1;
+
+        oldsize = base->tablesize;
+        free( base->table );
+        base->table     = table;
+        base->tablesize = 2 * oldsize;
 
-    // compute position of key
-    pos = abs( key ) % base->size;
+        for ( i = 0; i < base->nnodes; i++ ) {
+            for ( pos = cl_slot( base, base->nodes[i].key ); table[pos] != 0;
+                  pos = ( pos + 1 ) & ( base->tablesize - 1 ) )
+                ;
+            table[pos] = i + 1;
+        }
+    }
 
-    // allocate a clusterkey structure
-    pk = (CLUSTERKEY *) malloc( sizeof( CLUSTERKEY ) );
+    // a key added again hides the earlier one
+    for ( pos = cl_slot( base, key ); base->table[pos] != 0;
+          pos = ( pos + 1 ) & ( base->tablesize - 1 ) )
+        if ( base->nodes[base->table[pos] - 1].key == key )
+            break;
+    base->table[pos] = base->nnodes + 1;
+
+    i = base->nnodes++;
+
+    // set node members
+    base->nodes[i].key         = key;
+    base->nodes[i].parent      = i;
+    base->nodes[i].next        = -1;
+    base->nodes[i].parity      = 0;
+    base->nodes[i].leftcon     = 0;
+    base->nodes[i].rightcon    = 0;
+    base->nodes[i].prof        = NULL;
+    base->nodes[i].profrc      = NULL;
+    base->nodes[i].count       = 1;
+    base->nodes[i].last        = i;
+    base->nodes[i].prevcluster = -1;
+    base->nodes[i].nextcluster = -1;
+    base->nodes[i].comment     = NULL;
 
-    if ( pk == NULL )
-        return -1;
+    base->trcount++;
+
+    return i;
+}
+
+/* starts a cluster holding only key, in direction 0, returns its root */
+int cl_newcluster( CLUSTERBASE *base, int key ) {
+    int root;
 
-    // allocate a clusteritem structure
-    pi = (CLUSTERITEM *) malloc( sizeof( CLUSTERITEM ) );
+    root = cl_newnode( base, key );
 
-    if ( pi == NULL ) {
-        free( pk );
+    if ( root < 0 )
         return -1;
-    }
 
-    // set clusterkey members and put in list
-    pk->key         = key;
-    pk->direction   = dir;
-    pk->leftcon     = 0;
-    pk->rightcon    = 0;
-    pk->cluster     = cluster;
-    pk->next        = base->keys[pos];
-    pk->prof        = NULL;
-    pk->profrc      = NULL;
-    base->keys[pos] = pk;
-
-    // set clusteritem member and put in list
-    pi->key  = pk;
-    pi->next = NULL;
-
-    if ( cluster->first == NULL ) {
-        cluster->first = pi;
-        cluster->last  = pi;
+    // place at end of cluster list
+    if ( base->firstcluster < 0 ) {
+        base->firstcluster = root;
+        base->lastcluster  = root;
     } else {
-        cluster->last->next = pi;
-        cluster->last       = pi;
+        base->nodes[base->lastcluster].nextcluster = root;
+        base->nodes[root].prevcluster              = base->lastcluster;
+        base->lastcluster                          = root;
     }
 
-    cluster->count++;
-    base->trcount++;
+    return root;
+}
+
+int cl_insertkey( CLUSTERBASE *base, int root, int key, int dir ) {
+    CLUSTERNODE *nodes;
+    int          node;
+
+    node = cl_newnode( base, key );
+
+    if ( node < 0 )
+        return -1;
+
+    // direction relative to the root, after the table may have moved
+    nodes              = base->nodes;
+    nodes[node].parent = root;
+    nodes[node].parity = dir ^ nodes[root].parity;
+
+    // put at the end of the cluster
+    nodes[nodes[root].last].next = node;
+    nodes[root].last             = node;
+    nodes[root].count++;
 
     return 0;
 }
 
-int cl_mergeclusters(
-  CLUSTERBASE *base, CLUSTERHEAD *c1, CLUSTERHEAD *c2, int flip ) {
-    CLUSTERHEAD *hold;
-    CLUSTERITEM *item;
+int cl_mergeclusters( CLUSTERBASE *base, int r1, int r2, int flip ) {
+    CLUSTERNODE *nodes = base->nodes;
+    int          hold;
 
-    // make c1 the one with more items
-    if ( c1->count < c2->count ) {
-        hold = c1;
-        c1   = c2;
-        c2   = hold;
+    // make r1 the one with more items
+    if ( nodes[r1].count < nodes[r2].count ) {
+        hold = r1;
+        r1   = r2;
+        r2   = hold;
     }
 
-    // make all keys in c2 point to c1
-    for ( item = c2->first; item != NULL; item = item->next ) {
-        item->key->cluster = c1;
+    // hang r2 off r1, flipping the direction of all of r2 if flip is 1
+    nodes[r2].parent = r1;
+    nodes[r2].parity ^= flip ^ nodes[r1].parity;
 
-        // also flip direction if flip is 1
-        item->key->direction ^= flip;
-    }
+    // append r2's items to r1
+    nodes[nodes[r1].last].next = r2;
+    nodes[r1].last             = nodes[r2].last;
+    nodes[r1].count += nodes[r2].count;
 
-    // append c2's item list to c1
-    c1->last->next = c2->first;
-    c1->last       = c2->last;
-    c1->count += c2->count;
-
-    // remove c2 from list and free it.
-    if ( c2 == base->firstcluster ) {
-        base->firstcluster           = c2->nextcluster;
-        c2->nextcluster->prevcluster = NULL;
-    } else if ( c2 == base->lastcluster ) {
-        base->lastcluster            = c2->prevcluster;
-        c2->prevcluster->nextcluster = NULL;
-    } else { // cluster is in the middle
-        c2->nextcluster->prevcluster = c2->prevcluster;
-        c2->prevcluster->nextcluster = c2->nextcluster;
-    }
+    // remove r2 from the cluster list
+    if ( nodes[r2].prevcluster < 0 )
+        base->firstcluster = nodes[r2].nextcluster;
+    else
+        nodes[nodes[r2].prevcluster].nextcluster = nodes[r2].nextcluster;
 
-    free( c2 );
+    if ( nodes[r2].nextcluster < 0 )
+        base->lastcluster = nodes[r2].prevcluster;
+    else
+        nodes[nodes[r2].nextcluster].prevcluster = nodes[r2].prevcluster;
+
+    free( nodes[r2].comment );
+    nodes[r2].comment = NULL;
 
     return 0;
 }
 
 int ClusterBasePrint( CLUSTERBASE *base, FILE *fp ) {
-    CLUSTERHEAD *cluster;
-    CLUSTERITEM *item;
+    CLUSTERNODE *nodes;
+    int          cluster, item, dir;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -502,36 +537,40 @@ int ClusterBasePrint( CLUSTERBASE *base, FILE *fp ) {
     if ( base->magic != CLUSTERMAGICNUM )
         return -1;
 
-    for ( cluster = base->firstcluster; cluster != NULL;
-          cluster = cluster->nextcluster ) {
+    nodes = base->nodes;
+
+    for ( cluster = base->firstcluster; cluster >= 0;
+          cluster = nodes[cluster].nextcluster ) {
 
         {
 
             fprintf( fp, "@" );
 
-            for ( item = cluster->first; item != NULL; item = item->next ) {
+            for ( item = cluster; item >= 0; item = nodes[item].next ) {
 
                 /* for ref to ref */
                 if ( OPTION == 'R' ) {
 
-                    if ( item->key->leftcon || item->key->rightcon )
+                    if ( nodes[item].leftcon || nodes[item].rightcon )
                         fprintf(
-                          fp, " %d+", item->key->key ); // UNDISTINGUISHABLE
+                          fp, " %d+", nodes[item].key ); // UNDISTINGUISHABLE
                     else
                         fprintf(
-                          fp, " %d-", item->key->key ); // DISTINGUISHABLE
+                          fp, " %d-", nodes[item].key ); // DISTINGUISHABLE
 
                 } else {
 
-                    if ( item->key->direction )
-                        fprintf( fp, " %d\"", item->key->key );
+                    cl_findroot( base, item, &dir );
+
+                    if ( dir )
+                        fprintf( fp, " %d\"", nodes[item].key );
                     else
-                        fprintf( fp, " %d'", item->key->key );
+                        fprintf( fp, " %d'", nodes[item].key );
                 }
             }
 
-            if ( cluster->comment )
-                fprintf( fp, " #%s\n", cluster->comment );
+            if ( nodes[cluster].comment )
+                fprintf( fp, " #%s\n", nodes[cluster].comment );
             else
                 fprintf( fp, "\n" );
         }
@@ -541,8 +580,7 @@ int ClusterBasePrint( CLUSTERBASE *base, FILE *fp ) {
 }
 
 int ClusterBaseDestroy( CLUSTERBASE *base ) {
-    CLUSTERHEAD *clus;
-    CLUSTERITEM *item;
+    int cluster;
 
     // verify if valid cluster base
     if ( base == NULL )
@@ -551,24 +589,13 @@ int ClusterBaseDestroy( CLUSTERBASE *base ) {
     if ( base->magic != CLUSTERMAGICNUM )
         return -1;
 
-    // free clusterheads, clusteritems, and clusterkeys
-    while ( base->firstcluster != NULL ) {
-        clus               = base->firstcluster;
-        base->firstcluster = clus->nextcluster;
-
-        while ( clus->first != NULL ) {
-            item        = clus->first;
-            clus->first = item->next;
-
-            free( item->key );
-            free( item );
-        }
-
-        free( clus );
-    }
+    // free comments, nodes and table
+    for ( cluster = base->firstcluster; cluster >= 0;
+          cluster = base->nodes[cluster].nextcluster )
+        free( base->nodes[cluster].comment );
 
-    // free hash rack and base structure
-    free( base->keys );
+    free( base->nodes );
+    free( base->table );
     base->magic = 0;
     free( base );
 
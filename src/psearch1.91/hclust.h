@@ -24,21 +24,13 @@
 #include <math.h>
 
 #include "../libs/easylife/easylife.h"
-#include "bitwise LCS multiple word.h"
-#include "bitwise edit distance alignment multiple word no end penalty.h"
+#include "../libs/vntr_kernels/vntr_kernels.h"
 #include "doublehash.h"
 #include "profile.h"
 
-//#pragma pack(push)  /* push current alignment to stack */
-//#pragma pack(1)     /* set alignment to 1 byte boundary */
-
-typedef struct {
-    short int pmin;
-    char      dir;
-    PROFILE * prof;
-} SEED_HIT;
-
-//#pragma pack(pop)
+#if defined( __BMI2__ )
+#include <immintrin.h>
+#endif
 
 typedef struct tagSTATS {
     __int64 stTuplesProcessed; // various statistics
@@ -61,25 +53,28 @@ int Trange_Profile_Range[MAXPROFILESIZE + 1];
 #define MAX_LIST_TRANGE ( 14 )
 #define MAX_N_ONES ( 29 )
 
-EASY_ARRAY *
-  *Easy_Array_Tuples[MAX_LIST_TRANGE + 1]; // range 1 - MAX_ARRAY_TRANGE
-
-SEED_HIT **Array_Tuples[MAX_LIST_TRANGE + 1]; // range 1 - MAX_ARRAY_TRANGE
-EASY_ARRAY *
-  *Array_Tuples_Index[MAX_LIST_TRANGE + 1]; // range 1 - MAX_ARRAY_TRANGE
-unsigned int
-  *Array_Tuples_Length[MAX_LIST_TRANGE + 1];      // range 1 - MAX_ARRAY_TRANGE
 unsigned int Trange_N_Codes[MAX_LIST_TRANGE + 1]; // range 1 - MAX_ARRAY_TRANGE
 
-GDHASH *Hash_Tuples[MAX_LIST_TRANGE +
-                    1]; // range (MAX_ARRAY_TRANGE+1) - MAX_LIST_TRANGE
-
 int   Trange_Tuple_Size[MAX_LIST_TRANGE + 1]; // range 1 - MAX_LIST_TRANGE
 int   Trange_Ones[MAX_LIST_TRANGE + 1];       // range 1 - MAX_LIST_TRANGE
 char *Trange_Seed[MAX_LIST_TRANGE + 1];       // range 1 - MAX_LIST_TRANGE
 
+#include "refindex.h"
+
+REFINDEX *RefIndex = NULL;
+
+// reference seeds, only used while building the index
+REFINDEX_SEEDS Seed_Tuples[MAX_LIST_TRANGE + 1];
+
 long int *Index, *Complement;
-char *    Complementascii = NULL;
+
+/* run of consecutive seed ones inside one window word */
+typedef struct {
+    unsigned long long mask;     // bits of the run, shifted down
+    unsigned char      word;     // 0 - last 32 bases, 1 - the 32 before
+    unsigned char      shift;    // bit position in the window word
+    unsigned char      outshift; // bit position in the seed code
+} SEED_RUN;
 
 typedef struct {
     char *seed;
@@ -90,461 +85,491 @@ typedef struct {
     int  num_patterns; // 2 with X, 1 no X
     int *foffset[2];   // forward offset arrays - 0 unshifted, 1 shifted
     int *roffset[2];   // reverse offset arrays
+
+    // extraction of the code from a rolling 2 bit window (unshifted seed)
+    unsigned long long mask[2]; // bits of the ones in the two window words
+    int                nlow;    // ones in the last 32 bases
+    int                nruns;
+    SEED_RUN           runs[MAX_N_ONES];
 } SEED_STRUCT;
 
 SEED_STRUCT seedstruct;
 
+/* confirmed ref/read link, kept by the scanning thread until it is merged
+ * into the CLUSTERBASE in read order */
+typedef struct {
+    int    refkey;
+    int    readkey;
+    char   newdir;
+    double bestsim;
+    int    lerr, rerr;
+} SCAN_LINK;
+
+/* rotation pair passing the profile alignment, its flanks are aligned
+ * together with the other pairs of the read */
+typedef struct {
+    PROFILE *ref, *read;
+    int      refkey, readkey;
+    char     newdir;
+    double   bestsim;
+    int      maxel, maxer;
+    int      lerr, rerr;
+} FLANK_CHECK;
+
+/* per-thread read scanning state */
+typedef struct {
+    SEED_STRUCT seedstruct;
+    int         seedtrange; // TRANGE seedstruct was retrieved for
+    BLASTSTATS  stats;
+    EASY_ARRAY *candidates1, *candidates2;
+    PACKEDSEQ   packed;
+    PA_CONTEXT *pac; // profile alignment workspace
+    SCAN_LINK * links;
+    size_t      nlinks, maxlinks;
+
+    // distinct refs of a candidate list, prefiltered together by LCS
+    LCS_BATCH      lcs;
+    REFINDEX_HIT **batchhits;
+    char **        batchseqs;
+    int *          batchlens, *batchkeep;
+    size_t         maxbatch;
+
+    // flanks of the last reference aligned in each orientation, prepared
+    // for edit distance so reads hitting it again skip the encoding
+    PROFILE *             edref[2];
+    EDIT_DISTANCE_PATTERN edleft[2], edright[2];
+
+    // flank alignments of a read, run side by side
+    ED_BATCH     edbatch;
+    FLANK_CHECK *checks;
+    size_t       nchecks, maxchecks;
+} SCAN_WORKER;
+
 /************************************************************************************************************************/
-int _HCLUST_process_sequence( char *Sequence, SEED_STRUCT *pSS, int TRANGE,
-  int MaxTupleSize_SN, PROFILE *prof, int rc, int pmin ) {
-    int          Length          = prof->seq->length;
-    int          tuplesprocessed = 0, where;
-    int          g = 0, badcharindex = -1;
-    int          offset;
-    unsigned int seedcode, seedcode2;
-    int          i;
-    int *        SeedSeenHash = NULL;
-    int          code1Bad = 0, code2Bad = 0;
-    EASY_ARRAY * artemp;
-    SEED_HIT *   sh;
-
-    // printf(stderr, "\ntrange: %d sequence: %s\n",TRANGE,Sequence);
-
-    /* start processing */
-    for ( i = 0; i < ( Length ); i++ ) {
-
-        if ( ( strchr( "ACGT", Sequence[i] ) ==
-               NULL ) ) { /* not one of A,C,G,T */
-            badcharindex = i;
-            /* find first good string of mintupsize characters */
-            g = 0;
-
-            while ( ( g < MaxTupleSize_SN ) && ( i < ( Length - 1 ) ) ) {
-                i++;
-
-                /* adjust the running max and min centers */
-                // for(k=1;k<=NT_P;k++)
-                // Update_Runningmaxmincenters3(i,k);
-                if ( strchr( "ACGT", Sequence[i] ) == NULL ) {
-                    badcharindex = i;
-                    g            = 0;
-                } else
-                    g++;
-            }
+/* flank patterns of ref in the given slot of the worker, encoded only when
+ * the slot held another reference */
+static void _HCLUST_prepare_flanks( SCAN_WORKER *w, int slot, PROFILE *ref ) {
 
-            if ( g < MaxTupleSize_SN )
-                break; /* i=Length and minimum tuple not found */
-        }
+    if ( w->edref[slot] == ref )
+        return;
 
-        // fprintf(stderr,"\npSS->roffset[0]: %d",pSS->roffset[0]);
-        // fprintf(stderr,"\npSS->roffset[1]: %d",pSS->roffset[1]);
+    if ( Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare(
+           &w->edleft[slot], ref->left, ref->leftlen ) < 0 ||
+         Edit_Distance_multiple_word_NoEndPenaltySeq1_Prepare(
+           &w->edright[slot], ref->right, ref->rightlen ) < 0 )
+        doCriticalErrorAndQuit(
+          "Unable to allocate edit distance pattern. Aborting!" );
 
-        // fprintf(stderr,"\n\npSS->foffset[0]: %d",pSS->foffset[0]);
-        // fprintf(stderr,"\npSS->foffset[1]: %d",pSS->foffset[1]);
+    w->edref[slot] = ref;
+}
 
-        // fprintf(stderr,"\n\npSS->num_patterns: %d",pSS->num_patterns);
+/************************************************************************************************************************/
+/* queues a read flank against a prepared ref flank, pairs that do not fit
+ * the batch are aligned right away */
+static void _HCLUST_queue_flank( SCAN_WORKER *w,
+  EDIT_DISTANCE_PATTERN *pattern, char *read, int M, int maxerrors,
+  int *result ) {
+
+    if ( !ED_batch_add( &w->edbatch, pattern, pattern->N, read, M, result ) )
+        *result = Edit_Distance_multiple_word_NoEndPenaltySeq1_Run_Bounded(
+          pattern, pattern->N, read, M, maxerrors );
+}
 
-        // fprintf(stderr,"\n\npIndex: %d",Index);
+/************************************************************************************************************************/
+/* code of the seed ending at the newest base of the rolling window (lo holds
+ * the last 32 bases, hi the 32 before), the first 15 ones go to seedcode and
+ * the rest to seedcode2 */
+static inline void _HCLUST_seed_code( SEED_STRUCT *pSS, unsigned long long lo,
+  unsigned long long hi, unsigned int *seedcode, unsigned int *seedcode2 ) {
+
+    unsigned long long code;
+    int                rest;
+
+#if defined( __BMI2__ )
+    code = ( _pext_u64( hi, pSS->mask[1] ) << ( 2 * pSS->nlow ) ) |
+           _pext_u64( lo, pSS->mask[0] );
+#else
+    unsigned long long window[2] = { lo, hi };
+    SEED_RUN *         run;
+
+    code = 0;
+
+    for ( run = pSS->runs; run < pSS->runs + pSS->nruns; run++ ) {
+        code |= ( ( window[run->word] >> run->shift ) & run->mask )
+                << run->outshift;
+    }
+#endif
 
-        // printf("\n\npIndex['A']: %d",Index['A']);
+    rest = pSS->num_ones - 15;
 
-        // exit(1);
+    if ( rest > 0 ) {
+        *seedcode  = (unsigned int) ( code >> ( 2 * rest ) );
+        *seedcode2 = (unsigned int) ( code & ( ( 1ULL << ( 2 * rest ) ) - 1 ) );
+    } else {
+        *seedcode  = (unsigned int) code;
+        *seedcode2 = 0;
+    }
+}
 
-        if ( ( i - badcharindex ) >=
-             MaxTupleSize_SN ) { /* check for valid tuple */
+/************************************************************************************************************************/
+int _HCLUST_process_sequence( PACKEDSEQ *pseq, SEED_STRUCT *pSS, int TRANGE,
+  int MaxTupleSize_SN, PROFILE *prof, int rc, int pmin ) {
+    int                Length          = pseq->length;
+    int                tuplesprocessed = 0;
+    int                i, badcharindex = -1;
+    unsigned int       seedcode, seedcode2;
+    unsigned long long lo = 0, hi = 0;
 
-            /* produce code */
-            {
-                {
-                    seedcode = seedcode2 = 0;
+    if ( MaxTupleSize_SN > Length )
+        doCriticalErrorAndQuit(
+          "Tuple size (%d) is larger than sequence(%d). Aborting!",
+          MaxTupleSize_SN, Length );
 
-                    for ( offset = 0; offset < pSS->num_ones; offset++ ) {
+    /* start processing, roll the 2 bit window one base at a time */
+    for ( i = 0; i < Length; i++ ) {
 
-                        // if (0 == rc)
-                        //  where = i + pSS->roffset[0][pSS->num_ones - offset
-                        //  -1];
-                        // else
-                        where = i + pSS->foffset[0][offset];
+        hi = ( hi << 2 ) | ( lo >> 62 );
+        lo = ( lo << 2 ) | PACKEDSEQ_BASE( pseq, i );
 
-                        // fprintf(stderr,"\nOFFSET: %d, value: %d, i: %d,
-                        // where:
-                        // %d\n\n",offset,pSS->foffset[0][offset],i,where);
+        if ( PACKEDSEQ_ISN( pseq, i ) ) /* not one of A,C,G,T */
+            badcharindex = i;
 
-                        if ( where < 0 ) {
-                            doCriticalErrorAndQuit( "WHERE is <0!!" );
-                        }
+        if ( ( i - badcharindex ) < MaxTupleSize_SN ) /* check for valid tuple */
+            continue;
 
-                        if ( where >= ( Length + MaxTupleSize_SN ) ) {
-                            doCriticalErrorAndQuit( "where too large!" );
-                        }
+        _HCLUST_seed_code( pSS, lo, hi, &seedcode, &seedcode2 );
 
-                        if ( !( Sequence[where] == 'A' ||
-                                Sequence[where] == 'C' ||
-                                Sequence[where] == 'G' ||
-                                Sequence[where] == 'T' ) ) {
-                            doCriticalErrorAndQuit(
-                              "Unknown character in sequence! (%c) seqlen: %d, "
-                              "trange: %d, MaxTupleSize_SN: %d, where: %d, rc: "
-                              "%d, sequence: %s\n",
-                              Sequence[where], Length, TRANGE, MaxTupleSize_SN,
-                              where, rc, Sequence );
-                        }
-
-                        if ( offset <= 14 )
-                            seedcode = seedcode * 4 + Index[Sequence[where]];
-                        else if ( offset <= 29 )
-                            seedcode2 = seedcode2 * 4 + Index[Sequence[where]];
-                        else
-                            doCriticalErrorAndQuit(
-                              "Seed too large! Aborting!" );
-                    }
-                }
-                // Tuplecode[numpatterns]=code;
-                // Seedcode[numpatterns]=seedcode;
-                // Seedcode2[numpatterns]=seedcode2;
-            }
+        /* create an entry for seed hit, distinction between shifted and
+         * unshifted is not needed, the index sorts them into buckets */
+        if ( ( pSS->num_ones <= 13 && TRANGE <= MAX_ARRAY_TRANGE &&
+               TRANGE >= 1 ) ||
+             ( pSS->num_ones <= MAX_N_ONES && TRANGE > MAX_ARRAY_TRANGE &&
+               TRANGE <= MAX_LIST_TRANGE ) ) {
 
-            /* create an entry for seed hit, use -location to indicated reverse
-             * complemented hit, distinction between shifted and unshifted is
-             * not needed */
-            sh       = (SEED_HIT *) scalloc( 1, sizeof( SEED_HIT ) );
-            sh->pmin = pmin;
-            sh->dir  = rc;
-            sh->prof = prof;
-
-            if ( pSS->num_ones <= 13 && TRANGE <= MAX_ARRAY_TRANGE &&
-                 TRANGE >= 1 ) {
-
-                if ( NULL ==
-                     ( artemp = Easy_Array_Tuples[TRANGE][seedcode] ) ) {
-                    Easy_Array_Tuples[TRANGE][seedcode] = artemp =
-                      EasyArrayCreate( 2, NULL, free );
-                }
+            RefIndexAddSeed( &Seed_Tuples[TRANGE], seedcode, seedcode2,
+              prof->ordinal, pmin, rc );
 
-                EasyArrayInsert( artemp, (void *) sh );
+        } else {
+            doCriticalErrorAndQuit( "Seed with more than %d 1s or TRANGE "
+                                    "higher than 7, not yet implemented!",
+              MAX_N_ONES );
+        }
 
-            } else if ( pSS->num_ones <= MAX_N_ONES &&
-                        TRANGE > MAX_ARRAY_TRANGE &&
-                        TRANGE <= MAX_LIST_TRANGE ) {
+        tuplesprocessed++;
+    }
 
-                if ( NULL ==
-                     ( artemp = (EASY_ARRAY *) GetDoubleHashItem(
-                         Hash_Tuples[TRANGE], seedcode, seedcode2 ) ) ) {
-                    artemp = EasyArrayCreate( 2, NULL, free );
-                    SetDoubleHashItem( Hash_Tuples[TRANGE], seedcode, seedcode2,
-                      (void *) artemp, NULL, 0 );
-                }
+    return tuplesprocessed;
+}
 
-                EasyArrayInsert( artemp, (void *) sh );
+/************************************************************************************************************************/
+int _HCLUST_find_candidates( PACKEDSEQ *pseq, SEED_STRUCT *pSS, int TRANGE,
+  int MaxTupleSize_SN, int pmin, EASY_ARRAY *candidates ) {
 
-            } else {
-                doCriticalErrorAndQuit( "Seed with more than %d 1s or TRANGE "
-                                        "higher than 7, not yet implemented!",
-                  MAX_N_ONES );
-            }
+    int                Length = pseq->length;
+    int                i, badcharindex = -1;
+    unsigned int       seedcode, seedcode2;
+    unsigned long long lo = 0, hi = 0;
+    size_t             length, first, last;
+    REFINDEX_HIT *     shtemp;
 
-            /*
-                sh->location=i;   // i is index of current tuple
-                sh->seq=pseq;
-                sh->tsize=MaxTupleSize_SN;
+    if ( MaxTupleSize_SN > Length )
+        doCriticalErrorAndQuit(
+          "Tuple size (%d) is larger than sequence(%d). Aborting!",
+          MaxTupleSize_SN, Length );
 
+    if ( pSS->num_ones > MAX_N_ONES || TRANGE < 1 || TRANGE > MAX_LIST_TRANGE )
+        doCriticalErrorAndQuit( "Seed with more than %d 1s or TRANGE "
+                                "higher than 7, not yet implemented!",
+          MAX_N_ONES );
 
-                if
-               (NULL==(rc=GetTripleHashItem(SHash,seedcode,seedcode2,seedcode3)))
-               { wordList=EasyListCreate(NULL,free);
-                        SetTripleHashItem(SHash,seedcode,seedcode2,seedcode3,wordList);
-                } else {
-                        wordList = rc;
-                }
+    /* start processing, roll the 2 bit window one base at a time */
+    for ( i = 0; i < Length; i++ ) {
 
+        hi = ( hi << 2 ) | ( lo >> 62 );
+        lo = ( lo << 2 ) | PACKEDSEQ_BASE( pseq, i );
 
-                EasyListInsertHead(wordList,sh);
+        if ( PACKEDSEQ_ISN( pseq, i ) ) /* not one of A,C,G,T */
+            badcharindex = i;
 
-            */
+        if ( ( i - badcharindex ) < MaxTupleSize_SN ) /* check for valid tuple */
+            continue;
 
-            tuplesprocessed++;
+        _HCLUST_seed_code( pSS, lo, hi, &seedcode, &seedcode2 );
+
+        /* look up reference hits of the seed in the index, take the pmin
+         * groups within PATLEN_SIZE_ERR_FRACTION of ours */
+        if ( RefIndexLookup(
+               RefIndex, TRANGE, seedcode, seedcode2, &shtemp, &length ) ) {
+
+            // hits are sorted by pmin, bisect for the first hit in range and
+            // the first one past it (which is included)
+            first = RefIndexPminBound( shtemp, length,
+              pmin - (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
+                             TRUNC_ROUND_CEIL ) );
+            last = RefIndexPminBound( shtemp, length,
+              pmin + (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
+                             TRUNC_ROUND_CEIL ) + 1 );
+
+            if ( last == length )
+                last = length - 1;
+
+            for ( ; first <= last; first++ ) {
+                EasyArrayInsert( candidates, (void *) &shtemp[first] );
+            }
         }
     }
 
-    return tuplesprocessed;
+    return 0;
 }
 
 /************************************************************************************************************************/
-int _HCLUST_find_candidates( char *Sequence, FASTASEQUENCE *pseq,
-  SEED_STRUCT *pSS, int TRANGE, int MaxTupleSize_SN, int rc, int pmin,
-  EASY_ARRAY *candidates ) {
-
-    int Length = pseq->length;
-    // int tuplesprocessed=0;
-    int          where;
-    int          g = 0, badcharindex = -1;
-    int          offset;
-    unsigned int seedcode, seedcode2;
-    size_t       length;
-    int          i;
-    int *        SeedSeenHash = NULL;
-    int          code1Bad = 0, code2Bad = 0;
-    EASY_ARRAY * iatemp;
-    SEED_HIT *   shtemp;
-
-    /* start processing */
-    for ( i = 0; i < ( Length ); i++ ) {
-
-        if ( ( strchr( "ACGT", Sequence[i] ) ==
-               NULL ) ) { /* not one of A,C,G,T */
-            badcharindex = i;
-            /* find first good string of mintupsize characters */
-            g = 0;
+/* aligns the flanks of the rotation pairs collected for a read, side by side
+ * where they fit, and keeps the links passing in the order they were found */
+void _HCLUST_check_flanks( SCAN_WORKER *w ) {
+
+    FLANK_CHECK *check;
+    PROFILE *    read_ptr, *ref_ptr;
+    int          flanksPasses, lerr, rerr;
+    size_t       ui;
+
+    for ( ui = 0; ui < w->nchecks; ui++ ) {
+
+        check    = &w->checks[ui];
+        read_ptr = check->read;
+        ref_ptr  = check->ref;
+
+        _HCLUST_prepare_flanks( w, check->newdir, ref_ptr );
 
-            while ( ( g < MaxTupleSize_SN ) && ( i < ( Length - 1 ) ) ) {
-                i++;
+        /* refs vs reads */
+        if ( OPTION != 'R' ) {
 
-                if ( strchr( "ACGT", Sequence[i] ) == NULL ) {
-                    badcharindex = i;
-                    g            = 0;
-                } else
-                    g++;
+            if ( 0 != MAXERRORS ) {
+                check->maxel = MAXERRORS;
+                check->maxer = MAXERRORS;
+            } else {
+                check->maxel =
+                  min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
+                check->maxer =
+                  min( 8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
             }
 
-            if ( g < MaxTupleSize_SN )
-                break; /* i=Length and minimum tuple not found */
+            /* reflen is almost always 60, readlen is <=50. If reflen is from
+             * ends of chromosome it could be shorter.Thats why readlen will
+             * be shortened to reflen */
+            _HCLUST_queue_flank( w, &w->edleft[check->newdir], read_ptr->left,
+              min( ref_ptr->leftlen, read_ptr->leftlen ), check->maxel,
+              &check->lerr );
+            _HCLUST_queue_flank( w, &w->edright[check->newdir],
+              read_ptr->right, min( ref_ptr->rightlen, read_ptr->rightlen ),
+              check->maxer, &check->rerr );
+
+            /* refs vs refs */
+        } else {
+
+            /* Dec 5, 2014: Yozen asked to  make ref-ref scoring just like
+             * regular pipeline runs */
+            check->maxel = min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
+            check->maxer = min( 8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
+
+            _HCLUST_queue_flank( w, &w->edleft[check->newdir], read_ptr->left,
+              read_ptr->leftlen, check->maxel, &check->lerr );
+            _HCLUST_queue_flank( w, &w->edright[check->newdir],
+              read_ptr->right, read_ptr->rightlen, check->maxer,
+              &check->rerr );
         }
+    }
 
-        if ( ( i - badcharindex ) >=
-             MaxTupleSize_SN ) { /* check for valid tuple */
+    ED_batch_run( &w->edbatch );
 
-            SEED_HIT *start_hit = NULL, *end_hit = NULL, *temp_hit;
-            GDHITEM * gdhit;
-            size_t    uj;
+    for ( ui = 0; ui < w->nchecks; ui++ ) {
 
-            /* produce code */
-            {
-                {
-                    seedcode = seedcode2 = 0;
+        check    = &w->checks[ui];
+        read_ptr = check->read;
+        ref_ptr  = check->ref;
+        lerr     = check->lerr;
+        rerr     = check->rerr;
 
-                    for ( offset = 0; offset < pSS->num_ones; offset++ ) {
+        if ( lerr == -1 || rerr == -1 ) {
+            doCriticalErrorAndQuit(
+              "Edit_Distance_multiple_word_NoEndPenaltySeq1 "
+              "returned -1. Aborting!" );
+        }
 
-                        // if (0 == rc)
-                        //  where = i + pSS->roffset[0][pSS->num_ones - offset
-                        //  -1];
-                        // else
-                        where = i + pSS->foffset[0][offset];
+        // flanksPasses = (max(lerr,rerr) <= MAXERRORS);
+        // TESTING BOTH FLANKS FOR PARAMTER SELECTION
+        flanksPasses = ( lerr <= check->maxel && rerr <= check->maxer );
+
+        /* there is a possibility that reversing these might have different
+         * result, lets try it, 1.90 testing for mapping */
+        if ( OPTION == 'R' && !flanksPasses ) {
+
+            lerr = Edit_Distance_multiple_word_NoEndPenaltySeq1_Bounded(
+              read_ptr->left, ref_ptr->left, read_ptr->leftlen,
+              ref_ptr->leftlen, check->maxel );
+            rerr = Edit_Distance_multiple_word_NoEndPenaltySeq1_Bounded(
+              read_ptr->right, ref_ptr->right, read_ptr->rightlen,
+              ref_ptr->rightlen, check->maxer );
+
+            if ( lerr == -1 || rerr == -1 ) {
+                doCriticalErrorAndQuit( "Edit_Distance_multiple_word_"
+                                        "NoEndPenaltySeq1 returned -1. "
+                                        "Aborting!" );
+            }
 
-                        if ( where < 0 ) {
-                            doCriticalErrorAndQuit( "WHERE is <0!!" );
-                        }
+            flanksPasses = ( lerr <= check->maxel && rerr <= check->maxer );
+        }
 
-                        if ( where >= ( Length + MaxTupleSize_SN ) ) {
-                            doCriticalErrorAndQuit( "where too large!" );
-                        }
+        /* if flanks failed, try the other way (for palindromes).
+        This is more liberal for pipeline, but not sure if this
+        should be in final version
 
-                        if ( !( Sequence[where] == 'A' ||
-                                Sequence[where] == 'C' ||
-                                Sequence[where] == 'G' ||
-                                Sequence[where] == 'T' ) ) {
-                            doCriticalErrorAndQuit(
-                              "Unknown character in sequence! (%c) seqlen: %d, "
-                              "trange: %d, MaxTupleSize_SN: %d, where: %d, rc: "
-                              "%d, sequence: %s\n",
-                              Sequence[where], Length, TRANGE, MaxTupleSize_SN,
-                              where, rc, Sequence );
-                        }
-
-                        if ( offset <= 14 )
-                            seedcode = seedcode * 4 + Index[Sequence[where]];
-                        else if ( offset <= 29 )
-                            seedcode2 = seedcode2 * 4 + Index[Sequence[where]];
-                        else
-                            doCriticalErrorAndQuit(
-                              "Seed too large! Aborting!" );
-                    }
-                }
-            }
+        TURNS OUT THIS IS NOT NEEDED, because palindromes would be
+        find on reverse seeds too, very unlikely for this to not be
+        found, even impossible for true palindromes
 
-            /* create an entry for seed hit, use -location to indicated reverse
-             * complemented hit, distinction between shifted and unshifted is
-             * not needed */
-            if ( pSS->num_ones <= 13 && TRANGE <= MAX_ARRAY_TRANGE &&
-                 TRANGE >= 1 ) {
-
-                if ( NULL !=
-                     ( iatemp = Array_Tuples_Index[TRANGE][seedcode] ) ) {
-
-                    for ( uj = 0; uj < iatemp->size; uj++ ) {
-
-                        temp_hit = (SEED_HIT *) ( iatemp->array[uj] );
-
-                        // fprintf(stderr,"\n\tGOT HERE!, TRANGE: %d,
-                        // temp_hit->pmin: %u",TRANGE,temp_hit->pmin);
-
-                        if ( !start_hit &&
-                             temp_hit->pmin >=
-                               ( pmin -
-                                 (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
-                                         TRUNC_ROUND_CEIL ) ) ) {
-                            start_hit = temp_hit;
-                        }
-
-                        if ( !end_hit &&
-                             temp_hit->pmin >
-                               ( pmin +
-                                 (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
-                                         TRUNC_ROUND_CEIL ) ) ) {
-                            end_hit = temp_hit;
-                        }
-
-                        if ( start_hit && end_hit ) {
-                            break;
-                        }
-                    }
+        if (!flanksPasses) {
 
-                    //                    if (!start_hit) { start_hit = &
-                    //                    Array_Tuples[TRANGE][seedcode][ 0 ]; }
-                    if ( !end_hit ) {
-                        end_hit =
-                          &Array_Tuples[TRANGE][seedcode]
-                                       [Array_Tuples_Length[TRANGE][seedcode] -
-                                         1];
-                    }
+                if (0 == newdir) {
+                        ref_ptr = prof1rcROT;
+                } else {
+                        ref_ptr = prof1ROT;
+                }
 
-                    // fprintf(stderr,"\nGOT HERE!!, start_hit: %llu, end_hit:
-                    // %llu",start_hit,end_hit); exit(1);
+                newdir=!newdir;
 
-                    if ( start_hit && end_hit && start_hit <= end_hit ) {
+                // reflen is almost always 60, readlen is <=50. If
+        reflen is from ends of chromosome it could be shorter.Thats
+        why readlen will be shortened to reflen
 
-                        for ( ;; start_hit++ ) {
-                            EasyArrayInsert( candidates, (void *) start_hit );
+                lerr =
+        Edit_Distance_multiple_word_NoEndPenaltySeq1(ref_ptr->left,read_ptr->left,
+        ref_ptr->leftlen,(ref_ptr->leftlen>read_ptr->leftlen)?read_ptr->leftlen:ref_ptr->leftlen);
+                rerr =
+        Edit_Distance_multiple_word_NoEndPenaltySeq1(ref_ptr->right,read_ptr->right,
+        ref_ptr->rightlen,(ref_ptr->rightlen>read_ptr->rightlen)?read_ptr->rightlen:ref_ptr->rightlen);
 
-                            if ( start_hit == end_hit )
-                                break;
-                        }
-                    }
+                //fprintf(stderr,"\nlerr: %d, rerr:
+        %d\n\n",lerr,rerr);
+
+                if (lerr==-1 || rerr==-1)
+                {
+                     doCriticalErrorAndQuit("Edit_Distance_multiple_word_NoEndPenaltySeq1
+        returned -1. Aborting!");
                 }
 
-            } else if ( pSS->num_ones <= MAX_N_ONES &&
-                        TRANGE > MAX_ARRAY_TRANGE &&
-                        TRANGE <= MAX_LIST_TRANGE ) {
-
-                if ( NULL !=
-                     ( gdhit = (GDHITEM *) GetDoubleHash(
-                         Hash_Tuples[TRANGE], seedcode, seedcode2 ) ) ) {
-
-                    iatemp = (EASY_ARRAY *) gdhit->index;
-                    shtemp = (SEED_HIT *) gdhit->data;
-                    length = gdhit->length;
-
-                    for ( uj = 0; uj < iatemp->size; uj++ ) {
-
-                        temp_hit = (SEED_HIT *) iatemp->array[uj];
-
-                        // temp_hit = (SEED_HIT*)EasyArrayItem(iatemp,uj);
-                        if ( !start_hit &&
-                             temp_hit->pmin >=
-                               ( pmin -
-                                 (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
-                                         TRUNC_ROUND_CEIL ) ) ) {
-                            start_hit = temp_hit;
-                        }
-
-                        if ( !end_hit &&
-                             temp_hit->pmin >
-                               ( pmin +
-                                 (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
-                                         TRUNC_ROUND_CEIL ) ) ) {
-                            end_hit = temp_hit;
-                        }
-
-                        if ( start_hit && end_hit ) {
-                            break;
-                        }
-                    }
 
-                    if ( !end_hit ) {
-                        end_hit = &shtemp[length - 1];
-                    }
+                flanksPasses = (max(lerr,rerr) <= MAXERRORS);
+        }
+        */
 
-                    //         start_hit = & shtemp[ 0 ];
-                    //         end_hit = & shtemp[ length - 1 ];
+        /* DEBUG
+        if (refprof->key == 175388148 || refprof->key == -175388148
+        || refprof->key == 176296442 || refprof->key == -176296442)
+        { if (readprof->key == 175388148 || readprof->key ==
+        -175388148 || readprof->key == 176296442 || readprof->key ==
+        -176296442) { printf("\nDEBUG %d%s vs %d%s,\tprofscore =
+        %.2lf lerr=%d, rerr=%d\n",refprof->key, refprof->rcflag ?
+        "RC" : "", readprof->key,readprof->rcflag ? "RC" :
+        "",bestsim,lerr,rerr);
+        }}
+        */
 
-                    if ( start_hit && end_hit && start_hit <= end_hit ) {
-                        for ( ;; start_hit++ ) {
-                            // printf("\nstart_hit: %llu end_hit: %llu length:
-                            // %d",start_hit,end_hit,length);
-                            EasyArrayInsert( candidates, (void *) start_hit );
+        /* all green */
+        if ( flanksPasses ) {
 
-                            if ( start_hit == end_hit )
-                                break;
-                        }
-                    }
-                }
+            SCAN_LINK *link;
 
-                // EasyArrayInsert(  artemp , (void*) sh);
+            if ( w->nlinks >= w->maxlinks ) {
+                w->maxlinks = ( w->maxlinks ) ? 2 * w->maxlinks : 64;
+                w->links =
+                  realloc( w->links, w->maxlinks * sizeof( SCAN_LINK ) );
 
-            } else {
-                doCriticalErrorAndQuit( "Seed with more than %d 1s or TRANGE "
-                                        "higher than 7, not yet implemented!",
-                  MAX_N_ONES );
+                if ( NULL == w->links )
+                    doCriticalErrorAndQuit(
+                      "Unable to grow link buffer. Aborting!" );
             }
 
-            // tuplesprocessed++;
+            link          = &w->links[w->nlinks++];
+            link->refkey  = check->refkey;
+            link->readkey = check->readkey;
+            link->newdir  = check->newdir;
+            link->bestsim = check->bestsim;
+            link->lerr    = lerr;
+            link->rerr    = rerr;
+
+            w->stats.stPairsConfirmedAfterFlankAlignments++;
         }
     }
 
-    return 0;
+    w->nchecks = 0;
 }
 
 /************************************************************************************************************************/
 int _HCLUST_align_candidates( PROFILE *readprof, int rc, int pmin,
-  EASY_ARRAY *candidates, unsigned char *dt1, CLUSTERBASE *cb ) {
-
-    PROFPAIR *   refpair;
-    SEED_HIT *   pshit;
-    PAP *        pap1;
-    EASY_NODE *  nof1;
-    PROFILE *    refprof;
-    double       bestsim, sizeerror;
-    int          oldkey;
-    int          concensusLCS, shortest, minlen;
-    char         olddir;
-    unsigned int uj;
-    unsigned int written = 0;
-
-    // go through all candidates
+  EASY_ARRAY *candidates, unsigned char *dt1, SCAN_WORKER *w ) {
+
+    REFINDEX_HIT *pshit;
+    PAP           pap1;
+    int           papret;
+    PROFILE *     refprof;
+    double        bestsim, sizeerror;
+    int           nbatch, nkeep, uk;
+    unsigned int  uj;
+
+    // room for every candidate in the batch buffers
+    if ( candidates->size > w->maxbatch ) {
+        w->maxbatch  = 2 * candidates->size;
+        w->batchhits = realloc( w->batchhits, w->maxbatch * sizeof( void * ) );
+        w->batchseqs = realloc( w->batchseqs, w->maxbatch * sizeof( char * ) );
+        w->batchlens = realloc( w->batchlens, w->maxbatch * sizeof( int ) );
+        w->batchkeep = realloc( w->batchkeep, w->maxbatch * sizeof( int ) );
+
+        if ( NULL == w->batchhits || NULL == w->batchseqs ||
+             NULL == w->batchlens || NULL == w->batchkeep )
+            doCriticalErrorAndQuit( "Unable to grow candidate batch. Aborting!" );
+    }
+
+    // go through all candidates, collect distinct refs
     refprof = NULL;
+    nbatch  = 0;
 
     for ( uj = 0; uj < candidates->size; uj++ ) {
 
-        pshit = (SEED_HIT *) candidates->array[uj];
+        pshit = (REFINDEX_HIT *) candidates->array[uj];
 
-        blaststats.stCandidatesConsidered++;
+        w->stats.stCandidatesConsidered++;
 
         // skip same ref same dir, sorted
-        if ( pshit->prof == refprof ) {
+        if ( RefIndex->profiles[pshit->prof] == refprof ) {
             continue;
         }
 
-        refprof = pshit->prof;
+        refprof              = RefIndex->profiles[pshit->prof];
+        w->batchhits[nbatch] = pshit;
+        w->batchseqs[nbatch] = refprof->seq->sequence;
+        w->batchlens[nbatch] = refprof->seq->length;
+        w->batchkeep[nbatch] = nbatch;
+        nbatch++;
+    }
+
+    nkeep = nbatch;
 
-        // use lcs on concensus sequences firest
+    // use lcs on concensus sequences firest, read match vectors are built once
 #ifdef CONCENSUS_LCS_CHECK
 
-        blaststats.stLCSalignments++;
+    w->stats.stLCSalignments += nbatch;
 
-        concensusLCS =
-          LCS_multiple_word( refprof->seq->sequence, readprof->seq->sequence,
-            refprof->seq->length, readprof->seq->length );
+    LCS_batch_prepare(
+      &w->lcs, readprof->seq->sequence, readprof->seq->length );
+    nkeep = LCS_batch_filter( &w->lcs, w->batchseqs, w->batchlens, nbatch,
+      LCS_CUTOFF, w->batchkeep );
 
-        shortest = min( readprof->seq->length, refprof->seq->length );
-        minlen =
-          (int) ( shortest * LCS_CUTOFF + .5 ); // + .5 in there would round and
-                                                // would filter more stuff out
-        minlen = min( minlen, ( shortest - 1 ) );
+#endif
 
-        if ( concensusLCS < minlen ) {
-            continue;
-        }
+    for ( uk = 0; uk < nkeep; uk++ ) {
 
-#endif
+        pshit   = w->batchhits[w->batchkeep[uk]];
+        refprof = RefIndex->profiles[pshit->prof];
 
         // align profiles
         if ( min( refprof->patlen, readprof->patlen ) >= 30 ) {
@@ -560,23 +585,28 @@ int _HCLUST_align_candidates( PROFILE *readprof, int rc, int pmin,
             // narrowband sometimes returns error when patterns are too
             // different (100% diff) in size so use regular
             if ( sizeerror > 100.0 ) {
-                pap1 = GetFixedProfileAP( refprof, readprof, dt1 );
+                papret = GetFixedProfileScore(
+                  w->pac, refprof, readprof, dt1, &pap1 );
             } else {
-                pap1 = GetFixedProfileAPNarrowband(
-                  refprof, readprof, dt1, TARGET_HOMOLOGY_INT );
+                papret = GetFixedProfileScoreNarrowband( w->pac, refprof,
+                  readprof, dt1, TARGET_HOMOLOGY_INT, &pap1 );
             }
 
-            bestsim = pap1->similarity;
-            FreePAP( pap1 );
-
         } else {
 
-            pap1    = GetFixedProfileAP( refprof, readprof, dt1 );
-            bestsim = pap1->similarity;
-            FreePAP( pap1 );
+            papret =
+              GetFixedProfileScore( w->pac, refprof, readprof, dt1, &pap1 );
         }
 
-        blaststats.stProfileAlignments++;
+        if ( papret < 0 )
+            doCriticalErrorAndQuit( "Unable to allocate profile alignment "
+                                    "rows or bad profile (%d-vs-%d)!\n",
+              refprof->proflen, readprof->proflen );
+
+        // only the score is used, so the traceback matrix is never built
+        bestsim = pap1.similarity;
+
+        w->stats.stProfileAlignments++;
 
         /* DEBUG
         if (refprof->key == 175388148 || refprof->key == -175388148 ||
@@ -592,13 +622,12 @@ int _HCLUST_align_candidates( PROFILE *readprof, int rc, int pmin,
         // add to final result
         if ( bestsim >= TARGET_HOMOLOGY ) {
 
-            EASY_NODE *nrotf1, *nrotf2;
-            PROFILE *  prof1ROT, *prof1rcROT, *prof2ROT, *prof2rcROT;
-            PROFPAIR * profpair1, *profpair2;
-            int        flanksPasses, lerr, rerr;
-            PROFILE *  read_ptr, *ref_ptr;
+            EASY_NODE *  nrotf1, *nrotf2;
+            PROFILE *    prof1ROT, *prof1rcROT, *prof2ROT, *prof2rcROT;
+            PROFPAIR *   profpair1, *profpair2;
+            FLANK_CHECK *check;
 
-            blaststats.stProfileAlignmentsSuccess++;
+            w->stats.stProfileAlignmentsSuccess++;
 
             /* cyclic rotations, check all flanks, 1.87 change */
             for ( nrotf1 = refprof->rotlist->head; nrotf1 != NULL;
@@ -642,210 +671,24 @@ int _HCLUST_align_candidates( PROFILE *readprof, int rc, int pmin,
                     if ( profpair2->prof->dir )
                         newdir = !newdir;
 
-                    read_ptr = prof2ROT;
-
-                    if ( 0 == newdir ) {
-                        ref_ptr = prof1ROT;
-                    } else {
-                        ref_ptr = prof1rcROT;
-                    }
+                    // flanks are aligned once the candidate list is done
+                    if ( w->nchecks >= w->maxchecks ) {
+                        w->maxchecks = ( w->maxchecks ) ? 2 * w->maxchecks : 64;
+                        w->checks    = realloc(
+                          w->checks, w->maxchecks * sizeof( FLANK_CHECK ) );
 
-                    // printf("\nAligning flanks ");
-
-                    /* refs vs reads */
-                    if ( OPTION != 'R' ) {
-
-                        int MAXEL1, MAXER1, LARGESERRORALLOWED;
-
-                        if ( 0 != MAXERRORS ) {
-                            MAXEL1 = MAXERRORS;
-                            MAXER1 = MAXERRORS;
-                        } else {
-                            MAXEL1 =
-                              min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
-                            MAXER1 = min(
-                              8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
-                        }
-
-                        /* reflen is almost always 60, readlen is <=50. If
-                         * reflen is from ends of chromosome it could be
-                         * shorter.Thats why readlen will be shortened to reflen
-                         */
-                        lerr = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->left, read_ptr->left, ref_ptr->leftlen,
-                          ( ref_ptr->leftlen > read_ptr->leftlen )
-                            ? read_ptr->leftlen
-                            : ref_ptr->leftlen );
-                        rerr = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->right, read_ptr->right, ref_ptr->rightlen,
-                          ( ref_ptr->rightlen > read_ptr->rightlen )
-                            ? read_ptr->rightlen
-                            : ref_ptr->rightlen );
-
-                        // fprintf(stderr,"\nref: %d read: %d (lflank: %d,
-                        // rflank: %d) ===> lerr: %d (MAXEL1=%d), rerr: %d
-                        // (MAXER1:
-                        // %d)\n\n",ref_ptr->key,read_ptr->key,read_ptr->leftlen,read_ptr->rightlen,lerr,MAXEL1,rerr,MAXER1);
-
-                        if ( lerr == -1 || rerr == -1 ) {
+                        if ( NULL == w->checks )
                             doCriticalErrorAndQuit(
-                              "Edit_Distance_multiple_word_NoEndPenaltySeq1 "
-                              "returned -1. Aborting!" );
-                        }
-
-                        // flanksPasses = (max(lerr,rerr) <= MAXERRORS);
-                        flanksPasses = ( lerr <= MAXEL1 && rerr <= MAXER1 );
-
-                        /* refs vs refs */
-                    } else {
-
-                        int MAXEL1, MAXER1;
-
-                        /* Dec 5, 2014: Yozen asked to  make ref-ref scoring
-                         * just like regular pipeline runs */
-                        MAXEL1 =
-                          min( 8, (int) ( 0.4 * read_ptr->leftlen + .01 ) );
-                        MAXER1 =
-                          min( 8, (int) ( 0.4 * read_ptr->rightlen + .01 ) );
-
-                        lerr = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->left, read_ptr->left, ref_ptr->leftlen,
-                          read_ptr->leftlen );
-                        rerr = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                          ref_ptr->right, read_ptr->right, ref_ptr->rightlen,
-                          read_ptr->rightlen );
-
-                        if ( lerr == -1 || rerr == -1 ) {
-                            doCriticalErrorAndQuit(
-                              "Edit_Distance_multiple_word_NoEndPenaltySeq1 "
-                              "returned -1. Aborting!" );
-                        }
-
-                        // flanksPasses = (min(lerr,rerr) <= MAXERRORS);
-                        // TESTING BOTH FLANKS FOR PARAMTER SELECTION
-                        flanksPasses = ( lerr <= MAXEL1 && rerr <= MAXER1 );
-
-                        /* there is a possibility that reversing these might
-                         * have different result, lets try it, 1.90 testing for
-                         * mapping */
-                        if ( !flanksPasses ) {
-
-                            lerr = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                              read_ptr->left, ref_ptr->left, read_ptr->leftlen,
-                              ref_ptr->leftlen );
-                            rerr = Edit_Distance_multiple_word_NoEndPenaltySeq1(
-                              read_ptr->right, ref_ptr->right,
-                              read_ptr->rightlen, ref_ptr->rightlen );
-
-                            if ( lerr == -1 || rerr == -1 ) {
-                                doCriticalErrorAndQuit(
-                                  "Edit_Distance_multiple_word_"
-                                  "NoEndPenaltySeq1 returned -1. Aborting!" );
-                            }
-
-                            // flanksPasses = (min(lerr,rerr) <= MAXERRORS);
-                            // TESTING BOTH FLANKS FOR PARAMTER SELECTION
-                            flanksPasses = ( lerr <= MAXEL1 && rerr <= MAXER1 );
-                        }
-
-                    } // end of R option
-
-                    /* if flanks failed, try the other way (for palindromes).
-                    This is more liberal for pipeline, but not sure if this
-                    should be in final version
-
-                    TURNS OUT THIS IS NOT NEEDED, because palindromes would be
-                    find on reverse seeds too, very unlikely for this to not be
-                    found, even impossible for true palindromes
-
-                    if (!flanksPasses) {
-
-                            if (0 == newdir) {
-                                    ref_ptr = prof1rcROT;
-                            } else {
-                                    ref_ptr = prof1ROT;
-                            }
-
-                            newdir=!newdir;
-
-                            // reflen is almost always 60, readlen is <=50. If
-                    reflen is from ends of chromosome it could be shorter.Thats
-                    why readlen will be shortened to reflen
-
-                            lerr =
-                    Edit_Distance_multiple_word_NoEndPenaltySeq1(ref_ptr->left,read_ptr->left,
-                    ref_ptr->leftlen,(ref_ptr->leftlen>read_ptr->leftlen)?read_ptr->leftlen:ref_ptr->leftlen);
-                            rerr =
-                    Edit_Distance_multiple_word_NoEndPenaltySeq1(ref_ptr->right,read_ptr->right,
-                    ref_ptr->rightlen,(ref_ptr->rightlen>read_ptr->rightlen)?read_ptr->rightlen:ref_ptr->rightlen);
-
-                            //fprintf(stderr,"\nlerr: %d, rerr:
-                    %d\n\n",lerr,rerr);
-
-                            if (lerr==-1 || rerr==-1)
-                            {
-                                 doCriticalErrorAndQuit("Edit_Distance_multiple_word_NoEndPenaltySeq1
-                    returned -1. Aborting!");
-                            }
-
-
-                            flanksPasses = (max(lerr,rerr) <= MAXERRORS);
-                    }
-                    */
-
-                    /* DEBUG
-                    if (refprof->key == 175388148 || refprof->key == -175388148
-                    || refprof->key == 176296442 || refprof->key == -176296442)
-                    { if (readprof->key == 175388148 || readprof->key ==
-                    -175388148 || readprof->key == 176296442 || readprof->key ==
-                    -176296442) { printf("\nDEBUG %d%s vs %d%s,\tprofscore =
-                    %.2lf lerr=%d, rerr=%d\n",refprof->key, refprof->rcflag ?
-                    "RC" : "", readprof->key,readprof->rcflag ? "RC" :
-                    "",bestsim,lerr,rerr);
-                    }}
-                    */
-
-                    /* all green */
-                    if ( flanksPasses ) {
-
-                        // printf("\nAdding link!");
-
-                        ClusterBaseAddLink(
-                          cb, prof1ROT->key, prof2ROT->key, newdir );
-                        blaststats.stPairsConfirmedAfterFlankAlignments++;
-
-                        //  write to map file (new after  pscearch1.9)
-                        if ( MAPFILE ) {
-                            fprintf( MAPFILE, "%d%c=>%d:%.2lf:%d:%d\n",
-                              prof1ROT->key, ( 0 == newdir ) ? '\'' : '\"',
-                              prof2ROT->key, bestsim, lerr, rerr );
-                        }
-
-                        /* mark connections for ref-to-ref */
-                        if ( OPTION == 'R' ) {
-
-                            CLUSTERKEY *pk1, *pk2;
-
-                            pk1 = cl_findkey( cb, prof1ROT->key );
-                            pk2 = cl_findkey( cb, prof2ROT->key );
-
-                            /*  exclude itself */
-                            if ( abs( prof1ROT->key ) ==
-                                 abs( prof2ROT->key ) ) {
-
-                            } else {
-                                if ( lerr <= MAXERRORS ) {
-                                    pk1->leftcon = 1;
-                                    pk2->leftcon = 1;
-                                }
-
-                                if ( rerr <= MAXERRORS ) {
-                                    pk1->rightcon = 1;
-                                    pk2->rightcon = 1;
-                                }
-                            }
-                        }
+                              "Unable to grow flank checks. Aborting!" );
                     }
+
+                    check          = &w->checks[w->nchecks++];
+                    check->read    = prof2ROT;
+                    check->ref     = ( 0 == newdir ) ? prof1ROT : prof1rcROT;
+                    check->refkey  = prof1ROT->key;
+                    check->readkey = prof2ROT->key;
+                    check->newdir  = newdir;
+                    check->bestsim = bestsim;
                 }
             } // end of cyclic rotation
 
@@ -853,27 +696,44 @@ int _HCLUST_align_candidates( PROFILE *readprof, int rc, int pmin,
 
     } // end of going though candidate list
 
+    _HCLUST_check_flanks( w );
+
     return 0;
 }
 
 /************************************************************************************************************************/
-char *seqdupPlusTuple( int length, char *in, int tsize ) {
+/* replays links collected by the scanning threads, in read order, so the
+ * clusters and the map file come out as with a single thread */
+void _HCLUST_commit_links( CLUSTERBASE *cb, SCAN_LINK *links, size_t nlinks ) {
 
-    char *res;
+    SCAN_LINK *link;
+    size_t     ui;
 
-    int start, stop, i;
+    for ( ui = 0; ui < nlinks; ui++ ) {
 
-    if ( tsize > length )
-        doCriticalErrorAndQuit(
-          "Tuple size (%d) is larger than sequence(%d). Aborting!", tsize,
-          length );
+        link = &links[ui];
 
-    res = smalloc( ( ( length + tsize + 2 ) * sizeof( char ) ) );
-    strcpy( res, in );
-    memcpy( res + length, in, tsize );
-    res[length + tsize] = 0;
+        ClusterBaseAddLink( cb, link->refkey, link->readkey, link->newdir );
 
-    return res;
+        //  write to map file (new after  pscearch1.9)
+        if ( MAPFILE ) {
+            fprintf( MAPFILE, "%d%c=>%d:%.2lf:%d:%d\n", link->refkey,
+              ( 0 == link->newdir ) ? '\'' : '\"', link->readkey,
+              link->bestsim, link->lerr, link->rerr );
+        }
+
+        /* mark connections for ref-to-ref */
+        if ( OPTION == 'R' ) {
+
+            /*  exclude itself */
+            if ( abs( link->refkey ) != abs( link->readkey ) ) {
+                ClusterBaseSetConnected( cb, link->refkey,
+                  link->lerr <= MAXERRORS, link->rerr <= MAXERRORS );
+                ClusterBaseSetConnected( cb, link->readkey,
+                  link->lerr <= MAXERRORS, link->rerr <= MAXERRORS );
+            }
+        }
+    }
 }
 
 /************************************************************************************************************************/
@@ -931,148 +791,6 @@ void init_index( void )
     Index['T'] = 3;
 }
 
-/************************************************************************************************************************/
-void init_complement_ascii( void )
-
-{
-    /* complement has 256 entries so that finding the entries for A, C, G and T
-     * which are complement ascii values */
-    /* require no calculation */
-    int i;
-    Complementascii = (char *) scalloc( 256, sizeof( long int ) );
-
-    // memory_stats_print("\n init_complement_ascii: requesting", 256 *
-    // sizeof(long int) );
-    if ( Complementascii == NULL ) {
-        doCriticalErrorAndQuit( "\ninit_complement_ascii: Out of memory!" );
-        exit( 0 );
-    }
-
-    for ( i = 0; i < 256; i++ )
-        Complementascii[i] = i;
-
-    /* */
-    {
-        Complementascii['A'] = 'T';
-        Complementascii['C'] = 'G';
-        Complementascii['G'] = 'C';
-        Complementascii['T'] = 'A';
-        Complementascii['a'] = 't';
-        Complementascii['c'] = 'g';
-        Complementascii['g'] = 'c';
-        Complementascii['t'] = 'a';
-    }
-}
-
-/************************************************************************************************************************/
-char *GetReverseComplement( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    if ( NULL == original )
-        return NULL;
-
-    /* safety check */
-    if ( Complementascii == NULL ) {
-        init_complement_ascii();
-    }
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-
-    if ( buffer == NULL ) {
-        return NULL;
-    }
-
-    /* reverse complement pattern */
-    sourceptr  = original;
-    destinptr  = buffer + length; /* position at termination */
-    *destinptr = '\0';            /* terminate string */
-    destinptr--;
-
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = Complementascii[( *sourceptr )];
-        destinptr--;
-        sourceptr++;
-    }
-
-    /* return buffer containg reverse complement */
-    return buffer;
-}
-
-/***********************************************************************/
-char *GetComplement( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* safety check */
-    if ( Complementascii == NULL ) {
-        init_complement_ascii();
-    }
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-
-    if ( buffer == NULL ) {
-        return NULL;
-    }
-
-    /* complement pattern */
-    sourceptr = original;
-    destinptr = buffer;
-
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = Complementascii[( *sourceptr )];
-        destinptr++;
-        sourceptr++;
-    }
-
-    *destinptr = '\0'; /* terminate string */
-
-    /* return buffer containg reverse complement */
-    return buffer;
-}
-
-/************************************************************************************************************************/
-char *GetReverse( char *original ) {
-    char *sourceptr, *destinptr;
-    int   length;
-    char *buffer;
-
-    /* find out how long the string is */
-    length = strlen( original );
-
-    /* allocate the new string */
-    buffer = (char *) malloc( sizeof( char ) * ( length + 1 ) );
-
-    if ( buffer == NULL ) {
-        return NULL;
-    }
-
-    /* reverse pattern */
-    sourceptr  = original;
-    destinptr  = buffer + length; /* position at termination */
-    *destinptr = '\0';            /* terminate string */
-    destinptr--;
-
-    while ( *sourceptr != '\0' ) {
-        ( *destinptr ) = *sourceptr;
-        destinptr--;
-        sourceptr++;
-    }
-
-    /* return buffer containg reverse complement */
-    return buffer;
-}
-
 /************************************************************************************************************************/
 void retrieve_seed_info( char *seed, SEED_STRUCT *pSS ) {
     int i, j, k, num, length, hasX, offset, value, shift;
@@ -1168,6 +886,42 @@ void retrieve_seed_info( char *seed, SEED_STRUCT *pSS ) {
             j--;
         }
     }
+
+    // masks and runs of the unshifted seed in a rolling window of 64 bases,
+    // the newest base in the lowest bits, the first one in the highest bits
+    // of the code
+    if ( length > 64 ) {
+        doCriticalErrorAndQuit( "\n\nSorry, seed length cannot exceed 64." );
+        exit( 0 );
+    }
+
+    pSS->mask[0] = pSS->mask[1] = 0;
+    pSS->nlow = pSS->nruns = 0;
+
+    for ( i = 0; i < num; i++ ) {
+        offset = -pSS->foffset[0][i]; // bases back from the newest
+        k      = offset / 32;
+        shift  = 2 * ( offset % 32 );
+        pSS->mask[k] |= 3ULL << shift;
+
+        if ( 0 == k )
+            pSS->nlow++;
+
+        // extend the run if the previous one is right above in the same word
+        if ( pSS->nruns > 0 && pSS->runs[pSS->nruns - 1].word == k &&
+             pSS->runs[pSS->nruns - 1].shift == shift + 2 ) {
+            pSS->runs[pSS->nruns - 1].mask =
+              ( pSS->runs[pSS->nruns - 1].mask << 2 ) | 3;
+            pSS->runs[pSS->nruns - 1].shift    = shift;
+            pSS->runs[pSS->nruns - 1].outshift = 2 * ( num - 1 - i );
+        } else {
+            pSS->runs[pSS->nruns].mask     = 3;
+            pSS->runs[pSS->nruns].word     = k;
+            pSS->runs[pSS->nruns].shift    = shift;
+            pSS->runs[pSS->nruns].outshift = 2 * ( num - 1 - i );
+            pSS->nruns++;
+        }
+    }
 }
 
 /************************************************************************************************************************/
@@ -0,0 +1,702 @@
+/****************************************************************
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ ****************************************************************/
+
+/***************************************************************
+    leb36.h : Memory mapped loader for LEB36 profile files.
+
+              The file is mapped read-only and split at line
+              starts (one record per line, as written by
+              WriteProfileWithRC) into one chunk per thread.
+              Each chunk is parsed with the same rules as
+              ReadProfileWithRC and its profiles, concensus
+              sequences and flanks are placed in an arena
+              owned by the loaded set, so they are released
+              together by Leb36Free and never one by one.
+
+              Offsets are size_t, files past 2GB load the
+              same way.
+
+              Loading stops at the first record that
+              ReadProfileWithRC would stop at, with the same
+              message.
+
+              Binary profile files (profbin.h) are recognized
+              by their header and split by records instead.
+              Indices and concensus sequences are used from
+              the mapping, which stays open until Leb36Free,
+              only the flanks are copied into psearch's form.
+****************************************************************/
+
+#ifndef LEB36_H
+#define LEB36_H
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../libs/easylife/easylife.h"
+#include "../libs/profbin/profbin.h"
+#include "profile.h"
+
+/* INTERFACE */
+
+typedef struct tagLEB36_BLOCK LEB36_BLOCK;
+
+typedef struct {
+    PROFILE **    profiles; // profile, reverse complement, ... in file order
+    size_t        nprofiles;
+    LEB36_BLOCK * arena;  // blocks of all chunks
+    PROFBIN_FILE *binary; // mapping of a binary file, NULL for text
+} LEB36_FILE;
+
+// Loads all profile pairs of a text or binary file on nthreads threads,
+// isread as in ReadProfileWithRC. Returns NULL if the file cannot be
+// mapped or is a binary file of another version.
+LEB36_FILE *Leb36Load( FILE *fp, int isread, int nthreads );
+void        Leb36Free( LEB36_FILE *lf );
+
+/* IMPLEMENTATION */
+
+#define LEB36_BLOCKSIZE ( 1 << 20 )
+
+struct tagLEB36_BLOCK {
+    LEB36_BLOCK *next;
+    size_t       used, size;
+    double       data[]; // aligned for any member of a profile
+};
+
+/* why a chunk stopped early, errors are numbered as the "load error!!!"
+   messages of ReadProfileWithRC */
+enum {
+    LEB36_DONE     = 0,
+    LEB36_STOP     = 1, // unreadable header or no reverse complement
+    LEB36_NOFLANKS = 2,
+    LEB36_ERROR4   = 4, // profile
+    LEB36_ERROR5   = 5, // reverse complement profile
+    LEB36_ERROR6   = 6  // counts
+};
+
+typedef struct {
+    const char *        start, *end; // records of the chunk
+    const char *        base;        // start of the mapping, for offsets
+    const PROFBIN_FILE *pf;          // binary file, records first to last
+    uint64_t            first, last;
+    int                 isread;
+    LEB36_BLOCK *       arena;
+    PROFILE **          profiles;
+    size_t              nprofiles, maxprofiles;
+    int                 status;
+    pthread_t           thread;
+} LEB36_CHUNK;
+
+/* flank characters as ReadProfileWithRC leaves them (upper case ACGT, N
+   otherwise) and their complements */
+static char Leb36FlankChar[256], Leb36FlankComplement[256];
+
+/***************************************************************/
+static void *leb36_alloc( LEB36_BLOCK **arena, size_t size ) {
+    LEB36_BLOCK *block = *arena;
+    void *       ptr;
+
+    size = ( size + sizeof( double ) - 1 ) & ~( sizeof( double ) - 1 );
+
+    if ( NULL == block || block->used + size > block->size ) {
+        block = (LEB36_BLOCK *) malloc(
+          sizeof( LEB36_BLOCK ) + max( size, LEB36_BLOCKSIZE ) );
+
+        if ( NULL == block )
+            doCriticalErrorAndQuit( "Unable to allocate profile arena!" );
+
+        block->next = *arena;
+        block->used = 0;
+        block->size = max( size, LEB36_BLOCKSIZE );
+        *arena      = block;
+    }
+
+    ptr = (char *) block->data + block->used;
+    block->used += size;
+
+    return ptr;
+}
+
+/***************************************************************/
+#define LEB36_ISSPACE( c )                                                 \
+    ( ' ' == ( c ) || '\n' == ( c ) || '\t' == ( c ) || '\r' == ( c ) || \
+      '\v' == ( c ) || '\f' == ( c ) )
+
+/* next whitespace delimited token, empty at the end of the chunk */
+static const char *leb36_token( const char **p, const char *end, size_t *len ) {
+    const char *s = *p, *token;
+
+    while ( s < end && LEB36_ISSPACE( *s ) )
+        s++;
+
+    token = s;
+
+    while ( s < end && !LEB36_ISSPACE( *s ) )
+        s++;
+
+    *len = s - token;
+    return token;
+}
+
+/* %d and %f of fscanf: converts the longest prefix of the next token */
+static int leb36_number( const char **p, const char *end, int isfloat,
+  int *ivalue, float *fvalue ) {
+    char        buffer[64], *stop;
+    const char *token;
+    size_t      len;
+
+    token = leb36_token( p, end, &len );
+
+    if ( 0 == len )
+        return 0;
+
+    len = min( len, sizeof( buffer ) - 1 );
+    memcpy( buffer, token, len );
+    buffer[len] = '\0';
+
+    if ( isfloat )
+        *fvalue = strtof( buffer, &stop );
+    else
+        *ivalue = (int) strtol( buffer, &stop, 10 );
+
+    if ( stop == buffer )
+        return 0;
+
+    *p = token + ( stop - buffer );
+    return 1;
+}
+
+/* %2s of fscanf followed by LEB36ToInt */
+static int leb36_digits( const char **p, const char *end, int *value ) {
+    const char *token;
+    char        digits[3];
+    size_t      len;
+
+    token = leb36_token( p, end, &len );
+
+    if ( 0 == len )
+        return 0;
+
+    len = min( len, 2 );
+    memcpy( digits, token, len );
+    digits[len] = '\0';
+    *p          = token + len;
+
+    LEB36ToInt( digits, value );
+    return 1;
+}
+
+/* same as getConcensusFromProfile, into the arena */
+static void leb36_concensus(
+  LEB36_BLOCK **arena, PROFILE *prof, FASTASEQUENCE *pseq ) {
+    int   i, j, sel, max, counts[5];
+    char *str;
+
+    str = (char *) leb36_alloc( arena, prof->proflen + 1 );
+
+    for ( pseq->length = 0, i = 0; i < prof->proflen; i++ ) {
+        GetCompositionCounts( prof->indices[i], counts );
+        sel = 0;
+        max = 0;
+
+        for ( j = 0; j < 5; j++ ) {
+            if ( counts[j] > max ) {
+                max = counts[j];
+                sel = j;
+            }
+        }
+
+        if ( sel != 4 )
+            str[pseq->length++] = _conc_map[sel];
+    }
+
+    str[pseq->length] = '\0';
+    pseq->sequence    = str;
+    pseq->id          = prof->key;
+    prof->seq         = pseq;
+}
+
+/* same as ave_entropy_and_counts without the column strings */
+static void leb36_entropy( PROFILE *prof ) {
+    int    i, counts[5];
+    double entropySum = 0.0;
+
+    for ( i = 0; i < prof->proflen; i++ ) {
+        GetCompositionCounts( prof->indices[i], counts );
+        prof->aProf += counts[0];
+        prof->cProf += counts[1];
+        prof->gProf += counts[2];
+        prof->tProf += counts[3];
+        prof->dashProf += counts[4];
+        entropySum = entropySum + entropy_col( counts );
+    }
+
+    prof->AveEntProf = (float) ( entropySum / prof->proflen );
+}
+
+/* copies n flank characters, reversed and/or complemented */
+static char *leb36_flank( LEB36_BLOCK **arena, const char *src, size_t n,
+  int reverse, const char *map ) {
+    char * str;
+    size_t i;
+
+    str = (char *) leb36_alloc( arena, n + 1 );
+
+    for ( i = 0; i < n; i++ )
+        str[i] = map[(unsigned char) src[reverse ? n - 1 - i : i]];
+
+    str[n] = '\0';
+    return str;
+}
+
+/* fix to limit flank length if Ref to REf is used */
+static void leb36_shorten( PROFILE *prof, PROFILE *profrc, int isread ) {
+    if ( OPTION == 'R' ) {
+        prof->leftlen    = min( prof->leftlen, REFLEN );
+        prof->rightlen   = min( prof->rightlen, REFLEN );
+        profrc->leftlen  = min( profrc->leftlen, REFLEN );
+        profrc->rightlen = min( profrc->rightlen, REFLEN );
+
+    } else if ( isread ) {
+
+        // only the read is shortened, see ReadProfileWithRC
+        prof->leftlen    = min( prof->leftlen, MAXFLANKCONSIDERED );
+        prof->rightlen   = min( prof->rightlen, MAXFLANKCONSIDERED );
+        profrc->leftlen  = min( profrc->leftlen, MAXFLANKCONSIDERED );
+        profrc->rightlen = min( profrc->rightlen, MAXFLANKCONSIDERED );
+    }
+}
+
+/***************************************************************
+ *  Parses one record, returns LEB36_DONE and the pair or the
+ *  reason it stopped.
+ ***************************************************************/
+static int leb36_record( LEB36_CHUNK *ck, const char **p, PROFILE **profret,
+  PROFILE **profrcret ) {
+    int            i, key, patlen, proflen, proflenrc, number;
+    float          copynum;
+    PROFILE *      prof, *profrc;
+    FASTASEQUENCE *pseq;
+    const char *   end = ck->end, *flanks, *bar;
+    size_t         len, leftlen, rightlen;
+
+    // read key, pattern length and profile length
+    if ( !leb36_number( p, end, 0, &key, NULL ) ||
+         !leb36_number( p, end, 0, &patlen, NULL ) ||
+         !leb36_number( p, end, 1, NULL, &copynum ) ||
+         !leb36_number( p, end, 0, &proflen, NULL ) ||
+         !leb36_number( p, end, 0, &proflenrc, NULL ) )
+        return LEB36_STOP;
+
+    // ReadProfileWithRC returns no reverse complement, loading stops there
+    if ( proflenrc <= 0 )
+        return LEB36_STOP;
+
+    prof   = (PROFILE *) leb36_alloc( &ck->arena, 2 * sizeof( PROFILE ) );
+    profrc = prof + 1;
+    memset( prof, 0, 2 * sizeof( PROFILE ) );
+
+    prof->indices   = (int *) leb36_alloc( &ck->arena, sizeof( int ) * proflen );
+    profrc->indices =
+      (int *) leb36_alloc( &ck->arena, sizeof( int ) * proflenrc );
+
+    prof->key     = profrc->key     = key;
+    prof->patlen  = profrc->patlen  = patlen;
+    prof->copynum = profrc->copynum = copynum;
+    prof->proflen                   = proflen;
+    profrc->proflen                 = proflenrc;
+    profrc->rcflag                  = 1;
+    prof->rotationmaster = profrc->rotationmaster = 1;
+
+    for ( i = 0; i < proflen; i++ ) {
+        if ( !leb36_digits( p, end, &number ) )
+            return LEB36_ERROR4;
+
+        prof->indices[i] = number;
+    }
+
+    for ( i = 0; i < proflenrc; i++ ) {
+        if ( !leb36_digits( p, end, &number ) )
+            return LEB36_ERROR5;
+
+        profrc->indices[i] = number;
+    }
+
+    // read counts
+    if ( !leb36_number( p, end, 0, &prof->a, NULL ) ||
+         !leb36_number( p, end, 0, &prof->c, NULL ) ||
+         !leb36_number( p, end, 0, &prof->g, NULL ) ||
+         !leb36_number( p, end, 0, &prof->t, NULL ) )
+        return LEB36_ERROR6;
+
+    profrc->a = prof->t;
+    profrc->t = prof->a;
+    profrc->c = prof->g;
+    profrc->g = prof->c;
+
+    // concensus for blast search
+    pseq = (FASTASEQUENCE *) leb36_alloc(
+      &ck->arena, 2 * sizeof( FASTASEQUENCE ) );
+    leb36_concensus( &ck->arena, prof, pseq );
+    leb36_concensus( &ck->arena, profrc, pseq + 1 );
+    leb36_entropy( prof );
+    leb36_entropy( profrc );
+
+    // flanks, left|right
+    flanks = leb36_token( p, end, &len );
+    *p     = flanks + len;
+    bar    = ( len > 0 ) ? memchr( flanks, '|', len ) : NULL;
+
+    if ( NULL == bar )
+        return LEB36_NOFLANKS;
+
+    leftlen  = bar - flanks;
+    rightlen = len - leftlen - 1;
+
+    prof->left = leb36_flank( &ck->arena, flanks, leftlen, 1, Leb36FlankChar );
+    prof->right =
+      leb36_flank( &ck->arena, bar + 1, rightlen, 0, Leb36FlankChar );
+    profrc->left =
+      leb36_flank( &ck->arena, prof->right, rightlen, 0, Leb36FlankComplement );
+    profrc->right =
+      leb36_flank( &ck->arena, prof->left, leftlen, 0, Leb36FlankComplement );
+
+    prof->leftlen    = leftlen;
+    prof->rightlen   = rightlen;
+    profrc->leftlen  = rightlen;
+    profrc->rightlen = leftlen;
+    prof->nextoffset = *p - ck->base;
+    leb36_shorten( prof, profrc, ck->isread );
+
+    *profret   = prof;
+    *profrcret = profrc;
+    return LEB36_DONE;
+}
+
+/***************************************************************/
+static void leb36_add( LEB36_CHUNK *ck, PROFILE *prof, PROFILE *profrc ) {
+    if ( ck->nprofiles + 2 > ck->maxprofiles ) {
+        ck->maxprofiles = max( 1024, 2 * ck->maxprofiles );
+        ck->profiles    = (PROFILE **) realloc(
+          ck->profiles, ck->maxprofiles * sizeof( PROFILE * ) );
+
+        if ( NULL == ck->profiles )
+            doCriticalErrorAndQuit( "Unable to allocate profile list!" );
+    }
+
+    ck->profiles[ck->nprofiles++] = prof;
+    ck->profiles[ck->nprofiles++] = profrc;
+}
+
+/***************************************************************/
+static void *leb36_parse( void *arg ) {
+    LEB36_CHUNK *ck = (LEB36_CHUNK *) arg;
+    const char * p  = ck->start;
+    PROFILE *    prof, *profrc;
+    size_t       len;
+
+    ck->status = LEB36_DONE;
+
+    for ( ;; ) {
+
+        // end of the chunk
+        leb36_token( &p, ck->end, &len );
+
+        if ( 0 == len )
+            break;
+
+        ck->status = leb36_record( ck, &p, &prof, &profrc );
+
+        if ( LEB36_DONE != ck->status )
+            break;
+
+        leb36_add( ck, prof, profrc );
+    }
+
+    return NULL;
+}
+
+/***************************************************************
+ *  Same as leb36_record for a record of a binary file.
+ ***************************************************************/
+static int leb36_binary_record( LEB36_CHUNK *ck, uint64_t i,
+  PROFILE **profret, PROFILE **profrcret ) {
+    const PROFBIN_RECORD *rec = ProfbinRecord( ck->pf, i );
+    PROFILE *             prof, *profrc;
+    FASTASEQUENCE *       pseq;
+
+    if ( rec->proflenrc <= 0 )
+        return LEB36_STOP;
+
+    if ( rec->leftlen < 0 )
+        return LEB36_NOFLANKS;
+
+    prof   = (PROFILE *) leb36_alloc( &ck->arena, 2 * sizeof( PROFILE ) );
+    profrc = prof + 1;
+    memset( prof, 0, 2 * sizeof( PROFILE ) );
+
+    prof->key = profrc->key = rec->key;
+    prof->patlen = profrc->patlen = rec->patlen;
+    prof->copynum = profrc->copynum = rec->copynum;
+    prof->proflen                   = rec->proflen;
+    profrc->proflen                 = rec->proflenrc;
+    profrc->rcflag                  = 1;
+    prof->rotationmaster = profrc->rotationmaster = 1;
+    prof->indices   = (int *) ProfbinIndices( rec );
+    profrc->indices = (int *) ProfbinRCIndices( rec );
+
+    prof->a   = rec->a;
+    prof->c   = rec->c;
+    prof->g   = rec->g;
+    prof->t   = rec->t;
+    profrc->a = prof->t;
+    profrc->t = prof->a;
+    profrc->c = prof->g;
+    profrc->g = prof->c;
+
+    pseq = (FASTASEQUENCE *) leb36_alloc(
+      &ck->arena, 2 * sizeof( FASTASEQUENCE ) );
+    pseq[0].sequence = (char *) ProfbinConcensus( rec );
+    pseq[0].length   = rec->conclen;
+    pseq[0].id       = rec->key;
+    pseq[1].sequence = (char *) ProfbinRCConcensus( rec );
+    pseq[1].length   = rec->conclenrc;
+    pseq[1].id       = rec->key;
+    prof->seq        = pseq;
+    profrc->seq      = pseq + 1;
+    leb36_entropy( prof );
+    leb36_entropy( profrc );
+
+    prof->left  = leb36_flank( &ck->arena, ProfbinLeft( rec ), rec->leftlen,
+      1, Leb36FlankChar );
+    prof->right = leb36_flank( &ck->arena, ProfbinRight( rec ), rec->rightlen,
+      0, Leb36FlankChar );
+    profrc->left  = leb36_flank( &ck->arena, prof->right, rec->rightlen, 0,
+      Leb36FlankComplement );
+    profrc->right = leb36_flank( &ck->arena, prof->left, rec->leftlen, 0,
+      Leb36FlankComplement );
+
+    prof->leftlen    = rec->leftlen;
+    prof->rightlen   = rec->rightlen;
+    profrc->leftlen  = rec->rightlen;
+    profrc->rightlen = rec->leftlen;
+    prof->nextoffset = ck->pf->table[i] + rec->size;
+    leb36_shorten( prof, profrc, ck->isread );
+
+    *profret   = prof;
+    *profrcret = profrc;
+    return LEB36_DONE;
+}
+
+/***************************************************************/
+static void *leb36_parse_binary( void *arg ) {
+    LEB36_CHUNK *ck = (LEB36_CHUNK *) arg;
+    PROFILE *    prof, *profrc;
+    uint64_t     i;
+
+    ck->status = LEB36_DONE;
+
+    for ( i = ck->first; i < ck->last; i++ ) {
+        ck->status = leb36_binary_record( ck, i, &prof, &profrc );
+
+        if ( LEB36_DONE != ck->status )
+            break;
+
+        leb36_add( ck, prof, profrc );
+    }
+
+    return NULL;
+}
+
+/***************************************************************/
+LEB36_FILE *Leb36Load( FILE *fp, int isread, int nthreads ) {
+    LEB36_FILE *  lf;
+    LEB36_CHUNK * chunks;
+    LEB36_BLOCK * block;
+    PROFBIN_FILE *pf = NULL;
+    struct stat   st;
+    const char *  base, *s;
+    size_t        size, i, n;
+    int           k, c;
+
+    if ( 0 != fstat( fileno( fp ), &st ) )
+        return NULL;
+
+    size = st.st_size;
+    base = "";
+
+    if ( ProfbinIsBinary( fp ) ) {
+        pf = ProfbinMap( fp );
+
+        if ( NULL == pf )
+            return NULL;
+
+        size = 0;
+    } else if ( size > 0 ) {
+        base = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fileno( fp ), 0 );
+
+        if ( MAP_FAILED == base )
+            return NULL;
+
+        madvise( (void *) base, size, MADV_SEQUENTIAL );
+    }
+
+    // tables shared by the threads are set up before they start
+    if ( !cmp_init )
+        InitializeCompositions();
+
+    for ( c = 0; c < 256; c++ ) {
+        Leb36FlankChar[c] = ( NULL != strchr( "ACGT", toupper( c ) ) && c )
+                              ? toupper( c )
+                              : 'N';
+        Leb36FlankComplement[c] = c;
+    }
+
+    Leb36FlankComplement['A'] = 'T';
+    Leb36FlankComplement['C'] = 'G';
+    Leb36FlankComplement['G'] = 'C';
+    Leb36FlankComplement['T'] = 'A';
+
+    // one chunk per thread, each starting at a line or a record
+    if ( pf )
+        nthreads = max( 1, min( nthreads, (int) ( pf->nrecords / 1024 ) + 1 ) );
+    else
+        nthreads = max( 1, min( nthreads, (int) ( size / 65536 ) + 1 ) );
+
+    chunks = scalloc( nthreads, sizeof( LEB36_CHUNK ) );
+
+    for ( k = 0; pf && k < nthreads; k++ ) {
+        chunks[k].pf     = pf;
+        chunks[k].isread = isread;
+        chunks[k].first  = pf->nrecords * k / nthreads;
+        chunks[k].last   = pf->nrecords * ( k + 1 ) / nthreads;
+    }
+
+    for ( k = 0; !pf && k < nthreads; k++ ) {
+        chunks[k].base   = base;
+        chunks[k].isread = isread;
+        chunks[k].end    = base + size;
+
+        if ( k > 0 ) {
+            s = base + size / nthreads * k;
+
+            if ( s < chunks[k - 1].start )
+                s = chunks[k - 1].start;
+
+            while ( s < base + size && s > base && '\n' != s[-1] )
+                s++;
+
+            chunks[k].start  = s;
+            chunks[k - 1].end = s;
+        } else {
+            chunks[k].start = base;
+        }
+    }
+
+    for ( k = 1; k < nthreads; k++ ) {
+        if ( 0 != pthread_create( &chunks[k].thread, NULL,
+                    pf ? leb36_parse_binary : leb36_parse, &chunks[k] ) )
+            doCriticalErrorAndQuit( "Unable to create loading thread!" );
+    }
+
+    if ( pf )
+        leb36_parse_binary( &chunks[0] );
+    else
+        leb36_parse( &chunks[0] );
+
+    for ( k = 1; k < nthreads; k++ )
+        pthread_join( chunks[k].thread, NULL );
+
+    if ( size > 0 )
+        munmap( (void *) base, size );
+
+    // profiles in file order, up to the first record that stopped loading
+    lf         = scalloc( 1, sizeof( LEB36_FILE ) );
+    lf->binary = pf;
+
+    for ( n = 0, k = 0; k < nthreads; k++ ) {
+        n += chunks[k].nprofiles;
+
+        if ( LEB36_DONE != chunks[k].status )
+            break;
+    }
+
+    lf->profiles = (PROFILE **) malloc( ( n + 1 ) * sizeof( PROFILE * ) );
+
+    if ( NULL == lf->profiles )
+        doCriticalErrorAndQuit( "Unable to allocate profile list!" );
+
+    for ( c = 1, k = 0; k < nthreads; k++ ) {
+        if ( c ) {
+            for ( i = 0; i < chunks[k].nprofiles; i++ )
+                lf->profiles[lf->nprofiles++] = chunks[k].profiles[i];
+
+            switch ( chunks[k].status ) {
+            case LEB36_DONE:
+                break;
+
+            case LEB36_STOP:
+                c = 0;
+                break;
+
+            case LEB36_NOFLANKS:
+                printf( "\nNo flanks specified!\n" );
+                c = 0;
+                break;
+
+            default:
+                printf( "\nload error!!!%d\n", chunks[k].status );
+                c = 0;
+                break;
+            }
+        }
+
+        // the blocks of every chunk go to the set
+        while ( NULL != ( block = chunks[k].arena ) ) {
+            chunks[k].arena = block->next;
+            block->next     = lf->arena;
+            lf->arena       = block;
+        }
+
+        free( chunks[k].profiles );
+    }
+
+    sfree( chunks );
+
+    return lf;
+}
+
+/***************************************************************/
+void Leb36Free( LEB36_FILE *lf ) {
+    LEB36_BLOCK *block;
+
+    if ( NULL == lf )
+        return;
+
+    while ( NULL != ( block = lf->arena ) ) {
+        lf->arena = block->next;
+        free( block );
+    }
+
+    ProfbinUnmap( lf->binary );
+    free( lf->profiles );
+    sfree( lf );
+}
+
+#endif
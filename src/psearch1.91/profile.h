@@ -79,6 +79,7 @@
 #include <string.h>
 
 #include "../libs/easylife/easylife.h"
+#include "../libs/vntr_kernels/packed_sequence.h"
 
 #define __int64 unsigned long long int
 
@@ -91,9 +92,6 @@
 #define max( a, b ) ( ( ( a ) >= ( b ) ) ? ( a ) : ( b ) )
 #define min( a, b ) ( ( ( a ) <= ( b ) ) ? ( a ) : ( b ) )
 
-extern char *GetReverse( char * );
-extern char *GetComplement( char * );
-
 extern int  REFLEN;
 extern int  MAXFLANKCONSIDERED;
 extern char OPTION;
@@ -109,14 +107,14 @@ typedef struct {
 //////////////////////// BASIC DATA TYPES ///////////////////////////
 
 typedef struct {
-    int   key;
-    int   patlen;
-    float copynum;
-    int   proflen;
-    int   rcflag;
-    int * indices;
-    int   a, c, g, t, n;
-    int   nextoffset;
+    int    key;
+    int    patlen;
+    float  copynum;
+    int    proflen;
+    int    rcflag;
+    int *  indices;
+    int    a, c, g, t, n;
+    size_t nextoffset;
 
     int   aProf, cProf, gProf, tProf, dashProf;
     float AveEntProf;
@@ -136,6 +134,9 @@ typedef struct {
     char       rotationmaster;
     char       dir;
     EASY_LIST *rotlist;
+
+    /* position in the reference index profile table */
+    unsigned int ordinal;
 } PROFILE;
 
 typedef struct {
@@ -156,7 +157,7 @@ typedef struct {
 // end of the file.
 PROFILE *ReadProfile( FILE *fp, int offset ); // NO LONGER USED
 PROFILE *ReadProfileWithRC(
-  FILE *fp, int offset, PROFILE **profrcret, int isread );
+  FILE *fp, long offset, PROFILE **profrcret, int isread );
 
 // Writes the profile to the current position of text file.
 void WriteProfile( FILE *fp, PROFILE *prof ); // NO LONGER USED
@@ -202,12 +203,34 @@ unsigned char *LoadDistanceTable( char *filename );
 // Frees memory. Same as free(disttable);
 void FreeDistanceTable( unsigned char *disttable );
 
+// Workspace of the profile alignment routines. Every routine takes one,
+// its buffers grow to the largest profiles aligned and are reused by the
+// following calls. Use one context per thread.
+typedef struct tagPA_CONTEXT PA_CONTEXT;
+
+// Creates an empty context, NULL if out of memory
+PA_CONTEXT *CreatePAContext( void );
+
+// Frees a context and its workspace
+void FreePAContext( PA_CONTEXT *pac );
+
 // Aligns p1 against the cyclic permuation of p2 that produces the lowest
 // distance
-PAP *GetBestProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *submatrix );
+PAP *GetBestProfileAP(
+  PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2, unsigned char *submatrix );
 
 // Align p1 against current rotation of p2 (not cyclic)
-PAP *GetFixedProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *submatrix );
+PAP *GetFixedProfileAP(
+  PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2, unsigned char *submatrix );
+
+// Same scores as GetFixedProfileAP and GetFixedProfileAPNarrowband in
+// linear memory and without traceback, fills ap (prof1side and prof2side
+// are NULL, as with the full versions). Returns -1 if out of memory.
+int GetFixedProfileScore(
+  PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2, unsigned char *submatrix,
+  PAP *ap );
+int GetFixedProfileScoreNarrowband( PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2,
+  unsigned char *submatrix, int homology, PAP *ap );
 
 // Frees memory associated with a profile alignemnt struct and its members
 void FreePAP( PAP *ap );
@@ -446,12 +469,14 @@ float ave_entropy_and_counts( int *indices, int proflen, int *aProf, int *cProf,
 }
 
 PROFILE *ReadProfileWithRC(
-  FILE *fp, int offset, PROFILE **profrcret, int isread ) {
+  FILE *fp, long offset, PROFILE **profrcret, int isread ) {
     int   c = 0, i, key = 0, patlen = 0, proflen = 0, proflenrc = 0, number = 0;
     char  dummy = 0;
     float copynum;
     char  digits[4], *src, *src2;
-    PROFILE *prof, *profrc;
+    PROFILE *      prof, *profrc;
+    PACKEDSEQ      leftpacked = { 0 }, rightpacked = { 0 };
+    PACKEDSEQ_VIEW left, right;
 
     static char leftflank[1000];
     static char rightflank[1000];
@@ -684,14 +709,36 @@ PROFILE *ReadProfileWithRC(
                 src2++;
             }
 
-            prof->left     = GetReverse( leftflank );
-            prof->leftlen  = strlen( prof->left );
-            prof->right    = strdup( rightflank );
-            prof->rightlen = strlen( prof->right );
+            /* the left flank is kept reversed, the rc profile has the
+             * complements of the other side */
+            if ( PackSequence( &leftpacked, leftflank, strlen( leftflank ) ) <
+                   0 ||
+                 PackSequence(
+                   &rightpacked, rightflank, strlen( rightflank ) ) < 0 )
+                doCriticalErrorAndQuit( "\nload: out of memory!" );
 
-            profrc->left     = GetComplement( prof->right );
+            left  = PackedSeqViewReverse(
+              PackedSeqView( &leftpacked, 0, leftpacked.length ) );
+            right = PackedSeqView( &rightpacked, 0, rightpacked.length );
+
+            prof->left  = PackedSeqViewString( &left );
+            prof->right = PackedSeqViewString( &right );
+
+            left          = PackedSeqViewComplement( left );
+            right         = PackedSeqViewComplement( right );
+            profrc->left  = PackedSeqViewString( &right );
+            profrc->right = PackedSeqViewString( &left );
+
+            FreePackedSequence( &leftpacked );
+            FreePackedSequence( &rightpacked );
+
+            if ( !prof->left || !prof->right || !profrc->left ||
+                 !profrc->right )
+                doCriticalErrorAndQuit( "\nload: out of memory!" );
+
+            prof->leftlen    = strlen( prof->left );
+            prof->rightlen   = strlen( prof->right );
             profrc->leftlen  = strlen( profrc->left );
-            profrc->right    = GetComplement( prof->left );
             profrc->rightlen = strlen( profrc->right );
             i                = 1;
             break;
@@ -1126,11 +1173,12 @@ struct tagPSD {
 };
 typedef struct tagPSD PSD;
 
-/* global variables */
-SPINEOFPALIMITS paL[MAXPROFILESIZE];
-PSD *           paS;
-int             padoublepat[MAXPROFILESIZE * 2];
-int             pa_need_init = 1;
+/* one cell of the score-only aligners: distance and the weighted sums of the
+ * path the traceback would take from it */
+typedef struct tagPSDSUM {
+    int distance;
+    int dsum, sumw, length;
+} PSDSUM;
 
 /* paLOGDEPTH is used by Controlstack and limits paReserve */
 
@@ -1144,23 +1192,6 @@ struct tagRESERVEOFPALIMITS {
 };
 typedef struct tagRESERVEOFPALIMITS RESERVE;
 
-RESERVE paReserve;
-
-/* addlimits and removelimits handle limit structures hanging off
-   paL[] spine */
-
-void addlimits( int a ) {
-    paReserve.next++;
-    paL[a].limits                    = paReserve.limits[paReserve.next];
-    paReserve.limits[paReserve.next] = NULL;
-}
-
-void removelimits( int a ) {
-    paReserve.limits[paReserve.next] = paL[a].limits;
-    paL[a].limits                    = NULL;
-    paReserve.next--;
-}
-
 /* Controlstack is used to get the correct order for the alignments */
 
 struct tagCONTROLSTACK {
@@ -1171,80 +1202,174 @@ struct tagCONTROLSTACK {
 
 typedef struct tagCONTROLSTACK CONTROLSTACK;
 
-CONTROLSTACK Controlstack;
+/* workspace that used to be global, sizes are in elements */
+struct tagPA_CONTEXT {
+    /* GetBestProfileAP */
+    SPINEOFPALIMITS paL[MAXPROFILESIZE];
+    PSD *           paS;
+    size_t          maxpaS;
+    int *           padoublepat;
+    size_t          maxdoublepat;
+    RESERVE         paReserve;
+    size_t          maxlimits; /* of each paReserve.limits array */
+    CONTROLSTACK    Controlstack;
+
+    /* GetFixedProfileAP and GetFixedProfileAPNarrowband */
+    PSD *  S;
+    size_t maxS;
+
+    /* GetFixedProfileScore and GetFixedProfileScoreNarrowband */
+    PSDSUM *rows;
+    size_t  maxrows;
+
+    unsigned int cells_processed;
+};
+
+PA_CONTEXT *CreatePAContext( void ) {
+    PA_CONTEXT *pac;
+
+    pac = (PA_CONTEXT *) calloc( 1, sizeof( PA_CONTEXT ) );
+
+    if ( pac == NULL )
+        return NULL;
+
+    pac->paReserve.next = -1;
+
+    return pac;
+}
+
+void FreePAContext( PA_CONTEXT *pac ) {
+    int i;
+
+    if ( pac == NULL )
+        return;
+
+    free( pac->paS );
+    free( pac->padoublepat );
+
+    for ( i = 0; i < paLOGDEPTH; i++ )
+        free( pac->paReserve.limits[i] );
+
+    free( pac->S );
+    free( pac->rows );
+    free( pac );
+}
+
+/* makes room for n elements of size bytes in *buf, returns 1 if out of
+   memory (the old buffer is kept) */
+int PAContextGrow( void **buf, size_t *maxn, size_t n, size_t size ) {
+    void *newbuf;
+
+    if ( n <= *maxn )
+        return 0;
+
+    newbuf = realloc( *buf, n * size );
+
+    if ( newbuf == NULL )
+        return 1;
+
+    *buf  = newbuf;
+    *maxn = n;
+
+    return 0;
+}
+
+/* addlimits and removelimits handle limit structures hanging off
+   paL[] spine */
+
+void addlimits( PA_CONTEXT *pac, int a ) {
+    pac->paReserve.next++;
+    pac->paL[a].limits = pac->paReserve.limits[pac->paReserve.next];
+    pac->paReserve.limits[pac->paReserve.next] = NULL;
+}
+
+void removelimits( PA_CONTEXT *pac, int a ) {
+    pac->paReserve.limits[pac->paReserve.next] = pac->paL[a].limits;
+    pac->paL[a].limits                         = NULL;
+    pac->paReserve.next--;
+}
 
 /* Controlstack functions */
 
-int Controlstackempty() { return ( Controlstack.height == -1 ); }
+int Controlstackempty( CONTROLSTACK *cs ) { return ( cs->height == -1 ); }
 
-void newControlstack() { Controlstack.height = -1; }
+void newControlstack( CONTROLSTACK *cs ) { cs->height = -1; }
 
-void pushControlstack( int a, int b ) {
-    Controlstack.height++;
-    Controlstack.left[Controlstack.height]  = a;
-    Controlstack.right[Controlstack.height] = b;
+void pushControlstack( CONTROLSTACK *cs, int a, int b ) {
+    cs->height++;
+    cs->left[cs->height]  = a;
+    cs->right[cs->height] = b;
 }
 
-void popControlstack( int *a, int *b ) {
-    *a = Controlstack.left[Controlstack.height];
-    *b = Controlstack.right[Controlstack.height];
-    Controlstack.height--;
+void popControlstack( CONTROLSTACK *cs, int *a, int *b ) {
+    *a = cs->left[cs->height];
+    *b = cs->right[cs->height];
+    cs->height--;
 }
 
-/* changed this procedure to remove allocation for paL[], added allocation
-   for paReserve, removed paouterleft */
+/* replaces PA_InitializeGlobals, grows the workspace of GetBestProfileAP to
+   an slength by plength alignment instead of allocating for the maximum
+   profile size up front. Returns 1 if out of memory */
 
-int PA_InitializeGlobals() {
-    int i;
+int PA_ReserveBest( PA_CONTEXT *pac, int slength, int plength ) {
+    PALIMIT *limits;
+    int      i;
 
-    /* allocate the maximum DS space that can possibly be needed */
-    paS = (PSD *) malloc(
-      ( MAXPROFILESIZE + 1 ) * ( MAXPROFILESIZE + 1 ) * sizeof( PSD ) );
+    if ( PAContextGrow( (void **) &pac->paS, &pac->maxpaS,
+           (size_t)( slength + 1 ) * ( plength + 1 ), sizeof( PSD ) ) )
+        return 1;
 
-    if ( paS == NULL )
+    if ( PAContextGrow( (void **) &pac->padoublepat, &pac->maxdoublepat,
+           (size_t) plength * 2, sizeof( int ) ) )
         return 1;
 
-    /* allocate paLOGDEPTH row limits */
-    for ( i = 0; i < paLOGDEPTH; i++ ) {
-        paReserve.limits[i] =
-          (PALIMIT *) malloc( sizeof( PALIMIT ) * ( MAXPROFILESIZE + 1 ) );
+    /* the limits are all back in the reserve between alignments, rows go
+       up to slength + 1 */
+    if ( (size_t)( slength + 2 ) > pac->maxlimits ) {
+        for ( i = 0; i < paLOGDEPTH; i++ ) {
+            limits = (PALIMIT *) realloc(
+              pac->paReserve.limits[i], sizeof( PALIMIT ) * ( slength + 2 ) );
 
-        if ( paReserve.limits[i] == NULL )
-            return 1;
-    }
+            if ( limits == NULL )
+                return 1;
 
-    paReserve.next = -1;
+            pac->paReserve.limits[i] = limits;
+        }
 
-    pa_need_init = 0;
+        pac->maxlimits = slength + 2;
+    }
 
     return 0;
 }
 
 // creates the boundaries that are used in the first alignment
-void init_rectangular_limits( int plength, int slength ) {
-    static int i;
+void init_rectangular_limits( PA_CONTEXT *pac, int plength, int slength ) {
+    int i;
 
     for ( i = 0; i <= slength; i++ ) {
-        paL[0].limits[i].right       = 0;
-        paL[0].limits[i].left        = 0;
-        paL[plength].limits[i].right = plength;
-        paL[plength].limits[i].left  = plength;
+        pac->paL[0].limits[i].right       = 0;
+        pac->paL[0].limits[i].left        = 0;
+        pac->paL[plength].limits[i].right = plength;
+        pac->paL[plength].limits[i].left  = plength;
     }
 }
 
-void PAPToLimit( int start, int slength, int plength, PAP *pa )
+void PAPToLimit(
+  PA_CONTEXT *pac, int start, int slength, int plength, PAP *pa )
 
 {
-    int  row, col, i, length;
-    int *ss, *ps;
+    int      row, col, i, length;
+    int *    ss, *ps;
+    PALIMIT *limits;
 
     length = pa->length;
     ss     = pa->prof1side;
     ps     = pa->prof2side;
+    limits = pac->paL[start].limits;
 
     row                          = 0;
     col                          = start;
-    paL[start].limits[row].right = col;
+    limits[row].right = col;
 
     for ( i = 0; i < length; i++ ) {
         if ( ( ss[i] != NEWGAPINDEX ) && ( ps[i] != NEWGAPINDEX ) ) {
@@ -1256,14 +1381,14 @@ void PAPToLimit( int start, int slength, int plength, PAP *pa )
             row++;
         }
 
-        paL[start].limits[row].right = col;
+        limits[row].right = col;
     }
 
     row = slength;
     col = start + plength;
 
     for ( i = length - 1; i >= 0; i-- ) {
-        paL[start].limits[row].left = col;
+        limits[row].left = col;
 
         if ( ( ss[i] != NEWGAPINDEX ) && ( ps[i] != NEWGAPINDEX ) ) {
             row--;
@@ -1275,17 +1400,18 @@ void PAPToLimit( int start, int slength, int plength, PAP *pa )
         }
     }
 
-    paL[start].limits[row].left = col;
+    limits[row].left = col;
 }
 
-PAP *GetBoundedProfileAP( int *left, int *top, int leftlen, int start, int end,
-  PALIMIT *mins, PALIMIT *maxs, unsigned char *sm ) {
+PAP *GetBoundedProfileAP( PA_CONTEXT *pac, int *left, int *top, int leftlen,
+  int start, int end, PALIMIT *mins, PALIMIT *maxs, unsigned char *sm ) {
     int  min, max, rindex2, leftRminus1;
     int  r, c, i, width, sumw, dsum, dashnum;
     PSD *Sp, *Srm1p, *Scm1p, *Srcm1p; /* temporary pointers */
     int  sa, f, e;
     PAP *ap;
     int *seqpos, *patpos, *leftpos, *toppos;
+    PSD *paS = pac->paS;
 
     /****************************************
      * Do distances and directions for row zero
@@ -1583,18 +1709,13 @@ void DoubleProfile( int *p, int len, int *dest ) {
     return;
 }
 
-PAP *GetBestProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *submatrix ) {
-    int  m, left, right;
-    PAP *bestsofar, *ap;
-    int *s, *p, slength, plength;
-
-    /* make sure memory for workspace and limits has been allocated */
-    if ( pa_need_init ) {
-        if ( PA_InitializeGlobals() )
-            return NULL;
-
-        pa_need_init = 0;
-    }
+PAP *GetBestProfileAP(
+  PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2, unsigned char *submatrix ) {
+    int              m, left, right;
+    PAP *            bestsofar, *ap;
+    int *            s, *p, slength, plength;
+    SPINEOFPALIMITS *paL = pac->paL;
+    CONTROLSTACK *   cs  = &pac->Controlstack;
 
     /* set local variables */
     s       = p1->indices;
@@ -1602,20 +1723,24 @@ PAP *GetBestProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *submatrix ) {
     p       = p2->indices;
     plength = p2->proflen;
 
-    newControlstack();
-    addlimits( 0 );
-    addlimits( plength );
-    init_rectangular_limits( plength, slength );
+    /* make sure the workspace and limits are large enough */
+    if ( PA_ReserveBest( pac, slength, plength ) )
+        return NULL;
+
+    newControlstack( cs );
+    addlimits( pac, 0 );
+    addlimits( pac, plength );
+    init_rectangular_limits( pac, plength, slength );
 
-    /* duplicate the top profile into global padoublepat */
-    DoubleProfile( p, plength, padoublepat );
+    /* duplicate the top profile into padoublepat */
+    DoubleProfile( p, plength, pac->padoublepat );
 
     /* get first alignment */
-    bestsofar = GetBoundedProfileAP( s, padoublepat, slength, 0, plength,
-      paL[0].limits, paL[plength].limits, submatrix );
+    bestsofar = GetBoundedProfileAP( pac, s, pac->padoublepat, slength, 0,
+      plength, paL[0].limits, paL[plength].limits, submatrix );
 
     /* copy alignment to paL[0].limits */
-    PAPToLimit( 0, slength, plength, bestsofar );
+    PAPToLimit( pac, 0, slength, plength, bestsofar );
 
     /* copy paL[0].limits to paL[plength].limits */
     for ( m = 0; m <= slength; m++ ) {
@@ -1623,21 +1748,21 @@ PAP *GetBestProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *submatrix ) {
         paL[plength].limits[m].left  = paL[0].limits[m].left + plength;
     }
 
-    pushControlstack( 0, plength );
+    pushControlstack( cs, 0, plength );
 
-    while ( !Controlstackempty() ) {
-        popControlstack( &left, &right );
+    while ( !Controlstackempty( cs ) ) {
+        popControlstack( cs, &left, &right );
 
         if ( right - left > 1 ) {
             m = ( left + right ) / 2;
 
             /* the next is the routine for the alignment */
-            ap = GetBoundedProfileAP( s, padoublepat, slength, m, m + plength,
-              paL[left].limits, paL[right].limits, submatrix );
+            ap = GetBoundedProfileAP( pac, s, pac->padoublepat, slength, m,
+              m + plength, paL[left].limits, paL[right].limits, submatrix );
 
-            addlimits( m );
+            addlimits( pac, m );
             /* copy alignment to paL[m].limits */
-            PAPToLimit( m, slength, plength, ap );
+            PAPToLimit( pac, m, slength, plength, ap );
 
             // if(ap->distance<bestsofar->distance)
             // if (((ap->distance)/(255.0*ap->length)) <
@@ -1651,13 +1776,13 @@ PAP *GetBestProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *submatrix ) {
                 FreePAP( ap );
             }
 
-            pushControlstack( m, right );
-            pushControlstack( left, m );
+            pushControlstack( cs, m, right );
+            pushControlstack( cs, left, m );
         } else
-            removelimits( left );
+            removelimits( pac, left );
     }
 
-    removelimits( plength );
+    removelimits( pac, plength );
 
     // set rc flag
     if ( p1->rcflag == p2->rcflag )
@@ -1728,10 +1853,29 @@ void printSP( PSD *S, int leftlen, int toplen ) {
     ( ( row < halfleft ) ? ( startradius + gradvector * row ) \
                          : ( startradius + gradvector * ( leftlen - row ) ) )
 
-unsigned int cells_processed;
+/* half width of the narrowband, from the angle of the target homology */
+int NarrowbandRadius( int leftlen, int toplen, int homology ) {
+    double virtdiagonal, angle, topangle, bandradius, midradius, minlen;
+    int    startradius = 6;
+
+    minlen = min( toplen, leftlen );
+    virtdiagonal =
+      sqrt( pow( minlen, 2 ) * 2 ); // modified virtdiagonal to accountfor
+                                    // matrix not being a perfect square matrix
+    angle      = acos( homology / 100.0 );
+    topangle   = atan( (double) leftlen / (double) toplen );
+    midradius  = tan( angle ) * ( virtdiagonal / 2.0 );
+    bandradius = midradius / sin( topangle );
+
+    /* this formula is from Dr. Benson's TRF program */
+    // bandradius_int = (int)floor(2.3*sqrt(.1*max(toplen,leftlen)));
+    // bandradius_int = max(bandradius_int,startradius) + 1;
+
+    return (int) max( bandradius, startradius ) + 1;
+}
 
-PAP *GetFixedProfileAPNarrowband(
-  PROFILE *p1, PROFILE *p2, unsigned char *sm, int homology ) {
+PAP *GetFixedProfileAPNarrowband( PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2,
+  unsigned char *sm, int homology ) {
 
     int col, row, length, lstart, rend, center, toplenreached, oldrend, sumw,
       dsum, dashnum;
@@ -1743,47 +1887,29 @@ PAP *GetFixedProfileAPNarrowband(
     PAP *  ap;
     int    leftlen, toplen, *toppos, *leftpos;
     int *  left, *top;
-    double svector, diagonal, virtdiagonal, angle, virt100;
-    double topangle, bandradius, midradius, minlen;
+    double svector;
     int    startradius, bandradius_int;
 
     // set lengths to be used
-    cells_processed = 0;
+    pac->cells_processed = 0;
     leftlen         = p1->proflen;
     toplen          = p2->proflen;
-    diagonal =
-      sqrt( pow( toplen, 2 ) + pow( leftlen, 2 ) ); // actual diagonal length
-    minlen = min( toplen, leftlen );
-    virtdiagonal =
-      sqrt( pow( minlen, 2 ) * 2 ); // modified virtdiagonal to accountfor
-                                    // matrix not being a perfect square matrix
-    virt100     = 100 * virtdiagonal / diagonal;
-    svector     = (double) toplen / (double) leftlen;
-    startradius = 6;
-
-    {
-        angle          = acos( homology / 100.0 );
-        topangle       = atan( (double) leftlen / (double) toplen );
-        midradius      = tan( angle ) * ( virtdiagonal / 2.0 );
-        bandradius     = midradius / sin( topangle );
-        bandradius_int = (int) max( bandradius, startradius ) + 1;
-    }
-
-    /* this formula is from Dr. Benson's TRF program */
-    // bandradius_int = (int)floor(2.3*sqrt(.1*max(toplen,leftlen)));
-    // bandradius_int = max(bandradius_int,startradius) + 1;
+    svector         = (double) toplen / (double) leftlen;
+    startradius     = 6;
+    bandradius_int  = NarrowbandRadius( leftlen, toplen, homology );
 
     /* set shorthand for array of profile indices */
     left = p1->indices;
     top  = p2->indices;
 
-    /* allocate the alignment matrix */
-    S = (PSD *) malloc( sizeof( PSD ) * ( leftlen + 1 ) * ( toplen + 1 ) );
-
-    if ( S == NULL ) {
+    /* make room for the alignment matrix */
+    if ( PAContextGrow( (void **) &pac->S, &pac->maxS,
+           (size_t)( leftlen + 1 ) * ( toplen + 1 ), sizeof( PSD ) ) ) {
         return NULL; /* in case memory allocation fails */
     }
 
+    S = pac->S;
+
     /* compute Alignment Matrix */
     /* first element */
     Sp            = S;
@@ -1905,7 +2031,7 @@ PAP *GetFixedProfileAPNarrowband(
             Scm1p++;
             Srcm1p++;
 #ifdef PROCLU_DEBUG
-            cells_processed++;
+            pac->cells_processed++;
 #endif
         }
 
@@ -1919,7 +2045,6 @@ PAP *GetFixedProfileAPNarrowband(
     ap = (PAP *) malloc( sizeof( PAP ) );
 
     if ( ap == NULL ) {
-        free( S );
         return NULL;
     }
 
@@ -2030,14 +2155,12 @@ exit7:; /* goes here in case PA_START */
 
     // printf("|\n"); fflush(stdout);
 
-    /* free alignment matrix */
-    free( S );
-
     /* return pointer to alignment */
     return ap;
 }
 
-PAP *GetFixedProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *sm ) {
+PAP *GetFixedProfileAP(
+  PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2, unsigned char *sm ) {
     int  col, row, length;
     int  e;  /* equals e+indel */
     int  f;  /* equals f+indel */
@@ -2057,13 +2180,14 @@ PAP *GetFixedProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *sm ) {
     left = p1->indices;
     top  = p2->indices;
 
-    /* allocate the alignment matrix */
-    S = (PSD *) malloc( sizeof( PSD ) * ( leftlen + 1 ) * ( toplen + 1 ) );
-
-    if ( S == NULL ) {
+    /* make room for the alignment matrix */
+    if ( PAContextGrow( (void **) &pac->S, &pac->maxS,
+           (size_t)( leftlen + 1 ) * ( toplen + 1 ), sizeof( PSD ) ) ) {
         return NULL; /* in case memory allocation fails */
     }
 
+    S = pac->S;
+
     /* compute Alignment Matrix */
     /* first element */
     Sp            = S;
@@ -2135,7 +2259,6 @@ PAP *GetFixedProfileAP( PROFILE *p1, PROFILE *p2, unsigned char *sm ) {
     ap = (PAP *) malloc( sizeof( PAP ) );
 
     if ( ap == NULL ) {
-        free( S );
         return NULL;
     }
 
@@ -2213,9 +2336,6 @@ exit7:; /* goes here in case PA_START */
     ap->distanceweighted = dsum;
     ap->weights          = sumw;
 
-    /* free alignment matrix */
-    free( S );
-
     // ap->similarity = (1.0-(ap->distance)/(255.0*ap->length));
     ap->similarity =
       ( 1.0 - ( ap->distanceweighted ) / ( 255.0 * ap->weights ) );
@@ -2226,6 +2346,264 @@ exit7:; /* goes here in case PA_START */
     return ap;
 }
 
+/* moves along the path into a cell, by direction */
+#define PSDSUM_DIAGONAL( D, P, l, t, sm )                      \
+    {                                                          \
+        int dashnum_  = min( 10, NONDASHES[l] + NONDASHES[t] ); \
+        ( D )->dsum   = ( P )->dsum +                          \
+                      dashnum_ * EVALDISTANCE( l, t, sm );     \
+        ( D )->sumw   = ( P )->sumw + dashnum_;                \
+        ( D )->length = ( P )->length + 1;                     \
+    }
+#define PSDSUM_RIGHT( D, P, t, sm )                                  \
+    {                                                                \
+        ( D )->dsum   = ( P )->dsum +                                \
+                      NONDASHES[t] * EVALDISTANCE( GAPINDEX, t, sm ); \
+        ( D )->sumw   = ( P )->sumw + NONDASHES[t];                  \
+        ( D )->length = ( P )->length + 1;                           \
+    }
+#define PSDSUM_DOWN( D, P, l, sm )                                   \
+    {                                                                \
+        ( D )->dsum   = ( P )->dsum +                                \
+                      NONDASHES[l] * EVALDISTANCE( l, GAPINDEX, sm ); \
+        ( D )->sumw   = ( P )->sumw + NONDASHES[l];                  \
+        ( D )->length = ( P )->length + 1;                           \
+    }
+
+void PSDSumToPAP( PSDSUM *Sp, PAP *ap ) {
+    ap->start            = 0;
+    ap->distance         = Sp->distance;
+    ap->length           = Sp->length;
+    ap->distanceweighted = Sp->dsum;
+    ap->weights          = Sp->sumw;
+    ap->rcflag           = 0;
+    ap->similarity =
+      ( 1.0 - ( ap->distanceweighted ) / ( 255.0 * ap->weights ) );
+    ap->prof1side = NULL;
+    ap->prof2side = NULL;
+}
+
+/* GetFixedProfileAP in two rows, the weighted sums are carried forward along
+ * the same tie breaking (diagonal, down, right) the traceback follows */
+int GetFixedProfileScore(
+  PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2, unsigned char *sm, PAP *ap ) {
+    int     col, row, l;
+    int     e, f, sa;
+    int     leftlen, toplen;
+    int *   left, *top;
+    PSDSUM *R, *Rm1, *temp;
+
+    leftlen = p1->proflen;
+    toplen  = p2->proflen;
+    left    = p1->indices;
+    top     = p2->indices;
+
+    if ( PAContextGrow( (void **) &pac->rows, &pac->maxrows,
+           2 * (size_t)( toplen + 1 ), sizeof( PSDSUM ) ) ) {
+        return -1;
+    }
+
+    R   = pac->rows;
+    Rm1 = R + ( toplen + 1 );
+
+    /* first row */
+    Rm1[0].distance = Rm1[0].dsum = Rm1[0].sumw = Rm1[0].length = 0;
+
+    for ( col = 1; col <= toplen; col++ ) {
+        Rm1[col].distance =
+          EVALDISTANCE( GAPINDEX, top[col - 1], sm ) + Rm1[col - 1].distance;
+        PSDSUM_RIGHT( &Rm1[col], &Rm1[col - 1], top[col - 1], sm );
+    }
+
+    /* body of matrix */
+    for ( row = 1; row <= leftlen; row++ ) {
+        l = left[row - 1];
+
+        /* profile indices are never negative, EVALDISTANCE branches on it */
+        if ( l < 0 )
+            return -1;
+
+        R[0].distance = EVALDISTANCE( GAPINDEX, l, sm ) + Rm1[0].distance;
+        PSDSUM_DOWN( &R[0], &Rm1[0], l, sm );
+
+        for ( col = 1; col <= toplen; col++ ) {
+            e = R[col - 1].distance +
+                EVALDISTANCE( GAPINDEX, top[col - 1], sm );
+            f  = Rm1[col].distance + EVALDISTANCE( GAPINDEX, l, sm );
+            sa = Rm1[col - 1].distance + EVALDISTANCE( l, top[col - 1], sm );
+
+            switch ( min3switch( sa, f, e ) ) {
+            case 1:
+                R[col].distance = sa;
+                PSDSUM_DIAGONAL( &R[col], &Rm1[col - 1], l, top[col - 1], sm );
+                break;
+
+            case 2:
+                R[col].distance = f;
+                PSDSUM_DOWN( &R[col], &Rm1[col], l, sm );
+                break;
+
+            case 3:
+                R[col].distance = e;
+                PSDSUM_RIGHT( &R[col], &R[col - 1], top[col - 1], sm );
+                break;
+            }
+        }
+
+        temp = Rm1;
+        Rm1  = R;
+        R    = temp;
+    }
+
+    PSDSumToPAP( &Rm1[toplen], ap );
+
+    return 0;
+}
+
+/* GetFixedProfileAPNarrowband in two rows, including the sentinel cells
+ * around the band, so the same cells are read with the same values */
+int GetFixedProfileScoreNarrowband( PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2,
+  unsigned char *sm, int homology, PAP *ap ) {
+
+    int     col, row, lstart, rend, center, toplenreached, oldrend, lastleft;
+    int     e, f, sa, l;
+    int     leftlen, toplen;
+    int *   left, *top;
+    double  svector;
+    int     startradius, bandradius_int;
+    PSDSUM *R, *Rm1, *temp, leftside;
+    PAP *   full;
+
+    pac->cells_processed = 0;
+    leftlen         = p1->proflen;
+    toplen          = p2->proflen;
+    svector         = (double) toplen / (double) leftlen;
+    startradius     = 6;
+    bandradius_int  = NarrowbandRadius( leftlen, toplen, homology );
+    left            = p1->indices;
+    top             = p2->indices;
+
+    if ( PAContextGrow( (void **) &pac->rows, &pac->maxrows,
+           2 * (size_t)( toplen + 1 ), sizeof( PSDSUM ) ) ) {
+        return -1;
+    }
+
+    R   = pac->rows;
+    Rm1 = R + ( toplen + 1 );
+    memset( R, 0, 2 * ( toplen + 1 ) * sizeof( PSDSUM ) );
+
+    /* across the top */
+    Rm1[0].distance = Rm1[0].dsum = Rm1[0].sumw = Rm1[0].length = 0;
+    rend = min( toplen, bandradius_int + 3 );
+
+    for ( col = 1; col <= rend; col++ ) {
+        if ( col > bandradius_int )
+            Rm1[col].distance = 100000000;
+        else
+            Rm1[col].distance = EVALDISTANCE( GAPINDEX, top[col - 1], sm ) +
+                                Rm1[col - 1].distance;
+
+        PSDSUM_RIGHT( &Rm1[col], &Rm1[col - 1], top[col - 1], sm );
+    }
+
+    /* the left side is filled down to the first row starting past column 3 */
+    for ( lastleft = 1; lastleft < leftlen; lastleft++ ) {
+        if ( max( 1, (int) ( lastleft * svector ) - bandradius_int ) > 3 )
+            break;
+    }
+
+    leftside = Rm1[0];
+
+    /* body of matrix */
+    toplenreached = 0;
+    oldrend       = startradius;
+
+    for ( row = 1; row <= leftlen; row++ ) {
+        l = left[row - 1];
+
+        /* profile indices are never negative, EVALDISTANCE branches on it */
+        if ( l < 0 )
+            return -1;
+
+        /* calculate narrowband bounds */
+        center = (int) ( row * svector );
+        lstart = center - bandradius_int;
+        lstart = max( 1, ( lstart ) );
+        rend   = center + bandradius_int;
+        rend   = min( toplen, ( rend ) );
+
+        if ( row <= lastleft ) {
+            leftside.distance += EVALDISTANCE( GAPINDEX, l, sm );
+            PSDSUM_DOWN( &leftside, &leftside, l, sm );
+            R[0] = leftside;
+        }
+
+        if ( lstart > 1 ) {
+            for ( col = lstart - 1; col >= max( 0, lstart - 3 ); col-- ) {
+                R[col].distance = 100000000;
+                PSDSUM_DOWN( &R[col], &Rm1[col], l, sm );
+            }
+        }
+
+        if ( !toplenreached ) {
+            if ( row > 1 ) {
+                for ( col = oldrend + 1; col <= min( toplen, oldrend + 3 );
+                      col++ ) {
+                    Rm1[col].distance = 100000000;
+                    PSDSUM_RIGHT( &Rm1[col], &Rm1[col - 1], top[col - 1], sm );
+                }
+            }
+
+            if ( rend == toplen )
+                toplenreached = 1;
+        }
+
+        for ( col = lstart; col <= rend; col++ ) {
+            e = R[col - 1].distance +
+                EVALDISTANCE( GAPINDEX, top[col - 1], sm );
+            f  = Rm1[col].distance + EVALDISTANCE( GAPINDEX, l, sm );
+            sa = Rm1[col - 1].distance + EVALDISTANCE( l, top[col - 1], sm );
+
+            switch ( min3switch( sa, f, e ) ) {
+            case 1:
+                R[col].distance = sa;
+                PSDSUM_DIAGONAL( &R[col], &Rm1[col - 1], l, top[col - 1], sm );
+                break;
+
+            case 2:
+                R[col].distance = f;
+                PSDSUM_DOWN( &R[col], &Rm1[col], l, sm );
+                break;
+
+            case 3:
+                R[col].distance = e;
+                PSDSUM_RIGHT( &R[col], &R[col - 1], top[col - 1], sm );
+                break;
+            }
+
+#ifdef PROCLU_DEBUG
+            pac->cells_processed++;
+#endif
+        }
+
+        oldrend = rend;
+        temp    = Rm1;
+        Rm1     = R;
+        R       = temp;
+    }
+
+    PSDSumToPAP( &Rm1[toplen], ap );
+
+    /* the full version gives up on paths this long, let it report */
+    if ( ap->length > 5000 ) {
+        full = GetFixedProfileAPNarrowband( pac, p1, p2, sm, homology );
+        *ap  = *full;
+        free( full );
+    }
+
+    return 0;
+}
+
 PROFILE *GetReverseComplementProfile( PROFILE *original ) {
     PROFILE *newprof;
     int      i, *sourceptr, *destinptr;
@@ -2303,8 +2681,8 @@ void RescorePAP( PAP *ap, unsigned char *submatrix ) {
 //#define SUBPATDEBUG
 
 /************************************************************************************************************/
-PAP *GetBestProfileAPSubpattern(
-  PROFILE *p1, PROFILE *p2, unsigned char *submatrix, double target_homology ) {
+PAP *GetBestProfileAPSubpattern( PA_CONTEXT *pac, PROFILE *p1, PROFILE *p2,
+  unsigned char *submatrix, double target_homology ) {
 
     PROFILE *pLargest, *pTemp, Temp;
     PAP *    bestsofar = NULL, *ap;
@@ -2372,7 +2750,7 @@ PAP *GetBestProfileAPSubpattern(
         /* align */
         if ( NULL != bestsofar ) {
             ap = GetFixedProfileAPNarrowband(
-              pLargest, &Temp, submatrix, homology_int );
+              pac, pLargest, &Temp, submatrix, homology_int );
 
 #ifdef SUBPATDEBUG
             printf( "dist: %d", ap->distance );
@@ -2388,7 +2766,7 @@ PAP *GetBestProfileAPSubpattern(
         } else {
             // bestsofar =   GetFixedProfileAP(pLargest, &Temp, submatrix);
             bestsofar = GetFixedProfileAPNarrowband(
-              pLargest, &Temp, submatrix, homology_int );
+              pac, pLargest, &Temp, submatrix, homology_int );
 
 #ifdef SUBPATDEBUG
             printf( "dist: %d", bestsofar->distance );
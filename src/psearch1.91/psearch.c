@@ -3,6 +3,42 @@
 this is a restructured version of proclu, optimized for speed for refs vs reads
 comparison, no cyclic alignment
 
+  1.93 - READPROFILES can be a directory or a @list of reads files, the refs
+are loaded once and the files are scanned one after another
+       - reads are scanned by NTHREADS threads (-t option), links are merged in
+read order so the output does not depend on the thread count
+       - reference profiles and seed tables are kept in a memory mapped index
+(REFPROFILES.psidx), built by the first run and reused while the content of the
+refs and their rotindex is unchanged, in $PSEARCH_INDEX_DIR the index name
+carries a digest of the refs so reference sets of the same name keep apart
+       - seed tables are flat (sorted codes, offsets, 8 byte hits), built
+directly from the seeds without the double hash, pmin ranges are bisected
+       - seeds are extracted from 2 bit packed sequences with a rolling window
+(PEXT when built with BMI2), no more per position strchr and offset loops
+       - consensus LCS prefilter runs once per candidate list with the read
+match vectors prepared once (bitwise LCS batch.c)
+       - profile alignments of candidates are scored in two rows with the
+weighted sums carried along the path, no full matrix or traceback
+       - profile alignment workspace is owned by a PA_CONTEXT per thread and
+reused, nothing is allocated per alignment (the 200MB GetBestProfileAP matrix
+is now grown to the profiles aligned)
+       - profile files are memory mapped and parsed on NTHREADS threads into one
+arena per file (leb36.h), offsets are size_t
+       - refs and reads can be binary profile files (profbin.h, written by
+trf2proclu-ngs -b, redund -b or leb36conv), their indices and consensus are
+used from the mapping
+       - flanks of a reference are encoded for edit distance once and reused
+by the reads hitting it next (Edit_Distance_multiple_word_NoEndPenaltySeq1
+_Prepare/_Run), no allocation per flank alignment
+       - flank edit distances stop as soon as no column of a row is within
+MAXEL1/MAXER1, only the pass/fail and the errors of passing flanks are used
+       - flanks of all rotation pairs of a read are aligned together, several
+pairs side by side in vector lanes (bitwise edit distance batch.h, AVX-512,
+AVX2 or SSE2 picked at run time)
+       - LCS and edit distance kernels come from libs/vntr_kernels, shared with
+the other tools: LCS_single_word keeps strings of 60 to 63 characters whole
+and flanks over 63 bases get the 4/30/14 edit distance carry fix
+
   1.92 - passing 0 for maxerrors will now make the program pick one based on
 length of the flank
 
@@ -36,6 +72,8 @@ match)
 #define I64d ld
 #endif
 
+#include <dirent.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
@@ -45,6 +83,7 @@ int  REFLEN             = 50;      // for ref-vs-ref
 int  MAXFLANKCONSIDERED = 1000000; // for ref-vs-read
 char OPTION             = 0;       // for ref-vs-ref
 char OPTION2            = 0;       // v1.9, for mapfile
+int  NTHREADS           = 1;       // v1.93, read scanning threads
 
 static time_t startTime;
 
@@ -67,6 +106,7 @@ typedef struct {
 } PROFPAIR;
 
 GSHASH *profileHash = NULL;
+#define READHASHSIZE 1000000 // profileHash room for the reads of a file
 FILE *  MAPFILE     = NULL; // written in version 1.9
 
 #include "hclust.h"
@@ -74,20 +114,24 @@ FILE *  MAPFILE     = NULL; // written in version 1.9
 int LoadRotated( FILE *fp );
 
 //#include "narrowbandDistanceAlignment.h"
-#include "bitwise LCS multiple word.h"
-#include "bitwise LCS single word.h"
-#include "bitwise edit distance alignment multiple word no end penalty.h"
+#include "../libs/vntr_kernels/vntr_kernels.h"
+
+#include "leb36.h"
+
+LEB36_FILE *RefProfiles = NULL; // reference profiles read from text
 
 void doEdgesBruteForce( FILE *fpi, FILE *fpi2, FILE *edgesIn,
   unsigned char *dt1, int fixed, char *outputfile );
 
 /*******************************************************************************************/
-int patcmp( const void *item1, const void *item2 ) {
+/* for qsort on the candidates array, EasyArrayQuickSort is not thread safe
+ * (it draws pivots from a shared generator) */
+int candsort( const void *item1, const void *item2 ) {
 
-    short int d1, d2;
+    unsigned int d1, d2;
 
-    d1 = ( (SEED_HIT *) item1 )->pmin;
-    d2 = ( (SEED_HIT *) item2 )->pmin;
+    d1 = ( *(REFINDEX_HIT **) item1 )->prof;
+    d2 = ( *(REFINDEX_HIT **) item2 )->prof;
 
     if ( d1 > d2 )
         return 1;
@@ -98,39 +142,222 @@ int patcmp( const void *item1, const void *item2 ) {
 }
 
 /*******************************************************************************************/
-int candsort( const void *item1, const void *item2 ) {
+/* read scanning, reads of a batch are handed out to the threads in chunks of
+ * SCAN_CHUNK pairs, the links they produce are merged after the batch */
+#define SCAN_CHUNK ( 8 )
 
-    PROFILE *d1, *d2;
+typedef struct {
+    SCAN_WORKER *w;
+    size_t       start, count; // links of a read pair in w->links
+} SCAN_RESULT;
 
-    d1 = ( (SEED_HIT *) item1 )->prof;
-    d2 = ( (SEED_HIT *) item2 )->prof;
+typedef struct {
+    PROFILE **        reads; // read, read rc, read, read rc, ...
+    SCAN_RESULT *     results;
+    size_t            next, end; // pairs left in the current batch
+    int               quit;
+    unsigned char *   dt1;
+    pthread_mutex_t   lock;
+    pthread_barrier_t start, done;
+} SCAN_POOL;
 
-    if ( d1 > d2 )
-        return 1;
-    else if ( d1 < d2 )
-        return -1;
+typedef struct {
+    SCAN_POOL * pool;
+    SCAN_WORKER worker;
+    pthread_t   thread;
+} SCAN_THREAD;
 
-    return 0;
+/*******************************************************************************************/
+void scan_read(
+  SCAN_WORKER *w, PROFILE *prof1, PROFILE *prof1rc, unsigned char *dt1 ) {
+
+    int pmin, TRANGE;
+
+    pmin = min( prof1->patlen, prof1rc->patlen );
+
+    if ( pmin < 7 || pmin > MAXPROFILESIZE ) {
+        doCriticalErrorAndQuit(
+          "pmin(%d) must be in 7-%d range!", pmin, MAXPROFILESIZE );
+    }
+
+    TRANGE = Trange_Profile_Range[pmin];
+
+    if ( TRANGE > 0 ) {
+
+        w->candidates1->size = 0;
+        w->candidates2->size = 0;
+
+        if ( w->seedtrange != TRANGE ) {
+            free_seed_info( &w->seedstruct );
+            retrieve_seed_info( Trange_Seed[TRANGE], &w->seedstruct );
+            w->seedtrange = TRANGE;
+
+            if ( w->seedstruct.hasX )
+                doCriticalErrorAndQuit(
+                  "Seeds with X are not allowed in this version. Aborting!" );
+        }
+
+        if ( PackSequence(
+               &w->packed, prof1->seq->sequence, prof1->seq->length ) < 0 )
+            doCriticalErrorAndQuit( "Unable to pack a sequence of %d bases!",
+              prof1->seq->length );
+        _HCLUST_find_candidates( &w->packed, &w->seedstruct, TRANGE,
+          Trange_Tuple_Size[TRANGE], pmin, w->candidates1 );
+
+        if ( PackSequence(
+               &w->packed, prof1rc->seq->sequence, prof1rc->seq->length ) < 0 )
+            doCriticalErrorAndQuit( "Unable to pack a sequence of %d bases!",
+              prof1rc->seq->length );
+        _HCLUST_find_candidates( &w->packed, &w->seedstruct, TRANGE,
+          Trange_Tuple_Size[TRANGE], pmin, w->candidates2 );
+
+        qsort( w->candidates1->array, w->candidates1->size,
+          sizeof( void * ), candsort );
+        qsort( w->candidates2->array, w->candidates2->size,
+          sizeof( void * ), candsort );
+
+        _HCLUST_align_candidates( prof1, 0, pmin, w->candidates1, dt1, w );
+        _HCLUST_align_candidates( prof1rc, 1, pmin, w->candidates2, dt1, w );
+    }
 }
 
 /*******************************************************************************************/
-CLUSTERBASE *doSearchSimilarities(
-  FILE *fpi, FILE *fpi2, FILE *fpirot, FILE *fpi2rot, unsigned char *dt1 ) {
-
-    EASY_LIST *  profileList = NULL, *profileList2 = NULL, *tempList = NULL;
-    EASY_ARRAY * artemp, *iatemp;
-    EASY_NODE *  nof1, *nof2;
-    SEED_HIT *   shtemp;
-    GDHASH *     gdtemp;
-    EASY_NODE *  iter;
-    GDHITEM *    gdrack, *curr;
-    PROFPAIR *   profpair, *profpair2;
-    CLUSTERBASE *cb;
-    PROFILE *    prof1, *prof2, *prof1rc, *prof2rc;
-    int off1, i, j, pmin, TRANGE, NEWRANGE, lowerpat, higherpat, readcount,
-      readpercent;
-    size_t ui, uj;
-    char * src, *sequence;
+void scan_batch( SCAN_POOL *pool, SCAN_WORKER *w ) {
+
+    SCAN_RESULT *res;
+    size_t       first, last, ui;
+
+    while ( 1 ) {
+
+        pthread_mutex_lock( &pool->lock );
+        first      = pool->next;
+        last       = ( pool->end - first > SCAN_CHUNK ) ? first + SCAN_CHUNK
+                                                        : pool->end;
+        pool->next = last;
+        pthread_mutex_unlock( &pool->lock );
+
+        if ( first >= last )
+            break;
+
+        for ( ui = first; ui < last; ui++ ) {
+            res        = &pool->results[ui];
+            res->w     = w;
+            res->start = w->nlinks;
+            scan_read(
+              w, pool->reads[2 * ui], pool->reads[2 * ui + 1], pool->dt1 );
+            res->count = w->nlinks - res->start;
+        }
+    }
+}
+
+/*******************************************************************************************/
+void *scan_thread( void *arg ) {
+
+    SCAN_THREAD *st = (SCAN_THREAD *) arg;
+
+    while ( 1 ) {
+
+        pthread_barrier_wait( &st->pool->start );
+
+        if ( st->pool->quit )
+            break;
+
+        scan_batch( st->pool, &st->worker );
+        pthread_barrier_wait( &st->pool->done );
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************************/
+/* adds a PROFPAIR with its own rotation list to profileHash for every
+ * profile, rc profile pair in list */
+void AddProfilePairs( EASY_LIST *list ) {
+
+    EASY_NODE *nof1;
+    PROFPAIR * profpair;
+
+    for ( nof1 = list->head; nof1 != NULL; ) {
+        profpair         = scalloc( 1, sizeof( PROFPAIR ) );
+        profpair->prof   = (PROFILE *) EasyListItem( nof1 );
+        profpair->profrc = (PROFILE *) EasyListItem( nof1->next );
+
+        profpair->prof->rotlist = profpair->profrc->rotlist =
+          EasyListCreate( NULL, NULL );
+        EasyListInsertTail( profpair->prof->rotlist, profpair );
+
+        if ( NULL != GetSingleHashItem( profileHash, profpair->prof->key ) ) {
+            printf( "\nERROR: duplicate index %d!", profpair->prof->key );
+            exit( 1 );
+        }
+
+        SetSingleHashItem( profileHash, profpair->prof->key, profpair );
+
+        nof1 = nof1->next;
+        if ( nof1 != NULL ) {
+            nof1 = nof1->next;
+        }
+    }
+}
+
+/*******************************************************************************************/
+/* removes the pairs of list from profileHash, the profiles themselves are
+ * freed with the LEB36_FILE they were loaded into */
+void FreeProfilePairs( EASY_LIST *list ) {
+
+    EASY_NODE *nof1;
+    PROFPAIR * profpair;
+    PROFILE *  prof1;
+
+    for ( nof1 = list->head; nof1 != NULL; ) {
+        prof1 = (PROFILE *) EasyListItem( nof1 );
+
+        profpair = GetSingleHashItem( profileHash, prof1->key );
+        ClearSingleHashItem( profileHash, prof1->key );
+        EasyListDestroy( prof1->rotlist );
+        sfree( profpair );
+
+        nof1 = nof1->next;
+        if ( nof1 != NULL ) {
+            nof1 = nof1->next;
+        }
+    }
+}
+
+/*******************************************************************************************/
+/* loads the profile pairs of a file into list, they live in the returned file */
+LEB36_FILE *LoadProfileList( FILE *fp, EASY_LIST *list, int isread ) {
+
+    LEB36_FILE *lf;
+    size_t      ui;
+
+    lf = Leb36Load( fp, isread, NTHREADS );
+
+    if ( NULL == lf )
+        doCriticalErrorAndQuit( "Unable to map profiles file!" );
+
+    for ( ui = 0; ui < lf->nprofiles; ui++ ) {
+        EasyListInsertTail( list, lf->profiles[ui] );
+    }
+
+    return lf;
+}
+
+/*******************************************************************************************/
+/* loads the reference profiles and their seed index, done once per process */
+void doLoadReferences(
+  FILE *fpi, FILE *fpirot, const char *reffile, char *indexfile ) {
+
+    EASY_LIST *profileList = NULL, *tempList = NULL;
+    EASY_LIST *seedList = NULL;
+    EASY_NODE *        nof1;
+    long long          refsize, rotsize;
+    unsigned long long refdigest, rotdigest;
+    PROFILE *          prof1, *prof1rc;
+    int                pmin, TRANGE, NEWRANGE, lowerpat, higherpat;
+    size_t             ui;
+    char *             src;
+    PACKEDSEQ          packed = { 0 }, packedrc = { 0 };
 
     // initializations
     seedstruct.foffset[0] = NULL;
@@ -138,21 +365,12 @@ CLUSTERBASE *doSearchSimilarities(
     seedstruct.roffset[0] = NULL;
     seedstruct.roffset[1] = NULL;
 
-    init_complement_ascii();
     init_index();
     init_complement();
 
     blaststats.stTuplesProcessed = 0;
     blaststats.CellsProcessed    = 0;
 
-    blaststats.stCandidatesConsidered               = 0;
-    blaststats.stLCSalignments                      = 0;
-    blaststats.stProfileAlignments                  = 0;
-    blaststats.stProfileAlignmentsSuccess           = 0;
-    blaststats.stPairsConfirmedAfterFlankAlignments = 0;
-
-    // easy array of tuples, it automatically reallocs when grows bigger
-    Easy_Array_Tuples[0] = NULL;
     Trange_Tuple_Size[0] = 0;
     Trange_N_Codes[0]    = 0;
     Trange_Ones[0]       = 0;
@@ -266,17 +484,12 @@ CLUSTERBASE *doSearchSimilarities(
         // for arrays only
         if ( TRANGE <= MAX_ARRAY_TRANGE ) {
 
-            Trange_N_Codes[TRANGE]    = pow( 4, Trange_Ones[TRANGE] );
-            Easy_Array_Tuples[TRANGE] = (EASY_ARRAY **) scalloc(
-              Trange_N_Codes[TRANGE], sizeof( EASY_ARRAY ** ) );
-            Hash_Tuples[TRANGE] = NULL;
+            Trange_N_Codes[TRANGE] = pow( 4, Trange_Ones[TRANGE] );
 
             // for hashes only
         } else {
 
-            Trange_N_Codes[TRANGE]    = 0;
-            Easy_Array_Tuples[TRANGE] = NULL;
-            Hash_Tuples[TRANGE]       = (GDHASH *) CreateDoubleHash( 1000000 );
+            Trange_N_Codes[TRANGE] = 0;
         }
     }
 
@@ -317,131 +530,64 @@ CLUSTERBASE *doSearchSimilarities(
             Trange_Profile_Range[pmin] = 0;
     }
 
-    // create a clusterbase to find connections
-    cb = ClusterBaseCreate();
+    // create profile list
+    profileList = EasyListCreate( NULL, NULL );
 
-    // create profile lists
-    profileList  = EasyListCreate( NULL, NULL );
-    profileList2 = EasyListCreate( NULL, NULL );
+    // reference index, concurrent runs on the same refs wait for one build
+    RefIndexStamp( fpi, &refsize, &refdigest );
+    RefIndexStamp( fpirot, &rotsize, &rotdigest );
+    RefIndexPath( indexfile, reffile, refdigest );
+    flock( fileno( fpi ), LOCK_EX );
 
-    // read ref profiles into list
-    fprintf( stderr, "\nReading reference profiles..." );
+    fprintf( stderr, "\nOpening reference index..." );
     fflush( stderr );
-    off1 = 0;
-
-    while ( 1 ) {
+    RefIndex = RefIndexOpen( indexfile, refsize, refdigest, rotsize, rotdigest );
 
-        prof1   = NULL;
-        prof1rc = NULL;
-        prof1   = ReadProfileWithRC( fpi, off1, &prof1rc, 0 );
+    if ( RefIndex ) {
 
-        if ( NULL == prof1 || NULL == prof1rc )
-            break;
-
-        EasyListInsertTail( profileList, prof1 );
-        EasyListInsertTail( profileList, prof1rc );
-
-        off1 = prof1->nextoffset;
-    }
+        flock( fileno( fpi ), LOCK_UN );
 
-    fprintf( stderr, "(total time: %.1lf secs)",
-      (double) ( time( NULL ) - startTime ) );
-    fprintf( stderr, "\nLoaded %zu profiles from reference file!",
-      profileList->size / 2 );
-    fflush( stderr );
+        for ( ui = 0; ui < RefIndex->nprofiles; ui++ ) {
+            EasyListInsertTail( profileList, RefIndex->profiles[ui] );
+        }
 
-    // read read profiles into list
-    fprintf( stderr, "\nReading read profiles..." );
-    fflush( stderr );
-    off1 = 0;
+        fprintf( stderr, "(total time: %.1lf secs)",
+          (double) ( time( NULL ) - startTime ) );
+        fprintf( stderr, "\nLoaded %zu profiles from reference index!",
+          profileList->size / 2 );
+        fflush( stderr );
 
-    while ( 1 ) {
+    } else {
 
-        prof1   = NULL;
-        prof1rc = NULL;
-        prof1   = ReadProfileWithRC( fpi2, off1, &prof1rc, 1 );
+        fprintf( stderr, "not found or out of date." );
 
-        if ( NULL == prof1 || NULL == prof1rc )
-            break;
+        // read ref profiles into list
+        fprintf( stderr, "\nReading reference profiles..." );
+        fflush( stderr );
+        RefProfiles = LoadProfileList( fpi, profileList, 0 );
 
-        EasyListInsertTail( profileList2, prof1 );
-        EasyListInsertTail( profileList2, prof1rc );
+        for ( ui = 0; ui < RefProfiles->nprofiles; ui++ ) {
+            RefProfiles->profiles[ui]->ordinal = ui;
+        }
 
-        off1 = prof1->nextoffset;
+        fprintf( stderr, "(total time: %.1lf secs)",
+          (double) ( time( NULL ) - startTime ) );
+        fprintf( stderr, "\nLoaded %zu profiles from reference file!",
+          profileList->size / 2 );
+        fflush( stderr );
     }
 
-    fprintf( stderr, "(total time: %.1lf secs)",
-      (double) ( time( NULL ) - startTime ) );
-    fprintf( stderr, "\nLoaded %zu profiles from reads file!",
-      profileList2->size / 2 );
-    fflush( stderr );
-
-    // creating profile lookup hash
+    // creating profile lookup hash, reads are added per reads file
     fprintf( stderr, "\nCreating profile lookup hash..." );
     fflush( stderr );
-    {
-        unsigned int pread = 0;
-
-        profileHash =
-          CreateSingleHash( ( profileList->size + profileList2->size ) );
-
-        for ( nof1 = profileList->head; nof1 != NULL; ) {
-            profpair         = scalloc( 1, sizeof( PROFPAIR ) );
-            profpair->prof   = (PROFILE *) EasyListItem( nof1 );
-            profpair->profrc = (PROFILE *) EasyListItem( nof1->next );
-
-            profpair->prof->rotlist = profpair->profrc->rotlist =
-              EasyListCreate( NULL, NULL );
-            EasyListInsertTail( profpair->prof->rotlist, profpair );
-
-            if ( NULL !=
-                 GetSingleHashItem( profileHash, profpair->prof->key ) ) {
-                printf( "\nERROR: duplicate index %d!", profpair->prof->key );
-                exit( 1 );
-            }
-
-            SetSingleHashItem( profileHash, profpair->prof->key, profpair );
-
-            // if ((pread%1000)==0) printf("\nLoaded %u profiles",pread);
-
-            nof1 = nof1->next;
-            if ( nof1 != NULL ) {
-                nof1 = nof1->next;
-            }
-            pread++;
-        }
-
-        for ( nof1 = profileList2->head; nof1 != NULL; ) {
-
-            profpair         = scalloc( 1, sizeof( PROFPAIR ) );
-            profpair->prof   = (PROFILE *) EasyListItem( nof1 );
-            profpair->profrc = (PROFILE *) EasyListItem( nof1->next );
-
-            profpair->prof->rotlist = profpair->profrc->rotlist =
-              EasyListCreate( NULL, NULL );
-            EasyListInsertTail( profpair->prof->rotlist, profpair );
-
-            if ( NULL !=
-                 GetSingleHashItem( profileHash, profpair->prof->key ) ) {
-                printf( "\nERROR: duplicate index %d!", profpair->prof->key );
-                exit( 1 );
-            }
-
-            SetSingleHashItem( profileHash, profpair->prof->key, profpair );
-
-            // if ((pread%1000)==0) printf("\nLoaded %u profiles",pread);
-
-            nof1 = nof1->next;
-            if ( nof1 != NULL ) {
-                nof1 = nof1->next;
-            }
-            pread++;
-        }
-    }
+    profileHash = CreateSingleHash( profileList->size + READHASHSIZE );
+    AddProfilePairs( profileList );
     fprintf( stderr, "(total time: %.1lf secs)",
       (double) ( time( NULL ) - startTime ) );
 
     // redundcy files
+    seedList = profileList;
+
     if ( fpirot ) {
         fprintf( stderr, "\nUsing redundancy file to speed up alignments..." );
         fflush( stderr );
@@ -449,7 +595,7 @@ CLUSTERBASE *doSearchSimilarities(
         if ( 0 != LoadRotated( fpirot ) )
             doCriticalErrorAndQuit( "Error reading rotated refs file!" );
 
-        // if not masterrotated, remove from lists
+        // if not masterrotated, do not seed (the index keeps all refs)
         tempList = EasyListCreate( NULL, NULL );
 
         for ( nof1 = profileList->head; nof1 != NULL; ) {
@@ -467,371 +613,321 @@ CLUSTERBASE *doSearchSimilarities(
             }
         }
 
-        EasyListDestroy( profileList );
-        profileList = tempList;
+        seedList = tempList;
 
-        fprintf( stderr, "new ref list size %zu!", profileList->size / 2 );
+        fprintf( stderr, "new ref list size %zu!", seedList->size / 2 );
     }
 
-    if ( fpi2rot ) {
-        fprintf( stderr, "\nUsing redundancy file to speed up alignments..." );
-        fflush( stderr );
+    // build the index if there was no usable one
+    if ( NULL == RefIndex ) {
 
-        if ( 0 != LoadRotated( fpi2rot ) )
-            doCriticalErrorAndQuit( "Error reading rotated reads file!" );
+        memset( Seed_Tuples, 0, sizeof( Seed_Tuples ) );
 
-        // if not masterrotated, remove from lists
-        tempList = EasyListCreate( NULL, NULL );
+        // seed references
+        fprintf( stderr, "\nSeeding reference profiles' concensus sequences..." );
+        fflush( stderr );
+
+        for ( nof1 = seedList->head; nof1 != NULL; ) {
 
-        for ( nof1 = profileList2->head; nof1 != NULL; ) {
             prof1   = (PROFILE *) EasyListItem( nof1 );
             prof1rc = (PROFILE *) EasyListItem( nof1->next );
 
-            if ( 1 == prof1->rotationmaster ) {
-                EasyListInsertTail( tempList, prof1 );
-                EasyListInsertTail( tempList, prof1rc );
-            }
-
-            nof1 = nof1->next;
-            if ( nof1 != NULL ) {
-                nof1 = nof1->next;
-            }
-        }
-
-        EasyListDestroy( profileList2 );
-        profileList2 = tempList;
-
-        fprintf( stderr, "new read list size %zu!", profileList2->size / 2 );
-    }
-
-    // seed references
-    fprintf( stderr, "\nSeeding reference profiles' concensus sequences..." );
-    fflush( stderr );
-
-    for ( nof1 = profileList->head; nof1 != NULL; ) {
-
-        prof1   = (PROFILE *) EasyListItem( nof1 );
-        prof1rc = (PROFILE *) EasyListItem( nof1->next );
-
-        pmin = min( prof1->patlen, prof1rc->patlen );
-
-        if ( pmin < 7 || pmin > MAXPROFILESIZE ) {
-            doCriticalErrorAndQuit(
-              "pmin(%d) must be in 7-%d range!", pmin, MAXPROFILESIZE );
-        }
-
-        TRANGE = Trange_Profile_Range[pmin];
+            pmin = min( prof1->patlen, prof1rc->patlen );
 
-        if ( TRANGE > 0 ) {
-
-            // current range
-            free_seed_info( &seedstruct );
-            retrieve_seed_info( Trange_Seed[TRANGE], &seedstruct );
-
-            if ( seedstruct.hasX )
+            if ( pmin < 7 || pmin > MAXPROFILESIZE ) {
                 doCriticalErrorAndQuit(
-                  "Seeds with X are not allowed in this version. Aborting!" );
-
-            sequence = seqdupPlusTuple( prof1->seq->length,
-              prof1->seq->sequence, Trange_Tuple_Size[TRANGE] );
-            blaststats.stTuplesProcessed += _HCLUST_process_sequence( sequence,
-              &seedstruct, TRANGE, Trange_Tuple_Size[TRANGE], prof1, 0, pmin );
-            sfree( sequence );
-
-            sequence = seqdupPlusTuple( prof1rc->seq->length,
-              prof1rc->seq->sequence, Trange_Tuple_Size[TRANGE] );
-            blaststats.stTuplesProcessed +=
-              _HCLUST_process_sequence( sequence, &seedstruct, TRANGE,
-                Trange_Tuple_Size[TRANGE], prof1rc, 1, pmin );
-            sfree( sequence );
-
-            // lower range
-            lowerpat = pmin - (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
-                                      TRUNC_ROUND_CEIL );
+                  "pmin(%d) must be in 7-%d range!", pmin, MAXPROFILESIZE );
+            }
 
-            if ( lowerpat >= 7 &&
-                 Trange_Profile_Range[lowerpat] <= ( TRANGE - 1 ) ) {
+            TRANGE = Trange_Profile_Range[pmin];
 
-                NEWRANGE = TRANGE - 1;
+            if ( TRANGE > 0 ) {
 
+                // current range
                 free_seed_info( &seedstruct );
-                retrieve_seed_info( Trange_Seed[NEWRANGE], &seedstruct );
+                retrieve_seed_info( Trange_Seed[TRANGE], &seedstruct );
 
                 if ( seedstruct.hasX )
-                    doCriticalErrorAndQuit( "Seeds with X are not allowed in "
-                                            "this version. Aborting!" );
+                    doCriticalErrorAndQuit(
+                      "Seeds with X are not allowed in this version. Aborting!" );
+
+                // pack once for all ranges
+                if ( PackSequence(
+                       &packed, prof1->seq->sequence, prof1->seq->length ) <
+                       0 ||
+                     PackSequence( &packedrc, prof1rc->seq->sequence,
+                       prof1rc->seq->length ) < 0 )
+                    doCriticalErrorAndQuit(
+                      "Unable to pack a sequence of %d bases!",
+                      prof1->seq->length );
 
-                sequence = seqdupPlusTuple( prof1->seq->length,
-                  prof1->seq->sequence, Trange_Tuple_Size[NEWRANGE] );
                 blaststats.stTuplesProcessed +=
-                  _HCLUST_process_sequence( sequence, &seedstruct, NEWRANGE,
-                    Trange_Tuple_Size[NEWRANGE], prof1, 0, pmin );
-                sfree( sequence );
-
-                sequence = seqdupPlusTuple( prof1rc->seq->length,
-                  prof1rc->seq->sequence, Trange_Tuple_Size[NEWRANGE] );
+                  _HCLUST_process_sequence( &packed, &seedstruct, TRANGE,
+                    Trange_Tuple_Size[TRANGE], prof1, 0, pmin );
                 blaststats.stTuplesProcessed +=
-                  _HCLUST_process_sequence( sequence, &seedstruct, NEWRANGE,
-                    Trange_Tuple_Size[NEWRANGE], prof1rc, 1, pmin );
-                sfree( sequence );
-            }
+                  _HCLUST_process_sequence( &packedrc, &seedstruct, TRANGE,
+                    Trange_Tuple_Size[TRANGE], prof1rc, 1, pmin );
 
-            // higher range
-            higherpat = pmin + (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
-                                       TRUNC_ROUND_CEIL );
+                // lower range
+                lowerpat = pmin - (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
+                                          TRUNC_ROUND_CEIL );
 
-            if ( Trange_Profile_Range[higherpat] >= ( TRANGE + 1 ) ) {
+                if ( lowerpat >= 7 &&
+                     Trange_Profile_Range[lowerpat] <= ( TRANGE - 1 ) ) {
 
-                NEWRANGE = TRANGE + 1;
+                    NEWRANGE = TRANGE - 1;
 
-                free_seed_info( &seedstruct );
-                retrieve_seed_info( Trange_Seed[NEWRANGE], &seedstruct );
+                    free_seed_info( &seedstruct );
+                    retrieve_seed_info( Trange_Seed[NEWRANGE], &seedstruct );
 
-                if ( seedstruct.hasX )
-                    doCriticalErrorAndQuit( "Seeds with X are not allowed in "
-                                            "this version. Aborting!" );
+                    if ( seedstruct.hasX )
+                        doCriticalErrorAndQuit( "Seeds with X are not allowed in "
+                                                "this version. Aborting!" );
 
-                sequence = seqdupPlusTuple( prof1->seq->length,
-                  prof1->seq->sequence, Trange_Tuple_Size[NEWRANGE] );
-                blaststats.stTuplesProcessed +=
-                  _HCLUST_process_sequence( sequence, &seedstruct, NEWRANGE,
-                    Trange_Tuple_Size[NEWRANGE], prof1, 0, pmin );
-                sfree( sequence );
+                    blaststats.stTuplesProcessed +=
+                      _HCLUST_process_sequence( &packed, &seedstruct, NEWRANGE,
+                        Trange_Tuple_Size[NEWRANGE], prof1, 0, pmin );
 
-                sequence = seqdupPlusTuple( prof1rc->seq->length,
-                  prof1rc->seq->sequence, Trange_Tuple_Size[NEWRANGE] );
-                blaststats.stTuplesProcessed +=
-                  _HCLUST_process_sequence( sequence, &seedstruct, NEWRANGE,
-                    Trange_Tuple_Size[NEWRANGE], prof1rc, 1, pmin );
-                sfree( sequence );
-            }
-        }
+                    blaststats.stTuplesProcessed +=
+                      _HCLUST_process_sequence( &packedrc, &seedstruct, NEWRANGE,
+                        Trange_Tuple_Size[NEWRANGE], prof1rc, 1, pmin );
+                }
 
-        nof1 = nof1->next;
-        if ( nof1 != NULL ) {
-            nof1 = nof1->next;
-        }
-    }
+                // higher range
+                higherpat = pmin + (int) ( pmin * PATLEN_SIZE_ERR_FRACTION +
+                                           TRUNC_ROUND_CEIL );
 
-    fprintf( stderr, "(total time: %.1lf secs)",
-      (double) ( time( NULL ) - startTime ) );
+                if ( Trange_Profile_Range[higherpat] >= ( TRANGE + 1 ) ) {
 
-    // sort
-    fprintf( stderr, "\nSorting ref seed arrays..." );
-    fflush( stderr );
+                    NEWRANGE = TRANGE + 1;
 
-    for ( TRANGE = 1; TRANGE <= MAX_LIST_TRANGE; TRANGE++ ) {
+                    free_seed_info( &seedstruct );
+                    retrieve_seed_info( Trange_Seed[NEWRANGE], &seedstruct );
 
-        if ( TRANGE <= MAX_ARRAY_TRANGE ) {
+                    if ( seedstruct.hasX )
+                        doCriticalErrorAndQuit( "Seeds with X are not allowed in "
+                                                "this version. Aborting!" );
 
-            for ( ui = 0; ui < Trange_N_Codes[TRANGE]; ui++ ) {
-                if ( ( artemp = Easy_Array_Tuples[TRANGE][ui] ) ) {
-                    EasyArrayQuickSort( artemp, patcmp );
+                    blaststats.stTuplesProcessed +=
+                      _HCLUST_process_sequence( &packed, &seedstruct, NEWRANGE,
+                        Trange_Tuple_Size[NEWRANGE], prof1, 0, pmin );
+
+                    blaststats.stTuplesProcessed +=
+                      _HCLUST_process_sequence( &packedrc, &seedstruct, NEWRANGE,
+                        Trange_Tuple_Size[NEWRANGE], prof1rc, 1, pmin );
                 }
             }
 
-        } else {
-
-            for ( iter = Hash_Tuples[TRANGE]->walker->head; iter != NULL;
-                  iter = iter->next ) {
-                ui     = *(size_t *) EasyListItem( iter );
-                gdrack = Hash_Tuples[TRANGE]->rack[ui];
-
-                while ( gdrack ) {
-                    curr   = gdrack;
-                    gdrack = gdrack->next;
-                    artemp = (EASY_ARRAY *) ( curr->data );
-                    EasyArrayQuickSort( artemp, patcmp );
-                }
+            nof1 = nof1->next;
+            if ( nof1 != NULL ) {
+                nof1 = nof1->next;
             }
         }
-    }
 
-    fprintf( stderr, "(total time: %.1lf secs)",
-      (double) ( time( NULL ) - startTime ) );
+        fprintf( stderr, "(total time: %.1lf secs)",
+          (double) ( time( NULL ) - startTime ) );
 
-    // Optimizing ref seed arrays and creating ref patsize lookups
-    fprintf( stderr,
-      "\nOptimizing ref seed arrays and creating ref patsize lookups..." );
-    fflush( stderr );
-    Array_Tuples[0]        = NULL;
-    Array_Tuples_Length[0] = 0;
-    Array_Tuples_Index[0]  = NULL;
-
-    for ( TRANGE = 1; TRANGE <= MAX_LIST_TRANGE; TRANGE++ ) {
+        // sort and write the ref index
+        fprintf( stderr, "\nWriting reference index..." );
+        fflush( stderr );
 
-        if ( TRANGE <= MAX_ARRAY_TRANGE ) {
+        RefIndex = RefIndexBuild(
+          profileList, Seed_Tuples, refsize, refdigest, rotsize, rotdigest );
 
-            int prev_pat;
-
-            Array_Tuples[TRANGE] = (SEED_HIT **) scalloc(
-              Trange_N_Codes[TRANGE], sizeof( *( Array_Tuples[TRANGE] ) ) );
-            Array_Tuples_Length[TRANGE] = scalloc( Trange_N_Codes[TRANGE],
-              sizeof( *( Array_Tuples_Length[TRANGE] ) ) );
-            Array_Tuples_Index[TRANGE]  = (EASY_ARRAY **) scalloc(
-              Trange_N_Codes[TRANGE], sizeof( EASY_ARRAY ** ) );
-
-            for ( ui = 0; ui < Trange_N_Codes[TRANGE]; ui++ ) {
-                if ( ( artemp = Easy_Array_Tuples[TRANGE][ui] ) ) {
-                    Array_Tuples[TRANGE][ui] =
-                      ( shtemp = (SEED_HIT *) scalloc(
-                          artemp->size, sizeof( SEED_HIT ) ) );
-                    Array_Tuples_Index[TRANGE][ui] =
-                      ( iatemp = EasyArrayCreate( 2, NULL, NULL ) );
-
-                    for ( uj = 0; uj < artemp->size; uj++ ) {
-                        shtemp[uj] = *(SEED_HIT *) artemp->array[uj];
-
-                        if ( uj == 0 || shtemp[uj].pmin != prev_pat ) {
-                            prev_pat = shtemp[uj].pmin;
-                            EasyArrayInsert( iatemp, &shtemp[uj] );
-                        }
-                    }
+        if ( 0 != RefIndexWrite( RefIndex, indexfile ) ) {
+            fprintf( stderr,
+              "unable to write '%s', using index from memory...", indexfile );
+        }
 
-                    Array_Tuples_Length[TRANGE][ui] = artemp->size;
-                    EasyArrayDestroy( artemp );
-                }
-            }
+        flock( fileno( fpi ), LOCK_UN );
 
-            sfree( Easy_Array_Tuples[TRANGE] );
-            Easy_Array_Tuples[TRANGE] = NULL;
+        // seed lists are no longer needed
+        FreePackedSequence( &packed );
+        FreePackedSequence( &packedrc );
 
-        } else {
+        for ( TRANGE = 1; TRANGE <= MAX_LIST_TRANGE; TRANGE++ ) {
+            free( Seed_Tuples[TRANGE].seeds );
+            Seed_Tuples[TRANGE].seeds  = NULL;
+            Seed_Tuples[TRANGE].nseeds = Seed_Tuples[TRANGE].maxseeds = 0;
+        }
 
-            int prev_pat;
+        fprintf( stderr, "(total time: %.1lf secs)",
+          (double) ( time( NULL ) - startTime ) );
+    }
 
-            Array_Tuples[TRANGE]        = NULL;
-            Array_Tuples_Length[TRANGE] = 0;
-            Array_Tuples_Index[TRANGE]  = NULL;
+    if ( seedList != profileList )
+        EasyListDestroy( seedList );
 
-            for ( iter = Hash_Tuples[TRANGE]->walker->head; iter != NULL;
-                  iter = iter->next ) {
-                ui = *(size_t *) EasyListItem( iter );
+    // profiles stay reachable through RefIndex->profiles
+    EasyListDestroy( profileList );
+}
 
-                gdrack = Hash_Tuples[TRANGE]->rack[ui];
+/*******************************************************************************************/
+/* scans one reads file against the loaded references */
+CLUSTERBASE *doSearchSimilarities(
+  FILE *fpi2, FILE *fpi2rot, unsigned char *dt1 ) {
 
-                while ( gdrack ) {
-                    curr   = gdrack;
-                    gdrack = gdrack->next;
-                    artemp = (EASY_ARRAY *) ( curr->data );
+    EASY_LIST *  profileList2 = NULL, *readList = NULL, *tempList = NULL;
+    EASY_NODE *  nof1;
+    CLUSTERBASE *cb;
+    PROFILE *    prof1, *prof1rc;
+    int          i, readcount, readpercent;
+    SCAN_POOL    pool;
+    SCAN_THREAD *threads;
+    SCAN_WORKER *w;
+    size_t       npairs, pair, end;
+    size_t       ui;
+    LEB36_FILE * readFile;
 
-                    ( shtemp = (SEED_HIT *) scalloc(
-                        artemp->size, sizeof( SEED_HIT ) ) );
-                    iatemp = EasyArrayCreate( 2, NULL, NULL );
+    blaststats.stCandidatesConsidered               = 0;
+    blaststats.stLCSalignments                      = 0;
+    blaststats.stProfileAlignments                  = 0;
+    blaststats.stProfileAlignmentsSuccess           = 0;
+    blaststats.stPairsConfirmedAfterFlankAlignments = 0;
 
-                    for ( uj = 0; uj < artemp->size; uj++ ) {
-                        shtemp[uj] = *(SEED_HIT *) artemp->array[uj];
+    // create a clusterbase to find connections
+    cb = ClusterBaseCreate();
 
-                        if ( uj == 0 || shtemp[uj].pmin != prev_pat ) {
-                            prev_pat = shtemp[uj].pmin;
-                            EasyArrayInsert( iatemp, &shtemp[uj] );
-                        }
-                    }
+    // create profile list
+    profileList2 = EasyListCreate( NULL, NULL );
 
-                    curr->length = artemp->size;
-                    EasyArrayDestroy( artemp );
-                    curr->data  = (void *) shtemp;
-                    curr->index = (void *) iatemp;
-                }
-            }
-        }
-    }
+    // read read profiles into list
+    fprintf( stderr, "\nReading read profiles..." );
+    fflush( stderr );
+    readFile = LoadProfileList( fpi2, profileList2, 1 );
 
     fprintf( stderr, "(total time: %.1lf secs)",
       (double) ( time( NULL ) - startTime ) );
+    fprintf( stderr, "\nLoaded %zu profiles from reads file!",
+      profileList2->size / 2 );
+    fflush( stderr );
 
-    // Rehashing ref hashes to optimal sizes
-    fprintf( stderr, "\nRehashing ref hashes to optimal sizes..." );
+    // adding to profile lookup hash
+    fprintf( stderr, "\nAdding reads to profile lookup hash..." );
     fflush( stderr );
+    AddProfilePairs( profileList2 );
+    fprintf( stderr, "(total time: %.1lf secs)",
+      (double) ( time( NULL ) - startTime ) );
+
+    // redundcy file
+    readList = profileList2;
 
-    for ( TRANGE = MAX_ARRAY_TRANGE + 1; TRANGE <= MAX_LIST_TRANGE; TRANGE++ ) {
+    if ( fpi2rot ) {
+        fprintf( stderr, "\nUsing redundancy file to speed up alignments..." );
+        fflush( stderr );
 
-        gdtemp = (GDHASH *) CreateDoubleHash( Hash_Tuples[TRANGE]->nitems * 2 );
+        if ( 0 != LoadRotated( fpi2rot ) )
+            doCriticalErrorAndQuit( "Error reading rotated reads file!" );
 
-        for ( iter = Hash_Tuples[TRANGE]->walker->head; iter != NULL;
-              iter = iter->next ) {
-            ui     = *(size_t *) EasyListItem( iter );
-            gdrack = Hash_Tuples[TRANGE]->rack[ui];
+        // if not masterrotated, remove from lists
+        tempList = EasyListCreate( NULL, NULL );
 
-            while ( gdrack ) {
-                curr   = gdrack;
-                gdrack = gdrack->next;
-                SetDoubleHashItem( gdtemp, curr->key1, curr->key2, curr->data,
-                  curr->index, curr->length );
+        for ( nof1 = profileList2->head; nof1 != NULL; ) {
+            prof1   = (PROFILE *) EasyListItem( nof1 );
+            prof1rc = (PROFILE *) EasyListItem( nof1->next );
+
+            if ( 1 == prof1->rotationmaster ) {
+                EasyListInsertTail( tempList, prof1 );
+                EasyListInsertTail( tempList, prof1rc );
+            }
+
+            nof1 = nof1->next;
+            if ( nof1 != NULL ) {
+                nof1 = nof1->next;
             }
         }
 
-        DestroyDoubleHash( Hash_Tuples[TRANGE], NULL );
-        Hash_Tuples[TRANGE] = gdtemp;
-    }
+        profileList2 = tempList;
 
-    fprintf( stderr, "(total time: %.1lf secs)",
-      (double) ( time( NULL ) - startTime ) );
+        fprintf( stderr, "new read list size %zu!", profileList2->size / 2 );
+    }
 
     // scanning reads
-    fprintf( stderr, "\nScanning reads..." );
+    fprintf( stderr, "\nScanning reads (%d threads)...", NTHREADS );
     fflush( stderr );
     readcount   = 0;
     readpercent = 0;
 
-    for ( nof1 = profileList2->head; nof1 != NULL; ) {
+    npairs       = profileList2->size / 2;
+    pool.reads   = scalloc( 2 * npairs + 1, sizeof( PROFILE * ) );
+    pool.results = scalloc( npairs + 1, sizeof( SCAN_RESULT ) );
+    pool.next    = 0;
+    pool.end     = 0;
+    pool.quit    = 0;
+    pool.dt1     = dt1;
+
+    for ( ui = 0, nof1 = profileList2->head; nof1 != NULL;
+          nof1 = nof1->next, ui++ ) {
+        pool.reads[ui] = (PROFILE *) EasyListItem( nof1 );
+    }
 
-        prof1   = (PROFILE *) EasyListItem( nof1 );
-        prof1rc = (PROFILE *) EasyListItem( nof1->next );
+    pthread_mutex_init( &pool.lock, NULL );
+    pthread_barrier_init( &pool.start, NULL, NTHREADS );
+    pthread_barrier_init( &pool.done, NULL, NTHREADS );
 
-        pmin = min( prof1->patlen, prof1rc->patlen );
+    // the main thread is worker 0
+    threads = scalloc( NTHREADS, sizeof( SCAN_THREAD ) );
 
-        if ( pmin < 7 || pmin > MAXPROFILESIZE ) {
-            doCriticalErrorAndQuit(
-              "pmin(%d) must be in 7-%d range!", pmin, MAXPROFILESIZE );
-        }
+    for ( i = 0; i < NTHREADS; i++ ) {
+        threads[i].pool               = &pool;
+        threads[i].worker.candidates1 = EasyArrayCreate( 100, NULL, NULL );
+        threads[i].worker.candidates2 = EasyArrayCreate( 100, NULL, NULL );
+        threads[i].worker.pac         = CreatePAContext();
 
-        TRANGE = Trange_Profile_Range[pmin];
+        if ( NULL == threads[i].worker.pac )
+            doCriticalErrorAndQuit( "Unable to allocate alignment workspace!" );
 
-        if ( TRANGE > 0 ) {
+        ED_batch_init( &threads[i].worker.edbatch );
 
-            EASY_ARRAY *candidates1 = EasyArrayCreate( 100, NULL, NULL );
-            EASY_ARRAY *candidates2 = EasyArrayCreate( 100, NULL, NULL );
+        if ( i > 0 && 0 != pthread_create( &threads[i].thread, NULL,
+                             scan_thread, &threads[i] ) ) {
+            doCriticalErrorAndQuit( "Unable to create scanning thread!" );
+        }
+    }
 
-            free_seed_info( &seedstruct );
-            retrieve_seed_info( Trange_Seed[TRANGE], &seedstruct );
+    for ( pair = 0; pair < npairs; pair = end ) {
 
-            if ( seedstruct.hasX )
-                doCriticalErrorAndQuit(
-                  "Seeds with X are not allowed in this version. Aborting!" );
+        // run up to the read at which the next progress line is due
+        end = pair;
 
-            // fprintf(stderr,"\nreadcount: %d => candidates1: %d candidates2:
-            // %d (key: %d, pmin: %d, TRANGE: %d, read: %s, readrc:
-            // %s)",readcount/2,candidates1->size,candidates2->size,prof1->key,pmin,TRANGE,prof1->seq->sequence,prof1rc->seq->sequence);
-            // fflush(stderr);
+        do {
+            end++;
+        } while ( end < npairs &&
+                  (int) ( 100 * 2 * end / (double) profileList2->size ) <
+                    readpercent );
 
-            sequence = seqdupPlusTuple( prof1->seq->length,
-              prof1->seq->sequence, Trange_Tuple_Size[TRANGE] );
-            _HCLUST_find_candidates( sequence, prof1->seq, &seedstruct, TRANGE,
-              Trange_Tuple_Size[TRANGE], 0, pmin, candidates1 );
-            sfree( sequence );
+        pool.next = pair;
+        pool.end  = end;
 
-            sequence = seqdupPlusTuple( prof1rc->seq->length,
-              prof1rc->seq->sequence, Trange_Tuple_Size[TRANGE] );
-            _HCLUST_find_candidates( sequence, prof1rc->seq, &seedstruct,
-              TRANGE, Trange_Tuple_Size[TRANGE], 1, pmin, candidates2 );
-            sfree( sequence );
+        if ( NTHREADS > 1 )
+            pthread_barrier_wait( &pool.start );
 
-            EasyArrayQuickSort( candidates1, candsort );
-            EasyArrayQuickSort( candidates2, candsort );
+        scan_batch( &pool, &threads[0].worker );
 
-            _HCLUST_align_candidates( prof1, 0, pmin, candidates1, dt1, cb );
-            _HCLUST_align_candidates( prof1rc, 1, pmin, candidates2, dt1, cb );
+        if ( NTHREADS > 1 )
+            pthread_barrier_wait( &pool.done );
 
-            EasyArrayDestroy( candidates1 );
-            EasyArrayDestroy( candidates2 );
+        // merge links in read order and collect stats
+        for ( ui = pair; ui < end; ui++ ) {
+            _HCLUST_commit_links( cb,
+              pool.results[ui].w->links + pool.results[ui].start,
+              pool.results[ui].count );
         }
 
-        nof1 = nof1->next;
-        if ( nof1 != NULL ) {
-            nof1 = nof1->next;
+        for ( i = 0; i < NTHREADS; i++ ) {
+            w = &threads[i].worker;
+            blaststats.stCandidatesConsidered += w->stats.stCandidatesConsidered;
+            blaststats.stLCSalignments += w->stats.stLCSalignments;
+            blaststats.stProfileAlignments += w->stats.stProfileAlignments;
+            blaststats.stProfileAlignmentsSuccess +=
+              w->stats.stProfileAlignmentsSuccess;
+            blaststats.stPairsConfirmedAfterFlankAlignments +=
+              w->stats.stPairsConfirmedAfterFlankAlignments;
+            memset( &w->stats, 0, sizeof( w->stats ) );
+            w->nlinks = 0;
         }
-        readcount += 2;
+
+        readcount = 2 * end;
 
         if ( (int) ( 100 * readcount / (double) profileList2->size ) >=
              readpercent ) {
@@ -844,6 +940,44 @@ CLUSTERBASE *doSearchSimilarities(
         }
     }
 
+    // stop the pool
+    pool.quit = 1;
+
+    if ( NTHREADS > 1 )
+        pthread_barrier_wait( &pool.start );
+
+    for ( i = 0; i < NTHREADS; i++ ) {
+
+        if ( i > 0 )
+            pthread_join( threads[i].thread, NULL );
+
+        w = &threads[i].worker;
+        free_seed_info( &w->seedstruct );
+        EasyArrayDestroy( w->candidates1 );
+        EasyArrayDestroy( w->candidates2 );
+        FreePackedSequence( &w->packed );
+        LCS_batch_free( &w->lcs );
+        FreePAContext( w->pac );
+        Edit_Distance_multiple_word_NoEndPenaltySeq1_Free( &w->edleft[0] );
+        Edit_Distance_multiple_word_NoEndPenaltySeq1_Free( &w->edleft[1] );
+        Edit_Distance_multiple_word_NoEndPenaltySeq1_Free( &w->edright[0] );
+        Edit_Distance_multiple_word_NoEndPenaltySeq1_Free( &w->edright[1] );
+        ED_batch_free( &w->edbatch );
+        free( w->checks );
+        free( w->batchhits );
+        free( w->batchseqs );
+        free( w->batchlens );
+        free( w->batchkeep );
+        free( w->links );
+    }
+
+    pthread_barrier_destroy( &pool.start );
+    pthread_barrier_destroy( &pool.done );
+    pthread_mutex_destroy( &pool.lock );
+    sfree( threads );
+    sfree( pool.reads );
+    sfree( pool.results );
+
     fprintf( stderr,
       "\nscan finished!\n\t"
       "CandidatesConsidered: %llu\n\t"
@@ -862,21 +996,111 @@ CLUSTERBASE *doSearchSimilarities(
 
     fflush( stderr );
 
+    // reads are done, references stay for the next file
+    if ( profileList2 != readList )
+        EasyListDestroy( profileList2 );
+
+    FreeProfilePairs( readList );
+    EasyListDestroy( readList );
+    Leb36Free( readFile );
+
     return cb;
 }
 
+/*******************************************************************************************/
+int filenamecmp( const void *item1, const void *item2 ) {
+    return strcmp( (const char *) item1, (const char *) item2 );
+}
+
+/*******************************************************************************************/
+/* name is a reads file, a directory of .leb36 files or @FILE listing one reads
+ * file per line. multi is set for the last two. */
+EASY_LIST *ListReadFiles( char *name, int *multi ) {
+
+    EASY_LIST *    files = EasyListCreate( NULL, free );
+    FILE *         fp;
+    DIR *          dir;
+    struct dirent *entry;
+    struct stat    st;
+    char           line[1000], *path;
+    size_t         len;
+
+    *multi = 1;
+
+    if ( '@' == name[0] ) {
+
+        if ( NULL == ( fp = fopen( name + 1, "r" ) ) ) {
+            doCriticalErrorAndQuit( "Unable to open reads list '%s'!", name + 1 );
+        }
+
+        while ( fgets( line, sizeof( line ), fp ) ) {
+            len = strcspn( line, "\r\n" );
+            line[len] = '\0';
+
+            if ( len > 0 && '#' != line[0] )
+                EasyListInsertTail( files, strdup( line ) );
+        }
+
+        fclose( fp );
+
+    } else if ( 0 == stat( name, &st ) && S_ISDIR( st.st_mode ) ) {
+
+        if ( NULL == ( dir = opendir( name ) ) ) {
+            doCriticalErrorAndQuit( "Unable to open directory '%s'!", name );
+        }
+
+        while ( ( entry = readdir( dir ) ) ) {
+            len = strlen( entry->d_name );
+
+            if ( ( len > 6 &&
+                   0 == strcmp( entry->d_name + len - 6, ".leb36" ) ) ||
+                 ( len > strlen( PROFBIN_EXT ) &&
+                   0 == strcmp( entry->d_name + len - strlen( PROFBIN_EXT ),
+                          PROFBIN_EXT ) ) ) {
+                path = smalloc( strlen( name ) + len + strlen( PROFBIN_EXT ) + 2 );
+                sprintf( path, "%s/%s", name, entry->d_name );
+
+                // a .leb36 converted to binary is read from the binary file
+                if ( 0 == strcmp( entry->d_name + len - 6, ".leb36" ) ) {
+                    strcpy( path + strlen( path ) - 6, PROFBIN_EXT );
+
+                    if ( 0 == stat( path, &st ) ) {
+                        free( path );
+                        continue;
+                    }
+
+                    sprintf( path, "%s/%s", name, entry->d_name );
+                }
+
+                EasyListInsertTail( files, path );
+            }
+        }
+
+        closedir( dir );
+        EasyListQuickSort( files, filenamecmp );
+
+    } else {
+
+        *multi = 0;
+        EasyListInsertTail( files, strdup( name ) );
+    }
+
+    return files;
+}
+
 /*******************************************************************************************/
 int main( int argc, char **argv ) {
     FILE *         fpiRefs, *fpirot, *fpiReads, *fpi2rot, *fpo;
-    int            cutoff2;
+    int            cutoff2, i, multiFile, savedStderr = -1, fd;
     unsigned char *dt1;
     CLUSTERBASE *  cb;
+    EASY_LIST *    readFiles;
+    EASY_NODE *    nof1;
+    size_t         filecount = 0;
     char           inputfile[1000] = "", inputfile2[1000] = "", *edgesIn = NULL;
     char buffer[1000] = "", distfile1[1000] = "", outputfile[1000] = "",
-         mapfile[1000] = "", edgesfile[1000] = "";
-
-    // printf("\nseed_hit size: %d",sizeof(SEED_HIT));
-    // exit(1);
+         mapfile[1000] = "", edgesfile[1000] = "", indexfile[1000] = "",
+         *readsfile;
 
     // verify parameter count
     if ( argc < 7 ) {
@@ -886,11 +1110,21 @@ int main( int argc, char **argv ) {
           "\n\nUsage:  %s REFPROFILES READPROFILES DISTANCEFILE CUTOFF(70-100) "
           "MAXERRORS MAXFLANKCONSIDERED [EDGESINFILE] [OPTION]\n\n",
           argv[0] );
+        printf( "\tREADPROFILES may be a directory of .leb36 files or @FILE "
+                "listing one reads file per line,\n\tthe references are then "
+                "loaded once and every reads file gets its own .clu, .map "
+                "and .proclu_log\n\n" );
         printf( "\tOPTIONS: \n" );
         printf( "\t\t-r ref-to-ref alignments, only one flank has to match, 50 "
                 "is default length but may be followed by integer flank "
                 "length, ex -r 50 \n" );
         printf( "\t\t-m produce map file  \n" );
+        printf( "\t\t-t number of threads scanning reads, ex -t 8 \n" );
+        printf( "\n\tREFPROFILES%s is created on first use and reused while "
+                "the content of REFPROFILES is unchanged,\n\tin the "
+                "directory %s names if it is set (named by the digest\n\tof "
+                "REFPROFILES there)\n",
+          REFINDEX_EXT, REFINDEX_DIR_ENV );
         printf( "\n" );
         exit( 1 );
     }
@@ -899,8 +1133,6 @@ int main( int argc, char **argv ) {
     strcpy( inputfile, argv[1] );
     strcpy( inputfile2, argv[2] );
     strcpy( distfile1, argv[3] );
-    sprintf( outputfile, "%s.clu", inputfile2 );
-    sprintf( mapfile, "%s.map", inputfile2 );
     sprintf( edgesfile, "%s.edges", inputfile2 );
     sscanf( argv[4], "%d", &cutoff2 );
 
@@ -916,77 +1148,44 @@ int main( int argc, char **argv ) {
                                   // Set this to anything and use -r [reflen]
                                   // for ref-to-ref flank shortening.
 
-    // is option the next to last parameter?
-    if ( argc >= 8 &&
-         ( 0 == strcmp( argv[7], "-r" ) || 0 == strcmp( argv[7], "-R" ) ) ) {
-
-        OPTION = 'R';
+    // is the first optional parameter the EDGESIN file?
+    edgesIn = ( argc >= 8 && '-' != argv[7][0] ) ? argv[7] : NULL;
 
-        if ( argc >= 9 && 0 != atoi( argv[8] ) ) {
-            REFLEN = atoi( argv[8] );
-        }
-
-        // if not, is it the EDGESIN file?
-    } else {
-
-        edgesIn = ( argc >= 8 ) ? argv[7] : NULL;
-
-        if ( edgesIn &&
-             0 != strcmp( edgesIn + strlen( edgesIn ) - 7, ".edgein" ) ) {
-            printf(
-              "\nERROR: Please make sure edgesin file has extension .edgein!" );
-            exit( 1 );
-        }
+    if ( edgesIn &&
+         0 != strcmp( edgesIn + strlen( edgesIn ) - 7, ".edgein" ) ) {
+        printf(
+          "\nERROR: Please make sure edgesin file has extension .edgein!" );
+        exit( 1 );
     }
 
-    // -r
-    if ( argc >= 9 &&
-         ( 0 == strcmp( argv[8], "-r" ) || 0 == strcmp( argv[8], "-R" ) ) ) {
+    // options
+    for ( i = 7; i < argc; i++ ) {
 
-        OPTION = 'R';
+        // -r
+        if ( 0 == strcmp( argv[i], "-r" ) || 0 == strcmp( argv[i], "-R" ) ) {
 
-        if ( argc >= 10 && 0 != atoi( argv[9] ) ) {
-            REFLEN = atoi( argv[9] );
-        }
-    }
+            OPTION = 'R';
 
-    if ( argc >= 10 &&
-         ( 0 == strcmp( argv[9], "-r" ) || 0 == strcmp( argv[9], "-R" ) ) ) {
-
-        OPTION = 'R';
-
-        if ( argc >= 11 && 0 != atoi( argv[10] ) ) {
-            REFLEN = atoi( argv[10] );
+            if ( i + 1 < argc && 0 != atoi( argv[i + 1] ) ) {
+                REFLEN = atoi( argv[++i] );
+            }
         }
-    }
-
-    // -m
-    if ( argc >= 8 &&
-         ( 0 == strcmp( argv[7], "-m" ) || 0 == strcmp( argv[7], "-M" ) ) ) {
-
-        OPTION2 = 'M';
-    }
-
-    if ( argc >= 9 &&
-         ( 0 == strcmp( argv[8], "-m" ) || 0 == strcmp( argv[8], "-M" ) ) ) {
-
-        OPTION2 = 'M';
-    }
 
-    if ( argc >= 10 &&
-         ( 0 == strcmp( argv[9], "-m" ) || 0 == strcmp( argv[9], "-M" ) ) ) {
+        // -m
+        else if ( 0 == strcmp( argv[i], "-m" ) ||
+                  0 == strcmp( argv[i], "-M" ) ) {
 
-        OPTION2 = 'M';
-    }
+            OPTION2 = 'M';
+        }
 
-    // open map file
-    if ( OPTION2 == 'M' ) {
-        MAPFILE = fopen( mapfile, "w" );
+        // -t
+        else if ( 0 == strcmp( argv[i], "-t" ) ||
+                  0 == strcmp( argv[i], "-T" ) ) {
 
-        if ( MAPFILE == NULL ) {
-            fprintf(
-              stderr, "\nERROR: Unable to open mapfile file '%s'", mapfile );
-            exit( 1 );
+            if ( i + 1 >= argc || ( NTHREADS = atoi( argv[++i] ) ) < 1 ) {
+                printf( "\nERROR: -t must be followed by number of threads!" );
+                exit( 1 );
+            }
         }
     }
 
@@ -1010,12 +1209,12 @@ int main( int argc, char **argv ) {
         exit( 1 );
     }
 
-    // open the reads input file for reading
-    fpiReads = fopen( inputfile2, "r" );
+    // list reads files
+    readFiles = ListReadFiles( inputfile2, &multiFile );
 
-    if ( fpiReads == NULL ) {
+    if ( 0 == readFiles->size ) {
         fprintf(
-          stderr, "\nERROR: Unable to open input file '%s'", inputfile2 );
+          stderr, "\nERROR: No reads files found in '%s'", inputfile2 );
         exit( 1 );
     }
 
@@ -1038,6 +1237,19 @@ int main( int argc, char **argv ) {
               "Unable to open input file '%s'!", edgesIn );
         }
 
+        if ( multiFile ) {
+            doCriticalErrorAndQuit(
+              "EDGESINFILE needs a single reads file, not '%s'!", inputfile2 );
+        }
+
+        fpiReads = fopen( inputfile2, "r" );
+
+        if ( fpiReads == NULL ) {
+            fprintf(
+              stderr, "\nERROR: Unable to open input file '%s'", inputfile2 );
+            exit( 1 );
+        }
+
         doEdgesBruteForce( fpiRefs, fpiReads, fpeIn, dt1, 1, edgesfile );
         fclose( fpeIn );
 
@@ -1047,37 +1259,112 @@ int main( int argc, char **argv ) {
     // open redundancy index
     sprintf( buffer, "%s.rotindex", inputfile );
     fpirot = fopen( buffer, "r" );
-    sprintf( buffer, "%s.rotindex", inputfile2 );
-    fpi2rot = fopen( buffer, "r" );
 
-    cb = doSearchSimilarities( fpiRefs, fpiReads, fpirot, fpi2rot, dt1 );
+    // persistent seed index of the refs
+    doLoadReferences( fpiRefs, fpirot, inputfile, indexfile );
 
     fclose( fpiRefs );
-    fclose( fpiReads );
 
     if ( fpirot )
         fclose( fpirot );
 
-    if ( fpi2rot )
-        fclose( fpi2rot );
+    // with many reads files, each one logs into its own .proclu_log
+    if ( multiFile ) {
+        fflush( stderr );
+        savedStderr = dup( 2 );
+    }
 
-    if ( MAPFILE )
-        fclose( MAPFILE );
+    for ( nof1 = readFiles->head; nof1 != NULL; nof1 = nof1->next ) {
 
-    // print clusters to output file
-    fpo = fopen( outputfile, "w" );
+        readsfile = (char *) EasyListItem( nof1 );
+        sprintf( outputfile, "%s.clu", readsfile );
+        sprintf( mapfile, "%s.map", readsfile );
 
-    if ( fpo == NULL ) {
-        fprintf(
-          stderr, "\nERROR: Unable to create output file '%s'", outputfile );
-        exit( 1 );
+        if ( multiFile ) {
+            sprintf( buffer, "%s.proclu_log", readsfile );
+            fd = open( buffer, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+            if ( fd < 0 ) {
+                doCriticalErrorAndQuit(
+                  "Unable to create log file '%s'!", buffer );
+            }
+
+            dup2( fd, 2 );
+            close( fd );
+        }
+
+        // open the reads input file for reading
+        fpiReads = fopen( readsfile, "r" );
+
+        if ( fpiReads == NULL ) {
+            fprintf(
+              stderr, "\nERROR: Unable to open input file '%s'", readsfile );
+            exit( 1 );
+        }
+
+        sprintf( buffer, "%s.rotindex", readsfile );
+        fpi2rot = fopen( buffer, "r" );
+
+        // open map file
+        if ( OPTION2 == 'M' ) {
+            MAPFILE = fopen( mapfile, "w" );
+
+            if ( MAPFILE == NULL ) {
+                fprintf( stderr, "\nERROR: Unable to open mapfile file '%s'",
+                  mapfile );
+                exit( 1 );
+            }
+        }
+
+        cb = doSearchSimilarities( fpiReads, fpi2rot, dt1 );
+
+        fclose( fpiReads );
+
+        if ( fpi2rot )
+            fclose( fpi2rot );
+
+        if ( MAPFILE ) {
+            fclose( MAPFILE );
+            MAPFILE = NULL;
+        }
+
+        // print clusters to output file
+        fpo = fopen( outputfile, "w" );
+
+        if ( fpo == NULL ) {
+            fprintf( stderr, "\nERROR: Unable to create output file '%s'",
+              outputfile );
+            exit( 1 );
+        }
+
+        ClusterBasePrint( cb, fpo );
+        fclose( fpo );
+        ClusterBaseDestroy( cb );
+        fprintf( stderr, "done (total time: %.1lf secs)\n\n",
+          (double) ( time( NULL ) - startTime ) );
+        fflush( stderr );
+
+        if ( multiFile ) {
+            dup2( savedStderr, 2 );
+            filecount++;
+            fprintf( stderr, "\n%s done (%zu of %zu files, total time: %.1lf "
+                             "secs)",
+              readsfile, filecount, readFiles->size,
+              (double) ( time( NULL ) - startTime ) );
+            fflush( stderr );
+        }
     }
 
-    ClusterBasePrint( cb, fpo );
-    fclose( fpo );
-    fprintf( stderr, "done (total time: %.1lf secs)\n\n",
-      (double) ( time( NULL ) - startTime ) );
-    fflush( stderr );
+    if ( multiFile ) {
+        close( savedStderr );
+        fprintf( stderr, "\n" );
+    }
+
+    EasyListDestroy( readFiles );
+
+    // the reference profiles go with the index
+    RefIndexDestroy( RefIndex );
+    RefIndex = NULL;
 
     return 0;
 }
@@ -1229,11 +1516,11 @@ void doEdgesBruteForce( FILE *fpi, FILE *fpi2, FILE *edgesIn,
     EASY_LIST *profileList = NULL, *profileList2 = NULL;
     EASY_NODE *nof1, *nof2;
     FILE *     fpo;
-    int        dir, off1, id1, id2;
-    PROFILE *  prof1, *prof2, *prof1rc, *prof2rc;
+    int        dir, id1, id2;
     PAP *      pap1, *pap2, *bestpap;
     GSHASH *   profileHash = NULL;
     PROFPAIR * profpair, *profpair2;
+    PA_CONTEXT *pac;
 
     // open output file
     fpo = fopen( outputfile, "w" );
@@ -1244,48 +1531,26 @@ void doEdgesBruteForce( FILE *fpi, FILE *fpi2, FILE *edgesIn,
         exit( 1 );
     }
 
+    // alignment workspace, reused by every edge
+    pac = CreatePAContext();
+
+    if ( pac == NULL ) {
+        fprintf( stderr, "\nERROR: Unable to allocate alignment workspace" );
+        exit( 1 );
+    }
+
     // create lists
     profileList  = EasyListCreate( NULL, NULL );
     profileList2 = EasyListCreate( NULL, NULL );
 
     // read 1st file profiles into list
-    off1 = 0;
-
-    while ( 1 ) {
-
-        prof1   = NULL;
-        prof1rc = NULL;
-        prof1   = ReadProfileWithRC( fpi, off1, &prof1rc, 0 );
-
-        if ( NULL == prof1 || NULL == prof1rc )
-            break;
-
-        EasyListInsertTail( profileList, prof1 );
-        EasyListInsertTail( profileList, prof1rc );
-
-        off1 = prof1->nextoffset;
-    }
+    LoadProfileList( fpi, profileList, 0 );
 
     fprintf(
       stdout, "\nLoaded %zu profiles from 1st file", profileList->size / 2 );
 
     // read 2nd file profiles into list
-    off1 = 0;
-
-    while ( 1 ) {
-
-        prof1   = NULL;
-        prof1rc = NULL;
-        prof1   = ReadProfileWithRC( fpi2, off1, &prof1rc, 0 );
-
-        if ( NULL == prof1 || NULL == prof1rc )
-            break;
-
-        EasyListInsertTail( profileList2, prof1 );
-        EasyListInsertTail( profileList2, prof1rc );
-
-        off1 = prof1->nextoffset;
-    }
+    LoadProfileList( fpi2, profileList2, 0 );
 
     fprintf(
       stdout, "\nLoaded %zu profiles from 2nd file", profileList2->size / 2 );
@@ -1357,10 +1622,10 @@ void doEdgesBruteForce( FILE *fpi, FILE *fpi2, FILE *edgesIn,
             bestsim = 0.0;
             {
 
-                pap1 =
-                  GetFixedProfileAP( profpair->prof, profpair2->prof, dt1 );
-                pap2 =
-                  GetFixedProfileAP( profpair->profrc, profpair2->prof, dt1 );
+                pap1 = GetFixedProfileAP(
+                  pac, profpair->prof, profpair2->prof, dt1 );
+                pap2 = GetFixedProfileAP(
+                  pac, profpair->profrc, profpair2->prof, dt1 );
 
                 if ( pap1->similarity >= pap2->similarity ) {
                     bestpap = pap1;
@@ -1376,10 +1641,10 @@ void doEdgesBruteForce( FILE *fpi, FILE *fpi2, FILE *edgesIn,
                 FreePAP( pap2 );
 
                 // now doing all 4 ways
-                pap1 =
-                  GetFixedProfileAP( profpair->prof, profpair2->profrc, dt1 );
-                pap2 =
-                  GetFixedProfileAP( profpair->profrc, profpair2->profrc, dt1 );
+                pap1 = GetFixedProfileAP(
+                  pac, profpair->prof, profpair2->profrc, dt1 );
+                pap2 = GetFixedProfileAP(
+                  pac, profpair->profrc, profpair2->profrc, dt1 );
 
                 if ( pap1->similarity >= pap2->similarity ) {
                     bestpap = pap1;
@@ -1400,6 +1665,8 @@ void doEdgesBruteForce( FILE *fpi, FILE *fpi2, FILE *edgesIn,
         }
     }
 
+    FreePAContext( pac );
+
     fprintf( fpo, "#ave: %.4lf\n", totsim / count );
     fprintf( stdout, "\nAlignment complete\n" );
 }
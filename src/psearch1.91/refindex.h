@@ -0,0 +1,710 @@
+/****************************************************************
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ ****************************************************************/
+
+/***************************************************************
+    refindex.h : Persistent reference seed index.
+
+                 The reference profiles and their seed tuple
+                 tables are serialized once into a flat file
+                 next to the reference profiles (REFINDEX_EXT),
+                 or in the directory named by REFINDEX_DIR_ENV,
+                 and memory mapped read-only by every later
+                 run, so concurrent psearch processes share
+                 one copy through the page cache.
+
+                 All references inside the image are byte
+                 offsets from its start, so the same image
+                 can be used from a file mapping or from
+                 memory when the file cannot be written.
+
+                 Seed tables are in CSR form: sorted seed
+                 codes, bucket offsets and one contiguous
+                 array of 8 byte hits, sorted by pmin inside
+                 each bucket so pattern size ranges are found
+                 by binary search.
+
+                 Included by hclust.h (needs the TRANGE
+                 limits).
+****************************************************************/
+
+#ifndef REFINDEX_H
+#define REFINDEX_H
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../libs/easylife/easylife.h"
+#include "profile.h"
+
+/* INTERFACE */
+
+#define REFINDEX_EXT ".psidx"
+#define REFINDEX_DIR_ENV "PSEARCH_INDEX_DIR"
+#define REFINDEX_MAGIC "PSIDX\n\032"
+#define REFINDEX_VERSION 4
+#define REFINDEX_DIRBITS 16 /* top key bits resolved by the directory */
+
+typedef struct {
+    unsigned int prof; // ordinal into the profile table
+    short int    pmin;
+    char         dir;
+    char         pad;
+} REFINDEX_HIT;
+
+typedef struct {
+    unsigned int key1;
+    unsigned int key2;
+} REFINDEX_KEY;
+
+/* one seed table per TRANGE, all members are offsets into the image */
+typedef struct {
+    unsigned int       nbuckets; // codes for array ranges, keys otherwise
+    unsigned int       nhits;
+    int                dirshift; // -1 when buckets are addressed by code
+    unsigned long long keys;     // REFINDEX_KEY[nbuckets], sorted
+    unsigned long long dir;      // unsigned int[2^DIRBITS+1] into keys
+    unsigned long long offsets;  // unsigned int[nbuckets+1] into hits
+    unsigned long long hits;     // REFINDEX_HIT[nhits], sorted by pmin
+} REFINDEX_TABLE;
+
+typedef struct {
+    int                key, patlen, proflen, rcflag;
+    float              copynum, AveEntProf;
+    int                a, c, g, t;
+    int                aProf, cProf, gProf, tProf, dashProf;
+    int                seqlen, leftlen, rightlen;
+    unsigned long long indices, sequence, left, right;
+} REFINDEX_PROFILE;
+
+typedef struct {
+    char               magic[8];
+    unsigned int       version;
+    unsigned int       hitsize;
+    long long          refsize, rotsize;     // sizes of the inputs
+    unsigned long long refdigest, rotdigest; // and digests of their content
+    int                option, reflen;    // ref-to-ref flank shortening
+    unsigned int       nprofiles;
+    unsigned int       ntables;
+    unsigned long long filesize;
+    unsigned long long profiles; // REFINDEX_PROFILE[nprofiles]
+    REFINDEX_TABLE     tables[MAX_LIST_TRANGE + 1];
+} REFINDEX_HEADER;
+
+typedef struct {
+    char *           base;
+    size_t           size;
+    int              mapped;   // 1 if base is a file mapping
+    REFINDEX_HEADER *header;
+    PROFILE **       profiles; // ordinal -> profile
+    unsigned int     nprofiles;
+    PROFILE *        profstore; // profiles rebuilt from the image
+    FASTASEQUENCE *  seqstore;
+} REFINDEX;
+
+/* seed occurrence collected while seeding the references */
+typedef struct {
+    unsigned int key1;
+    unsigned int key2;
+    REFINDEX_HIT hit;
+} REFINDEX_SEED;
+
+/* growable seed list of one TRANGE, handed to the builder */
+typedef struct {
+    REFINDEX_SEED *seeds;
+    size_t         nseeds, maxseeds;
+} REFINDEX_SEEDS;
+
+void RefIndexPath(
+  char *indexfile, const char *reffile, unsigned long long refdigest );
+void RefIndexStamp( FILE *fp, long long *size, unsigned long long *digest );
+REFINDEX *RefIndexOpen( const char *filename, long long refsize,
+  unsigned long long refdigest, long long rotsize,
+  unsigned long long rotdigest );
+void RefIndexAddSeed( REFINDEX_SEEDS *set, unsigned int key1,
+  unsigned int key2, unsigned int prof, int pmin, int dir );
+REFINDEX *RefIndexBuild( EASY_LIST *profileList, REFINDEX_SEEDS *seeds,
+  long long refsize, unsigned long long refdigest, long long rotsize,
+  unsigned long long rotdigest );
+int  RefIndexWrite( REFINDEX *idx, const char *filename );
+void RefIndexDestroy( REFINDEX *idx );
+int  RefIndexLookup( REFINDEX *idx, int TRANGE, unsigned int key1,
+   unsigned int key2, REFINDEX_HIT **hits, size_t *length );
+size_t RefIndexPminBound( REFINDEX_HIT *hits, size_t length, int pmin );
+
+/* IMPLEMENTATION */
+
+#define REFINDEX_AT( IDX, OFF, TYPE ) ( (TYPE *) ( ( IDX )->base + ( OFF ) ) )
+#define REFINDEX_ALIGN( X ) ( ( ( X ) + 7 ) & ~( (unsigned long long) 7 ) )
+
+/***************************************************************
+ *  Index file of the reference profiles, next to them unless
+ *  REFINDEX_DIR_ENV names a directory for it (reference
+ *  directories can be read-only, shared or temporary). Indices
+ *  in that directory are named by the digest of the profiles
+ *  too, so reference sets with the same file name keep apart.
+ ***************************************************************/
+void RefIndexPath(
+  char *indexfile, const char *reffile, unsigned long long refdigest ) {
+    const char *dir = getenv( REFINDEX_DIR_ENV ), *name;
+
+    if ( NULL == dir || '\0' == dir[0] ) {
+        sprintf( indexfile, "%s%s", reffile, REFINDEX_EXT );
+        return;
+    }
+
+    name = strrchr( reffile, '/' );
+    name = ( NULL == name ) ? reffile : name + 1;
+    sprintf( indexfile, "%s/%s.%016llx%s", dir, name, refdigest,
+      REFINDEX_EXT );
+}
+
+/***************************************************************
+ *  Size and 64 bit FNV-1a digest of the content of an input.
+ *  Reads with pread, the stream position is left alone. An
+ *  input regenerated with the same content keeps its stamp.
+ ***************************************************************/
+void RefIndexStamp( FILE *fp, long long *size, unsigned long long *digest ) {
+    unsigned char      buffer[1 << 16];
+    unsigned long long hash = 14695981039346656037ULL;
+    off_t              offset = 0;
+    ssize_t            got, i;
+    int                fd;
+
+    *size   = -1;
+    *digest = 0;
+
+    if ( NULL == fp )
+        return;
+
+    fd = fileno( fp );
+
+    while ( ( got = pread( fd, buffer, sizeof( buffer ), offset ) ) > 0 ) {
+        for ( i = 0; i < got; i++ ) {
+            hash = ( hash ^ buffer[i] ) * 1099511628211ULL;
+        }
+
+        offset += got;
+    }
+
+    if ( got < 0 )
+        return;
+
+    *size   = (long long) offset;
+    *digest = hash;
+}
+
+/***************************************************************/
+int ri_attach( REFINDEX *idx, EASY_LIST *profileList ) {
+    REFINDEX_HEADER * h = idx->header;
+    REFINDEX_PROFILE *rp;
+    EASY_NODE *       nof1;
+    PROFILE *         prof;
+    unsigned int      i;
+
+    idx->nprofiles = h->nprofiles;
+    idx->profiles  = scalloc( h->nprofiles + 1, sizeof( PROFILE * ) );
+
+    // profiles still in memory (index was just built)
+    if ( profileList ) {
+        for ( i = 0, nof1 = profileList->head; nof1 != NULL;
+              nof1 = nof1->next, i++ ) {
+            idx->profiles[i] = (PROFILE *) EasyListItem( nof1 );
+        }
+
+        return 0;
+    }
+
+    // otherwise rebuild profile structures pointing into the image
+    idx->profstore = scalloc( h->nprofiles + 1, sizeof( PROFILE ) );
+    idx->seqstore  = scalloc( h->nprofiles + 1, sizeof( FASTASEQUENCE ) );
+    rp             = REFINDEX_AT( idx, h->profiles, REFINDEX_PROFILE );
+
+    for ( i = 0; i < h->nprofiles; i++, rp++ ) {
+        prof = &idx->profstore[i];
+
+        prof->key        = rp->key;
+        prof->patlen     = rp->patlen;
+        prof->copynum    = rp->copynum;
+        prof->proflen    = rp->proflen;
+        prof->rcflag     = rp->rcflag;
+        prof->indices    = REFINDEX_AT( idx, rp->indices, int );
+        prof->a          = rp->a;
+        prof->c          = rp->c;
+        prof->g          = rp->g;
+        prof->t          = rp->t;
+        prof->aProf      = rp->aProf;
+        prof->cProf      = rp->cProf;
+        prof->gProf      = rp->gProf;
+        prof->tProf      = rp->tProf;
+        prof->dashProf   = rp->dashProf;
+        prof->AveEntProf = rp->AveEntProf;
+
+        idx->seqstore[i].length   = rp->seqlen;
+        idx->seqstore[i].id       = rp->key;
+        idx->seqstore[i].sequence = REFINDEX_AT( idx, rp->sequence, char );
+        prof->seq                 = &idx->seqstore[i];
+
+        prof->left           = REFINDEX_AT( idx, rp->left, char );
+        prof->right          = REFINDEX_AT( idx, rp->right, char );
+        prof->leftlen        = rp->leftlen;
+        prof->rightlen       = rp->rightlen;
+        prof->rotationmaster = 1;
+        prof->dir            = 0;
+        prof->rotlist        = NULL;
+        prof->ordinal        = i;
+
+        idx->profiles[i] = prof;
+    }
+
+    return 0;
+}
+
+/***************************************************************/
+REFINDEX *RefIndexOpen( const char *filename, long long refsize,
+  unsigned long long refdigest, long long rotsize,
+  unsigned long long rotdigest ) {
+    REFINDEX *       idx;
+    REFINDEX_HEADER *h;
+    struct stat      st;
+    void *           base;
+    int              fd;
+
+    fd = open( filename, O_RDONLY );
+
+    if ( fd < 0 )
+        return NULL;
+
+    if ( 0 != fstat( fd, &st ) || st.st_size < (off_t) sizeof( *h ) ) {
+        close( fd );
+        return NULL;
+    }
+
+    base = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+
+    if ( MAP_FAILED == base )
+        return NULL;
+
+    // reject indices built by other versions or from other inputs
+    h = (REFINDEX_HEADER *) base;
+
+    if ( 0 != memcmp( h->magic, REFINDEX_MAGIC, sizeof( h->magic ) ) ||
+         h->version != REFINDEX_VERSION ||
+         h->hitsize != sizeof( REFINDEX_HIT ) ||
+         h->ntables != MAX_LIST_TRANGE + 1 ||
+         h->filesize != (unsigned long long) st.st_size ||
+         h->refsize != refsize || h->refdigest != refdigest ||
+         h->rotsize != rotsize || h->rotdigest != rotdigest ||
+         h->option != OPTION || h->reflen != REFLEN ) {
+        munmap( base, st.st_size );
+        return NULL;
+    }
+
+    idx         = scalloc( 1, sizeof( REFINDEX ) );
+    idx->base   = base;
+    idx->size   = st.st_size;
+    idx->mapped = 1;
+    idx->header = h;
+    ri_attach( idx, NULL );
+
+    return idx;
+}
+
+/***************************************************************/
+void RefIndexAddSeed( REFINDEX_SEEDS *set, unsigned int key1,
+  unsigned int key2, unsigned int prof, int pmin, int dir ) {
+    REFINDEX_SEED *seed;
+
+    if ( set->nseeds == set->maxseeds ) {
+        set->maxseeds = ( 0 == set->maxseeds ) ? 1024 : 2 * set->maxseeds;
+        set->seeds =
+          realloc( set->seeds, set->maxseeds * sizeof( REFINDEX_SEED ) );
+
+        if ( NULL == set->seeds )
+            doCriticalErrorAndQuit(
+              "Unable to grow the reference seed list to %zu entries!",
+              set->maxseeds );
+    }
+
+    seed           = &set->seeds[set->nseeds++];
+    seed->key1     = key1;
+    seed->key2     = key2;
+    seed->hit.prof = prof;
+    seed->hit.pmin = pmin;
+    seed->hit.dir  = dir;
+    seed->hit.pad  = 0;
+}
+
+/***************************************************************/
+int ri_seedcmp( const void *item1, const void *item2 ) {
+    const REFINDEX_SEED *s1 = item1, *s2 = item2;
+
+    if ( s1->key1 != s2->key1 )
+        return ( s1->key1 > s2->key1 ) ? 1 : -1;
+
+    if ( s1->key2 != s2->key2 )
+        return ( s1->key2 > s2->key2 ) ? 1 : -1;
+
+    if ( s1->hit.pmin != s2->hit.pmin )
+        return ( s1->hit.pmin > s2->hit.pmin ) ? 1 : -1;
+
+    if ( s1->hit.prof != s2->hit.prof )
+        return ( s1->hit.prof > s2->hit.prof ) ? 1 : -1;
+
+    return s1->hit.dir - s2->hit.dir;
+}
+
+/***************************************************************
+ *  Serializes the profiles in profileList (ordinal = position
+ *  in the list) and the seed lists of every TRANGE, which are
+ *  sorted here in place. Buckets of array ranges are indexed
+ *  by code, buckets of hashed ranges by their sorted keys.
+ ***************************************************************/
+REFINDEX *RefIndexBuild( EASY_LIST *profileList, REFINDEX_SEEDS *seeds,
+  long long refsize, unsigned long long refdigest, long long rotsize,
+  unsigned long long rotdigest ) {
+    REFINDEX *        idx;
+    REFINDEX_HEADER * h;
+    REFINDEX_TABLE *  tab;
+    REFINDEX_PROFILE *rp;
+    REFINDEX_KEY *    keys;
+    REFINDEX_HIT *    hits;
+    REFINDEX_SEED *   seed;
+    REFINDEX_SEEDS *  set;
+    EASY_NODE *       nof1;
+    PROFILE *         prof;
+    unsigned int *    offsets, *dir;
+    unsigned long long size, blob;
+    size_t             ui, b, nprofiles, nbuckets[MAX_LIST_TRANGE + 1];
+    int                TRANGE, codebits;
+    unsigned int       d;
+    char *             base;
+
+    nprofiles = profileList->size;
+
+    // size the image: header, profile table, profile data
+    size = REFINDEX_ALIGN( sizeof( REFINDEX_HEADER ) );
+    size += REFINDEX_ALIGN( nprofiles * sizeof( REFINDEX_PROFILE ) );
+
+    for ( nof1 = profileList->head; nof1 != NULL; nof1 = nof1->next ) {
+        prof = (PROFILE *) EasyListItem( nof1 );
+        size += REFINDEX_ALIGN( prof->proflen * sizeof( int ) );
+        size += REFINDEX_ALIGN( prof->seq->length + 1 );
+        size += REFINDEX_ALIGN( strlen( prof->left ) + 1 );
+        size += REFINDEX_ALIGN( strlen( prof->right ) + 1 );
+    }
+
+    // ... and the seed tables
+    nbuckets[0] = 0;
+
+    for ( TRANGE = 1; TRANGE <= MAX_LIST_TRANGE; TRANGE++ ) {
+        set = &seeds[TRANGE];
+
+        if ( set->nseeds > UINT_MAX )
+            doCriticalErrorAndQuit(
+              "Too many seed hits (%zu) for the reference index!",
+              set->nseeds );
+
+        qsort( set->seeds, set->nseeds, sizeof( REFINDEX_SEED ), ri_seedcmp );
+
+        if ( TRANGE > MAX_ARRAY_TRANGE ) {
+            nbuckets[TRANGE] = 0;
+
+            for ( ui = 0; ui < set->nseeds; ui++ ) {
+                if ( ui == 0 || set->seeds[ui].key1 != set->seeds[ui - 1].key1 ||
+                     set->seeds[ui].key2 != set->seeds[ui - 1].key2 )
+                    nbuckets[TRANGE]++;
+            }
+
+            size += REFINDEX_ALIGN( nbuckets[TRANGE] * sizeof( REFINDEX_KEY ) );
+            size += REFINDEX_ALIGN(
+              ( ( 1 << REFINDEX_DIRBITS ) + 1 ) * sizeof( unsigned int ) );
+        } else {
+            nbuckets[TRANGE] = Trange_N_Codes[TRANGE];
+        }
+
+        size += REFINDEX_ALIGN( ( nbuckets[TRANGE] + 1 ) * sizeof( unsigned int ) );
+        size += REFINDEX_ALIGN( set->nseeds * sizeof( REFINDEX_HIT ) );
+    }
+
+    base = calloc( 1, size );
+
+    if ( NULL == base )
+        doCriticalErrorAndQuit(
+          "Unable to allocate %llu bytes for the reference index!", size );
+
+    // header
+    h = (REFINDEX_HEADER *) base;
+    memcpy( h->magic, REFINDEX_MAGIC, sizeof( h->magic ) );
+    h->version   = REFINDEX_VERSION;
+    h->hitsize   = sizeof( REFINDEX_HIT );
+    h->refsize   = refsize;
+    h->refdigest = refdigest;
+    h->rotsize   = rotsize;
+    h->rotdigest = rotdigest;
+    h->option    = OPTION;
+    h->reflen    = REFLEN;
+    h->nprofiles = nprofiles;
+    h->ntables   = MAX_LIST_TRANGE + 1;
+    h->filesize  = size;
+    blob         = REFINDEX_ALIGN( sizeof( REFINDEX_HEADER ) );
+
+    // profile table and data
+    h->profiles = blob;
+    rp          = (REFINDEX_PROFILE *) ( base + blob );
+    blob += REFINDEX_ALIGN( nprofiles * sizeof( REFINDEX_PROFILE ) );
+
+    for ( nof1 = profileList->head; nof1 != NULL; nof1 = nof1->next, rp++ ) {
+        prof = (PROFILE *) EasyListItem( nof1 );
+
+        rp->key        = prof->key;
+        rp->patlen     = prof->patlen;
+        rp->proflen    = prof->proflen;
+        rp->rcflag     = prof->rcflag;
+        rp->copynum    = prof->copynum;
+        rp->AveEntProf = prof->AveEntProf;
+        rp->a          = prof->a;
+        rp->c          = prof->c;
+        rp->g          = prof->g;
+        rp->t          = prof->t;
+        rp->aProf      = prof->aProf;
+        rp->cProf      = prof->cProf;
+        rp->gProf      = prof->gProf;
+        rp->tProf      = prof->tProf;
+        rp->dashProf   = prof->dashProf;
+        rp->seqlen     = prof->seq->length;
+        rp->leftlen    = prof->leftlen;
+        rp->rightlen   = prof->rightlen;
+
+        rp->indices = blob;
+        memcpy( base + blob, prof->indices, prof->proflen * sizeof( int ) );
+        blob += REFINDEX_ALIGN( prof->proflen * sizeof( int ) );
+
+        rp->sequence = blob;
+        memcpy( base + blob, prof->seq->sequence, prof->seq->length );
+        blob += REFINDEX_ALIGN( prof->seq->length + 1 );
+
+        rp->left = blob;
+        strcpy( base + blob, prof->left );
+        blob += REFINDEX_ALIGN( strlen( prof->left ) + 1 );
+
+        rp->right = blob;
+        strcpy( base + blob, prof->right );
+        blob += REFINDEX_ALIGN( strlen( prof->right ) + 1 );
+    }
+
+    // seed tables
+    for ( TRANGE = 1; TRANGE <= MAX_LIST_TRANGE; TRANGE++ ) {
+        set           = &seeds[TRANGE];
+        tab           = &h->tables[TRANGE];
+        tab->nbuckets = nbuckets[TRANGE];
+        tab->nhits    = set->nseeds;
+        tab->dirshift = -1;
+        keys          = NULL;
+
+        if ( TRANGE > MAX_ARRAY_TRANGE ) {
+            tab->keys = blob;
+            keys      = (REFINDEX_KEY *) ( base + blob );
+            blob += REFINDEX_ALIGN( nbuckets[TRANGE] * sizeof( REFINDEX_KEY ) );
+            tab->dir = blob;
+            blob += REFINDEX_ALIGN(
+              ( ( 1 << REFINDEX_DIRBITS ) + 1 ) * sizeof( unsigned int ) );
+        }
+
+        tab->offsets = blob;
+        offsets      = (unsigned int *) ( base + blob );
+        blob += REFINDEX_ALIGN( ( nbuckets[TRANGE] + 1 ) * sizeof( unsigned int ) );
+        tab->hits = blob;
+        hits      = (REFINDEX_HIT *) ( base + blob );
+        blob += REFINDEX_ALIGN( set->nseeds * sizeof( REFINDEX_HIT ) );
+
+        // seeds are sorted by code, a bucket starts at every new code
+        for ( ui = 0, b = 0; ui < set->nseeds; ui++ ) {
+            seed = &set->seeds[ui];
+
+            if ( keys ) {
+                if ( ui == 0 || seed->key1 != keys[b - 1].key1 ||
+                     seed->key2 != keys[b - 1].key2 ) {
+                    keys[b].key1 = seed->key1;
+                    keys[b].key2 = seed->key2;
+                    offsets[b++] = ui;
+                }
+            } else {
+                while ( b <= seed->key1 )
+                    offsets[b++] = ui;
+            }
+
+            hits[ui] = seed->hit;
+        }
+
+        while ( b <= nbuckets[TRANGE] )
+            offsets[b++] = set->nseeds;
+
+        if ( keys ) {
+
+            // directory on the leading bits of key1 (at most 15 bases)
+            codebits      = 2 * min( Trange_Ones[TRANGE], 15 );
+            tab->dirshift = max( 0, codebits - REFINDEX_DIRBITS );
+            dir           = (unsigned int *) ( base + tab->dir );
+
+            for ( d = 0, ui = 0; d <= ( 1 << REFINDEX_DIRBITS ); d++ ) {
+                while ( ui < nbuckets[TRANGE] &&
+                        ( keys[ui].key1 >> tab->dirshift ) < d )
+                    ui++;
+
+                dir[d] = ui;
+            }
+        }
+    }
+
+    idx         = scalloc( 1, sizeof( REFINDEX ) );
+    idx->base   = base;
+    idx->size   = size;
+    idx->mapped = 0;
+    idx->header = h;
+    ri_attach( idx, profileList );
+
+    return idx;
+}
+
+/***************************************************************
+ *  Writes the image under a temporary name and renames it, so
+ *  other processes never map a partially written index.
+ ***************************************************************/
+int RefIndexWrite( REFINDEX *idx, const char *filename ) {
+    char * tmpname;
+    FILE * fpo;
+    size_t written;
+
+    tmpname = smalloc( strlen( filename ) + 32 );
+    sprintf( tmpname, "%s.tmp%d", filename, (int) getpid() );
+
+    fpo = fopen( tmpname, "wb" );
+
+    if ( NULL == fpo ) {
+        sfree( tmpname );
+        return -1;
+    }
+
+    written = fwrite( idx->base, 1, idx->size, fpo );
+
+    if ( 0 != fclose( fpo ) || written != idx->size ||
+         0 != rename( tmpname, filename ) ) {
+        unlink( tmpname );
+        sfree( tmpname );
+        return -1;
+    }
+
+    sfree( tmpname );
+
+    return 0;
+}
+
+/***************************************************************/
+void RefIndexDestroy( REFINDEX *idx ) {
+    if ( NULL == idx )
+        return;
+
+    if ( idx->mapped )
+        munmap( idx->base, idx->size );
+    else
+        free( idx->base );
+
+    sfree( idx->profiles );
+    sfree( idx->profstore );
+    sfree( idx->seqstore );
+    sfree( idx );
+}
+
+/***************************************************************
+ *  Finds the bucket of a seed code. Returns 0 if the code has
+ *  no reference hits, otherwise the hits of the bucket.
+ ***************************************************************/
+int RefIndexLookup( REFINDEX *idx, int TRANGE, unsigned int key1,
+  unsigned int key2, REFINDEX_HIT **hits, size_t *length ) {
+    REFINDEX_TABLE *tab = &idx->header->tables[TRANGE];
+    REFINDEX_KEY *  keys;
+    unsigned int *  offsets, *dir;
+    size_t          lo, hi, mid, b;
+
+    if ( tab->dirshift < 0 ) {
+
+        // array range, bucket is the code itself
+        if ( key1 >= tab->nbuckets )
+            return 0;
+
+        b = key1;
+
+    } else {
+
+        // hashed range, narrow down with the directory then bisect
+        keys = REFINDEX_AT( idx, tab->keys, REFINDEX_KEY );
+        dir  = REFINDEX_AT( idx, tab->dir, unsigned int );
+        lo   = dir[key1 >> tab->dirshift];
+        hi   = dir[( key1 >> tab->dirshift ) + 1];
+
+        while ( lo < hi ) {
+            mid = ( lo + hi ) / 2;
+
+            if ( keys[mid].key1 < key1 ||
+                 ( keys[mid].key1 == key1 && keys[mid].key2 < key2 ) )
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        if ( lo >= tab->nbuckets || keys[lo].key1 != key1 ||
+             keys[lo].key2 != key2 )
+            return 0;
+
+        b = lo;
+    }
+
+    offsets = REFINDEX_AT( idx, tab->offsets, unsigned int );
+
+    if ( offsets[b] == offsets[b + 1] )
+        return 0;
+
+    *hits   = REFINDEX_AT( idx, tab->hits, REFINDEX_HIT ) + offsets[b];
+    *length = offsets[b + 1] - offsets[b];
+
+    return 1;
+}
+
+/***************************************************************
+ *  Position of the first hit of a bucket with at least the
+ *  given pmin, length if there is none.
+ ***************************************************************/
+size_t RefIndexPminBound( REFINDEX_HIT *hits, size_t length, int pmin ) {
+    size_t lo = 0, hi = length, mid;
+
+    while ( lo < hi ) {
+        mid = ( lo + hi ) / 2;
+
+        if ( hits[mid].pmin < pmin )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+#endif
@@ -72,6 +72,7 @@
 #include <string.h>
 
 #include "../libs/easylife/easylife.h"
+#include "../libs/profbin/profbin.h"
 
 #define max3( a, b, c )                                           \
     ( ( ( a ) >= ( b ) ) ? ( ( ( a ) >= ( c ) ) ? ( a ) : ( c ) ) \
@@ -104,6 +105,7 @@ typedef struct {
     int   a, c, g, t, n, acgtCount;
     char *left;
     char *right;
+    int   minrep; // PROFBIN_MINREP_* from a binary file, -1 from text
 
 } PROFILE;
 
@@ -125,10 +127,17 @@ typedef struct {
 // end of the file.
 PROFILE *ReadProfileWithRC( FILE *fp, PROFILE **profrcret );
 
+// Same as ReadProfileWithRC for a record of a binary profile file.
+PROFILE *ReadProfileFromBinary(
+  const PROFBIN_RECORD *rec, PROFILE **profrcret );
+
 // Writes the profile to the current position of text file.
 void WriteProfile( FILE *fp, PROFILE *prof ); // NO LONGER USED
 void WriteProfileWithRC( FILE *fp, PROFILE *prof, PROFILE *profrc );
 
+// Writes the profile to a binary profile file, returns 0 on success.
+int WriteProfileBinary( PROFBIN_WRITER *pw, PROFILE *prof, PROFILE *profrc );
+
 // Frees memory associate with a profile
 void FreeProfile( PROFILE *prof );
 
@@ -237,6 +246,7 @@ PROFILE *CopyProfile( PROFILE *prof ) {
     result->t         = prof->t;
     result->n         = prof->n;
     result->acgtCount = prof->acgtCount;
+    result->minrep    = prof->minrep;
 
     return result;
 }
@@ -470,9 +480,9 @@ PROFILE *ReadProfileWithRC( FILE *fp, PROFILE **profrcret ) {
     char     digits[4], *src, *src2;
     PROFILE *prof, *profrc;
 
-    static char leftflank[2100];
-    static char rightflank[2100];
-    static char buffer[2100];
+    char leftflank[2100];
+    char rightflank[2100];
+    char buffer[2100];
 
     // read key, pattern length and profile length
     c = fscanf(
@@ -498,6 +508,7 @@ PROFILE *ReadProfileWithRC( FILE *fp, PROFILE **profrcret ) {
     prof->copynum = copynum;
     prof->proflen = proflen;
     prof->rcflag  = 0;
+    prof->minrep  = -1;
 
     if ( proflenrc > 0 ) {
         profrc = (PROFILE *) malloc( sizeof( PROFILE ) );
@@ -516,6 +527,7 @@ PROFILE *ReadProfileWithRC( FILE *fp, PROFILE **profrcret ) {
         profrc->copynum = copynum;
         profrc->proflen = proflenrc;
         profrc->rcflag  = 1;
+        profrc->minrep  = -1;
     }
 
     for ( i = 0; i < proflen; i++ ) {
@@ -629,6 +641,93 @@ PROFILE *ReadProfileWithRC( FILE *fp, PROFILE **profrcret ) {
     return prof;
 }
 
+/* upper case ACGT, N otherwise, as ReadProfileWithRC leaves flanks */
+char *_flankdup( const char *flank ) {
+    char *str, *src;
+
+    str = strdup( flank );
+
+    if ( NULL == str )
+        doCriticalErrorAndQuit( "\nUnable to copy flank!\n" );
+
+    for ( src = str; *src != '\0'; src++ ) {
+        *src = toupper( *src );
+        if ( NULL == strchr( "ACGT", *src ) ) {
+            *src = 'N';
+        }
+    }
+
+    return str;
+}
+
+PROFILE *ReadProfileFromBinary(
+  const PROFBIN_RECORD *rec, PROFILE **profrcret ) {
+    PROFILE *prof, *profrc = NULL;
+
+    prof = (PROFILE *) calloc( 1, sizeof( PROFILE ) );
+    if ( prof )
+        prof->indices = (int *) malloc( sizeof( int ) * rec->proflen );
+    if ( prof == NULL || prof->indices == NULL ) {
+        doCriticalErrorAndQuit( "\nload error!!!2\n" );
+        return NULL;
+    }
+
+    prof->key     = rec->key;
+    prof->patlen  = rec->patlen;
+    prof->copynum = rec->copynum;
+    prof->proflen = rec->proflen;
+    prof->minrep  = rec->minrep;
+    memcpy( prof->indices, ProfbinIndices( rec ), sizeof( int ) * rec->proflen );
+
+    if ( rec->proflenrc <= 0 ) {
+        *profrcret = NULL;
+        return prof;
+    }
+
+    profrc = (PROFILE *) calloc( 1, sizeof( PROFILE ) );
+    if ( profrc )
+        profrc->indices = (int *) malloc( sizeof( int ) * rec->proflenrc );
+    if ( profrc == NULL || profrc->indices == NULL ) {
+        doCriticalErrorAndQuit( "\nload error!!!3\n" );
+        return NULL;
+    }
+
+    profrc->key     = rec->key;
+    profrc->patlen  = rec->patlen;
+    profrc->copynum = rec->copynum;
+    profrc->proflen = rec->proflenrc;
+    profrc->rcflag  = 1;
+    profrc->minrep  = rec->minrep;
+    memcpy( profrc->indices, ProfbinRCIndices( rec ),
+      sizeof( int ) * rec->proflenrc );
+
+    prof->a           = rec->a;
+    prof->c           = rec->c;
+    prof->g           = rec->g;
+    prof->t           = rec->t;
+    prof->acgtCount   = prof->a + prof->c + prof->g + prof->t;
+    profrc->a         = prof->t;
+    profrc->t         = prof->a;
+    profrc->c         = prof->g;
+    profrc->g         = prof->c;
+    profrc->acgtCount = prof->acgtCount;
+
+    if ( rec->leftlen < 0 ) {
+        doCriticalErrorAndQuit( "\nNo flanks specified!\n" );
+        return NULL;
+    }
+
+    prof->left    = _flankdup( ProfbinLeft( rec ) );
+    prof->right   = _flankdup( ProfbinRight( rec ) );
+    profrc->left  = GetReverseComplement( prof->right );
+    profrc->right = GetReverseComplement( prof->left );
+
+    if ( profrcret )
+        *profrcret = profrc;
+
+    return prof;
+}
+
 void WriteProfile( FILE *fp, PROFILE *prof ) {
     int  i, number, proflen;
     char digits[4];
@@ -701,6 +800,30 @@ void WriteProfileWithRC( FILE *fp, PROFILE *prof, PROFILE *profrc ) {
     return;
 }
 
+int WriteProfileBinary( PROFBIN_WRITER *pw, PROFILE *prof, PROFILE *profrc ) {
+    PROFBIN_ENTRY pe;
+
+    memset( &pe, 0, sizeof( pe ) );
+    pe.key     = prof->key;
+    pe.patlen  = prof->patlen;
+    pe.copynum = prof->copynum;
+    pe.indices = prof->indices;
+    pe.proflen = prof->proflen;
+
+    if ( profrc ) {
+        pe.rcindices = profrc->indices;
+        pe.proflenrc = profrc->proflen;
+        pe.a         = prof->a;
+        pe.c         = prof->c;
+        pe.g         = prof->g;
+        pe.t         = prof->t;
+        pe.left      = prof->left;
+        pe.right     = prof->right;
+    }
+
+    return ProfbinWrite( pw, &pe );
+}
+
 void LEB36ToInt( char *leb36, int *dec ) {
     int   i, mult, num;
     char *p;
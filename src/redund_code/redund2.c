@@ -28,6 +28,27 @@
 
         - reading profile now exits correctly on error
 
+  - inputs can be binary profile files (profbin.h), -b writes the output as
+    one, the minimum representation key stored in a binary input is used
+    with -i
+
+  - sorted input files are merged with a loser tree keyed on a fixed width
+    prefix of the minimum representation, equal records now come out in
+    input file order
+
+  - -t runs the merge on several threads, each on its own range of keys
+    split at sampled keys of the inputs, the ranges are written out in
+    order so the output is the same as with one thread
+
+  - the minimum representation comes from MinRepresentation (vntr_kernels),
+    it points into the profile (or a reused buffer when rotated) instead of
+    being copied, without -i the least rotations are found in linear time
+    and the unrotated reverse complement is a candidate too
+
+  - at most -f N (default MAX_FANIN) inputs are open in a merge, more are
+    merged in passes over groups of them into sorted runs in a temporary
+    directory, the open file limit no longer has to fit all the inputs
+
 */
 
 
@@ -40,6 +61,9 @@
 #define RECORDS_PER_FILE ( 100000 )
 #define OUTPREFIX "reads"
 #define MAX_BUFFER_SIZE 1000
+#define MAX_FANIN 256
+#define INPUT_BUFFER_SIZE ( 1 << 18 )
+#define INPUT_BUFFER_ALIGN 4096
 
 /***************************************************************
     redund.c    :   Program that takes a file with a list of
@@ -64,6 +88,17 @@
             Use -n switch to make the program output a single file (not broken
    up in multiples.)
 
+            Use -b switch to write binary profile files (profbin.h) instead
+   of LEB36 text. Inputs are read in either format.
+
+            Use -t N to merge on N threads. The key space is split in N
+   ranges at keys sampled from the (sorted) inputs and every range is
+   merged on its own thread, the output does not change.
+
+            Use -f N to merge at most N files at once (default 256). With
+   more inputs than that, groups of N are first merged into sorted runs in
+   a temporary directory next to OUTPUTFILE, as many passes as it takes.
+
     VERSION     :   1.00
 
 */
@@ -105,8 +140,21 @@ char *Complementascii = NULL;
 #include "../libs/easylife/easylife.h"
 //#include "easylife.h"
 #include "profile.h"
+#include "../libs/vntr_kernels/min_representation.h"
 
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//records between two samples of the key index of an input
+#define INDEX_STRIDE 16
+
+//open files kept apart from the inputs: stdio, outputs, spools, sqlite
+#define RESERVED_FILES 64
 
 /*******************************************************************************************/
 typedef struct{
@@ -114,22 +162,87 @@ typedef struct{
     int dir;
 } RECORD_STRUCT;
 
+typedef struct {
+    uint64_t  prefix;   // MinRepPrefix of the record
+    long long position; // byte offset in a text input, record of a binary one
+} KEY_SAMPLE;
+
+typedef struct {
+    int *    minRepresentation; // NULL if the range is open on that side
+    int      minrlen;
+    uint64_t minrepprefix;
+} RANGE_KEY;
+
+typedef struct {
+    RANGE_KEY lower, upper; // lower <= key < upper
+} RANGE_STRUCT;
+
 typedef struct {
     char *   inputfile;
     char *   outputfile;
     char *   outputfile2;
     char *   d_name;
     FILE *   in;
+    char *   iobuffer; // stdio buffer of a text input
     PROFILE *prof, *profrc;
-    int *    minRepresentation;
+    int *    minRepresentation; // into prof, profrc or keybuffer
     int      minrlen;
+    uint64_t minrepprefix; // MinRepPrefix of minRepresentation
+    int *    keybuffer;    // rotated minRepresentation, reused
+    int      maxkeybuffer;
     int      dir;
     RECORD_STRUCT **buffer;
     int buffercount;
     int bufferindex;
     int inputclosed;
+    PROFBIN_FILE *binary; // mapping of a binary input, NULL for text
+    uint64_t nextrecord;
+    uint64_t endrecord;   // a binary input is read up to this record
+    long long endoffset;  // a text input up to this offset, -1 to the end
+    const RANGE_STRUCT *range; // keys merged from this input, NULL for all
+    uint64_t lastprefix;  // of the record before, to notice unsorted input
+    int unsorted;
+    KEY_SAMPLE *samples;  // every INDEX_STRIDE-th record
+    int nsamples;
 } FITEM_STRUCT;
 
+typedef struct {
+    FILE *          fpto, *fpto2;
+    PROFBIN_WRITER *pwto;
+    char *          outputfile, *outputfile2, *outputdname, *outputbname;
+    int             filescreated, single, binary;
+    long long int   nwritten;
+} OUTPUT_STRUCT;
+
+typedef struct {
+    FILE *          fp;    // the records, as a binary profile file
+    FILE *          flags; // a byte per record, the direction plus 2 if redundant
+    PROFBIN_WRITER *pw;
+} SPOOL_STRUCT;
+
+typedef struct {
+    FITEM_STRUCT **inputs;
+    int            ninputs, identical_only, unsorted;
+    RANGE_STRUCT   range;
+    SPOOL_STRUCT   spool;
+    long long int  nread;
+    pthread_t      thread;
+} RANGE_TASK;
+
+typedef struct {
+    FITEM_STRUCT **inputs; // consecutive inputs, in file order
+    int            ninputs;
+    FITEM_STRUCT * run;    // the sorted run they are merged into
+    FILE *         fp;
+    PROFBIN_WRITER *pw;
+} RUN_TASK;
+
+typedef struct {
+    RUN_TASK *      tasks;
+    int             ntasks, next, identical_only;
+    pthread_mutex_t lock;
+} RUN_POOL;
+
 typedef struct {
     PROFILE *prof, *profrc;
     int *    minRepresentation;
@@ -262,266 +375,1222 @@ int *pintdup( int *src, int size ) {
 
     res = smalloc( sizeof( int ) * size );
 
-    for ( i = 0; i < size; i++ ) {
-        res[i] = src[i];
+    for ( i = 0; i < size; i++ ) {
+        res[i] = src[i];
+    }
+
+    return res;
+}
+
+/*******************************************************************************************/
+int ftouch( char *in ) {
+
+    FILE *fp;
+
+    if ( ( fp = fopen( in, "r" ) ) == NULL )
+        return 0;
+
+    fclose( fp );
+    return 1;
+}
+
+/*******************************************************************************************/
+int *GetMinRepresentation( PROFILE *prof, PROFILE *profrc, int *minrlen,
+  int *dir, int identical_only, int **buffer, int *maxbuffer ) {
+
+//finds the minimum profile and profile length from the profile and reverse complement profile
+//when identical_only == 1, no profile rotations are performed
+//this is the case with the current VNTRseek
+//the key written with a binary profile file is used as it is
+//the key points into the indices of the profile it comes from or, when
+//rotated, into *buffer, which grows as needed and is reused, dir is 1 for
+//the reverse complement
+
+    MINREP mr;
+
+    *dir = 0;
+
+    if ( identical_only && NULL != profrc && prof->minrep >= 0 ) {
+        mr.rc      = ( PROFBIN_MINREP_RC == prof->minrep );
+        mr.indices = ( 0 == mr.rc ) ? prof->indices : profrc->indices;
+        mr.length  = ( 0 == mr.rc ) ? prof->proflen : profrc->proflen;
+        mr.offset  = 0;
+    } else if ( 0 != MinRepresentation( prof->indices, prof->proflen,
+                       profrc ? profrc->indices : NULL,
+                       profrc ? profrc->proflen : 0, !identical_only, &mr ) ) {
+        return NULL;
+    }
+
+    *dir     = mr.rc;
+    *minrlen = mr.length;
+
+    if ( 0 == mr.offset )
+        return (int *) mr.indices;
+
+    if ( *maxbuffer < mr.length ) {
+        *maxbuffer = mr.length;
+        *buffer    = (int *) realloc( *buffer, sizeof( int ) * mr.length );
+
+        if ( NULL == *buffer ) {
+            printf( "\nERROR: Insuficient memory for a minimum representation\n\n" );
+            exit( 1 );
+        }
+    }
+
+    return MinRepresentationCopy( &mr, *buffer );
+}
+
+/*******************************************************************************************/
+PROFILE *ReadInputProfile( FILE *in, PROFBIN_FILE *binary, uint64_t *next,
+  PROFILE **profrc ) {
+
+//next profile of a text or binary input, NULL at the end
+
+    if ( NULL == binary )
+        return ReadProfileWithRC( in, profrc );
+
+    if ( *next == binary->nrecords )
+        return NULL;
+
+    return ReadProfileFromBinary( ProfbinRecord( binary, ( *next )++ ), profrc );
+}
+
+/*******************************************************************************************/
+void WriteOutputProfile( FILE *fp, PROFBIN_WRITER *pw, PROFILE *prof,
+  PROFILE *profrc ) {
+
+//LEB36 text or, with -b, binary
+
+    if ( NULL == pw ) {
+        WriteProfileWithRC( fp, prof, profrc );
+        return;
+    }
+
+    if ( 0 != WriteProfileBinary( pw, prof, profrc ) ) {
+        printf( "\nERROR: Unable to write profile %d: %s\n\n", prof->key,
+          strerror( errno ) );
+        exit( 1 );
+    }
+}
+
+/*******************************************************************************************/
+PROFBIN_WRITER *StartOutput( FILE *fp, int binary ) {
+
+    PROFBIN_WRITER *pw;
+
+    if ( !binary )
+        return NULL;
+
+    pw = ProfbinCreate( fp );
+
+    if ( NULL == pw ) {
+        printf( "\nERROR: Unable to start binary output: %s\n\n",
+          strerror( errno ) );
+        exit( 1 );
+    }
+
+    return pw;
+}
+
+/*******************************************************************************************/
+void FinishOutput( PROFBIN_WRITER *pw ) {
+
+    if ( NULL != pw && 0 != ProfbinClose( pw ) ) {
+        printf( "\nERROR: Unable to finish binary output: %s\n\n",
+          strerror( errno ) );
+        exit( 1 );
+    }
+}
+
+/*******************************************************************************************/
+//fixed width prefix of a minimum representation, in the same order as pindcmp
+//the length takes the top 16 bits and the first MINREP_PREFIX_INDICES indices
+//12 bits each (LEB36 indices are below 1296), a value out of range saturates
+//and fills the rest of the prefix the same way, so two prefixes can tie on
+//different keys but never order them the wrong way round
+#define MINREP_PREFIX_INDICES 4
+
+uint64_t MinRepPrefix( int *minrep, int len ) {
+
+    uint64_t prefix;
+    int      i, shift;
+
+    if ( len >= 0xFFFF )
+        return ~0ULL;
+
+    prefix = (uint64_t) len << 48;
+
+    for ( i = 0; i < MINREP_PREFIX_INDICES && i < len; i++ ) {
+        shift = 36 - 12 * i;
+
+        if ( minrep[i] < 0 )
+            break;
+
+        if ( minrep[i] >= 0xFFF ) {
+            prefix |= ( 1ULL << ( shift + 12 ) ) - 1;
+            break;
+        }
+
+        prefix |= (uint64_t) minrep[i] << shift;
+    }
+
+    return prefix;
+}
+
+/*******************************************************************************************/
+//1 if the current record of file a goes before the one of file b
+//equal records go in file order and finished files go last
+int mergeBefore( FITEM_STRUCT **files, int a, int b ) {
+
+    FITEM_STRUCT *fiptr1 = files[a], *fiptr2 = files[b];
+    int           test;
+
+    if ( NULL == fiptr1->minRepresentation )
+        return 0;
+
+    if ( NULL == fiptr2->minRepresentation )
+        return 1;
+
+    test = pindcmp( fiptr1->minRepresentation, fiptr2->minRepresentation,
+      fiptr1->minrlen, fiptr2->minrlen );
+
+    if ( test != 0 )
+        return ( test < 0 );
+
+    return ( a < b );
+}
+
+/*******************************************************************************************/
+//tournament (loser) tree over n files: file i is leaf n+i, internal node k
+//has children 2k and 2k+1 and keeps the loser of the match played there,
+//node 0 keeps the overall winner
+//each node carries the key prefix of its file so a match is one integer
+//compare, the full representations are only compared when the prefixes tie
+typedef struct {
+    uint64_t prefix; // ~0 once the file is finished
+    int      file;
+} LOSER_NODE;
+
+static inline int loserBefore( FITEM_STRUCT **files, LOSER_NODE *a,
+  LOSER_NODE *b ) {
+
+    if ( a->prefix != b->prefix )
+        return ( a->prefix < b->prefix );
+
+    return mergeBefore( files, a->file, b->file );
+}
+
+/*******************************************************************************************/
+LOSER_NODE buildLoserTree( FITEM_STRUCT **files, LOSER_NODE *losers, int n,
+  int node ) {
+
+    LOSER_NODE winner1, winner2;
+
+    if ( node >= n ) {
+        winner1.file   = node - n;
+        winner1.prefix = files[winner1.file]->minrepprefix;
+        return winner1;
+    }
+
+    winner1 = buildLoserTree( files, losers, n, 2 * node );
+    winner2 = buildLoserTree( files, losers, n, 2 * node + 1 );
+
+    if ( loserBefore( files, &winner2, &winner1 ) ) {
+        losers[node] = winner1;
+        return winner2;
+    }
+
+    losers[node] = winner2;
+    return winner1;
+}
+
+/*******************************************************************************************/
+//replays the matches on the path of the winner after its file moved on
+void replayLoserTree( FITEM_STRUCT **files, LOSER_NODE *losers, int n ) {
+
+    LOSER_NODE winner, hold;
+    int        node;
+
+    winner        = losers[0];
+    winner.prefix = files[winner.file]->minrepprefix;
+
+    for ( node = ( winner.file + n ) / 2; node > 0; node /= 2 ) {
+        if ( loserBefore( files, &losers[node], &winner ) ) {
+            hold         = losers[node];
+            losers[node] = winner;
+            winner       = hold;
+        }
+    }
+
+    losers[0] = winner;
+}
+
+/*******************************************************************************************/
+//a text input gets a large aligned stdio buffer, which has to be set before
+//the first read, and the kernel is told it is read front to back so it reads
+//ahead further
+void bufferInput( FITEM_STRUCT *fiptr ) {
+
+    posix_fadvise( fileno( fiptr->in ), 0, 0, POSIX_FADV_SEQUENTIAL );
+
+    if ( NULL == fiptr->iobuffer &&
+         0 != posix_memalign( (void **) &( fiptr->iobuffer ),
+                INPUT_BUFFER_ALIGN, INPUT_BUFFER_SIZE ) ) {
+        fiptr->iobuffer = NULL; // stdio keeps its own buffer
+        return;
+    }
+
+    setvbuf( fiptr->in, fiptr->iobuffer, _IOFBF, INPUT_BUFFER_SIZE );
+}
+
+/*******************************************************************************************/
+//opens an input, a binary one is mapped, ready to be read from the start
+void openInput( FITEM_STRUCT *fiptr ) {
+
+    fiptr->in = fopen( fiptr->inputfile, "r" );
+    fiptr->inputclosed = 0;
+
+    if ( NULL == fiptr->in ) {
+        printf( "\nERROR opening input file '%s': %s\n", fiptr->inputfile,
+          strerror( errno ) );
+        exit( 1 );
+    }
+
+    if ( ProfbinIsBinary( fiptr->in ) ) {
+        if ( NULL == ( fiptr->binary = ProfbinMap( fiptr->in ) ) ) {
+            printf( "\nERROR: Unfinished or unsupported binary profile file "
+                    "'%s'\n",
+              fiptr->inputfile );
+            exit( 1 );
+        }
+
+        madvise( (void *) fiptr->binary->base, fiptr->binary->size,
+          MADV_SEQUENTIAL );
+    } else {
+        //the header check reads with pread, the stream is still unused
+        bufferInput( fiptr );
+    }
+
+    fiptr->nextrecord = 0;
+    fiptr->endrecord  = ( NULL == fiptr->binary ) ? 0 : fiptr->binary->nrecords;
+    fiptr->endoffset  = -1;
+}
+
+/*******************************************************************************************/
+void closeInput(FITEM_STRUCT *fiptr) {
+
+    //a range merge reads a binary input through the mapping of the caller
+    //and has no FILE of its own for it
+    if (fiptr->in != NULL) {
+        ProfbinUnmap(fiptr->binary);
+        fclose(fiptr->in);
+    }
+
+    free(fiptr->iobuffer);
+
+    fiptr->iobuffer = NULL;
+    fiptr->binary = NULL;
+    fiptr->in = NULL;
+    fiptr->inputclosed = 1;
+}
+
+/*******************************************************************************************/
+void readRecordsFromFileToBuffer(FITEM_STRUCT *fiptr) {
+    int  bn, buffercounter=0;
+    RECORD_STRUCT * bufferptr, *tempbufferptr;
+
+    //allocate buffer pointer and records memory on reading first records,
+    //later rounds reuse them
+    if (fiptr->buffer == NULL) {
+        fiptr->buffer = (RECORD_STRUCT **)calloc(MAX_BUFFER_SIZE, sizeof(RECORD_STRUCT *));
+        tempbufferptr = (RECORD_STRUCT *)calloc(MAX_BUFFER_SIZE, sizeof(RECORD_STRUCT));
+
+        if (fiptr->buffer == NULL || tempbufferptr == NULL) {
+            printf( "\nERROR: Insuficient memory to buffer '%s'\n\n", fiptr->inputfile );
+            exit( 1 );
+        }
+
+        for(bn = 0; bn < MAX_BUFFER_SIZE; bn++) {
+            fiptr->buffer[bn] = tempbufferptr;
+            tempbufferptr++;
+        }
+    }
+
+    //printf("\n\nBefore read records for file %s, bufferindex = %d, buffercount = %d",fiptr->inputfile, fiptr->bufferindex, fiptr->buffercount);
+
+    //read records
+    //printf("\nReading records from %s",fiptr->inputfile);
+    while (buffercounter<MAX_BUFFER_SIZE) {
+        if (fiptr->binary ? fiptr->nextrecord == fiptr->endrecord : ( feof(fiptr->in) ||
+              ( fiptr->endoffset >= 0 && ftello(fiptr->in) >= fiptr->endoffset ) ))
+            break;
+        bufferptr = fiptr->buffer[buffercounter];
+        bufferptr->prof = ReadInputProfile( fiptr->in, fiptr->binary, &( fiptr->nextrecord ), &( bufferptr->profrc ));
+        //test, because could be empty line
+        if (bufferptr->prof != NULL) {
+            buffercounter++;
+        }
+    }
+
+    //set the counts
+    fiptr->buffercount = buffercounter;
+    fiptr->bufferindex = 0;
+    //printf("\nRead %d records",fiptr->buffercount);
+
+    //printf("\nAfter read records for file %s, bufferindex = %d, buffercount = %d",fiptr->inputfile, fiptr->bufferindex, fiptr->buffercount);
+
+    //close the file if finished
+    if(fiptr->buffercount == 0) {
+        //printf("\nNo more records, closing file %s.",fiptr->inputfile);
+        closeInput(fiptr);
+    }
+
+}
+
+/*******************************************************************************************/
+void loadRecordFromBufferAndGetMinRepresetation (FITEM_STRUCT * fiptr, int identical_only) {
+
+    int i = fiptr->bufferindex;
+
+    //load record
+    fiptr->prof = fiptr->buffer[i]->prof;
+    fiptr->profrc = fiptr->buffer[i]->profrc;
+
+    /*** this set of dir may be incorrect ***/
+    //	fiptr->dir = fiptr->buffer[i]->dir;
+    //probably don't need this
+    //fiptr->buffer[i] = NULL;
+
+    fiptr->bufferindex++;
+
+    //compute minRepresentation
+    if ( NULL != fiptr->prof ) {
+        fiptr->minRepresentation =  GetMinRepresentation( fiptr->prof, fiptr->profrc,
+                &( fiptr->minrlen ), &( fiptr->dir ), identical_only,
+                &( fiptr->keybuffer ), &( fiptr->maxkeybuffer ) );
+        fiptr->minrepprefix = MinRepPrefix( fiptr->minRepresentation, fiptr->minrlen );
+    }
+    else {
+        fiptr->minRepresentation = NULL;
+        fiptr->minrepprefix = ~0ULL;
+    }
+}
+/*******************************************************************************************/
+//frees a profile pair that was read, FreeProfile leaves the flanks
+void freeProfilePair( PROFILE *prof, PROFILE *profrc ) {
+
+    if ( NULL != profrc ) {
+        free( prof->left );
+        free( prof->right );
+        free( profrc->left );
+        free( profrc->right );
+    }
+
+    FreeProfile( prof );
+    FreeProfile( profrc );
+}
+
+/*******************************************************************************************/
+//compares the current key of a file with a range bound, the same way as pindcmp
+int rangeKeyCmp( FITEM_STRUCT *fiptr, const RANGE_KEY *key ) {
+
+    if ( fiptr->minrepprefix != key->minrepprefix )
+        return ( fiptr->minrepprefix < key->minrepprefix ) ? -1 : 1;
+
+    return pindcmp( fiptr->minRepresentation, key->minRepresentation,
+      fiptr->minrlen, key->minrlen );
+}
+
+/*******************************************************************************************/
+//moves a file on to its next record (in its range, if it has one)
+//at the end the buffers are released and minRepresentation is NULL
+void nextRecord( FITEM_STRUCT *fiptr, int identical_only ) {
+
+    const RANGE_STRUCT *range = fiptr->range;
+    int                 i;
+
+    while ( 1 ) {
+
+        //buffer is empty, read records from file into the buffer
+        if ( fiptr->bufferindex == fiptr->buffercount ) {
+            readRecordsFromFileToBuffer( fiptr );
+
+            if ( 0 == fiptr->buffercount )
+                break;
+        }
+
+        loadRecordFromBufferAndGetMinRepresetation( fiptr, identical_only );
+
+        if ( NULL == range )
+            return;
+
+        //ranges are only right for sorted inputs, a key going down says not
+        if ( fiptr->minrepprefix < fiptr->lastprefix )
+            fiptr->unsorted = 1;
+
+        fiptr->lastprefix = fiptr->minrepprefix;
+
+        //before the range, the seek only gets close to it
+        if ( NULL != range->lower.minRepresentation &&
+             rangeKeyCmp( fiptr, &range->lower ) < 0 ) {
+            freeProfilePair( fiptr->prof, fiptr->profrc );
+            continue;
+        }
+
+        //past the range, nothing after it is needed
+        if ( NULL != range->upper.minRepresentation &&
+             rangeKeyCmp( fiptr, &range->upper ) >= 0 ) {
+            freeProfilePair( fiptr->prof, fiptr->profrc );
+
+            for ( i = fiptr->bufferindex; i < fiptr->buffercount; i++ ) {
+                freeProfilePair( fiptr->buffer[i]->prof, fiptr->buffer[i]->profrc );
+            }
+
+            if ( !fiptr->inputclosed )
+                closeInput( fiptr );
+
+            break;
+        }
+
+        return;
+    }
+
+    //no more records for this fiptr
+    //no profiles or minRepresentations remain
+    if ( NULL != fiptr->buffer ) {
+        free( fiptr->buffer[0] );
+        free( fiptr->buffer );
+        fiptr->buffer = NULL;
+    }
+
+    fiptr->buffercount = fiptr->bufferindex = 0;
+    fiptr->prof = NULL;
+    fiptr->profrc = NULL;
+    fiptr->minRepresentation = NULL;
+    fiptr->minrepprefix = ~0ULL;
+}
+
+/*******************************************************************************************/
+//writes a merged record, the nonredundant ones start a new rotindex line
+void emitRecord( OUTPUT_STRUCT *out, PROFILE *prof, PROFILE *profrc, int dir,
+  int duplicate ) {
+
+    if ( duplicate ) {
+        fprintf( out->fpto2, " %d%c", prof->key,
+          ( 0 == dir ) ? '\'' : '\"' ); //add duplicate index entry
+
+        // in proclu 1.87 we need all profiles written
+        WriteOutputProfile( out->fpto, out->pwto, prof, profrc );
+        return;
+    }
+
+    out->nwritten++;
+
+    // write out
+    WriteOutputProfile( out->fpto, out->pwto, prof, profrc );
+
+    if ( out->nwritten > 1 ) {
+        fprintf( out->fpto2, "\n" ); //start new preserved index entry
+    }
+
+    fprintf( out->fpto2, "%d%c", prof->key,
+      ( 0 == dir ) ? '\'' : '\"' ); // add preserved index entry
+
+    // open new file?
+    //shouldn't this test be before the record is written?
+    if ( !out->single && ( out->nwritten % ( RECORDS_PER_FILE ) ) == 0 ) {
+        FinishOutput( out->pwto );
+        fclose( out->fpto );
+        fclose( out->fpto2 );
+
+        out->filescreated++;
+
+        // open the output file for writing
+        sprintf( out->outputfile, "%s/%d.%s", out->outputdname,
+          out->filescreated, out->outputbname );
+        out->fpto = fopen( out->outputfile, "w" );
+
+        if ( out->fpto == NULL ) {
+            printf( "\nERROR: Unable to open output file '%s'\n\n",
+              out->outputfile );
+            exit( 1 );
+        }
+
+        out->pwto = StartOutput( out->fpto, out->binary );
+
+        // open the index file for writing
+        sprintf( out->outputfile2, "%s/%d.%s.rotindex", out->outputdname,
+          out->filescreated, out->outputbname );
+        out->fpto2 = fopen( out->outputfile2, "w" );
+
+        if ( out->fpto2 == NULL ) {
+            printf( "\nERROR: Unable to open output file '%s'\n\n",
+              out->outputfile2 );
+            exit( 1 );
+        }
+    }
+}
+
+/*******************************************************************************************/
+//keeps a merged record of a range until the ranges before it are written
+void spoolRecord( SPOOL_STRUCT *spool, PROFILE *prof, PROFILE *profrc, int dir,
+  int duplicate ) {
+
+    if ( 0 != WriteProfileBinary( spool->pw, prof, profrc ) ||
+         EOF == putc( dir | ( duplicate << 1 ), spool->flags ) ) {
+        printf( "\nERROR: Unable to spool profile %d: %s\n\n", prof->key,
+          strerror( errno ) );
+        exit( 1 );
+    }
+}
+
+/*******************************************************************************************/
+//merges n files, each already on its first record, into the output or, for a
+//range merge, into its spool, returns the number of records read
+long long int mergeFiles( FITEM_STRUCT **files, int n, int identical_only,
+  OUTPUT_STRUCT *out, SPOOL_STRUCT *spool ) {
+
+    FITEM_STRUCT *fiptr, *lastwrite;
+    LOSER_NODE *  losers;
+    long long int nread;
+    int           duplicate;
+
+    //play the first round of the loser tree
+    losers    = smalloc( sizeof( LOSER_NODE ) * n );
+    losers[0] = buildLoserTree( files, losers, n, 1 );
+
+    //set up for loop
+    nread     = 0;
+    lastwrite = NULL;
+
+    while (1) { //break when all files are finished
+
+        //get smallest record for writing
+        fiptr = files[losers[0].file];
+
+        //test if done
+        if (fiptr->minRepresentation == NULL)
+            break;
+
+        nread++;
+
+        // decide how to write and write profiles
+        // first if identifies duplicates of the last written record
+        // test if all the below occur
+        //   1: there is a last written record
+        //   2: for this record and the last written one
+        //     the minimum profiles match
+        //   3: for this record and the last written one
+        //     either the two forward profiles match,
+        //     the two reverse profiles match,
+        //     or there is a match between one profile and one reverse profile
+        // The last condition seems to be redundant, but probably assures that the two profiles are not NULLwhich would return a match for condition 2. 
+
+        duplicate = ((lastwrite != NULL) &&
+            (0 == arsize_and_min_rep_cmp( lastwrite, fiptr ) ) &&
+
+            // (ADDED apr 18, 2013)
+            ( ( 0 == pindcmp( fiptr->prof->indices, lastwrite->prof->indices,
+                        fiptr->prof->proflen, lastwrite->prof->proflen ) &&
+                0 == pindcmp( fiptr->profrc->indices,
+                        lastwrite->profrc->indices, fiptr->profrc->proflen,
+                        lastwrite->profrc->proflen ) ) ||
+             ( 0 == pindcmp( fiptr->prof->indices, lastwrite->profrc->indices,
+                        fiptr->prof->proflen, lastwrite->profrc->proflen ) &&
+                0 == pindcmp( fiptr->profrc->indices, lastwrite->prof->indices,
+                        fiptr->profrc->proflen,
+                        lastwrite->prof->proflen ) )
+            ) );
+
+        if ( NULL != spool )
+            spoolRecord( spool, fiptr->prof, fiptr->profrc, fiptr->dir, duplicate );
+        else
+            emitRecord( out, fiptr->prof, fiptr->profrc, fiptr->dir, duplicate );
+
+        //don't free lastwrite for a duplicate, because still in use
+        if ( !duplicate ) {
+
+            //free lastwrite here, because no longer used
+            if ( NULL != lastwrite ) {
+                FreeProfile( lastwrite->prof );
+                FreeProfile( lastwrite->profrc );
+                free( lastwrite->minRepresentation );
+                free( lastwrite );
+            }
+
+            //set lastwrite for comparison with next smallest record
+            lastwrite = smalloc( sizeof( FITEM_STRUCT ) );
+            lastwrite->prof = CopyProfile( fiptr->prof );
+            lastwrite->profrc = CopyProfile( fiptr->profrc );
+            lastwrite->minRepresentation = pintdup( fiptr->minRepresentation, fiptr->minrlen );
+            lastwrite->minrlen = fiptr->minrlen;
+        }
+
+        //at this point, free the profiles, minRepresentation goes with them
+        freeProfilePair( fiptr->prof, fiptr->profrc );
+
+        //load new profiles, from the buffer or the file
+        nextRecord( fiptr, identical_only );
+
+        //replay the matches of the file that won
+        replayLoserTree( files, losers, n );
+    }
+
+    if ( NULL != lastwrite ) {
+        FreeProfile( lastwrite->prof );
+        FreeProfile( lastwrite->profrc );
+        free( lastwrite->minRepresentation );
+        free( lastwrite );
+    }
+
+    free( losers );
+
+    return nread;
+}
+
+/*******************************************************************************************/
+//adds the key of a record to the samples of its input, 1 if it is out of
+//order (or there is none)
+int addSample( FITEM_STRUCT *fiptr, PROFILE *prof, PROFILE *profrc,
+  long long position, int *maxsamples, int identical_only ) {
+
+    int *    minrep, minrlen, dir, unsorted = 0;
+    uint64_t prefix;
+
+    minrep = GetMinRepresentation( prof, profrc, &minrlen, &dir, identical_only,
+      &( fiptr->keybuffer ), &( fiptr->maxkeybuffer ) );
+
+    if ( NULL == minrep ) {
+        prefix   = ~0ULL;
+        unsorted = 1;
+    } else {
+        prefix = MinRepPrefix( minrep, minrlen );
+    }
+
+    if ( fiptr->nsamples > 0 &&
+         prefix < fiptr->samples[fiptr->nsamples - 1].prefix )
+        unsorted = 1;
+
+    if ( fiptr->nsamples == *maxsamples ) {
+        *maxsamples    = ( *maxsamples ) ? 2 * *maxsamples : 1024;
+        fiptr->samples = (KEY_SAMPLE *) realloc(
+          fiptr->samples, *maxsamples * sizeof( KEY_SAMPLE ) );
+
+        if ( NULL == fiptr->samples ) {
+            printf( "\nERROR: Insuficient memory to index '%s'\n\n",
+              fiptr->inputfile );
+            exit( 1 );
+        }
+    }
+
+    fiptr->samples[fiptr->nsamples].prefix   = prefix;
+    fiptr->samples[fiptr->nsamples].position = position;
+    fiptr->nsamples++;
+
+    freeProfilePair( prof, profrc );
+
+    return unsorted;
+}
+
+/*******************************************************************************************/
+//samples the key of every INDEX_STRIDE-th record of an input and of its last
+//one, with where they start, returns 1 if the keys are not sorted
+int sampleInput( FITEM_STRUCT *fiptr, int identical_only ) {
+
+    PROFILE * prof, *profrc;
+    int       maxsamples = 0, unsorted = 0, c;
+    long long position = 0, sampled = -1;
+    uint64_t  record;
+
+    fiptr->nsamples = 0;
+
+    if ( NULL != fiptr->binary ) {
+        for ( record = 0; record < fiptr->binary->nrecords; record++ ) {
+            if ( 0 == record % INDEX_STRIDE ||
+                 record + 1 == fiptr->binary->nrecords ) {
+                prof = ReadProfileFromBinary(
+                  ProfbinRecord( fiptr->binary, record ), &profrc );
+                unsorted |= addSample(
+                  fiptr, prof, profrc, record, &maxsamples, identical_only );
+            }
+        }
+
+        return unsorted;
+    }
+
+    rewind( fiptr->in );
+
+    for ( record = 0;; record++ ) {
+
+        // a record starts on the first character that is not a space
+        do {
+            c = getc( fiptr->in );
+        } while ( isspace( c ) );
+
+        if ( EOF == c )
+            break;
+
+        ungetc( c, fiptr->in );
+        position = ftello( fiptr->in );
+
+        if ( 0 != record % INDEX_STRIDE ) {
+            if ( EOF == fscanf( fiptr->in, "%*[^\n]" ) )
+                break;
+
+            continue;
+        }
+
+        prof = ReadProfileWithRC( fiptr->in, &profrc );
+
+        if ( NULL == prof )
+            break;
+
+        unsorted |=
+          addSample( fiptr, prof, profrc, position, &maxsamples, identical_only );
+        sampled = position;
+    }
+
+    // the last record bounds the keys of the whole input
+    if ( position != sampled && 0 == fseeko( fiptr->in, position, SEEK_SET ) &&
+         NULL != ( prof = ReadProfileWithRC( fiptr->in, &profrc ) ) )
+        unsorted |=
+          addSample( fiptr, prof, profrc, position, &maxsamples, identical_only );
+
+    return unsorted;
+}
+
+/*******************************************************************************************/
+//number of samples with a key prefix below (or, with orequal, up to) prefix
+int samplesBelow( FITEM_STRUCT *fiptr, uint64_t prefix, int orequal ) {
+
+    int lo = 0, hi = fiptr->nsamples, mid;
+
+    while ( lo < hi ) {
+        mid = ( lo + hi ) / 2;
+
+        if ( fiptr->samples[mid].prefix < prefix ||
+             ( orequal && fiptr->samples[mid].prefix == prefix ) )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/*******************************************************************************************/
+//full key of the sampled record at a position of an input
+void sampledKey( FITEM_STRUCT *fiptr, long long position, RANGE_KEY *key,
+  int identical_only ) {
+
+    PROFILE *prof, *profrc;
+    int *    minrep, dir;
+
+    if ( NULL != fiptr->binary ) {
+        prof = ReadProfileFromBinary(
+          ProfbinRecord( fiptr->binary, position ), &profrc );
+    } else if ( 0 != fseeko( fiptr->in, position, SEEK_SET ) ||
+                NULL == ( prof = ReadProfileWithRC( fiptr->in, &profrc ) ) ) {
+        printf( "\nERROR: Unable to read back a record of '%s'\n\n",
+          fiptr->inputfile );
+        exit( 1 );
+    }
+
+    minrep = GetMinRepresentation( prof, profrc, &( key->minrlen ), &dir,
+      identical_only, &( fiptr->keybuffer ), &( fiptr->maxkeybuffer ) );
+    key->minRepresentation = pintdup( minrep, key->minrlen );
+    key->minrepprefix = MinRepPrefix( key->minRepresentation, key->minrlen );
+
+    freeProfilePair( prof, profrc );
+}
+
+/*******************************************************************************************/
+typedef struct {
+    uint64_t prefix;
+    int      file, sample;
+} SAMPLE_REF;
+
+int sample_ref_cmp( const void *item1, const void *item2 ) {
+
+    uint64_t p1 = ( (SAMPLE_REF *) item1 )->prefix,
+             p2 = ( (SAMPLE_REF *) item2 )->prefix;
+
+    return ( p1 > p2 ) - ( p1 < p2 );
+}
+
+int range_key_cmp( const void *item1, const void *item2 ) {
+
+    const RANGE_KEY *k1 = (const RANGE_KEY *) item1,
+                    *k2 = (const RANGE_KEY *) item2;
+
+    if ( k1->minrepprefix != k2->minrepprefix )
+        return ( k1->minrepprefix < k2->minrepprefix ) ? -1 : 1;
+
+    return pindcmp(
+      k1->minRepresentation, k2->minRepresentation, k1->minrlen, k2->minrlen );
+}
+
+/*******************************************************************************************/
+//splits the key space in up to nranges ranges at quantiles of the sampled
+//keys of all the inputs, returns the number of ranges made
+int makeRanges( FITEM_STRUCT **files, int n, int nranges, int identical_only,
+  RANGE_STRUCT **rangesret ) {
+
+    SAMPLE_REF *  refs;
+    RANGE_KEY *   splitters;
+    RANGE_STRUCT *ranges;
+    long long     nrefs = 0, k;
+    int           i, j, nsplitters;
+
+    for ( i = 0; i < n; i++ )
+        nrefs += files[i]->nsamples;
+
+    refs = smalloc( nrefs * sizeof( SAMPLE_REF ) );
+
+    for ( k = 0, i = 0; i < n; i++ ) {
+        for ( j = 0; j < files[i]->nsamples; j++, k++ ) {
+            refs[k].prefix = files[i]->samples[j].prefix;
+            refs[k].file   = i;
+            refs[k].sample = j;
+        }
+    }
+
+    qsort( refs, nrefs, sizeof( SAMPLE_REF ), sample_ref_cmp );
+
+    // the prefixes only order the samples roughly, which is enough to balance
+    // the ranges, the splitters themselves are full keys in their own order
+    splitters = smalloc( nranges * sizeof( RANGE_KEY ) );
+
+    for ( i = 1; i < nranges; i++ ) {
+        k = nrefs * i / nranges;
+        sampledKey( files[refs[k].file],
+          files[refs[k].file]->samples[refs[k].sample].position,
+          &splitters[i - 1], identical_only );
+    }
+
+    free( refs );
+
+    qsort( splitters, nranges - 1, sizeof( RANGE_KEY ), range_key_cmp );
+
+    // a key shared by many records splits nothing, its records stay in one range
+    for ( nsplitters = 0, i = 0; i < nranges - 1; i++ ) {
+        if ( nsplitters > 0 &&
+             0 == range_key_cmp( &splitters[nsplitters - 1], &splitters[i] ) )
+            free( splitters[i].minRepresentation );
+        else
+            splitters[nsplitters++] = splitters[i];
+    }
+
+    ranges = scalloc( nsplitters + 1, sizeof( RANGE_STRUCT ) );
+
+    for ( i = 0; i < nsplitters; i++ ) {
+        ranges[i].upper     = splitters[i];
+        ranges[i + 1].lower = splitters[i];
+    }
+
+    free( splitters );
+
+    *rangesret = ranges;
+    return nsplitters + 1;
+}
+
+/*******************************************************************************************/
+//merges the records of one key range of all the inputs into a spool
+void *mergeRange( void *arg ) {
+
+    RANGE_TASK *   task = (RANGE_TASK *) arg;
+    FITEM_STRUCT **files, *fiptr, *input;
+    int            i, start, end;
+
+    files = smalloc( sizeof( FITEM_STRUCT * ) * task->ninputs );
+
+    for ( i = 0; i < task->ninputs; i++ ) {
+        input = task->inputs[i];
+        fiptr = smalloc( sizeof( FITEM_STRUCT ) );
+
+        fiptr->inputfile = input->inputfile;
+        fiptr->d_name    = input->d_name;
+        fiptr->range     = &( task->range );
+
+        // last sample surely before the range, first one surely after it
+        start = ( NULL == task->range.lower.minRepresentation )
+                  ? -1
+                  : samplesBelow( input, task->range.lower.minrepprefix, 0 ) - 1;
+        end   = ( NULL == task->range.upper.minRepresentation )
+                  ? input->nsamples
+                  : samplesBelow( input, task->range.upper.minrepprefix, 1 );
+
+        if ( NULL != input->binary ) {
+            fiptr->binary     = input->binary;
+            fiptr->nextrecord = ( start < 0 ) ? 0 : input->samples[start].position;
+            fiptr->endrecord  = ( end == input->nsamples )
+                                 ? input->binary->nrecords
+                                 : (uint64_t) input->samples[end].position;
+        } else {
+            fiptr->in = fopen( fiptr->inputfile, "r" );
+
+            if ( NULL != fiptr->in )
+                bufferInput( fiptr );
+
+            if ( NULL == fiptr->in ||
+                 0 != fseeko( fiptr->in,
+                        ( start < 0 ) ? 0 : input->samples[start].position,
+                        SEEK_SET ) ) {
+                printf( "\nERROR opening input file '%s': %s\n",
+                  fiptr->inputfile, strerror( errno ) );
+                exit( 1 );
+            }
+
+            fiptr->endoffset = ( end == input->nsamples )
+                                 ? -1
+                                 : input->samples[end].position;
+        }
+
+        nextRecord( fiptr, task->identical_only );
+        files[i] = fiptr;
     }
 
-    return res;
-}
+    task->nread =
+      mergeFiles( files, task->ninputs, task->identical_only, NULL, &( task->spool ) );
 
-/*******************************************************************************************/
-int ftouch( char *in ) {
+    if ( 0 != ProfbinClose( task->spool.pw ) || 0 != fflush( task->spool.flags ) ) {
+        printf( "\nERROR: Unable to finish a spool file: %s\n\n",
+          strerror( errno ) );
+        exit( 1 );
+    }
 
-    FILE *fp;
+    for ( i = 0; i < task->ninputs; i++ ) {
+        task->unsorted |= files[i]->unsorted;
+        free( files[i]->keybuffer );
+        free( files[i] );
+    }
 
-    if ( ( fp = fopen( in, "r" ) ) == NULL )
-        return 0;
+    free( files );
 
-    fclose( fp );
-    return 1;
+    return NULL;
 }
 
-int RC = 0;
-
 /*******************************************************************************************/
-int *MinimumRepresentation( int *indptr, int len, int *indptrrc, int lenrc,
-  int *minrlen, int identical_only ) {
-
-//finds the minimum profile and profile length from the profile and reverse complement profile
-//when identical_only == 1, no profile rotations are performed
-//this is the case with the current VNTRseek
-
-    int  i, j;
-    int *src, *srcrc, *tar,
-      // *sourceptr,
-      // *destinptr,
-      tmp //,
-      // *indices
-      ;
+//writes the spool of a range merge to the output
+void replaySpool( SPOOL_STRUCT *spool, OUTPUT_STRUCT *out ) {
 
-    RC = 0;
+    PROFBIN_FILE *pf;
+    PROFILE *     prof, *profrc;
+    uint64_t      i;
+    int           flags;
 
-    if ( NULL == indptr || NULL == indptrrc )
-        return NULL;
+    pf = ProfbinMap( spool->fp );
 
-    src   = pintdup( indptr, len );
-    srcrc = pintdup( indptrrc, lenrc );
+    if ( NULL == pf ) {
+        printf( "\nERROR: Unable to map a spool file\n\n" );
+        exit( 1 );
+    }
 
-    tar = pintdup( indptr, len );
+    rewind( spool->flags );
 
-    /* added on feb 6, 2013 */
-    if ( identical_only ) {
+    for ( i = 0; i < pf->nrecords; i++ ) {
+        prof  = ReadProfileFromBinary( ProfbinRecord( pf, i ), &profrc );
+        flags = getc( spool->flags );
 
-        // minimum of the forward and reverse profiles
-        if ( pindcmp( srcrc, tar, lenrc, len ) < 0 ) {
-            free( tar );
-            tar = pintdup( srcrc, lenrc );
-            RC  = 1;
+        if ( EOF == flags ) {
+            printf( "\nERROR: Spool file ended early\n\n" );
+            exit( 1 );
         }
 
-    } else {
-
-        // FORWARD - test each rotation and find the minimum one
-        for ( i = 1; i < len; i++ ) {
+        emitRecord( out, prof, profrc, flags & 1, ( flags >> 1 ) & 1 );
 
-            // printf("\n\nstart: %s",src);
+        freeProfilePair( prof, profrc );
+    }
 
-            // rotate by 1
-            tmp = src[0];
+    ProfbinUnmap( pf );
+}
 
-            for ( j = 1; j < len; j++ ) {
-                src[j - 1] = src[j];
-            }
+/*******************************************************************************************/
+//merges a group of inputs into a sorted run, a binary profile file of all
+//their records, equal records stay in input file order so merging the runs
+//of consecutive groups gives what one merge of all the inputs would
+void mergeRun( RUN_TASK *task, int identical_only ) {
 
-            src[len - 1] = tmp;
+    FITEM_STRUCT **files = task->inputs, *fiptr;
+    LOSER_NODE *   losers;
+    int            i, n = task->ninputs;
 
-            // printf("\nend: %s comp: %d\n\n",src,strcmp(src,tar));
-            // exit(1);
+    for ( i = 0; i < n; i++ ) {
+        openInput( files[i] );
+        nextRecord( files[i], identical_only );
 
-            if ( pindcmp( src, tar, len, len ) < 0 ) {
-                free( tar );
-                tar = pintdup( src, len );
-            }
+        if ( NULL == files[i]->prof ) {
+            printf( "\nERROR: Input file %s was empty\n\n", files[i]->inputfile );
+            exit( 1 );
         }
+    }
 
-        // REVERSE - test each rotation and find the minimum one
-        for ( i = 1; i < lenrc; i++ ) {
+    losers    = smalloc( sizeof( LOSER_NODE ) * n );
+    losers[0] = buildLoserTree( files, losers, n, 1 );
 
-            // printf("\n\nstart: %s",src);
+    while ( 1 ) {
+        fiptr = files[losers[0].file];
 
-            // rotate by 1
-            tmp = srcrc[0];
+        if ( NULL == fiptr->minRepresentation )
+            break;
 
-            for ( j = 1; j < len; j++ ) {
-                srcrc[j - 1] = srcrc[j];
-            }
+        if ( 0 != WriteProfileBinary( task->pw, fiptr->prof, fiptr->profrc ) ) {
+            printf( "\nERROR: Unable to write run '%s': %s\n\n",
+              task->run->inputfile, strerror( errno ) );
+            exit( 1 );
+        }
 
-            srcrc[lenrc - 1] = tmp;
+        freeProfilePair( fiptr->prof, fiptr->profrc );
+        nextRecord( fiptr, identical_only );
+        replayLoserTree( files, losers, n );
+    }
 
-            // printf("\nend: %s comp: %d\n\n",src,strcmp(src,tar));
-            // exit(1);
+    free( losers );
 
-            if ( pindcmp( srcrc, tar, lenrc, len ) < 0 ) {
-                free( tar );
-                tar = pintdup( srcrc, lenrc );
-                RC  = 1;
-            }
-        }
+    if ( 0 != ProfbinClose( task->pw ) || 0 != fclose( task->fp ) ) {
+        printf( "\nERROR: Unable to finish run '%s': %s\n\n",
+          task->run->inputfile, strerror( errno ) );
+        exit( 1 );
     }
+}
 
-    // save rotated
-    free( src );
-    free( srcrc );
+/*******************************************************************************************/
+//takes the groups of a pass one at a time until none are left
+void *mergeRuns( void *arg ) {
 
-    *minrlen = ( 0 == RC ) ? len : lenrc;
+    RUN_POOL *pool = (RUN_POOL *) arg;
+    RUN_TASK *task;
+    int       i;
 
-    return tar;
-}
+    while ( 1 ) {
 
-/*******************************************************************************************/
-//restores the heap after adding a new element to the top
-void siftDown(EASY_ARRAY *array, int start, int n) {
-    FITEM_STRUCT *temp, *fiptr1, *fiptr2;
-    int swap, i, j, test;
-
-    swap = start;
-    i=2*start+1; //left child
-    while (i < n) {
-        //put smallest element on top
-        //test left child
-        fiptr1 = (FITEM_STRUCT *)EasyArrayItem(array,swap);
-        fiptr2 = (FITEM_STRUCT *)EasyArrayItem(array,i);
-
-        test = arsize_and_min_rep_cmp(fiptr2, fiptr1);
-        //printf("\nGot here in siftDown");
-
-        if (test < 0){
-            swap=i;
-            fiptr1 = fiptr2;
+        //the run is created under the lock, profbin sets up its tables the
+        //first time a file is created
+        pthread_mutex_lock( &( pool->lock ) );
+        i = pool->next++;
+
+        if ( i >= pool->ntasks ) {
+            pthread_mutex_unlock( &( pool->lock ) );
+            break;
         }
-        //test right child
-        j=i+1;
-        if (j < n){
-            fiptr2 = (FITEM_STRUCT *)EasyArrayItem(array,j);
-            test = arsize_and_min_rep_cmp(fiptr2, fiptr1);
-            if(test < 0) {
-                swap = j;
-                fiptr1 = fiptr2;
-            }
+
+        task     = &( pool->tasks[i] );
+        task->fp = fopen( task->run->inputfile, "w" );
+
+        if ( NULL == task->fp ||
+             NULL == ( task->pw = ProfbinCreate( task->fp ) ) ) {
+            printf( "\nERROR: Unable to create run '%s': %s\n\n",
+              task->run->inputfile, strerror( errno ) );
+            exit( 1 );
         }
-        //break if no change
-        if (swap == start) break;
-        //else swap
-        temp = EasyArrayItem(array,start);
-        //have to set these directly because there's no EasyArraySet function;
-        array->array[start] = fiptr1;
-        array->array[swap] = temp;
-        //printf("\nGot here in siftDown");
-        //reset and continue
-        start = swap;
-        i = 2*start+1;
-    }
-    //printf("\nGot here end of siftDown");
-}
 
-/*******************************************************************************************/
-void heapify(EASY_ARRAY *array, int n) {
-    //n is length of array[0..n-1]
-    int start;
+        pthread_mutex_unlock( &( pool->lock ) );
 
-    for(start=(n-2)/2; start>=0; start--) {
-        siftDown(array,start,n);
+        mergeRun( task, pool->identical_only );
     }
-    //printf("\nGot here end of heapify");
-}
 
-    /*******************************************************************************************/
-void readRecordsFromFileToBuffer(FITEM_STRUCT *fiptr) {
-    int  bn, buffercounter=0;
-    RECORD_STRUCT * bufferptr, *tempbufferptr;
+    return NULL;
+}
 
-    //allocate buffer pointer memory on reading first records
-    if (fiptr->buffer == NULL)
-        fiptr->buffer = (RECORD_STRUCT **)calloc(MAX_BUFFER_SIZE, sizeof(RECORD_STRUCT *));
+/*******************************************************************************************/
+//merges groups of up to maxfanin consecutive inputs into runs in rundir, on
+//up to nthreads threads, returns the runs, in the order of their groups
+FITEM_STRUCT **mergePass( FITEM_STRUCT **files, int n, int maxfanin,
+  int nthreads, int identical_only, const char *rundir, int pass,
+  int *nruns ) {
+
+    FITEM_STRUCT **runs;
+    RUN_POOL       pool;
+    pthread_t *    threads;
+    char *         name;
+    int            i;
+
+    pool.ntasks         = ( n + maxfanin - 1 ) / maxfanin;
+    pool.next           = 0;
+    pool.identical_only = identical_only;
+    pool.tasks          = scalloc( pool.ntasks, sizeof( RUN_TASK ) );
+    pthread_mutex_init( &( pool.lock ), NULL );
+
+    runs = smalloc( sizeof( FITEM_STRUCT * ) * pool.ntasks );
+    name = smalloc( strlen( rundir ) + 40 );
+
+    for ( i = 0; i < pool.ntasks; i++ ) {
+        sprintf( name, "%s/%d.%d.run", rundir, pass, i );
+        runs[i]            = smalloc( sizeof( FITEM_STRUCT ) );
+        runs[i]->inputfile = strdup( name );
+        runs[i]->d_name    = strdup( basename( name ) );
+
+        pool.tasks[i].inputs  = files + i * maxfanin;
+        pool.tasks[i].ninputs = min( maxfanin, n - i * maxfanin );
+        pool.tasks[i].run     = runs[i];
+    }
 
-    //free records memory on subsequent rounds before allocating new records
-    if(fiptr->buffer[0] != NULL)
-        free(fiptr->buffer[0]);
+    free( name );
 
-    //allocate new records memory
-    tempbufferptr = (RECORD_STRUCT *)calloc(MAX_BUFFER_SIZE, sizeof(RECORD_STRUCT)); 
-    for(bn = 0; bn < MAX_BUFFER_SIZE; bn++) {
-        fiptr->buffer[bn] = tempbufferptr;
-        tempbufferptr++;
-    }
+    nthreads = min( nthreads, pool.ntasks );
 
-    //printf("\n\nBefore read records for file %s, bufferindex = %d, buffercount = %d",fiptr->inputfile, fiptr->bufferindex, fiptr->buffercount);
+    if ( nthreads <= 1 ) {
+        mergeRuns( &pool );
+    } else {
+        threads = smalloc( sizeof( pthread_t ) * nthreads );
 
-    //read records
-    //printf("\nReading records from %s",fiptr->inputfile);
-    while (!feof(fiptr->in) && buffercounter<MAX_BUFFER_SIZE) {
-        bufferptr = fiptr->buffer[buffercounter];
-        bufferptr->prof = ReadProfileWithRC( fiptr->in, &( bufferptr->profrc ));
-        //test, because could be empty line
-        if (bufferptr->prof != NULL) {
-            buffercounter++;
+        for ( i = 0; i < nthreads; i++ ) {
+            if ( 0 != pthread_create( &threads[i], NULL, mergeRuns, &pool ) ) {
+                printf( "\nERROR: Unable to start a merge thread\n\n" );
+                exit( 1 );
+            }
         }
-    }
 
-    //set the counts
-    fiptr->buffercount = buffercounter;
-    fiptr->bufferindex = 0;
-    //printf("\nRead %d records",fiptr->buffercount);
+        for ( i = 0; i < nthreads; i++ )
+            pthread_join( threads[i], NULL );
 
-    //printf("\nAfter read records for file %s, bufferindex = %d, buffercount = %d",fiptr->inputfile, fiptr->bufferindex, fiptr->buffercount);
-
-    //close the file if finished
-    if(fiptr->buffercount == 0) {
-        //printf("\nNo more records, closing file %s.",fiptr->inputfile);
-        fclose(fiptr->in);
-        fiptr->inputclosed = 1;
+        free( threads );
     }
 
+    pthread_mutex_destroy( &( pool.lock ) );
+    free( pool.tasks );
+
+    *nruns = ( n + maxfanin - 1 ) / maxfanin;
+    return runs;
 }
 
 /*******************************************************************************************/
-void loadRecordFromBufferAndGetMinRepresetation (FITEM_STRUCT * fiptr, int identical_only) {
+//raises the soft limit on open files as far as the hard one lets it, returns
+//the limit in force
+long long openFileLimit( void ) {
 
-    int i = fiptr->bufferindex;
-
-    //load record
-    fiptr->prof = fiptr->buffer[i]->prof;
-    fiptr->profrc = fiptr->buffer[i]->profrc;
+    struct rlimit lim;
+    rlim_t        soft;
 
-    /*** this set of dir may be incorrect ***/
-    //	fiptr->dir = fiptr->buffer[i]->dir;
-    //probably don't need this
-    //fiptr->buffer[i] = NULL;
+    if ( 0 != getrlimit( RLIMIT_NOFILE, &lim ) )
+        return 1024;
 
-    fiptr->bufferindex++;
+    soft = lim.rlim_cur;
 
-    //compute minRepresentation
-    if ( NULL != fiptr->prof ) {
-        fiptr->minRepresentation =  MinimumRepresentation( fiptr->prof->indices, fiptr->prof->proflen,
-                fiptr->profrc->indices, fiptr->profrc->proflen,
-                &( fiptr->minrlen ), identical_only );
+    if ( lim.rlim_cur != lim.rlim_max ) {
+        lim.rlim_cur = lim.rlim_max;
 
-    /*** added RC here ***/
-        fiptr->dir = RC;
-    }
-    else {
-        fiptr->minRepresentation = NULL;
+        if ( 0 == setrlimit( RLIMIT_NOFILE, &lim ) )
+            soft = lim.rlim_max;
     }
+
+    return ( RLIM_INFINITY == soft || soft > INT_MAX ) ? INT_MAX : (long long) soft;
 }
+
 /*******************************************************************************************/
 int main( int argc, char **argv ) {
-    int   SINGLE_OUTFILE, SORT_ONLY, IDENTICAL_ONLY;
-    FILE *fpto, *fpto2;
+    int   SINGLE_OUTFILE, SORT_ONLY, IDENTICAL_ONLY, BINARY_OUTPUT, NTHREADS,
+      MAXFANIN;
+    FILE *fpto;
+    OUTPUT_STRUCT out;
+    PROFBIN_WRITER *pwto;
     char *bigtempbuf, *inputfile, *outputdname, *outputbname, *outputfile,
-      *outputfile2, *outdb, *err_msg = 0;
-    int            i, filescreated = 1, rc;
+      *outputfile2, *outdb, *rundir = NULL, *err_msg = 0;
+    int            i, rc, nranges, unsorted, pass, nruns, passthreads, ntext;
     time_t         startTime;
-    FITEM_STRUCT * fiptr, *fiptr2, *lastwrite;
+    FITEM_STRUCT * fiptr, **files, **runs;
+    RANGE_STRUCT * ranges;
+    RANGE_TASK *   tasks;
     PITEM_STRUCT * piptr;
     EASY_ARRAY *   FARRAY = NULL;
     struct dirent *de     = NULL;
@@ -529,9 +1598,8 @@ int main( int argc, char **argv ) {
     long long int  nwritten, nread;
     sqlite3 *      db;
     sqlite3_stmt * res, *pStmt;
-    struct rlimit old_lim, lim, new_lim; 
-    int filecounter, buffercounter, bn, softlimit;
-    RECORD_STRUCT *tempbufferptr;
+    long long      openlimit;
+    int filecounter;
     struct rusage *usage;
 
     usage = (struct rusage *)calloc(1, sizeof(struct rusage));
@@ -550,6 +1618,13 @@ int main( int argc, char **argv ) {
                 "otherwise) \n\n\n" );
         printf( "   -i options will only remove identical profiles, without "
                 "rotating \n\n\n" );
+        printf( "   -b options will write binary profile files instead of "
+                "LEB36 \n\n\n" );
+        printf( "   -t N options will merge on N threads, each on a range of "
+                "keys \n\n\n" );
+        printf( "   -f N options will merge at most N files at once, more are "
+                "merged in passes (default %d) \n\n\n",
+          MAX_FANIN );
 
         exit( 1 );
     }
@@ -567,57 +1642,51 @@ int main( int argc, char **argv ) {
     }
 
     IDENTICAL_ONLY = 0;
-
-    if ( argc >= 4 &&
-         ( 0 == strcmp( "-I", argv[3] ) || 0 == strcmp( "-i", argv[3] ) ) ) {
-        IDENTICAL_ONLY = 1;
-    }
-
-    if ( argc >= 5 &&
-         ( 0 == strcmp( "-I", argv[4] ) || 0 == strcmp( "-i", argv[4] ) ) ) {
-        IDENTICAL_ONLY = 1;
-    }
-
-    if ( argc >= 6 &&
-         ( 0 == strcmp( "-I", argv[5] ) || 0 == strcmp( "-i", argv[5] ) ) ) {
-        IDENTICAL_ONLY = 1;
-    }
-
     SINGLE_OUTFILE = 0;
+    SORT_ONLY      = 0;
+    BINARY_OUTPUT  = 0;
+    NTHREADS       = 1;
+    MAXFANIN       = MAX_FANIN;
+
+    for ( i = 3; i < argc; i++ ) {
+        if ( 0 == strcmp( "-I", argv[i] ) || 0 == strcmp( "-i", argv[i] ) ) {
+            IDENTICAL_ONLY = 1;
+        }
 
-    if ( argc >= 4 &&
-         ( 0 == strcmp( "-N", argv[3] ) || 0 == strcmp( "-n", argv[3] ) ) ) {
-        SINGLE_OUTFILE = 1;
-    }
+        if ( 0 == strcmp( "-N", argv[i] ) || 0 == strcmp( "-n", argv[i] ) ) {
+            SINGLE_OUTFILE = 1;
+        }
 
-    if ( argc >= 5 &&
-         ( 0 == strcmp( "-N", argv[4] ) || 0 == strcmp( "-n", argv[4] ) ) ) {
-        SINGLE_OUTFILE = 1;
-    }
+        if ( 0 == strcmp( "-S", argv[i] ) || 0 == strcmp( "-s", argv[i] ) ) {
+            SORT_ONLY      = 1;
+            SINGLE_OUTFILE = 1;
+        }
 
-    if ( argc >= 6 &&
-         ( 0 == strcmp( "-N", argv[5] ) || 0 == strcmp( "-n", argv[5] ) ) ) {
-        SINGLE_OUTFILE = 1;
-    }
+        if ( 0 == strcmp( "-B", argv[i] ) || 0 == strcmp( "-b", argv[i] ) ) {
+            BINARY_OUTPUT = 1;
+        }
 
-    SORT_ONLY = 0;
+        if ( ( 0 == strcmp( "-T", argv[i] ) || 0 == strcmp( "-t", argv[i] ) ) &&
+             i + 1 < argc ) {
+            NTHREADS = atoi( argv[++i] );
 
-    if ( argc >= 4 &&
-         ( 0 == strcmp( "-S", argv[3] ) || 0 == strcmp( "-s", argv[3] ) ) ) {
-        SORT_ONLY      = 1;
-        SINGLE_OUTFILE = 1;
-    }
+            if ( NTHREADS < 1 ) {
+                printf( "\nERROR: -t needs a number of threads of 1 or "
+                        "more\n\n" );
+                exit( 1 );
+            }
+        }
 
-    if ( argc >= 5 &&
-         ( 0 == strcmp( "-S", argv[4] ) || 0 == strcmp( "-s", argv[4] ) ) ) {
-        SORT_ONLY      = 1;
-        SINGLE_OUTFILE = 1;
-    }
+        if ( ( 0 == strcmp( "-F", argv[i] ) || 0 == strcmp( "-f", argv[i] ) ) &&
+             i + 1 < argc ) {
+            MAXFANIN = atoi( argv[++i] );
 
-    if ( argc >= 6 &&
-         ( 0 == strcmp( "-S", argv[5] ) || 0 == strcmp( "-s", argv[5] ) ) ) {
-        SORT_ONLY      = 1;
-        SINGLE_OUTFILE = 1;
+            if ( MAXFANIN < 2 ) {
+                printf( "\nERROR: -f needs a number of files of 2 or "
+                        "more\n\n" );
+                exit( 1 );
+            }
+        }
     }
 
     char *tmp   = strdup( argv[2] );
@@ -629,7 +1698,7 @@ int main( int argc, char **argv ) {
     outputfile2 = calloc( strlen( outputdname ) + strlen( outputbname ) + 19,
       sizeof( *outputfile2 ) );
     outdb       = calloc(
-      strlen( outputdname ) + strlen( outputbname ) + 4, sizeof( *outdb ) );
+      strlen( outputdname ) + strlen( outputbname ) + 5, sizeof( *outdb ) );
 
     if ( SINGLE_OUTFILE ) {
         sprintf( outputfile, "%s", argv[2] );
@@ -652,17 +1721,26 @@ int main( int argc, char **argv ) {
     //Started 8/25/20 Gary Benson
     //changes to convert to a merge sort of the existing leb36 files which are already sorted
     //Basic outline
-    //  Set open file limit high enough for the number of files plus some extra
+    //  While there are more files than MAXFANIN, merge each group of MAXFANIN
+    //    consecutive files into a sorted run, the runs are the files of the
+    //    next pass (and of the merge below), no record is dropped in a run
     //  Open all the files
     //  read first MAX_BUFFER_SIZE records from each file into a buffer for each file
-    //  move the first record from each buffer into a heap
-    //  heapify to find the smallest record and write to the output file
+    //  move the first record from each buffer into a loser tree
+    //  the winner of the tree is the smallest record, write it to the output file
     //  reload a record from the buffer which had the smallest record
     //  if a buffer is empty, read the next 10,000 records from that buffer's file
     //  if the file is empty,
     //    close the file
-    //    do something in the heap to get the next smallest record
-    //    keep repeating until the heap is empty
+    //    the file loses every match from now on
+    //  replay the matches of that file and keep repeating until the winner is
+    //    a finished file
+    //With -t the above runs once per range of keys, on a thread each
+    //  sample the key of every INDEX_STRIDE-th record of each file
+    //  split the keys at quantiles of the samples
+    //  a thread seeks every file to the last sample before its range and
+    //    merges until the keys pass the range, into a spool file
+    //  write the spools out in range order, the same as one merge
 
 
 
@@ -705,28 +1783,6 @@ int main( int argc, char **argv ) {
         }
 
         closedir( d );
-
-        // Set open file limit high enough for the number of files plus some extra
-
-        //get existing limits
-        getrlimit(RLIMIT_NOFILE, &old_lim);
-
-        softlimit = filecounter+1000;
-        if (softlimit > old_lim.rlim_max) {
-            fprintf( stderr, "Open file limit will be exceeded for .leb36.renumbered files; %d files to be read and %d + 1000 > hard limit = %llu\n", softlimit, softlimit,  old_lim.rlim_max );
-            exit (1);
-        }
-
-        //adjust soft limit
-        lim.rlim_cur = softlimit; 
-        lim.rlim_max = old_lim.rlim_max;
-        setrlimit(RLIMIT_NOFILE, &lim);
-
-        //debug
-        getrlimit(RLIMIT_NOFILE, &new_lim);
-        ////print to confirm
-        printf("Open file limits:\nOriginal: soft: %llu, hard: %llu\nNew: soft: %llu, hard: %llu\n",old_lim.rlim_cur, old_lim.rlim_max, new_lim.rlim_cur, new_lim.rlim_max);
-
     }
     else {  //input 1 not a directory, means single file, not used in VNTRseek anymore
 
@@ -735,9 +1791,12 @@ int main( int argc, char **argv ) {
             // -s options to sort single file
             if ( SORT_ONLY ) {
 
-                EASY_LIST *profileList;
-                EASY_NODE *nof1;
-                FILE *     fpi;
+                EASY_LIST *   profileList;
+                EASY_NODE *   nof1;
+                FILE *        fpi;
+                PROFBIN_FILE *pfi = NULL;
+                uint64_t      nextrecord = 0;
+                int *         keybuffer, maxkeybuffer, dir;
 
                 fpi = fopen( inputfile, "r" );
 
@@ -747,13 +1806,22 @@ int main( int argc, char **argv ) {
                     exit( 1 );
                 }
 
+                if ( ProfbinIsBinary( fpi ) &&
+                     NULL == ( pfi = ProfbinMap( fpi ) ) ) {
+                    printf( "\nERROR: Unfinished or unsupported binary "
+                            "profile file '%s'\n\n",
+                      inputfile );
+                    exit( 1 );
+                }
+
                 profileList = EasyListCreate( NULL, NULL );
 
                 while ( 1 ) {
 
                     piptr = smalloc( sizeof( PITEM_STRUCT ) );
 
-                    piptr->prof = ReadProfileWithRC( fpi, &( piptr->profrc ) );
+                    piptr->prof = ReadInputProfile(
+                      fpi, pfi, &nextrecord, &( piptr->profrc ) );
                     piptr->minRepresentation = NULL;
 
                     if ( NULL == piptr->prof || NULL == piptr->profrc ) {
@@ -762,10 +1830,13 @@ int main( int argc, char **argv ) {
                     }
 
                     // find minimum representation and put in list
-                    piptr->minRepresentation = MinimumRepresentation(
-                      piptr->prof->indices, piptr->prof->proflen,
-                      piptr->profrc->indices, piptr->profrc->proflen,
-                      &( piptr->minrlen ), IDENTICAL_ONLY );
+                    // (a rotated one gets a buffer of its own)
+                    keybuffer    = NULL;
+                    maxkeybuffer = 0;
+                    piptr->minRepresentation =
+                      GetMinRepresentation( piptr->prof, piptr->profrc,
+                        &( piptr->minrlen ), &dir, IDENTICAL_ONLY, &keybuffer,
+                        &maxkeybuffer );
 
                     if ( NULL == piptr->minRepresentation ) {
                         printf( "\nERROR: minrepresentation is NULL!\n\n" );
@@ -784,6 +1855,8 @@ int main( int argc, char **argv ) {
                     exit( 1 );
                 }
 
+                pwto = StartOutput( fpto, BINARY_OUTPUT );
+
                 rc = sqlite3_open( outdb, &db );
 
                 if ( rc != SQLITE_OK ) {
@@ -833,6 +1906,7 @@ int main( int argc, char **argv ) {
                 }
 
                 // sort and output
+                ProfbinUnmap( pfi );
                 fclose( fpi );
                 EasyListQuickSort( profileList, arsize_and_min_rep_cmp_pitem );
                 i = 0;
@@ -840,7 +1914,7 @@ int main( int argc, char **argv ) {
                 for ( nof1 = profileList->head; nof1 != NULL;
                       nof1 = nof1->next ) {
                     piptr = (PITEM_STRUCT *) EasyListItem( nof1 );
-                    WriteProfileWithRC( fpto, piptr->prof, piptr->profrc );
+                    WriteOutputProfile( fpto, pwto, piptr->prof, piptr->profrc );
                     sqlite3_bind_int( pStmt, 1, piptr->prof->key );
                     sqlite3_bind_int( pStmt, 2, i++ );
                     sqlite3_step( pStmt );
@@ -850,6 +1924,7 @@ int main( int argc, char **argv ) {
                 sqlite3_finalize( pStmt );
                 sqlite3_close( db );
 
+                FinishOutput( pwto );
                 fclose( fpto );
                 printf( "\n\nredund.exe: Input File sorted by minimum "
                         "representation. Now call this program again without "
@@ -864,6 +1939,7 @@ int main( int argc, char **argv ) {
             fiptr->d_name =
               strdup( inputfile ); // this won't be used in this case
             EasyArrayInsert( FARRAY, fiptr );
+            filecounter = 1;
 
         } else {
             printf(
@@ -875,279 +1951,248 @@ int main( int argc, char **argv ) {
     // first order by file name, because readdir is not sorted by default
     EasyArrayQuickSort( FARRAY, name_cmp );
 
-    // open input file(s) for reading
-    printf( "Opening files.\n" );
-
     if ( 0 == FARRAY->size ) {
         printf( "\nERROR: No input files found in the directory.\n\n" );
         exit( 1 );
     }
 
-    for ( i = 0; i < filecounter; i++ ) {
-        fiptr     = (FITEM_STRUCT *) EasyArrayItem( FARRAY, i );
-        fiptr->in = fopen( fiptr->inputfile, "r" );
-        fiptr->inputclosed = 0;
-
-        if ( NULL == fiptr->in ) {
-            printf( "\nERROR opening input file '%s': %s\n", fiptr->inputfile,
-              strerror( errno ) );
-            exit( 1 );
-        }
-
-        //printf( "\t%s\n", fiptr->inputfile );
-    }
-
-    printf("There were %d files opened.\n",filecounter);
-
-    // open the output file for writing
-    fpto = fopen( outputfile, "w" );
-
-    if ( fpto == NULL ) {
-        printf( "\nERROR: Unable to open output file '%s'.\n\n", outputfile );
-        exit( 1 );
-    }
-
-    // open the index file for writing
-    fpto2 = fopen( outputfile2, "w" );
-
-    if ( fpto2 == NULL ) {
-        printf( "\nERROR: Unable to open index file '%s'\n\n", outputfile2 );
-        exit( 1 );
-    }
-
-    //read first MAX_BUFFER_SIZE records from each file into a buffer for each file
-    for ( i = 0; i < filecounter; i++ ) {
-        fiptr = (FITEM_STRUCT *) EasyArrayItem( FARRAY, i );
-        //read records
-        readRecordsFromFileToBuffer(fiptr);
-        if (fiptr->buffercount == 0){
-            printf( "\nERROR: Input file %s was empty\n\n", fiptr->inputfile);
-            exit( 1 );
-        }
-    }
-
-    //getrusage(RUSAGE_SELF, usage);
-    //printf("\nMemory usage: %ld",usage->ru_maxrss);
-
-    //put smallest record in each buffer directly into the top level of fiptr for each FARRAY element and compute the minRepresentation
-    for ( i = 0; i < filecounter; i++ ) {
-        fiptr = (FITEM_STRUCT *) EasyArrayItem( FARRAY, i);
-        loadRecordFromBufferAndGetMinRepresetation (fiptr, IDENTICAL_ONLY); 
-    }
-
     //test that filecounter and FARRAY->size are the same
     if (filecounter!=FARRAY->size){
         printf("\nError: filecounter: %d not equal to FARRAY->size: %zu",filecounter, FARRAY->size);
         exit(1);
     }
 
-    //printf("\nGot here");
+    files = smalloc( sizeof( FITEM_STRUCT * ) * filecounter );
 
-    //treat FARRAY as the heap
-    //heapify FARRAY
-    heapify(FARRAY,filecounter);
+    for ( i = 0; i < filecounter; i++ )
+        files[i] = (FITEM_STRUCT *) EasyArrayItem( FARRAY, i );
 
+    //a merge keeps its inputs open, the fan-in has to fit the open file limit
+    openlimit = openFileLimit();
 
-    //set up for loop
-    nread     = 0;   //***this has to be moved up to incorporate the records read before
-    nwritten  = 0;
-    lastwrite = NULL;
+    if ( MAXFANIN > openlimit - RESERVED_FILES ) {
+        MAXFANIN = max( 2, openlimit - RESERVED_FILES );
+        printf( "Open file limit is %lld, merging at most %d files at once.\n",
+          openlimit, MAXFANIN );
+    }
 
-    while (1) { //break on empty heap
+    //merge groups of files into runs until few enough are left
+    for ( pass = 1; filecounter > MAXFANIN; pass++ ) {
 
-        //get smallest record for writing
-        //printf("\nGot here before first fiptr");
-        fiptr = (FITEM_STRUCT *) EasyArrayItem( FARRAY, 0 );
+        if ( NULL == rundir ) {
+            rundir = smalloc( strlen( outputdname ) + strlen( outputbname ) + 20 );
+            sprintf( rundir, "%s/%s.runs.XXXXXX", outputdname, outputbname );
 
-        //test if done
-        //***alternately, test for filecounter == 0
-        if (fiptr->prof == NULL)
-            break;
+            if ( NULL == mkdtemp( rundir ) ) {
+                printf( "\nERROR: Unable to create a directory for runs "
+                        "'%s': %s\n\n",
+                  rundir, strerror( errno ) );
+                exit( 1 );
+            }
+        }
 
-        nread++;
+        //each merge of a group keeps its inputs and its run open
+        passthreads =
+          max( 1, min( NTHREADS, ( openlimit - RESERVED_FILES ) / ( MAXFANIN + 1 ) ) );
 
-        // decide how to write and write profiles
-        // first if identifies duplicates of the last written record
-        // test if all the below occur
-        //   1: there is a last written record
-        //   2: for this record and the last written one
-        //     the minimum profiles match
-        //   3: for this record and the last written one
-        //     either the two forward profiles match,
-        //     the two reverse profiles match,
-        //     or there is a match between one profile and one reverse profile
-        // The last condition seems to be redundant, but probably assures that the two profiles are not NULLwhich would return a match for condition 2. 
+        printf( "Pass %d: merging %d files into runs of up to %d files.\n",
+          pass, filecounter, MAXFANIN );
 
-        if ((lastwrite != NULL) &&
-            (0 == arsize_and_min_rep_cmp( lastwrite, fiptr ) ) &&
+        runs = mergePass( files, filecounter, MAXFANIN, passthreads,
+          IDENTICAL_ONLY, rundir, pass, &nruns );
 
-            // (ADDED apr 18, 2013)
-            ( ( 0 == pindcmp( fiptr->prof->indices, lastwrite->prof->indices,
-                        fiptr->prof->proflen, lastwrite->prof->proflen ) &&
-                0 == pindcmp( fiptr->profrc->indices,
-                        lastwrite->profrc->indices, fiptr->profrc->proflen,
-                        lastwrite->profrc->proflen ) ) ||
-             ( 0 == pindcmp( fiptr->prof->indices, lastwrite->profrc->indices,
-                        fiptr->prof->proflen, lastwrite->profrc->proflen ) &&
-                0 == pindcmp( fiptr->profrc->indices, lastwrite->prof->indices,
-                        fiptr->profrc->proflen,
-                        lastwrite->prof->proflen ) )
-            ) ) 
-            {
+        //the runs of the pass before are no longer needed
+        for ( i = 0; i < filecounter; i++ ) {
+            if ( pass > 1 )
+                unlink( files[i]->inputfile );
 
-            fprintf( fpto2, " %d%c", fiptr->prof->key,
-              ( 0 == fiptr->dir ) ? '\'' : '\"' ); //add duplicate index entry
+            free( files[i]->keybuffer );
+            free( files[i]->inputfile );
+            free( files[i]->d_name );
+            free( files[i] );
+        }
 
-            // in proclu 1.87 we need all profiles written
+        free( files );
+        files       = runs;
+        filecounter = nruns;
+    }
 
-            WriteProfileWithRC( fpto, fiptr->prof, fiptr->profrc );
+    // open input file(s) for reading
+    printf( "Opening files.\n" );
 
-            //don't free lastwrite here, because still in use
+    for ( i = 0; i < filecounter; i++ ) {
+        openInput( files[i] );
+    }
 
-        } else {
+    printf("There were %d files opened.\n",filecounter);
 
-            //else condition if for non-duplicates
-            nwritten++;
+    // open the output file for writing
+    out.fpto = fopen( outputfile, "w" );
 
-            // write out
+    if ( out.fpto == NULL ) {
+        printf( "\nERROR: Unable to open output file '%s'.\n\n", outputfile );
+        exit( 1 );
+    }
 
-            WriteProfileWithRC( fpto, fiptr->prof, fiptr->profrc );
-            //printf("\nGot here after first write");
-            //fflush(stdout);
+    out.pwto = StartOutput( out.fpto, BINARY_OUTPUT );
 
+    // open the index file for writing
+    out.fpto2 = fopen( outputfile2, "w" );
 
-            if ( NULL != lastwrite ) {
-                fprintf( fpto2, "\n" ); //start new preserved index entry
-            }
+    if ( out.fpto2 == NULL ) {
+        printf( "\nERROR: Unable to open index file '%s'\n\n", outputfile2 );
+        exit( 1 );
+    }
 
-            fprintf( fpto2, "%d%c", fiptr->prof->key,
-              ( 0 == fiptr->dir ) ? '\'' : '\"' ); // add preserved index entry
+    out.outputfile   = outputfile;
+    out.outputfile2  = outputfile2;
+    out.outputdname  = outputdname;
+    out.outputbname  = outputbname;
+    out.filescreated = 1;
+    out.single       = SINGLE_OUTFILE;
+    out.binary       = BINARY_OUTPUT;
+    out.nwritten     = 0;
+
+    //with more threads, sample the keys of every file, split them in ranges
+    //and merge each range on a thread of its own
+    nread    = 0;
+    nranges  = 1;
+    unsorted = 0;
+
+    //every range merge opens the text inputs again, binary ones are shared
+    //through their mappings
+    for ( ntext = 0, i = 0; i < filecounter; i++ ) {
+        if ( NULL == files[i]->binary )
+            ntext++;
+    }
 
-                    // make sure new minrep is equal or larger than old minrep
+    while ( NTHREADS > 1 &&
+            (long long) filecounter + (long long) NTHREADS * ntext +
+                2 * NTHREADS + RESERVED_FILES >
+              openlimit )
+        NTHREADS--;
 
+    if ( NTHREADS > 1 ) {
+        for ( i = 0; i < filecounter; i++ ) {
+            unsorted |= sampleInput( files[i], IDENTICAL_ONLY );
 
-            //free lastwrite here, because no longer used
+            if ( 0 == files[i]->nsamples ) {
+                printf( "\nERROR: Input file %s was empty\n\n", files[i]->inputfile );
+                exit( 1 );
+            }
+        }
 
+        if ( unsorted )
+            printf( "Input files are not sorted, merging on one thread.\n" );
+        else
+            nranges = makeRanges(
+              files, filecounter, NTHREADS, IDENTICAL_ONLY, &ranges );
+    }
 
-            if ( NULL != lastwrite ) {          //*** may have to free other things
-                FreeProfile( lastwrite->prof );
-                FreeProfile( lastwrite->profrc );
-                free( lastwrite->minRepresentation );
-                free( lastwrite );
+    if ( nranges > 1 ) {
+        printf( "Merging %d key ranges on as many threads.\n", nranges );
+
+        tasks = scalloc( nranges, sizeof( RANGE_TASK ) );
+
+        for ( i = 0; i < nranges; i++ ) {
+            tasks[i].inputs         = files;
+            tasks[i].ninputs        = filecounter;
+            tasks[i].identical_only = IDENTICAL_ONLY;
+            tasks[i].range          = ranges[i];
+            tasks[i].spool.fp       = tmpfile();
+            tasks[i].spool.flags    = tmpfile();
+
+            if ( NULL == tasks[i].spool.fp || NULL == tasks[i].spool.flags ||
+                 NULL == ( tasks[i].spool.pw =
+                             ProfbinCreate( tasks[i].spool.fp ) ) ) {
+                printf( "\nERROR: Unable to create a spool file: %s\n\n",
+                  strerror( errno ) );
+                exit( 1 );
             }
 
+            if ( 0 != pthread_create(
+                        &tasks[i].thread, NULL, mergeRange, &tasks[i] ) ) {
+                printf( "\nERROR: Unable to start a merge thread\n\n" );
+                exit( 1 );
+            }
+        }
 
-            //set lastwrite for comparison with next smallest record
-            //*** may not need all this information
-            lastwrite = smalloc( sizeof( FITEM_STRUCT ) );
-            lastwrite->inputfile   = fiptr->inputfile;
-            lastwrite->outputfile  = fiptr->outputfile;
-            lastwrite->outputfile2 = fiptr->outputfile2;
-            lastwrite->in = fiptr->in;
-            lastwrite->prof = CopyProfile( fiptr->prof );
-            lastwrite->profrc = CopyProfile( fiptr->profrc );
-            lastwrite->minRepresentation = pintdup( fiptr->minRepresentation, fiptr->minrlen );
-            lastwrite->minrlen = fiptr->minrlen;
+        for ( i = 0; i < nranges; i++ ) {
+            pthread_join( tasks[i].thread, NULL );
+            unsorted |= tasks[i].unsorted;
+        }
 
-            //printf("\nGot here after lastwrite assignment");
-            //fflush(stdout);
+        if ( unsorted )
+            printf( "Input files are not sorted, merging again on one thread.\n" );
 
-            // open new file?
-            //shouldn't this test be before the record is written?
-            if ( !SINGLE_OUTFILE && ( nwritten % ( RECORDS_PER_FILE ) ) == 0 ) {
-                //printf("\nGot here just after test for multiple output files");
-                //fflush(stdout);
-                fclose( fpto );
-                fclose( fpto2 );
+        //the ranges go out in key order, as one merge would write them
+        for ( i = 0; i < nranges; i++ ) {
+            if ( !unsorted ) {
+                replaySpool( &tasks[i].spool, &out );
+                nread += tasks[i].nread;
+            }
 
-                filescreated++;
+            fclose( tasks[i].spool.fp );
+            fclose( tasks[i].spool.flags );
+            free( ranges[i].upper.minRepresentation );
+        }
 
-                // open the output file for writing
-                sprintf( outputfile, "%s/%d.%s", outputdname, filescreated,
-                  outputbname );
-                fpto = fopen( outputfile, "w" );
+        free( tasks );
+        free( ranges );
+    }
 
-                if ( fpto == NULL ) {
-                    printf( "\nERROR: Unable to open output file '%s'\n\n",
-                      outputfile );
-                    exit( 1 );
-                }
+    if ( 1 == nranges || unsorted ) {
 
-                // open the index file for writing
-                sprintf( outputfile2, "%s/%d.%s.rotindex", outputdname,
-                  filescreated, outputbname );
-                fpto2 = fopen( outputfile2, "w" );
+        //read first MAX_BUFFER_SIZE records from each file into a buffer for each file
+        //and put the smallest record of each directly into the top level of fiptr
+        for ( i = 0; i < filecounter; i++ ) {
+            fiptr = files[i];
 
-                if ( fpto2 == NULL ) {
-                    printf( "\nERROR: Unable to open output file '%s'\n\n",
-                      outputfile2 );
-                    exit( 1 );
-                }
+            if ( NULL == fiptr->binary )
+                rewind( fiptr->in );
+
+            fiptr->nextrecord = 0;
+            fiptr->endrecord  = ( NULL == fiptr->binary ) ? 0 : fiptr->binary->nrecords;
+            fiptr->endoffset  = -1;
+            nextRecord( fiptr, IDENTICAL_ONLY );
+
+            if ( NULL == fiptr->prof ) {
+                printf( "\nERROR: Input file %s was empty\n\n", fiptr->inputfile);
+                exit( 1 );
             }
         }
 
+        //getrusage(RUSAGE_SELF, usage);
+        //printf("\nMemory usage: %ld",usage->ru_maxrss);
 
-        //at this point, free the profiles and minRepresentation
-        FreeProfile( fiptr->prof );
-        FreeProfile( fiptr->profrc );
-        free( fiptr->minRepresentation );
-
-        //debug test
-        //printf("\nGot here before test of null fiptr");
-        //fflush(stdout);
-        //if (fiptr == NULL) {
-        //    printf("\nfiptr is null");
-        //    fflush(stdout);
-        //}
-        //printf("\nGot here after test of null fiptr");
-        //fflush(stdout);
-
-         //load new profiles or put last item in heap at top and shorten heap
-         //check buffer not empty
-         if (fiptr->bufferindex != fiptr->buffercount){
-                loadRecordFromBufferAndGetMinRepresetation (fiptr, IDENTICAL_ONLY);
-         }
-         else
-         {
-            //buffer is empty
-            //read records from file into the buffer
-            //debug print
-            readRecordsFromFileToBuffer(fiptr);
-
-            //if some records were read, load new profile
-            if(fiptr->buffercount != 0){
-                loadRecordFromBufferAndGetMinRepresetation (fiptr, IDENTICAL_ONLY);
+        nread = mergeFiles( files, filecounter, IDENTICAL_ONLY, &out, NULL );
+    }
 
-            }
-            else
-            {
-                //no more records for this fiptr
-                //no profiles or minRepresentations remain
-                free(fiptr->buffer[0]);
-                free(fiptr->buffer);
-                free(fiptr);
-
-                //get the last FARRAY item so it can be moved to the top
-                //it already has the profile and minRepresentation information 
-                fiptr = EasyArrayItem(FARRAY, filecounter-1);
-                FARRAY->array[0] = fiptr;
-
-                //reduce filecounter by 1
-                filecounter--;
-                //printf("\nFiles left = %d",filecounter);
-
-                //test if heap empty and if so, break out of while
-                if(filecounter == 0)
-                    break;
-            }
+    for ( i = 0; i < filecounter; i++ ) {
+        if ( !files[i]->inputclosed )
+            closeInput( files[i] );
 
-         }
+        if ( NULL != rundir )
+            unlink( files[i]->inputfile );
+
+        free( files[i]->samples );
+        free( files[i]->keybuffer );
+        free( files[i]->inputfile );
+        free( files[i]->d_name );
+        free( files[i] );
+    }
 
-        //fix heap
-        siftDown(FARRAY, 0, filecounter);
+    free( files );
 
+    if ( NULL != rundir ) {
+        rmdir( rundir );
+        free( rundir );
     }
 
+    FinishOutput( out.pwto );
+    fclose( out.fpto );
+    fclose( out.fpto2 );
+    nwritten = out.nwritten;
 
     free( outputbname );
     free( outputdname );
@@ -68,6 +68,9 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include "../libs/profbin/profbin.h"
 
 #define max( a, b )                 \
     ( {                             \
@@ -119,6 +122,10 @@ void WriteProfile( FILE *fp, PROFILE *prof ); // NO LONGER USED
 void WriteProfileWithRC(
   FILE *fp, PROFILE *prof, PROFILE *profrc, char *left, char *right );
 
+// Same record to a binary profile file, returns 0 on success.
+int WriteProfileBinary( PROFBIN_WRITER *pw, PROFILE *prof, PROFILE *profrc,
+  char *left, char *right );
+
 // Frees memory associate with a profile
 void FreeProfile( PROFILE *prof );
 
@@ -472,6 +479,31 @@ void WriteProfileWithRC(
     return;
 }
 
+int WriteProfileBinary( PROFBIN_WRITER *pw, PROFILE *prof, PROFILE *profrc,
+  char *left, char *right ) {
+    PROFBIN_ENTRY pe;
+
+    memset( &pe, 0, sizeof( pe ) );
+    pe.key     = prof->key;
+    pe.patlen  = prof->patlen;
+    pe.copynum = prof->copynum;
+    pe.indices = prof->indices;
+    pe.proflen = prof->proflen;
+
+    if ( profrc ) {
+        pe.rcindices = profrc->indices;
+        pe.proflenrc = profrc->proflen;
+        pe.a         = prof->a;
+        pe.c         = prof->c;
+        pe.g         = prof->g;
+        pe.t         = prof->t;
+        pe.left      = left;
+        pe.right     = right;
+    }
+
+    return ProfbinWrite( pw, &pe );
+}
+
 void LEB36ToInt( char *leb36, int *dec ) {
     int   i, mult, num;
     char *p;
@@ -34,6 +34,7 @@
 #include "../libs/easylife/easylife.h"
 #include "patupdt.h"
 #include "profile.h"
+#include "../libs/vntr_kernels/min_representation.h"
 
 // if this is set to 1, profiles are not rotated during sorting (must correspond
 // to -i flag in redund.c)
@@ -90,7 +91,7 @@ typedef struct {
 static char *usage =
   "Usage: trf2proclu-ngs.exe -f <num> -m <num> -s <num> -i <num> -o <string> "
   "-p <num> "
-  "-l <num> [input.dat]\nWhere:\n\t-f specifies the id assigned to the "
+  "-l <num> [-b] [input.dat]\nWhere:\n\t-f specifies the id assigned to the "
   "first record in the file (must be greater than or equal to "
   "1),\n\t-m must be equal to the matching weight parameter of the "
   "corresponding TRF run,\n\t-s must be equal to the mismatch penalty "
@@ -98,7 +99,8 @@ static char *usage =
   "indel penalty parameter of the corresponding TRF run,\n\t-o "
   "specifies the prefix of the output files,\n\t-p specifies "
   "minimum patsize to keep TR,\n\t-l specifies minimum flanksize "
-  "(either side) to keep TR\ntrf2proclu-ngs.exe reads a DAT file output by the "
+  "(either side) to keep TR,\n\t-b writes the profiles to a binary "
+  "profile file (.pbin) instead of LEB36\ntrf2proclu-ngs.exe reads a DAT file output by the "
   "TRF and "
   "produces an LEB36 file and an index file that contains records from "
   "the DAT file each preceded by a unique id.\n";
@@ -187,112 +189,12 @@ int arsize_and_min_rep_sort( const void *item1, const void *item2 ) {
       p1->minRepresentation, p2->minRepresentation, p1->minrlen, p2->minrlen );
 }
 
-/*******************************************************************************************/
-int *pintdup( int *src, int size ) {
-    int i, *res;
-
-    res = smalloc( sizeof( int ) * size );
-
-    for ( i = 0; i < size; i++ ) {
-        res[i] = src[i];
-    }
-
-    return res;
-}
-
-int RC = 0;
-
-/*******************************************************************************************/
-int *MinimumRepresentation( int *indptr, int len, int *indptrrc, int lenrc,
-  int *minrlen, int identical_only ) {
-
-    int  i, j;
-    int *src, *srcrc, *tar, tmp;
-
-    RC = 0;
-
-    if ( NULL == indptr || NULL == indptrrc )
-        return NULL;
-
-    src   = pintdup( indptr, len );
-    srcrc = pintdup( indptrrc, lenrc );
-
-    tar = pintdup( indptr, len );
-
-    /* added on feb 6, 2013 */
-    if ( identical_only ) {
-
-        // minimum of the forward and reverse profiles
-        if ( pindcmp( srcrc, tar, lenrc, len ) < 0 ) {
-            free( tar );
-            tar = pintdup( srcrc, lenrc );
-            RC  = 1;
-        }
-
-    } else {
-
-        // FORWARD - test each rotation and find the minimum one
-        for ( i = 1; i < len; i++ ) {
-
-            // printf("\n\nstart: %s",src);
-
-            // rotate by 1
-            tmp = src[0];
-
-            for ( j = 1; j < len; j++ ) {
-                src[j - 1] = src[j];
-            }
-
-            src[len - 1] = tmp;
-
-            // printf("\nend: %s comp: %d\n\n",src,strcmp(src,tar));
-            // exit(1);
-
-            if ( pindcmp( src, tar, len, len ) < 0 ) {
-                free( tar );
-                tar = pintdup( src, len );
-            }
-        }
-
-        // REVERSE - test each rotation and find the minimum one
-        for ( i = 1; i < lenrc; i++ ) {
-
-            // printf("\n\nstart: %s",src);
-
-            // rotate by 1
-            tmp = srcrc[0];
-
-            for ( j = 1; j < len; j++ ) {
-                srcrc[j - 1] = srcrc[j];
-            }
-
-            srcrc[lenrc - 1] = tmp;
-
-            // printf("\nend: %s comp: %d\n\n",src,strcmp(src,tar));
-            // exit(1);
-
-            if ( pindcmp( srcrc, tar, lenrc, len ) < 0 ) {
-                free( tar );
-                tar = pintdup( srcrc, lenrc );
-                RC  = 1;
-            }
-        }
-    }
-
-    // save rotated
-    free( src );
-    free( srcrc );
-
-    *minrlen = ( 0 == RC ) ? len : lenrc;
-
-    return tar;
-}
-
 /********************************	main
  * ********************************************/
 
 // Flag set by --ngs command line option
 static int verbose = 0;
+static int binary  = 0;
 
 int main( int argc, char **argv ) {
 
@@ -314,6 +216,8 @@ int main( int argc, char **argv ) {
     EASY_LIST * repList;
     EASY_NODE * tnode;
     PROFILE *   profptr;
+    PROFBIN_WRITER *pw = NULL;
+    MINREP          minrep;
     char *      outfile_prefix;
     char *      leb36file;
     char *      indexfileh;
@@ -327,6 +231,7 @@ int main( int argc, char **argv ) {
     while ( 1 ) {
         static struct option long_options[] = {// These options set a flag.
           {"verbose", no_argument, &verbose, 1},
+          {"binary", no_argument, &binary, 1},
           // These options don't set a flag.
           // We distinguish them by their indices.
           {"help", no_argument, NULL, 'h'},
@@ -339,7 +244,7 @@ int main( int argc, char **argv ) {
           {"output", required_argument, NULL, 'o'}, {0, 0, NULL, 0}};
         int option_index = 0; // getopt_long() stores the option index here
         c                = getopt_long(
-          argc, argv, "hf:m:s:i:p:l:o:", long_options, &option_index );
+          argc, argv, "hbf:m:s:i:p:l:o:", long_options, &option_index );
 
         if ( c == -1 )
             break; // detect the end of the options
@@ -357,6 +262,10 @@ int main( int argc, char **argv ) {
             fprintf( stderr, "%s", usage );
             return ( 3 );
 
+        case 'b':
+            binary = 1;
+            break;
+
         case 'f':
             startid = atoi( optarg );
 
@@ -825,17 +734,20 @@ int main( int argc, char **argv ) {
                 free( rep.pattern );
                 free( rep.profile );
 
-                repPtr->minRepresentation = MinimumRepresentation(
-                  repPtr->prof->indices, repPtr->prof->proflen,
-                  repPtr->profrc->indices, repPtr->profrc->proflen,
-                  &( repPtr->minrlen ), IDENTICAL_ONLY );
-
-                if ( NULL == repPtr->minRepresentation ) {
+                if ( 0 != MinRepresentation( repPtr->prof->indices,
+                            repPtr->prof->proflen, repPtr->profrc->indices,
+                            repPtr->profrc->proflen, !IDENTICAL_ONLY,
+                            &minrep ) ) {
                     fputs(
                       "Minimum representation is NULL. Aborting.\n", stderr );
                     return ( 100 );
                 }
 
+                // the profiles may be freed below, the key is kept
+                repPtr->minrlen           = minrep.length;
+                repPtr->minRepresentation = MinRepresentationCopy(
+                  &minrep, smalloc( sizeof( int ) * minrep.length ) );
+
                 repPtr->acgtCount = repPtr->prof->acgtCount;
 
                 /* to limit memory usage */
@@ -877,8 +789,8 @@ int main( int argc, char **argv ) {
           repList->size );
 
     leb36file = calloc( strlen( outfile_prefix ) + 7, sizeof( *leb36file ) );
-    snprintf(
-      leb36file, strlen( outfile_prefix ) + 7, "%s.leb36", outfile_prefix );
+    snprintf( leb36file, strlen( outfile_prefix ) + 7, "%s%s", outfile_prefix,
+      binary ? PROFBIN_EXT : ".leb36" );
     fp = fopen( leb36file, "w" );
 
     if ( fp == NULL ) {
@@ -886,6 +798,11 @@ int main( int argc, char **argv ) {
         return ( 17 );
     }
 
+    if ( binary && ( pw = ProfbinCreate( fp ) ) == NULL ) {
+        fputs( "Unable to start binary profile file. Aborting.\n", stderr );
+        return ( 17 );
+    }
+
     theid = startid;
     EASY_STRING_HASH *headerHash =
       EasyStringHashCreate( repList->size, NULL, free );
@@ -908,8 +825,14 @@ int main( int argc, char **argv ) {
               repPtr->header, repPtr->firstindex, repPtr->lastindex,
               repPtr->copynum, repPtr->patsize, repPtr->pattern );
             /* output leb36 to file */
-            WriteProfileWithRC( fp, repPtr->prof, repPtr->profrc,
-              (char *) repPtr->left, (char *) repPtr->right );
+            if ( pw == NULL )
+                WriteProfileWithRC( fp, repPtr->prof, repPtr->profrc,
+                  (char *) repPtr->left, (char *) repPtr->right );
+            else if ( WriteProfileBinary( pw, repPtr->prof, repPtr->profrc,
+                        (char *) repPtr->left, (char *) repPtr->right ) ) {
+                fputs( "Unable to write binary profile. Aborting.\n", stderr );
+                return ( 17 );
+            }
         }
 
         // We've not seen this header before. Set and increment the
@@ -951,6 +874,11 @@ int main( int argc, char **argv ) {
         //   repPtr->copynum, repPtr->patsize, repPtr->pattern );
     }
 
+    if ( pw != NULL && ProfbinClose( pw ) ) {
+        fputs( "Unable to finish binary profile file. Aborting.\n", stderr );
+        return ( 17 );
+    }
+
     fclose( fp );
 
     /* this is a file summarizing all results, including nonspanning and